@@ -0,0 +1,314 @@
+// SSArena.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A simple bump-pointer memory arena, a pool of deduplicated data blocks which draws from it,
+// and compact string storage which can refer to data in such a pool.
+
+#include <stdlib.h>
+#include <new>
+#include <algorithm>
+
+#include "SSArena.hpp"
+
+// Constructs an empty arena which will allocate memory in blocks of (blockSize) bytes.
+// No memory is allocated until the first call to allocate().
+
+SSArena::SSArena ( size_t blockSize )
+{
+    _blockSize = blockSize > 0 ? blockSize : kDefaultBlockSize;
+    _used = 0;
+    _reserved = 0;
+    _allocated = 0;
+}
+
+// Destructor releases all memory allocated from this arena.
+
+SSArena::~SSArena ( void )
+{
+    clear();
+}
+
+// Allocates a new block of (size) bytes and makes it the current block.
+// Throws bad_alloc if out of memory, like operator new.
+
+char *SSArena::newBlock ( size_t size )
+{
+    char *pBlock = (char *) malloc ( size );
+    if ( pBlock == nullptr )
+        throw bad_alloc();
+
+    _blocks.push_back ( { pBlock, size } );
+    _reserved += size;
+    _used = 0;
+    return pBlock;
+}
+
+// Returns a pointer to (size) bytes of memory aligned to a multiple of (align) bytes,
+// which must be a power of two no larger than alignof ( max_align_t ). Requests larger than
+// the block size get a block of their own.
+
+void *SSArena::allocate ( size_t size, size_t align )
+{
+    size_t start = ( _used + align - 1 ) & ~( align - 1 );
+    if ( _blocks.empty() || start + size > _blocks.back().size )
+    {
+        newBlock ( max ( size, _blockSize ) );
+        start = 0;
+    }
+
+    char *p = _blocks.back().data + start;
+    _allocated += start - _used + size;
+    _used = start + size;
+    return p;
+}
+
+// Returns true if a pointer (p) points into memory allocated from this arena.
+// Searches the most recently allocated blocks first.
+
+bool SSArena::contains ( const void *p )
+{
+    uintptr_t addr = (uintptr_t) p;
+
+    for ( size_t i = _blocks.size(); i > 0; i-- )
+    {
+        uintptr_t start = (uintptr_t) _blocks[i - 1].data;
+        if ( addr >= start && addr < start + _blocks[i - 1].size )
+            return true;
+    }
+
+    return false;
+}
+
+// Takes ownership of all memory allocated from another arena (other), which is left empty.
+// Pointers into the other arena stay valid, and are freed with this one. New allocations
+// still come from this arena's current block.
+
+void SSArena::absorb ( SSArena &other )
+{
+    if ( &other == this || other._blocks.empty() )
+        return;
+
+    if ( _blocks.empty() )
+    {
+        _blocks.swap ( other._blocks );
+        _used = other._used;
+    }
+    else
+    {
+        _blocks.insert ( _blocks.end() - 1, other._blocks.begin(), other._blocks.end() );
+        other._blocks.clear();
+    }
+
+    _reserved += other._reserved;
+    _allocated += other._allocated;
+    other._used = other._reserved = other._allocated = 0;
+}
+
+// Releases all memory allocated from this arena. Any pointers previously
+// returned by allocate() become invalid!
+
+void SSArena::clear ( void )
+{
+    for ( Block &block : _blocks )
+        free ( block.data );
+
+    _blocks.clear();
+    _used = 0;
+    _reserved = 0;
+    _allocated = 0;
+}
+
+// Constructs an empty pool which will store data in arena blocks of (blockSize) bytes.
+
+SSPool::SSPool ( size_t blockSize ) : _arena ( blockSize )
+{
+    _count = 0;
+    _interned = 0;
+}
+
+// Returns 64-bit hash of (size) bytes of data starting at (data). Like FNV-1a, but mixes in
+// eight bytes at a time, then folds the high bits down so the low bits used by the table are good.
+
+size_t SSPool::hash ( const void *data, size_t size )
+{
+    const unsigned char *p = (const unsigned char *) data;
+    uint64_t h = 14695981039346656037ULL ^ size;
+
+    for ( ; size >= 8; p += 8, size -= 8 )
+    {
+        uint64_t word;
+        memcpy ( &word, p, 8 );
+        h = ( h ^ word ) * 1099511628211ULL;
+    }
+
+    for ( ; size > 0; p++, size-- )
+        h = ( h ^ *p ) * 1099511628211ULL;
+
+    return (size_t) ( h ^ ( h >> 32 ) );
+}
+
+// Returns the entry for a pooled block identical to (size) bytes at (data), whose contents hash to (h),
+// and which is aligned to a multiple of (align) bytes. Returns the empty entry where such a block
+// would be inserted if there is none. The hash table must not be empty.
+
+const SSPool::Entry *SSPool::find ( const void *data, size_t size, size_t align, size_t h )
+{
+    size_t mask = _table.size() - 1;
+
+    for ( size_t i = h & mask; ; i = ( i + 1 ) & mask )
+    {
+        const Entry &entry = _table[i];
+        if ( entry.data == nullptr )
+            return &entry;
+
+        if ( entry.hash == h && entry.size == size && ( (uintptr_t) entry.data & ( align - 1 ) ) == 0 && memcmp ( entry.data, data, size ) == 0 )
+            return &entry;
+    }
+}
+
+// Inserts an entry for a block which is not already in the pool, doubling the hash table
+// whenever it would become more than half full.
+
+void SSPool::insert ( const Entry &entry )
+{
+    if ( ( _count + 1 ) * 2 > _table.size() )
+    {
+        vector<Entry> old ( max ( _table.size() * 2, (size_t) 1024 ), Entry { nullptr, 0, 0 } );
+        old.swap ( _table );
+
+        for ( Entry &e : old )
+            if ( e.data )
+                *const_cast<Entry *> ( find ( e.data, e.size, 1, e.hash ) ) = e;
+    }
+
+    *const_cast<Entry *> ( find ( entry.data, entry.size, 1, entry.hash ) ) = entry;
+    _count++;
+}
+
+// Returns a pointer to a pooled copy of (size) bytes of data starting at (data), aligned to a multiple of
+// (align) bytes. If an identical block is already in the pool, returns that block instead of copying.
+// Returns nullptr if (size) is zero.
+
+const void *SSPool::intern ( const void *data, size_t size, size_t align )
+{
+    if ( size == 0 )
+        return nullptr;
+
+    _interned++;
+    size_t h = hash ( data, size );
+    if ( ! _table.empty() )
+    {
+        const Entry *pEntry = find ( data, size, align, h );
+        if ( pEntry->data )
+            return pEntry->data;
+    }
+
+    char *p = (char *) _arena.allocate ( size, align );
+    memcpy ( p, data, size );
+    insert ( { p, size, h } );
+    return p;
+}
+
+// Takes ownership of all blocks in another pool (other), which is left empty.
+// Pointers into the other pool stay valid; blocks which duplicate blocks already
+// in this pool are kept, but only this pool's copies are returned by intern().
+
+void SSPool::absorb ( SSPool &other )
+{
+    if ( &other == this )
+        return;
+
+    _arena.absorb ( other._arena );
+    _interned += other._interned;
+
+    for ( Entry &entry : other._table )
+        if ( entry.data && ( _table.empty() || find ( entry.data, entry.size, 1, entry.hash )->data == nullptr ) )
+            insert ( entry );
+
+    other._table.clear();
+    other._count = 0;
+    other._interned = 0;
+}
+
+// Points this string at (len) characters stored at (p) on the heap or in a pool, as given by (tag).
+
+void SSCompactString::setPointer ( const char *p, size_t len, int tag )
+{
+    uint32_t count = (uint32_t) len;
+    memset ( _bytes, 0, sizeof ( _bytes ) );
+    memcpy ( _bytes, &p, sizeof ( p ) );
+    memcpy ( _bytes + 8, &count, sizeof ( count ) );
+    _bytes[15] = tag;
+}
+
+// Initializes this string with a copy of (len) characters starting at (str),
+// inline if they fit, otherwise on the heap.
+
+void SSCompactString::init ( const char *str, size_t len )
+{
+    reset();
+    if ( len <= kMaxInline )
+    {
+        memcpy ( _bytes, str, len );
+        _bytes[15] = kMaxInline - len;
+    }
+    else
+    {
+        char *p = new char[len + 1];
+        memcpy ( p, str, len );
+        p[len] = 0;
+        setPointer ( p, len, kHeap );
+    }
+}
+
+SSCompactString &SSCompactString::operator = ( const SSCompactString &other )
+{
+    if ( this != &other )
+    {
+        SSCompactString copy ( other );
+        *this = std::move ( copy );
+    }
+
+    return *this;
+}
+
+SSCompactString &SSCompactString::operator = ( SSCompactString &&other )
+{
+    if ( this != &other )
+    {
+        release();
+        memcpy ( _bytes, other._bytes, sizeof ( _bytes ) );
+        other.reset();
+    }
+
+    return *this;
+}
+
+// Returns number of characters in this string, not including terminating null.
+
+size_t SSCompactString::size ( void ) const
+{
+    if ( tag() <= kMaxInline )
+        return kMaxInline - tag();
+
+    uint32_t len;
+    memcpy ( &len, _bytes + 8, sizeof ( len ) );
+    return len;
+}
+
+// Moves this string's characters from the heap into a pool (pPool), where they are shared with
+// any identical string. Inline and already-pooled strings are left as they are.
+
+void SSCompactString::moveToPool ( SSPool *pPool )
+{
+    if ( tag() != kHeap )
+        return;
+
+    const char *p = pointer();
+    size_t len = size();
+    const char *q = (const char *) pPool->intern ( p, len + 1 );
+    delete [] p;
+    setPointer ( q, len, kPooled );
+}
@@ -0,0 +1,277 @@
+// SSArena.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A simple bump-pointer memory arena, a pool which stores each distinct block of data
+// (a string, a list of identifiers) only once, and compact string and array types which
+// can refer to data in such a pool. Used by SSObjectArray to store large catalogs of objects,
+// and their names and identifiers, in a few large blocks which are freed all at once.
+
+#ifndef SSArena_hpp
+#define SSArena_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+// This class hands out memory from a list of large blocks. Individual allocations are never freed;
+// all memory is released when the arena is cleared or destroyed. Not thread-safe: an arena should
+// only be used from one thread at a time.
+
+class SSArena
+{
+protected:
+
+    struct Block
+    {
+        char *data;             // start of block
+        size_t size;            // size of block in bytes
+    };
+
+    vector<Block> _blocks;      // all blocks allocated so far; the last one is the current block
+    size_t _blockSize;          // default size of new blocks, in bytes
+    size_t _used;               // bytes used in the current block
+    size_t _reserved;           // total bytes in all blocks
+    size_t _allocated;          // total bytes handed out by allocate(), including alignment padding
+
+    char *newBlock ( size_t size );
+
+public:
+
+    static constexpr size_t kDefaultBlockSize = 1024 * 1024;
+
+    SSArena ( size_t blockSize = kDefaultBlockSize );
+    ~SSArena ( void );
+
+    SSArena ( const SSArena & ) = delete;
+    SSArena &operator = ( const SSArena & ) = delete;
+
+    void *allocate ( size_t size, size_t align = alignof ( max_align_t ) );
+    bool contains ( const void *p );
+    void absorb ( SSArena &other );
+    void clear ( void );
+
+    size_t getUsed ( void ) { return _allocated; }
+    size_t getReserved ( void ) { return _reserved; }
+};
+
+// This class stores immutable blocks of data in an arena, and stores each distinct block only once:
+// interning a block identical to one already in the pool returns the existing copy. Pooled blocks
+// are never freed individually; all are released when the pool is destroyed. Not thread-safe.
+
+class SSPool
+{
+protected:
+
+    struct Entry
+    {
+        const char *data;       // pooled copy of block; null if this hash table entry is empty
+        size_t size;            // size of block in bytes
+        size_t hash;            // hash of block contents
+    };
+
+    SSArena _arena;             // memory for pooled blocks
+    vector<Entry> _table;       // open-addressed hash table of pooled blocks; size is zero or a power of two
+    size_t _count;              // number of distinct blocks in pool
+    size_t _interned;           // number of blocks interned, including duplicates
+
+    static size_t hash ( const void *data, size_t size );
+    const Entry *find ( const void *data, size_t size, size_t align, size_t hash );
+    void insert ( const Entry &entry );
+
+public:
+
+    SSPool ( size_t blockSize = SSArena::kDefaultBlockSize );
+
+    SSPool ( const SSPool & ) = delete;
+    SSPool &operator = ( const SSPool & ) = delete;
+
+    const void *intern ( const void *data, size_t size, size_t align = 1 );
+    void absorb ( SSPool &other );
+
+    size_t getCount ( void ) { return _count; }
+    size_t getInterned ( void ) { return _interned; }
+    size_t getUsed ( void ) { return _arena.getUsed() + _table.size() * sizeof ( Entry ); }
+    size_t getReserved ( void ) { return _arena.getReserved() + _table.capacity() * sizeof ( Entry ); }
+};
+
+// A string which takes 16 bytes, and needs no allocator. Strings of up to 15 characters are stored inline,
+// like short std::strings. Longer strings are stored on the heap, or after moveToPool(), in an SSPool,
+// where they are shared with identical strings and never freed individually. Copies are always stored
+// inline or on the heap, so a copy never outlives the pool its original came from.
+
+class SSCompactString
+{
+protected:
+
+    // Bytes 0-14 hold an inline string, and byte 15 holds 15 minus its length, so it also terminates
+    // a 15-character string. Otherwise, byte 15 holds kHeap or kPooled, and the first bytes hold a pointer
+    // to the characters, followed by their 32-bit count. Unused bytes are always zero, so identical
+    // strings have identical bytes, and arrays of pooled strings can be pooled too.
+
+    enum { kMaxInline = 15, kHeap = 0x80, kPooled = 0x81 };
+
+    char _bytes[16];
+
+    int tag ( void ) const { return (unsigned char) _bytes[15]; }
+    const char *pointer ( void ) const { const char *p; memcpy ( &p, _bytes, sizeof ( p ) ); return p; }
+    void reset ( void ) { memset ( _bytes, 0, sizeof ( _bytes ) ); _bytes[15] = kMaxInline; }
+    void setPointer ( const char *p, size_t len, int tag );
+    void init ( const char *str, size_t len );
+    void release ( void ) { if ( tag() == kHeap ) delete [] pointer(); }
+
+public:
+
+    SSCompactString ( void ) { reset(); }
+    SSCompactString ( const char *str, size_t len ) { init ( str, len ); }
+    SSCompactString ( const string &str ) { init ( str.c_str(), str.size() ); }
+    SSCompactString ( const SSCompactString &other ) { init ( other.c_str(), other.size() ); }
+    SSCompactString ( SSCompactString &&other ) { memcpy ( _bytes, other._bytes, sizeof ( _bytes ) ); other.reset(); }
+    ~SSCompactString ( void ) { release(); }
+
+    SSCompactString &operator = ( const SSCompactString &other );
+    SSCompactString &operator = ( SSCompactString &&other );
+
+    size_t size ( void ) const;
+    bool empty ( void ) const { return size() == 0; }
+    const char *c_str ( void ) const { return tag() <= kMaxInline ? _bytes : pointer(); }
+    string str ( void ) const { return string ( c_str(), size() ); }
+    bool isPooled ( void ) const { return tag() == kPooled; }
+
+    void moveToPool ( SSPool *pPool );
+};
+
+// Moves the contents of an element of an SSCompactArray into a pool. Does nothing unless the element
+// holds data outside itself, like SSCompactString.
+
+template <class T> inline void SSMoveToPool ( T &, SSPool * ) { }
+inline void SSMoveToPool ( SSCompactString &str, SSPool *pPool ) { str.moveToPool ( pPool ); }
+
+// A fixed-size array which takes 16 bytes, and needs no allocator. Elements are stored on the heap,
+// or after moveToPool(), in an SSPool, where identical arrays are shared and never freed individually.
+// Pooled arrays are read-only: edit() copies one to the heap before returning a modifiable pointer.
+// Copies are always stored on the heap. Elements must be safe to copy bytewise once moved to a pool.
+
+template <class T> class SSCompactArray
+{
+protected:
+
+    // Bytes 0-7 hold a pointer to the elements, bytes 8-11 hold their 32-bit count,
+    // and byte 15 holds kHeap or kPooled. Unused bytes are always zero, as in SSCompactString.
+
+    enum { kHeap = 0, kPooled = 1 };
+
+    char _bytes[16];
+
+    T *pointer ( void ) const { T *p; memcpy ( &p, _bytes, sizeof ( p ) ); return p; }
+
+    void set ( T *p, size_t n, int tag )
+    {
+        uint32_t count = (uint32_t) n;
+        memset ( _bytes, 0, sizeof ( _bytes ) );
+        memcpy ( _bytes, &p, sizeof ( p ) );
+        memcpy ( _bytes + 8, &count, sizeof ( count ) );
+        _bytes[15] = tag;
+    }
+
+    void release ( void ) { if ( _bytes[15] == kHeap ) delete [] pointer(); }
+
+public:
+
+    SSCompactArray ( void ) { set ( nullptr, 0, kHeap ); }
+    explicit SSCompactArray ( size_t n ) { set ( n > 0 ? new T[n] : nullptr, n, kHeap ); }
+    SSCompactArray ( const T *p, size_t n ) { set ( nullptr, 0, kHeap ); assign ( p, n ); }
+    SSCompactArray ( const SSCompactArray &other ) { set ( nullptr, 0, kHeap ); assign ( other.begin(), other.size() ); }
+    SSCompactArray ( SSCompactArray &&other ) { memcpy ( _bytes, other._bytes, sizeof ( _bytes ) ); other.set ( nullptr, 0, kHeap ); }
+    ~SSCompactArray ( void ) { release(); }
+
+    SSCompactArray &operator = ( const SSCompactArray &other )
+    {
+        if ( this != &other )
+            assign ( other.begin(), other.size() );
+        return *this;
+    }
+
+    SSCompactArray &operator = ( SSCompactArray &&other )
+    {
+        if ( this != &other )
+        {
+            release();
+            memcpy ( _bytes, other._bytes, sizeof ( _bytes ) );
+            other.set ( nullptr, 0, kHeap );
+        }
+        return *this;
+    }
+
+    size_t size ( void ) const { uint32_t n; memcpy ( &n, _bytes + 8, sizeof ( n ) ); return n; }
+    bool empty ( void ) const { return size() == 0; }
+    bool isPooled ( void ) const { return _bytes[15] == kPooled; }
+    const T *begin ( void ) const { return pointer(); }
+    const T *end ( void ) const { return pointer() + size(); }
+    const T &operator [] ( size_t i ) const { return pointer()[i]; }
+
+    // Replaces this array's elements with copies of (n) elements starting at (p), which may be in this array.
+
+    void assign ( const T *p, size_t n )
+    {
+        T *q = n > 0 ? new T[n] : nullptr;
+        for ( size_t i = 0; i < n; i++ )
+            q[i] = p[i];
+
+        release();
+        set ( q, n, kHeap );
+    }
+
+    // Appends a copy of an element to the end of this array. Reallocates the whole array,
+    // so this is only meant for the short lists of names and identifiers objects have.
+
+    void push_back ( const T &value )
+    {
+        size_t n = size();
+        T *q = new T[n + 1];
+        if ( isPooled() )
+            for ( size_t i = 0; i < n; i++ )
+                q[i] = pointer()[i];
+        else
+            for ( size_t i = 0; i < n; i++ )
+                q[i] = std::move ( pointer()[i] );
+
+        q[n] = value;
+        release();
+        set ( q, n + 1, kHeap );
+    }
+
+    // Returns a modifiable pointer to this array's elements, copying them to the heap first if pooled.
+
+    T *edit ( void )
+    {
+        if ( isPooled() )
+            assign ( begin(), size() );
+        return pointer();
+    }
+
+    // Moves this array's elements, and then the array itself, into a pool (pPool).
+
+    void moveToPool ( SSPool *pPool )
+    {
+        size_t n = size();
+        if ( isPooled() || n == 0 )
+            return;
+
+        T *p = pointer();
+        for ( size_t i = 0; i < n; i++ )
+            SSMoveToPool ( p[i], pPool );
+
+        const void *q = pPool->intern ( p, n * sizeof ( T ), alignof ( T ) );
+        delete [] p;
+        set ( (T *) q, n, kPooled );
+    }
+};
+
+#endif /* SSArena_hpp */
@@ -0,0 +1,394 @@
+// SSChebyshevEphemeris.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// Fits, writes, and reads precomputed Chebyshev ephemeris files for asteroids and comets.
+// A file starts with a fixed-size header, followed by one index entry per object sorted by
+// identifier, followed by every object's coefficients. All values are stored in the native
+// byte order of the machine which wrote the file.
+
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "SSChebyshevEphemeris.hpp"
+#include "SSCoordinates.hpp"
+#include "SSNBody.hpp"
+
+static const char kChebyshevMagic[8] = { 'S', 'S', 'C', 'O', 'R', 'E', 'C', 'H' };
+static const uint32_t kChebyshevByteOrder = 0x01020304;
+
+// Ephemeris file header, like SSSnapshotHeader.
+
+struct SSChebyshevHeader
+{
+    char     magic[8];      // always kChebyshevMagic
+    uint32_t version;       // file format version, kSSChebyshevEphemerisVersion
+    uint32_t byteOrder;     // kChebyshevByteOrder, as written by the machine which created the file
+    uint64_t count;         // number of index entries following the header
+    uint64_t size;          // total file size in bytes, including header
+    double   accuracy;      // position accuracy in AU the series were fitted to
+};
+
+SSChebyshevEphemeris::SSChebyshevEphemeris ( void )
+{
+    _entries = nullptr;
+    _count = 0;
+    _accuracy = 0.0;
+}
+
+SSChebyshevEphemeris::SSChebyshevEphemeris ( const string &filename ) : SSChebyshevEphemeris()
+{
+    open ( filename );
+}
+
+// Memory-maps an ephemeris file and validates its header and index, so compute()
+// never needs to check for coefficients outside the file.
+
+bool SSChebyshevEphemeris::open ( const string &filename )
+{
+    close();
+
+    unique_ptr<SSMappedFile> file ( new SSMappedFile ( filename ) );
+    if ( file->data() == nullptr || file->size() < sizeof ( SSChebyshevHeader ) )
+        return false;
+
+    SSChebyshevHeader header;
+    memcpy ( &header, file->data(), sizeof ( header ) );
+    if ( memcmp ( header.magic, kChebyshevMagic, sizeof ( header.magic ) ) != 0 || header.version != kSSChebyshevEphemerisVersion
+        || header.byteOrder != kChebyshevByteOrder || header.size != file->size() )
+        return false;
+
+    if ( header.count > ( file->size() - sizeof ( header ) ) / sizeof ( Entry ) )
+        return false;
+
+    // The header and entries are multiples of 8 bytes long, and mapped files start on a page boundary,
+    // so entries and coefficients can be read in place.
+
+    const Entry *entries = (const Entry *) ( file->data() + sizeof ( header ) );
+    for ( uint64_t i = 0; i < header.count; i++ )
+    {
+        const Entry &entry = entries[i];
+        if ( entry.coeffs < 1 || entry.coeffs > kMaxCoefficients || entry.offset % sizeof ( double ) != 0 || ! ( entry.step > 0.0 ) )
+            return false;
+
+        uint64_t bytes = (uint64_t) entry.segments * 3 * entry.coeffs * sizeof ( double );
+        if ( entry.offset > file->size() || bytes > file->size() - entry.offset )
+            return false;
+
+        if ( i > 0 && entries[i - 1].ident >= entry.ident )
+            return false;
+    }
+
+    _file = move ( file );
+    _entries = entries;
+    _count = header.count;
+    _accuracy = header.accuracy;
+    return true;
+}
+
+void SSChebyshevEphemeris::close ( void )
+{
+    _file.reset();
+    _entries = nullptr;
+    _count = 0;
+    _accuracy = 0.0;
+}
+
+// Returns index entry for an object, or null if the object isn't in the file, or its series'
+// error exceeds the file's accuracy, so callers fall back to the object's orbital elements.
+
+const SSChebyshevEphemeris::Entry *SSChebyshevEphemeris::find ( SSIdentifier ident ) const
+{
+    int64_t id = ident;
+    const Entry *end = _entries + _count;
+    const Entry *pEntry = lower_bound ( _entries, end, id, []( const Entry &entry, int64_t id ) { return entry.ident < id; } );
+    return pEntry != end && pEntry->ident == id && pEntry->error <= _accuracy ? pEntry : nullptr;
+}
+
+bool SSChebyshevEphemeris::covers ( SSIdentifier ident, double jde ) const
+{
+    const Entry *pEntry = find ( ident );
+    return pEntry && jde >= pEntry->jde0 && jde <= pEntry->jde0 + pEntry->segments * pEntry->step;
+}
+
+// Evaluates one segment's Chebyshev series (coeffs) of (n) X, then Y, then Z coefficients at normalized
+// time (x), from -1 at the start of the segment to +1 at the end. Returns position (pos), and velocity (vel)
+// from the series' derivative times (scale), which converts from normalized time to days.
+
+void SSChebyshevEphemeris::evaluate ( const double *coeffs, int n, double x, double scale, SSVector &pos, SSVector &vel )
+{
+    double t[kMaxCoefficients] = { 1.0, x }, d[kMaxCoefficients] = { 0.0, 1.0 };
+
+    for ( int j = 2; j < n; j++ )
+    {
+        t[j] = 2.0 * x * t[j - 1] - t[j - 2];
+        d[j] = 2.0 * t[j - 1] + 2.0 * x * d[j - 1] - d[j - 2];
+    }
+
+    double p[3] = { 0.0 }, v[3] = { 0.0 };
+    for ( int k = 0; k < 3; k++, coeffs += n )
+    {
+        for ( int j = n - 1; j >= 0; j-- )
+        {
+            p[k] += coeffs[j] * t[j];
+            v[k] += coeffs[j] * d[j];
+        }
+    }
+
+    pos = SSVector ( p[0], p[1], p[2] );
+    vel = SSVector ( v[0] * scale, v[1] * scale, v[2] * scale );
+}
+
+bool SSChebyshevEphemeris::compute ( SSIdentifier ident, double jde, SSVector &pos, SSVector &vel ) const
+{
+    const Entry *pEntry = find ( ident );
+    if ( pEntry == nullptr )
+        return false;
+
+    double s = ( jde - pEntry->jde0 ) / pEntry->step;
+    if ( ! ( s >= 0.0 && s <= pEntry->segments ) )
+        return false;
+
+    // The end of the last segment belongs to the last segment.
+
+    uint32_t k = min ( (uint32_t) s, pEntry->segments - 1 );
+    double x = 2.0 * ( s - k ) - 1.0;
+
+    const double *coeffs = (const double *) ( _file->data() + pEntry->offset ) + (size_t) k * 3 * pEntry->coeffs;
+    evaluate ( coeffs, pEntry->coeffs, x, 2.0 / pEntry->step, pos, vel );
+    return true;
+}
+
+// Chebyshev interpolation: samples the position function at the (coeffs) Chebyshev nodes of each
+// segment and converts the samples to coefficients with a discrete cosine transform. The error is
+// checked at the segment's ends and the points midway (in angle) between nodes, where it peaks.
+
+SSChebyshevEphemeris::Series SSChebyshevEphemeris::fit ( SSIdentifier ident, function<SSVector(double)> position, double jde0, double jde1, double accuracy, int coeffs )
+{
+    static const double kMaxStep = kMaxSegmentDays, kMinStep = kMinSegmentDays;
+
+    int n = clamp ( coeffs, 2, (int) kMaxCoefficients );
+    double span = max ( jde1 - jde0, kMinStep );
+    double step = kMaxStep;
+    while ( step > kMinStep && step / 2.0 >= span )
+        step /= 2.0;
+
+    vector<double> cosines ( n * n );
+    for ( int j = 0; j < n; j++ )
+        for ( int k = 0; k < n; k++ )
+            cosines[ j * n + k ] = cos ( M_PI * j * ( k + 0.5 ) / n );
+
+    Series series = { ident, jde0, step, 0, n, 0.0, { } };
+    vector<SSVector> samples ( n );
+
+    for ( ; step >= kMinStep; step /= 2.0 )
+    {
+        int segments = (int) ceil ( span / step );
+        series.step = step;
+        series.segments = segments;
+        series.error = 0.0;
+        series.data.assign ( (size_t) segments * 3 * n, 0.0 );
+
+        bool ok = true;
+        for ( int s = 0; s < segments && ok; s++ )
+        {
+            double mid = jde0 + ( s + 0.5 ) * step;
+            double *c = &series.data[ (size_t) s * 3 * n ];
+
+            for ( int k = 0; k < n; k++ )
+                samples[k] = position ( mid + 0.5 * step * cos ( M_PI * ( k + 0.5 ) / n ) );
+
+            for ( int j = 0; j < n; j++ )
+            {
+                SSVector sum ( 0.0, 0.0, 0.0 );
+                for ( int k = 0; k < n; k++ )
+                    sum += samples[k] * cosines[ j * n + k ];
+
+                double w = j == 0 ? 1.0 / n : 2.0 / n;
+                c[j] = sum.x * w;
+                c[j + n] = sum.y * w;
+                c[j + 2 * n] = sum.z * w;
+            }
+
+            for ( int k = 0; k <= n; k++ )
+            {
+                double x = cos ( M_PI * k / n );
+                SSVector pos, vel;
+                evaluate ( c, n, x, 1.0, pos, vel );
+                double error = ( pos - position ( mid + 0.5 * step * x ) ).magnitude();
+
+                // NaN errors (e.g. from invalid orbital elements) must fail, too.
+
+                if ( ! ( error <= series.error ) )
+                    series.error = error;
+            }
+
+            ok = series.error <= accuracy;
+        }
+
+        if ( ok || step / 2.0 < kMinStep )
+            break;
+    }
+
+    return series;
+}
+
+int SSChebyshevEphemeris::write ( const string &filename, const vector<Series> &series, double accuracy )
+{
+    // Sort series by identifier, leaving out all of any with the same identifier.
+
+    vector<const Series *> all, sorted;
+    for ( const Series &s : series )
+        all.push_back ( &s );
+
+    sort ( all.begin(), all.end(), []( const Series *a, const Series *b ) { return (int64_t) a->ident < (int64_t) b->ident; } );
+    for ( size_t i = 0, j = 0; i < all.size(); i = j )
+    {
+        j = i + 1;
+        while ( j < all.size() && (int64_t) all[j]->ident == (int64_t) all[i]->ident )
+            j++;
+
+        if ( j == i + 1 )
+            sorted.push_back ( all[i] );
+    }
+
+    // Build the whole file in memory: header, index, then coefficients.
+
+    uint64_t offset = sizeof ( SSChebyshevHeader ) + sorted.size() * sizeof ( Entry );
+    string buf ( offset, '\0' );
+
+    for ( size_t i = 0; i < sorted.size(); i++ )
+    {
+        const Series &s = *sorted[i];
+        Entry entry = { (int64_t) s.ident, s.jde0, s.step, (uint32_t) s.segments, (uint32_t) s.coeffs, buf.size(), s.error };
+        memcpy ( &buf[ sizeof ( SSChebyshevHeader ) + i * sizeof ( Entry ) ], &entry, sizeof ( entry ) );
+        buf.append ( (const char *) s.data.data(), s.data.size() * sizeof ( double ) );
+    }
+
+    SSChebyshevHeader header = {};
+    memcpy ( header.magic, kChebyshevMagic, sizeof ( header.magic ) );
+    header.version = kSSChebyshevEphemerisVersion;
+    header.byteOrder = kChebyshevByteOrder;
+    header.count = sorted.size();
+    header.size = buf.size();
+    header.accuracy = accuracy;
+    memcpy ( &buf[0], &header, sizeof ( header ) );
+
+    FILE *file = fopen ( filename.c_str(), "wb" );
+    if ( ! file )
+        return 0;
+
+    bool ok = fwrite ( buf.data(), 1, buf.size(), file ) == buf.size();
+    ok = fclose ( file ) == 0 && ok;
+
+    return ok ? (int) sorted.size() : 0;
+}
+
+// Fits series for (n) objects with identifiers (idents) and position function (position) on up to
+// (threads) threads, then writes all series with finite errors to a file. Objects whose identifiers
+// are shared with other objects are not fitted, since write() would leave them out anyway; that must
+// be decided before dropping failed fits, or a fragment's failure would let its parent through.
+// Objects are handed out to threads one at a time, since fitting a comet can take far longer than
+// an asteroid.
+
+static int fitAndWrite ( const string &filename, const vector<SSIdentifier> &idents, function<SSVector(size_t,double)> position, double jde0, double jde1, double accuracy, int threads )
+{
+    size_t n = idents.size();
+    vector<SSChebyshevEphemeris::Series> series ( n );
+
+    vector<int64_t> sorted ( idents.begin(), idents.end() );
+    sort ( sorted.begin(), sorted.end() );
+    auto shared = [&]( SSIdentifier ident ) { auto r = equal_range ( sorted.begin(), sorted.end(), (int64_t) ident ); return r.second - r.first > 1; };
+
+    if ( threads < 1 )
+        threads = max ( 1u, thread::hardware_concurrency() );
+
+    threads = (int) min ( (size_t) threads, max ( n, (size_t) 1 ) );
+
+    atomic<size_t> next ( 0 );
+    auto worker = [&] ( void )
+    {
+        for ( size_t i = next++; i < n; i = next++ )
+            if ( shared ( idents[i] ) )
+                series[i].error = NAN;
+            else
+                series[i] = SSChebyshevEphemeris::fit ( idents[i], [&]( double jde ) { return position ( i, jde ); }, jde0, jde1, accuracy );
+    };
+
+    vector<thread> pool;
+    for ( int t = 1; t < threads; t++ )
+        pool.push_back ( thread ( worker ) );
+
+    worker();
+    for ( thread &t : pool )
+        t.join();
+
+    series.erase ( remove_if ( series.begin(), series.end(), []( const SSChebyshevEphemeris::Series &s ) { return ! isfinite ( s.error ); } ), series.end() );
+    return SSChebyshevEphemeris::write ( filename, series, accuracy );
+}
+
+// Fits the objects' Keplerian orbits directly, not SSPlanet::computePositionVelocity(),
+// which would read any Chebyshev ephemeris already in use instead of the orbits.
+
+int SSExportChebyshevEphemeris ( const string &filename, SSObjectVec &objects, double jde0, double jde1, double accuracy, int threads )
+{
+    static SSMatrix matrix = SSCoordinates::getEclipticMatrix ( SSCoordinates::getObliquity ( SSTime::kJ2000 ) );
+    vector<SSIdentifier> idents;
+    vector<SSOrbit> orbits;
+
+    for ( size_t i = 0; i < objects.size(); i++ )
+    {
+        SSPlanetPtr pPlanet = SSGetPlanetPtr ( objects[i] );
+        if ( pPlanet == nullptr || ( pPlanet->getType() != kTypeAsteroid && pPlanet->getType() != kTypeComet ) )
+            continue;
+
+        SSIdentifier ident = pPlanet->getIdentifier();
+        if ( ident == SSIdentifier() )
+            continue;
+
+        idents.push_back ( ident );
+        orbits.push_back ( pPlanet->getOrbit() );
+    }
+
+    auto position = [&]( size_t i, double jde )
+    {
+        SSVector pos, vel;
+        orbits[i].toPositionVelocity ( jde, pos, vel );
+        return matrix.multiply ( pos );
+    };
+
+    return fitAndWrite ( filename, idents, position, jde0, jde1, accuracy, threads );
+}
+
+// Integrating every body to both ends of the span first leaves checkpoints and planet positions
+// covering all of it. After that, computing one body's position anywhere in the span only reads
+// the shared planet table, so different bodies can be fitted on different threads. The far end
+// is where fit() may sample, one segment past (jde1), since going past the table would extend
+// it while other threads are reading it.
+
+int SSExportChebyshevEphemeris ( const string &filename, SSNBody &nbody, double jde0, double jde1, double accuracy, int threads )
+{
+    nbody.computePositionVelocity ( jde0, threads );
+    nbody.computePositionVelocity ( jde1 + SSChebyshevEphemeris::kMaxSegmentDays, threads );
+
+    vector<SSIdentifier> idents;
+    vector<size_t> bodies;
+
+    for ( size_t i = 0; i < nbody.size(); i++ )
+    {
+        SSPlanetPtr pPlanet = nbody.getPlanet ( i );
+        SSIdentifier ident = pPlanet ? pPlanet->getIdentifier() : SSIdentifier();
+        if ( ident == SSIdentifier() )
+            continue;
+
+        idents.push_back ( ident );
+        bodies.push_back ( i );
+    }
+
+    auto position = [&]( size_t i, double jde ) { return nbody.computePositionVelocity ( bodies[i], jde ).pos; };
+    return fitAndWrite ( filename, idents, position, jde0, jde1, accuracy, threads );
+}
@@ -0,0 +1,130 @@
+// SSChebyshevEphemeris.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// Precomputed Chebyshev polynomial ephemerides for asteroids and comets, stored in a binary
+// file indexed by SSIdentifier, much like JPL's DE files store the major planets. Each object's
+// heliocentric position over a span of dates is fitted, to a stated accuracy, with a series of
+// equal-length segments; within each segment, X, Y, and Z are Chebyshev polynomials in time.
+// Computing a position is then a binary search for the object plus one polynomial evaluation,
+// instead of solving Kepler's equation or numerically integrating the orbit. The file is
+// memory-mapped read-only, so any number of processes reading the same file share one copy.
+// Like SSSnapshot files, these files are only readable on machines with the same byte order
+// as the machine which wrote them.
+
+#ifndef SSChebyshevEphemeris_hpp
+#define SSChebyshevEphemeris_hpp
+
+#include <functional>
+#include <memory>
+
+#include "SSPlanet.hpp"
+
+class SSNBody;
+
+// Current Chebyshev ephemeris file format version. Increment whenever the file layout changes!
+
+static constexpr int kSSChebyshevEphemerisVersion = 2;
+
+class SSChebyshevEphemeris
+{
+public:
+
+    static constexpr int kDefaultCoefficients = 12;     // default number of Chebyshev coefficients per coordinate per segment
+    static constexpr int kMaxCoefficients = 32;         // largest number of coefficients per coordinate allowed in a file
+    static constexpr double kMaxSegmentDays = 256.0;      // longest segment length tried by fit(), in days
+    static constexpr double kMinSegmentDays = 1.0 / 64.0; // shortest segment length tried by fit(), in days
+
+    // One object's fitted ephemeris, in memory, before it is written to a file.
+    // Positions are heliocentric, in AU, in the fundamental J2000 equatorial frame.
+
+    struct Series
+    {
+        SSIdentifier ident;     // object identifier
+        double jde0;            // Julian Ephemeris Date at start of first segment
+        double step;            // length of each segment in days
+        int segments;           // number of segments
+        int coeffs;             // number of Chebyshev coefficients per coordinate per segment
+        double error;           // largest position error found while fitting, in AU
+        vector<double> data;    // coefficients: for each segment, (coeffs) X coefficients, then Y, then Z
+    };
+
+protected:
+
+    // File index entry for one object. Entries are sorted by identifier.
+
+    struct Entry
+    {
+        int64_t  ident;         // object identifier
+        double   jde0;          // Julian Ephemeris Date at start of first segment
+        double   step;          // length of each segment in days
+        uint32_t segments;      // number of segments
+        uint32_t coeffs;        // number of Chebyshev coefficients per coordinate per segment
+        uint64_t offset;        // offset in bytes from start of file to first segment's coefficients
+        double   error;         // largest position error found while fitting, in AU
+    };
+
+    unique_ptr<SSMappedFile> _file;     // memory-mapped ephemeris file; null if none open
+    const Entry *_entries;              // index entries, in mapped file
+    size_t _count;                      // number of index entries
+    double _accuracy;                   // position accuracy in AU the file was fitted to
+
+    const Entry *find ( SSIdentifier ident ) const;
+    static void evaluate ( const double *coeffs, int n, double x, double scale, SSVector &pos, SSVector &vel );
+
+public:
+
+    SSChebyshevEphemeris ( void );
+    SSChebyshevEphemeris ( const string &filename );
+
+    // Opens and closes ephemeris file. Returns false if the file can't be opened, or was written
+    // by a different file format version or on a machine with different byte order, or is truncated.
+
+    bool open ( const string &filename );
+    bool isOpen ( void ) const { return _file != nullptr; }
+    void close ( void );
+
+    // Returns number of objects in file, the accuracy in AU they were fitted to,
+    // and whether an object's ephemeris covers a date.
+
+    size_t size ( void ) const { return _count; }
+    double accuracy ( void ) const { return _accuracy; }
+    bool covers ( SSIdentifier ident, double jde ) const;
+
+    // Computes object's heliocentric position (pos) and velocity (vel) vectors in AU and AU/day,
+    // in the fundamental J2000 equatorial frame, at Julian Ephemeris Date (jde). Returns false
+    // and leaves vectors unchanged if the object isn't in the file, or its series could not be
+    // fitted to the file's accuracy, or (jde) is outside its span.
+    // Only reads the mapped file, so it's safe to call from any number of threads at once.
+
+    bool compute ( SSIdentifier ident, double jde, SSVector &pos, SSVector &vel ) const;
+
+    // Fits Chebyshev series with (coeffs) coefficients to an object's heliocentric position
+    // function (position) from Julian Ephemeris Dates (jde0) to (jde1). Uses the longest segment
+    // length, halving from 256 days down to 1/64 day, for which every segment's position error
+    // is under (accuracy) AU at points midway between the fitted ones. The last segment may end
+    // up to one segment length, i.e. at most kMaxSegmentDays, after (jde1); (position) is sampled
+    // there too. The series' error field records the largest error actually found, which may
+    // exceed (accuracy) for near-parabolic comets close to the Sun.
+
+    static Series fit ( SSIdentifier ident, function<SSVector(double)> position, double jde0, double jde1, double accuracy, int coeffs = kDefaultCoefficients );
+
+    // Writes fitted series to a binary ephemeris file, recording the (accuracy) in AU they were
+    // fitted to. Series whose identifier is shared by another series, like comet fragments which
+    // share their parent's identifier, are all left out, since compute() could not tell them apart.
+    // Returns number of series written, or zero on failure.
+
+    static int write ( const string &filename, const vector<Series> &series, double accuracy );
+};
+
+// Fits Chebyshev ephemerides for all asteroids and comets in an object array (objects), or all bodies
+// in an n-body integration (nbody), from Julian Ephemeris Dates (jde0) to (jde1) to the given accuracy
+// in AU, on up to (threads) threads, and writes them to a file. Objects without identifiers, or whose
+// identifiers are shared by other objects, are skipped.
+// Returns number of objects written, or zero on failure.
+
+int SSExportChebyshevEphemeris ( const string &filename, SSObjectVec &objects, double jde0, double jde1, double accuracy, int threads = 0 );
+int SSExportChebyshevEphemeris ( const string &filename, SSNBody &nbody, double jde0, double jde1, double accuracy, int threads = 0 );
+
+#endif /* SSChebyshevEphemeris_hpp */
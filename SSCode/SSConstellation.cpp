@@ -4,6 +4,7 @@
 // Created by Tim DeBenedictis on 3/25/20.
 // Copyright © 2020 Southern Stars. All rights reserved.
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <map>
@@ -43,7 +44,7 @@ SSConstellation::SSConstellation ( SSObjectType type ) : SSObject ( type )
 string SSConstellation::indexToAbbreviation ( int index )
 {
     if ( index >=1 && index <= 88 )
-        return _convec[index];
+        return _convec[index - 1];
     else
         return "";
 }
@@ -76,13 +77,22 @@ SSConstellationPtr SSGetConstellationPtr ( SSObjectPtr ptr )
 
 SSObjectPtr SSConstellation::fromCSV ( string csv )
 {
-    vector<string> fields = split ( csv, "," );
-    
+    vector<SSStringView> fields;
+    split ( csv, ',', fields );
+    return fromCSV ( fields );
+}
+
+// Allocates a new SSConstellation and initializes it from a CSV-formatted string which has already
+// been split into fields, without copying them. Returns nullptr on error, like fromCSV ( string ).
+// The constellation is allocated in an arena (pArena) if not null, as with SSNewObject().
+
+SSObjectPtr SSConstellation::fromCSV ( vector<SSStringView> &fields, SSObjectArena *pArena )
+{
     SSObjectType type = SSObject::codeToType ( fields[0] );
     if ( type < kTypeConstellation || type > kTypeAsterism || fields.size() < 8 )
         return nullptr;
     
-	SSObjectPtr pObject = SSNewObject ( type );
+	SSObjectPtr pObject = SSNewObject ( type, pArena );
     SSConstellationPtr pCon = SSGetConstellationPtr ( pObject );
     if ( pCon == nullptr )
         return nullptr;
@@ -94,7 +104,7 @@ SSObjectPtr SSConstellation::fromCSV ( string csv )
     pCon->setDirection ( center );
     pCon->setArea ( degtorad ( degtorad ( strtofloat64 ( fields[3] ) ) ) );
     pCon->setRank ( strtoint ( fields[4] ) );
-    pCon->setNames ( vector<string> ( &fields[5], &fields[8] ) );
+    pCon->setNames ( { fields[5].str(), fields[6].str(), fields[7].str() } );
 
     return pObject;
 }
@@ -114,7 +124,7 @@ string SSConstellation::toCSV ( void )
     csv += _rank < 1 ? "," : format ( "%d,", _rank );
     
     for ( int i = 0; i < _names.size(); i++ )
-        csv += _names[i] + ",";
+        csv += getName ( i ) + ",";
     
     return csv;
 }
@@ -755,18 +765,193 @@ static CData _table[357] =
     {  0.0000, 24.0000, -90.0000, "Oct" }
 };
 
-// identifies constellation from position in B1875 equatorial cooordinates
-// (ra,dec) both in radians; returns 3-letter constellation abbreviation string.
+// Index into the boundary table above, so a constellation can be identified in near-constant time
+// instead of by a linear scan. The table's distinct lower declination limits divide the sky into bands;
+// within a band, the same table rows are eligible at every declination, so the first matching row
+// depends only on RA. Each band stores the sorted RA limits of its eligible rows, and the first
+// matching row for each interval between them. One-degree declination cells and 15-minute RA cells
+// give a starting band and interval, which are at most a few steps from the right ones.
+// Results are identical to scanning the table.
 
-string SSConstellation::identify ( double ra, double dec )
+static const int kDecCells = 180;   // number of one-degree declination cells from -90 to +90 degrees
+static const int kRACells = 96;     // number of 15-minute RA cells per band from 0 to 24 hours
+
+struct CBand
+{
+    double decl;        // band's lower declination limit, B1875.0 [decimal degrees]; bands are sorted by decreasing decl
+    int first;          // index of band's first RA interval in CIndex ras and rows vectors
+    int count;          // number of RA intervals in band
+};
+
+struct CIndex
+{
+    vector<CBand> bands;    // declination bands
+    vector<double> ras;     // lower RA limit of each interval [decimal hours]; intervals extend to the next limit, or 24h
+    vector<int> rows;       // table row matching each interval, or -1 if none
+    vector<int> indices;    // constellation index (1-88) of each table row
+    vector<int> decCells;   // first band at or below the top of each declination cell
+    vector<int> raCells;    // for each band, kRACells entries: last interval starting at or before each RA cell
+};
+
+// Returns the index of the first table row containing (ra,dec) in decimal hours and degrees, by linear scan,
+// or -1 if none does. Used to build the index, and by identifyByScan().
+
+static int scanTable ( double ra, double dec )
+{
+    int n = sizeof ( _table ) / sizeof ( _table[0] );
+    for ( int i = 0; i < n; i++ )
+        if ( ra >= _table[i].ral && ra < _table[i].rau && dec >= _table[i].decl )
+            return i;
+
+    return -1;
+}
+
+// Builds the index. Since the band's declination is its lowest, a table row is eligible anywhere in the band
+// exactly when it is eligible at the band's lower limit; and since table RA intervals are closed at the bottom
+// and open at the top, the first matching row is the same everywhere between two adjacent RA limits.
+
+static CIndex makeIndex ( void )
+{
+    int n = sizeof ( _table ) / sizeof ( _table[0] );
+    CIndex index;
+    
+    vector<double> decs;
+    for ( int i = 0; i < n; i++ )
+    {
+        decs.push_back ( _table[i].decl );
+        index.indices.push_back ( SSConstellation::abbreviationToIndex ( _table[i].con ) );
+    }
+    
+    sort ( decs.begin(), decs.end(), greater<double>() );
+    decs.erase ( unique ( decs.begin(), decs.end() ), decs.end() );
+
+    for ( double decl : decs )
+    {
+        vector<double> limits;
+        for ( int i = 0; i < n; i++ )
+        {
+            if ( _table[i].decl <= decl )
+            {
+                limits.push_back ( _table[i].ral );
+                limits.push_back ( _table[i].rau );
+            }
+        }
+        
+        sort ( limits.begin(), limits.end() );
+        limits.erase ( unique ( limits.begin(), limits.end() ), limits.end() );
+
+        CBand band = { decl, (int) index.ras.size(), 0 };
+        for ( double ra : limits )
+        {
+            if ( ra >= 24.0 )
+                break;
+            
+            index.ras.push_back ( ra );
+            index.rows.push_back ( scanTable ( ra, decl ) );
+            band.count++;
+        }
+        
+        for ( int c = 0, i = band.first; c < kRACells; c++ )
+        {
+            while ( i + 1 < band.first + band.count && index.ras[i + 1] <= c * 24.0 / kRACells )
+                i++;
+            index.raCells.push_back ( i );
+        }
+        
+        index.bands.push_back ( band );
+    }
+    
+    index.decCells.resize ( kDecCells );
+    for ( int c = kDecCells - 1, b = 0; c >= 0; c-- )
+    {
+        while ( b + 1 < (int) index.bands.size() && index.bands[b].decl > c + 1 - 90.0 )
+            b++;
+        index.decCells[c] = b;
+    }
+    
+    return index;
+}
+
+// Returns the index, building it the first time it's needed. Thread-safe.
+
+static const CIndex &getIndex ( void )
+{
+    static const CIndex index = makeIndex();
+    return index;
+}
+
+// Converts (ra,dec) from radians to table units, decimal hours and degrees. RA outside 0 to 24h
+// is wrapped into that range; declination below -90 degrees is treated as -90.
+// Returns false if either coordinate is not a number.
+
+static bool toTableUnits ( double &ra, double &dec )
 {
     ra *= SSAngle::kHourPerRad;
     dec *= SSAngle::kDegPerRad;
+    if ( ra < 0.0 || ra >= 24.0 )
+        ra -= 24.0 * floor ( ra / 24.0 );
+    if ( ra >= 24.0 )
+        ra = 0.0;
+    if ( dec < -90.0 )
+        dec = -90.0;
+    return ra >= 0.0 && dec >= -90.0;
+}
+
+// Returns index of the first table row containing (ra,dec) in radians, using the precomputed index.
+// Returns -1 if either coordinate is not a number.
+
+static int findRow ( double ra, double dec )
+{
+    const CIndex &index = getIndex();
+    
+    if ( ! toTableUnits ( ra, dec ) )
+        return -1;
+    
+    // Find first band whose lower limit is at or below dec. The declination cell's starting band
+    // is never below the right one, since cells are rounded down and start at the cell's top.
     
-    int i = 0;
-    while ( ra < _table[i].ral || ra >= _table[i].rau || dec < _table[i].decl )
+    int b = index.decCells[ min ( (int) ( dec + 90.0 ), kDecCells - 1 ) ];
+    while ( index.bands[b].decl > dec )
+        b++;
+    
+    // Find last RA interval in band starting at or before ra. Rounding may put ra in the next RA cell up
+    // when it's just below a cell boundary, so step back as well as forward.
+    
+    const CBand &band = index.bands[b];
+    int i = index.raCells[ b * kRACells + min ( (int) ( ra * kRACells / 24.0 ), kRACells - 1 ) ];
+    while ( i + 1 < band.first + band.count && index.ras[i + 1] <= ra )
         i++;
-    return string ( _table[i].con );
+    while ( i > band.first && index.ras[i] > ra )
+        i--;
+    
+    return index.ras[i] <= ra ? index.rows[i] : -1;
+}
+
+// identifies constellation from position in B1875 equatorial cooordinates
+// (ra,dec) both in radians; returns 3-letter constellation abbreviation string,
+// or empty string if coordinates are invalid.
+
+string SSConstellation::identify ( double ra, double dec )
+{
+    int row = findRow ( ra, dec );
+    return row < 0 ? string ( "" ) : string ( _table[row].con );
+}
+
+// As above, but scans the boundary table row by row without using the index, as identify() used to.
+// Much slower; this is the reference the index is built from, and can be tested against.
+
+string SSConstellation::identifyByScan ( double ra, double dec )
+{
+    int row = toTableUnits ( ra, dec ) ? scanTable ( ra, dec ) : -1;
+    return row < 0 ? string ( "" ) : string ( _table[row].con );
+}
+
+// Returns matrix which transforms J2000 equatorial vectors to B1875 equatorial vectors.
+
+static const SSMatrix &getB1875Matrix ( void )
+{
+    static const SSMatrix precess = SSCoordinates::getPrecessionMatrix ( SSTime::fromBesselianYear ( 1875.0 ) );
+    return precess;
 }
 
 // identifies constellation from unit position vector in J2000 equatorial cooordinates.
@@ -774,7 +959,42 @@ string SSConstellation::identify ( double ra, double dec )
 
 string SSConstellation::identify ( SSVector position )
 {
-    static SSMatrix precess = SSCoordinates::getPrecessionMatrix ( SSTime::fromBesselianYear ( 1875.0 ) );
-    SSSpherical coords = precess * position;
+    SSSpherical coords = getB1875Matrix() * position;
     return identify ( coords.lon, coords.lat );
 }
+
+// As above, but return constellation index from 1 (And) to 88 (Vul), or zero if coordinates are invalid.
+
+int SSConstellation::identifyIndex ( double ra, double dec )
+{
+    int row = findRow ( ra, dec );
+    return row < 0 ? 0 : getIndex().indices[row];
+}
+
+int SSConstellation::identifyIndex ( SSVector position )
+{
+    SSSpherical coords = getB1875Matrix() * position;
+    return identifyIndex ( coords.lon, coords.lat );
+}
+
+// Identifies constellations of an array of (count) J2000 equatorial unit vectors (positions), and stores
+// their constellation indices in (indices). Precesses positions to B1875 in blocks with SIMD instructions;
+// results are identical to identifyIndex ( SSVector ).
+
+void SSConstellation::identifyIndex ( const SSVector *positions, size_t count, int *indices )
+{
+    static const size_t kBlock = 256;
+    SSMatrix precess = getB1875Matrix();
+    SSVector block[kBlock];
+
+    for ( size_t i = 0; i < count; i += kBlock )
+    {
+        size_t n = min ( kBlock, count - i );
+        precess.multiply ( positions + i, block, n );
+        for ( size_t k = 0; k < n; k++ )
+        {
+            SSSpherical coords ( block[k] );
+            indices[i + k] = identifyIndex ( coords.lon, coords.lat );
+        }
+    }
+}
@@ -51,12 +51,21 @@ public:
     // imports/exports from/to CSV-format text string
     
     static SSObjectPtr fromCSV ( string csv );
+    static SSObjectPtr fromCSV ( vector<SSStringView> &fields, SSObjectArena *pArena = nullptr );
     string toCSV ( void );
     
     // identifies constellation from equatorial cooordinates (B1875 spherical or J2000 rectangular unit vector)
     
     static string identify ( double ra, double dec );   // B1875 coordinates
     static string identify ( SSVector position );       // J2000 coordinates
+    static string identifyByScan ( double ra, double dec ); // B1875 coordinates, by linear scan of boundary table; slow
+
+    // As above, but returns constellation index (1 = And ... 88 = Vul), or 0 if coordinates are invalid; and for
+    // arrays of (count) J2000 unit vectors. Uses a precomputed index of the boundary table, in O(log n) time.
+
+    static int identifyIndex ( double ra, double dec );
+    static int identifyIndex ( SSVector position );
+    static void identifyIndex ( const SSVector *positions, size_t count, int *indices );
 };
 
 // convenient alias for pointer to SSConstellation
@@ -20,6 +20,13 @@ SSCoordinates::SSCoordinates ( SSTime time, SSSpherical loc )
     _lat = loc.lat;
     _alt = loc.rad;
     
+    _smoothTime = false;
+    _smoothFit = false;
+    _smoothSpan = kSmoothTimeWindow / 2.0;
+    _smoothJD = 0.0;
+    _smoothDeltaT = 0.0;
+    _smoothDeltaTGen = _smoothEphemGen = 0;
+    
     setTime ( time );
     
     _starParallax = true;
@@ -30,18 +37,31 @@ SSCoordinates::SSCoordinates ( SSTime time, SSSpherical loc )
 
 // Changes this coordinate transformation object's Julian Date (time) and recomputes
 // all of its time-dependent quantites and matrices, without changing the observer's
-// longitude, latitude, or altitude.
+// longitude, latitude, or altitude. In smooth time mode, slowly-varying quantities
+// are interpolated from a cached fit instead; see setSmoothTime().
 
 void SSCoordinates::setTime ( SSTime time )
 {
     _jd = time;
     _jed = time.getJulianEphemerisDate();
-
-    getNutationConstants ( _jd, _de, _dl );
-    _obq = getObliquity ( _jd );
-    _lst = time.getSiderealTime ( SSAngle ( _lon + _dl * cos ( _obq + _de ) ) );
     
-    _preMat = getPrecessionMatrix ( _jd );
+    if ( _smoothTime )
+    {
+        double f[kSmoothValues];
+        interpolateSmoothTime ( _jd, f );
+        _obq = f[0];
+        _de = f[1];
+        _dl = f[2];
+        _preMat = SSMatrix ( f[3], f[4], f[5], f[6], f[7], f[8], f[9], f[10], f[11] );
+    }
+    else
+    {
+        getNutationConstants ( _jd, _de, _dl );
+        _obq = getObliquity ( _jd );
+        _preMat = getPrecessionMatrix ( _jd );
+    }
+    
+    _lst = time.getSiderealTime ( SSAngle ( _lon + _dl * cos ( _obq + _de ) ) );
     _nutMat = getNutationMatrix ( _obq, _dl, _de );
     _equMat = _nutMat * ( _preMat );
     _eclMat = getEclipticMatrix ( - _obq - _de ) * _equMat;
@@ -50,6 +70,108 @@ void SSCoordinates::setTime ( SSTime time )
     setLocation ( SSSpherical ( _lon, _lat, _alt ) );
 }
 
+// Turns smooth time mode on or off. In smooth time mode, setTime() does not recompute obliquity,
+// nutation, precession, or Earth's heliocentric position and velocity from their full series.
+// Instead, each is interpolated with a quartic polynomial through exact values at five
+// equally-spaced nodes across a window (window) days wide. When the time moves outside the window,
+// a new window is centered on it; the other nodes are only computed once a second time falls
+// inside the same window, so widely-spaced times never cost more than in exact mode.
+// Delta T, sidereal time, and the observer's geocentric offset are always recomputed exactly;
+// Delta T jumps at leap seconds, which a polynomial fit would smear across the whole window.
+// A new window is also started after Delta T tables are imported, or the planetary ephemeris changes.
+// With the default one-day window, interpolation errors are below 1.0e-6 arcsec in nutation,
+// obliquity, and precession; and 10 meters in Earth's position (0.005 arcsec in the Moon's
+// apparent direction). This is far below the 0.5 arcsec accuracy of the nutation theory itself.
+// Error grows with the fifth power of window width. Smooth time mode is meant for event searches
+// and animations which call setTime() thousands of times over short intervals.
+
+void SSCoordinates::setSmoothTime ( bool smooth, double window )
+{
+    _smoothTime = smooth;
+    _smoothSpan = window / 2.0;
+    _smoothJD = 0.0;
+    _smoothFit = false;
+    setTime ( _jd );
+}
+
+// Computes exact values of all quantities interpolated in smooth time mode at Julian Date (jd):
+// mean obliquity, nutation in obliquity and longitude, precession matrix elements, and Earth's
+// heliocentric position and velocity in the fundamental frame. Earth's position is computed with
+// the window's fixed Delta T, so it's smooth in (jd); setLocation() corrects it to the actual Delta T.
+
+void SSCoordinates::computeSmoothNode ( double jd, double *values )
+{
+    double de = 0.0, dl = 0.0;
+    SSVector pos, vel;
+
+    getNutationConstants ( jd, de, dl );
+    SSMatrix pre = getPrecessionMatrix ( jd );
+    SSPlanet::computeMajorPlanetPositionVelocity ( kEarth, jd + _smoothDeltaT, 0.0, pos, vel );
+
+    double v[kSmoothValues] = { getObliquity ( jd ), de, dl,
+                                pre.m00, pre.m01, pre.m02, pre.m10, pre.m11, pre.m12, pre.m20, pre.m21, pre.m22,
+                                pos.x, pos.y, pos.z, vel.x, vel.y, vel.z };
+    
+    for ( int k = 0; k < kSmoothValues; k++ )
+        values[k] = v[k];
+}
+
+// Obtains values of all smooth time quantities at Julian Date (jd); see computeSmoothNode().
+// If jd is outside the current fit window, or the Delta T tables or planetary ephemeris have changed
+// since the window was started, starts a new window centered on jd and returns exact values.
+// Otherwise interpolates from the window nodes, after computing any nodes which are still missing.
+// Note setTime() and setLocation() both call this at the same jd, which never triggers a fit.
+
+void SSCoordinates::interpolateSmoothTime ( double jd, double *values )
+{
+    int center = kSmoothNodes / 2;
+    int deltaTGen = SSTime::getDeltaTGeneration(), ephemGen = SSPlanet::getEphemerisGeneration();
+
+    if ( _smoothJD == 0.0 || fabs ( jd - _smoothJD ) > _smoothSpan || deltaTGen != _smoothDeltaTGen || ephemGen != _smoothEphemGen )
+    {
+        _smoothDeltaT = SSTime ( jd ).getDeltaT() / SSTime::kSecondsPerDay;
+        _smoothDeltaTGen = deltaTGen;
+        _smoothEphemGen = ephemGen;
+        computeSmoothNode ( jd, _smoothNodes[center] );
+        _smoothJD = jd;
+        _smoothFit = false;
+    }
+    
+    if ( jd == _smoothJD )
+    {
+        for ( int k = 0; k < kSmoothValues; k++ )
+            values[k] = _smoothNodes[center][k];
+        return;
+    }
+    
+    if ( ! _smoothFit )
+    {
+        for ( int i = 0; i < kSmoothNodes; i++ )
+            if ( i != center )
+                computeSmoothNode ( _smoothJD + _smoothSpan * ( i - center ) / center, _smoothNodes[i] );
+        _smoothFit = true;
+    }
+    
+    // Lagrange interpolation weights for equally-spaced nodes from -1 to +1.
+    
+    double u = ( jd - _smoothJD ) / _smoothSpan, w[kSmoothNodes];
+    for ( int i = 0; i < kSmoothNodes; i++ )
+    {
+        double xi = (double) ( i - center ) / center;
+        w[i] = 1.0;
+        for ( int j = 0; j < kSmoothNodes; j++ )
+            if ( j != i )
+                w[i] *= ( u - (double) ( j - center ) / center ) / ( xi - (double) ( j - center ) / center );
+    }
+    
+    for ( int k = 0; k < kSmoothValues; k++ )
+    {
+        values[k] = 0.0;
+        for ( int i = 0; i < kSmoothNodes; i++ )
+            values[k] += w[i] * _smoothNodes[i][k];
+    }
+}
+
 // Changes this coordinate transformation object's observer longitude (loc.lon), latitude (loc.lat),
 // and altitude (loc.rad); and recomputes all of its location-dependent quantites and matrices,
 // without changing the time.  Longitude and latitude in radians; altitude in kilometers.
@@ -63,7 +185,17 @@ void SSCoordinates::setLocation ( SSSpherical loc )
     
     _horMat = getHorizonMatrix ( _lst, _lat ).multiply ( _equMat );
 
-    SSPlanet::computeMajorPlanetPositionVelocity ( kEarth, _jed, 0.0, _obsPos, _obsVel );
+    if ( _smoothTime )
+    {
+        double f[kSmoothValues];
+        interpolateSmoothTime ( _jd, f );
+        _obsVel = SSVector ( f[15], f[16], f[17] );
+        _obsPos = SSVector ( f[12], f[13], f[14] ) + _obsVel * ( _jed - _jd - _smoothDeltaT );
+    }
+    else
+    {
+        SSPlanet::computeMajorPlanetPositionVelocity ( kEarth, _jed, 0.0, _obsPos, _obsVel );
+    }
     
     SSSpherical geodetic ( _lst, _lat, _alt );
     SSVector geocentric = toGeocentric ( geodetic, kKmPerEarthRadii, kEarthFlattening );
@@ -397,6 +529,102 @@ SSVector SSCoordinates::transform ( SSFrame from, SSFrame to, SSVector vec )
     return vec;
 }
 
+// Returns a single matrix which transforms rectangular coordinates from one reference frame (from)
+// to another (to), by composing this object's frame matrices once. Use this instead of calling
+// transform() repeatedly when converting many vectors between the same pair of frames.
+
+SSMatrix SSCoordinates::getTransformMatrix ( SSFrame from, SSFrame to )
+{
+    SSMatrix mat = SSMatrix::identity();
+    
+    if ( from != to )
+    {
+        if ( from == kEquatorial )
+            mat = _equMat.transpose();
+        else if ( from == kEcliptic )
+            mat = _eclMat.transpose();
+        else if ( from == kGalactic )
+            mat = _galMat.transpose();
+        else if ( from == kHorizon )
+            mat = _horMat.transpose();
+        
+        if ( to == kEquatorial )
+            mat = _equMat * mat;
+        else if ( to == kEcliptic )
+            mat = _eclMat * mat;
+        else if ( to == kGalactic )
+            mat = _galMat * mat;
+        else if ( to == kHorizon )
+            mat = _horMat * mat;
+    }
+    
+    return mat;
+}
+
+// Transforms an array of (n) rectangular coordinate vectors (in) from one reference frame (from)
+// to another (to), and stores them in an output array (out), which may be the same as the input.
+// The frame-to-frame matrix is composed once, then applied to all vectors with a SIMD kernel.
+// Results may differ from transform ( from, to, vec ) in the last bit, since that applies two matrices in turn.
+
+void SSCoordinates::transform ( SSFrame from, SSFrame to, const SSVector *in, SSVector *out, size_t n )
+{
+    getTransformMatrix ( from, to ).multiply ( in, out, n );
+}
+
+// As above, but for (n) vectors stored as separate arrays of x, y, z coordinates, which are
+// transformed into the output coordinate arrays (ox, oy, oz). These may be the same as the inputs.
+
+void SSCoordinates::transform ( SSFrame from, SSFrame to, const double *x, const double *y, const double *z, double *ox, double *oy, double *oz, size_t n )
+{
+    getTransformMatrix ( from, to ).multiply ( x, y, z, ox, oy, oz, n );
+}
+
+// Transforms an array of (n) rectangular coordinate vectors (in) from one reference frame (from)
+// to another (to), and converts them to spherical coordinates in an output array (out).
+// Use this to produce RA/Dec, ecliptic or galactic lon/lat, or azimuth/altitude in bulk.
+// Vectors are transformed in blocks, so no temporary storage proportional to (n) is needed.
+
+void SSCoordinates::toSpherical ( SSFrame from, SSFrame to, const SSVector *in, SSSpherical *out, size_t n )
+{
+    static const size_t kBlock = 256;
+    SSMatrix mat = getTransformMatrix ( from, to );
+    SSVector block[kBlock];
+
+    for ( size_t i = 0; i < n; i += kBlock )
+    {
+        size_t m = min ( kBlock, n - i );
+        mat.multiply ( in + i, block, m );
+        for ( size_t j = 0; j < m; j++ )
+            out[i + j] = SSSpherical ( block[j] );
+    }
+}
+
+// As above, but for (n) vectors stored as separate arrays of x, y, z coordinates, which are
+// converted to output arrays of longitude (lon), latitude (lat), and radial distance (rad).
+// Angles are in radians; longitudes are in the range 0 to 2 pi. Pass nullptr for (rad)
+// if distances are not needed, e.g. when input vectors are unit vectors.
+
+void SSCoordinates::toSpherical ( SSFrame from, SSFrame to, const double *x, const double *y, const double *z, double *lon, double *lat, double *rad, size_t n )
+{
+    static const size_t kBlock = 256;
+    SSMatrix mat = getTransformMatrix ( from, to );
+    double bx[kBlock], by[kBlock], bz[kBlock];
+    
+    for ( size_t i = 0; i < n; i += kBlock )
+    {
+        size_t m = min ( kBlock, n - i );
+        mat.multiply ( x + i, y + i, z + i, bx, by, bz, m );
+        for ( size_t j = 0; j < m; j++ )
+        {
+            double r = sqrt ( bx[j] * bx[j] + by[j] * by[j] + bz[j] * bz[j] );
+            lon[i + j] = SSAngle ( atan2 ( by[j], bx[j] ) ).mod2Pi();
+            lat[i + j] = asin ( bz[j] / r );
+            if ( rad )
+                rad[i + j] = r;
+        }
+    }
+}
+
 // Converts geodetic longitude, latitude, altitude to geocentric X, Y, Z vector.
 // geodetic.lon and .lat are in radians; geo.rad is altitude above geoid in same
 // units as equatorial radius of geoid ellipse (a). Geoid flattening (f) is ratio
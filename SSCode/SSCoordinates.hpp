@@ -37,6 +37,9 @@ class SSCoordinates
 {
 protected:
     
+    static constexpr int kSmoothNodes = 5;      // number of nodes in smooth time fit window
+    static constexpr int kSmoothValues = 18;    // number of quantities interpolated in smooth time mode
+    
     SSTime      _jd;             // Julian (Civil) Date, i.e. Julian Date in UTC, and local time zone in hours east of UTC
     double      _jed;            // Julian Ephemeris Date, i.e. Julian Date with Delta-T added (UTC to TDT)
     double      _lon;            // observer's longitude [radians, east positive]
@@ -62,6 +65,18 @@ protected:
     bool        _aberration;     // flag to apply aberration of light when computing all object's apparent directions; default true.
     bool        _lighttime;      // flag to apply light time correction when computing solar system object's apparent directions; default true.
 
+    bool        _smoothTime;     // flag to interpolate slowly-varying quantities from a cached fit in setTime(); default false.
+    bool        _smoothFit;      // true once all nodes of the current smooth time fit window have been computed.
+    double      _smoothSpan;     // half-width of smooth time fit window [days]
+    double      _smoothJD;       // Julian Date at center of current smooth time fit window; zero if none yet.
+    double      _smoothDeltaT;   // Delta T at center of current smooth time fit window [days]
+    int         _smoothDeltaTGen;    // SSTime::getDeltaTGeneration() when current smooth time fit window was started
+    int         _smoothEphemGen;     // SSPlanet::getEphemerisGeneration() when current smooth time fit window was started
+    double      _smoothNodes[kSmoothNodes][kSmoothValues];   // exact values at fit window nodes; see computeSmoothNode().
+
+    void computeSmoothNode ( double jd, double *values );
+    void interpolateSmoothTime ( double jd, double *values );
+
 public:
     
     static constexpr double kKmPerAU = 149597870.700;                               // kilometers per Astronomical Unit (IAU 2012)
@@ -75,6 +90,7 @@ public:
     static constexpr double kLYPerAU = 1.0 / kAUPerLY;                              // Light years per astronomical unit
     static constexpr double kLYPerParsec = kAUPerParsec / kAUPerLY;                 // Light years per parsec = 3.261563777179643
     static constexpr double kParsecPerLY = kAUPerLY / kAUPerParsec;                 // Parsecs per light year
+    static constexpr double kSmoothTimeWindow = 1.0;                                // Default width of smooth time fit window in days
 
     SSCoordinates ( SSTime time, SSSpherical location );
     
@@ -99,6 +115,9 @@ public:
     void setAberration ( bool aberration ) { _aberration = aberration; }
     void setLightTime ( bool lighttime ) { _lighttime = lighttime; }
     
+    bool getSmoothTime ( void ) { return _smoothTime; }
+    void setSmoothTime ( bool smooth, double window = kSmoothTimeWindow );
+    
     static double getObliquity ( double jd );
     static void   getNutationConstants ( double jd, double &de, double &dl );
     static void   getPrecessionConstants ( double jd, double &zeta, double &z, double &theta );
@@ -110,6 +129,14 @@ public:
     static SSMatrix getGalacticMatrix ( void );
 
     SSVector    transform ( SSFrame from, SSFrame to, SSVector vec );
+    SSMatrix    getTransformMatrix ( SSFrame from, SSFrame to );
+    
+    // bulk transformations of vector arrays, stored either as SSVectors or as separate x, y, z arrays
+    
+    void transform ( SSFrame from, SSFrame to, const SSVector *in, SSVector *out, size_t n );
+    void transform ( SSFrame from, SSFrame to, const double *x, const double *y, const double *z, double *ox, double *oy, double *oz, size_t n );
+    void toSpherical ( SSFrame from, SSFrame to, const SSVector *in, SSSpherical *out, size_t n );
+    void toSpherical ( SSFrame from, SSFrame to, const double *x, const double *y, const double *z, double *lon, double *lat, double *rad, size_t n );
     
     SSVector applyAberration ( SSVector direction );
     SSVector removeAberration ( SSVector direction );
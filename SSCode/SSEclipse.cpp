@@ -0,0 +1,507 @@
+// SSEclipse.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+
+#include <algorithm>
+
+#include "SSEclipse.hpp"
+#include "SSEvent.hpp"
+#include "SSPlanet.hpp"
+
+static const double kEarthE2 = SSCoordinates::kEarthFlattening * ( 2.0 - SSCoordinates::kEarthFlattening );    // square of Earth ellipsoid eccentricity
+static const double kAUPerEarthRadii = SSCoordinates::kKmPerAU / SSCoordinates::kKmPerEarthRadii;             // Earth equatorial radii per AU
+static const double kFitHours = 4.8;            // polynomials are fitted over this many hours either side of reference time; longest eclipses last about 6.5 hours
+static const double kNodeMargin = 0.99;         // at new or full moon, shadow axis is at least this fraction of its distance from its closest approach
+static const double kMoonRadiusPenumbra = 0.2725076;  // Moon's mean radius in Earth equatorial radii (IAU 1982), used for penumbral shadows and lunar eclipses
+static const double kMoonRadiusUmbra = 0.2722810;     // Moon's radius in Earth equatorial radii for umbral shadows, reduced for lunar valleys at the limb
+static const int kBisections = 60;              // bisection steps used to solve polynomials; shrinks a 10-hour range to far below one second
+
+// Returns radius of a solar system object (pObj) in Earth equatorial radii. The Moon's radius comes from
+// the constants above instead, which are the standard ones for eclipse predictions.
+
+static double radiusInEarthRadii ( SSObjectPtr pObj )
+{
+    SSPlanetPtr pPlanet = SSGetPlanetPtr ( pObj );
+    return pPlanet ? pPlanet->getRadius() / SSCoordinates::kKmPerEarthRadii : 0.0;
+}
+
+// Computes geocentric apparent positions of the Sun and Moon (pSun, pMoon) at Julian Date (jd) with geocentric coordinates (coords),
+// as rectangular vectors in the true equatorial frame of date, in Earth equatorial radii.
+
+static void sunMoonPositions ( SSCoordinates &coords, SSObjectPtr pSun, SSObjectPtr pMoon, double jd, SSVector &sun, SSVector &moon )
+{
+    coords.setTime ( SSTime ( jd ) );
+    pSun->computeEphemeris ( coords );
+    pMoon->computeEphemeris ( coords );
+
+    sun = coords.transform ( kFundamental, kEquatorial, pSun->getDirection() ) * ( pSun->getDistance() * kAUPerEarthRadii );
+    moon = coords.transform ( kFundamental, kEquatorial, pMoon->getDirection() ) * ( pMoon->getDistance() * kAUPerEarthRadii );
+}
+
+// Returns unit vectors (ex,ey) which point east and north in the plane perpendicular to unit vector (axis), whose
+// declination is returned in (dec) and right ascension in (ra).
+
+static void tangentPlane ( SSVector axis, SSVector &ex, SSVector &ey, double &ra, double &dec )
+{
+    ra = atan2 ( axis.y, axis.x );
+    dec = asin ( max ( -1.0, min ( 1.0, axis.z ) ) );
+    ex = SSVector ( -sin ( ra ), cos ( ra ), 0.0 );
+    ey = SSVector ( -sin ( dec ) * cos ( ra ), -sin ( dec ) * sin ( ra ), cos ( dec ) );
+}
+
+// Computes instantaneous Besselian elements at Julian Date (jd): x, y, d, mu, l1, l2, tan f1, tan f2, in that order, in (e).
+
+static void solarSample ( SSCoordinates &coords, SSObjectPtr pSun, SSObjectPtr pMoon, double jd, double e[8] )
+{
+    SSVector sun, moon, ex, ey;
+    sunMoonPositions ( coords, pSun, pMoon, jd, sun, moon );
+    double rs = radiusInEarthRadii ( pSun );
+
+    // Shadow axis runs from the Sun through the Moon; the fundamental plane is perpendicular to it.
+
+    SSVector g = sun - moon;
+    double dist = g.magnitude(), ra = 0.0, dec = 0.0;
+    g = g / dist;
+    tangentPlane ( g, ex, ey, ra, dec );
+    double z = moon * g;
+
+    double sinf1 = ( rs + kMoonRadiusPenumbra ) / dist, sinf2 = ( rs - kMoonRadiusUmbra ) / dist;
+    double tanf1 = sinf1 / sqrt ( 1.0 - sinf1 * sinf1 ), tanf2 = sinf2 / sqrt ( 1.0 - sinf2 * sinf2 );
+
+    e[0] = moon * ex;
+    e[1] = moon * ey;
+    e[2] = dec;
+    e[3] = coords.getLST() - ra;        // coordinates are geocentric at longitude zero, so local sidereal time is Greenwich sidereal time
+    e[4] = ( z + kMoonRadiusPenumbra / sinf1 ) * tanf1;
+    e[5] = ( z - kMoonRadiusUmbra / sinf2 ) * tanf2;
+    e[6] = tanf1;
+    e[7] = tanf2;
+}
+
+// Computes Moon's position relative to the Earth's shadow at Julian Date (jd): x and y of the Moon's center east and north
+// of the shadow axis, radii of umbra and penumbra, Moon's semidiameter (all in radians), and Moon's distance in Earth radii,
+// in that order, in (e). Shadow radii include Danjon's enlargement of the Earth's radius for its atmosphere.
+
+static void lunarSample ( SSCoordinates &coords, SSObjectPtr pSun, SSObjectPtr pMoon, double jd, double e[6] )
+{
+    SSVector sun, moon, ex, ey;
+    sunMoonPositions ( coords, pSun, pMoon, jd, sun, moon );
+
+    double sunDist = sun.magnitude(), moonDist = moon.magnitude(), ra = 0.0, dec = 0.0;
+    tangentPlane ( sun / -sunDist, ex, ey, ra, dec );
+
+    double moonPar = asin ( 1.0 / moonDist ), sunPar = asin ( 1.0 / sunDist );
+    double sunRad = asin ( radiusInEarthRadii ( pSun ) / sunDist );
+
+    e[0] = moon * ex / moonDist;
+    e[1] = moon * ey / moonDist;
+    e[2] = 1.01 * moonPar + sunPar - sunRad;
+    e[3] = 1.01 * moonPar + sunPar + sunRad;
+    e[4] = asin ( kMoonRadiusPenumbra / moonDist );
+    e[5] = moonDist;
+}
+
+// Fits a cubic polynomial (c) through four values (v) at times (t).
+
+static void fitCubic ( const double t[4], const double v[4], double c[4] )
+{
+    double a[4][5];
+    for ( int i = 0; i < 4; i++ )
+    {
+        a[i][0] = 1.0;
+        for ( int j = 1; j < 4; j++ )
+            a[i][j] = a[i][j - 1] * t[i];
+        a[i][4] = v[i];
+    }
+
+    // Gaussian elimination with partial pivoting, then back substitution.
+
+    for ( int k = 0; k < 4; k++ )
+    {
+        int p = k;
+        for ( int i = k + 1; i < 4; i++ )
+            if ( fabs ( a[i][k] ) > fabs ( a[p][k] ) )
+                p = i;
+        for ( int j = 0; j < 5; j++ )
+            swap ( a[k][j], a[p][j] );
+        for ( int i = k + 1; i < 4; i++ )
+        {
+            double f = a[i][k] / a[k][k];
+            for ( int j = k; j < 5; j++ )
+                a[i][j] -= f * a[k][j];
+        }
+    }
+
+    for ( int k = 3; k >= 0; k-- )
+    {
+        c[k] = a[k][4];
+        for ( int j = k + 1; j < 4; j++ )
+            c[k] -= a[k][j] * c[j];
+        c[k] /= a[k][k];
+    }
+}
+
+// Returns times at which polynomials are sampled: four points spread evenly over kFitHours either side of the reference time.
+
+static void sampleHours ( double hours, double t[4] )
+{
+    for ( int i = 0; i < 4; i++ )
+        t[i] = hours * ( 2.0 * i - 3.0 ) / 3.0;
+}
+
+// Finds a root of function (f) between (a) and (b) by bisection. Returns NaN if (f) has the same sign at both ends.
+
+template <class F> static double bisect ( F f, double a, double b )
+{
+    double fa = f ( a ), fb = f ( b );
+    if ( ( fa > 0.0 ) == ( fb > 0.0 ) )
+        return NAN;
+
+    for ( int i = 0; i < kBisections; i++ )
+    {
+        double m = ( a + b ) / 2.0, fm = f ( m );
+        if ( ( fm > 0.0 ) == ( fa > 0.0 ) )
+        {
+            a = m;
+            fa = fm;
+        }
+        else
+        {
+            b = m;
+        }
+    }
+
+    return ( a + b ) / 2.0;
+}
+
+// Finds the time in hours when the distance between (x) and (y) polynomials and the origin is smallest, within (tmin, tmax).
+// Returns NaN if the closest approach is not within that range.
+
+static double closestApproach ( const double x[4], const double y[4], double tmin, double tmax )
+{
+    auto rate = [&] ( double t ) { return SSBesselianElements::value ( x, t ) * SSBesselianElements::rate ( x, t ) + SSBesselianElements::value ( y, t ) * SSBesselianElements::rate ( y, t ); };
+    return bisect ( rate, tmin, tmax );
+}
+
+// Returns Julian Date of the time (t) in hours after (t0), or zero if (t) is NaN, i.e. doesn't exist.
+
+static SSTime contactTime ( SSTime t0, double t )
+{
+    return isnan ( t ) ? SSTime ( 0.0 ) : SSTime ( t0.jd + t / 24.0 );
+}
+
+// Returns time in hours after (t0) of Julian Date (time).
+
+static double hoursAfter ( SSTime t0, SSTime time )
+{
+    return ( time.jd - t0.jd ) * 24.0;
+}
+
+// Given the shadow axis coordinates (x) and (y1) in the fundamental plane, with (y1) scaled so the Earth's outline is a unit circle,
+// finds where the axis meets the Earth's ellipsoid when its declination is (d) and Greenwich hour angle is (mu). Returns the
+// geodetic longitude and latitude of that point in (point), and its height above the fundamental plane in (zeta).
+// Returns false if the axis misses the Earth; axes just grazing the Earth's limb, within rounding error, are allowed.
+
+static bool pointOnEarth ( double x, double y1, double d, double mu, SSSpherical &point, double &zeta )
+{
+    double rho1 = sqrt ( 1.0 - kEarthE2 * cos ( d ) * cos ( d ) );
+    double sind1 = sin ( d ) / rho1, cosd1 = sqrt ( 1.0 - kEarthE2 ) * cos ( d ) / rho1;
+    double b = 1.0 - x * x - y1 * y1;
+    if ( b < -1.0e-9 )
+        return false;
+
+    zeta = sqrt ( max ( 0.0, b ) );
+    double sinphi1 = y1 * cosd1 + zeta * sind1;
+    double theta = atan2 ( x, zeta * cosd1 - y1 * sind1 );
+    double phi1 = asin ( max ( -1.0, min ( 1.0, sinphi1 ) ) );
+
+    point.lat = atan ( tan ( phi1 ) / sqrt ( 1.0 - kEarthE2 ) );
+    point.lon = modpi ( theta - mu );
+    point.rad = 1.0;
+    return true;
+}
+
+// Returns ratio by which the y coordinate of the fundamental plane is scaled so the Earth's outline is a unit circle,
+// when the shadow axis declination is (d).
+
+static double earthOutline ( double d )
+{
+    return sqrt ( 1.0 - kEarthE2 * cos ( d ) * cos ( d ) );
+}
+
+// Computes Besselian elements fitted over (hours) either side of (t0) from the Sun and Moon's positions at four instants.
+
+SSBesselianElements SSEclipse::besselianElements ( SSTime t0, double hours, SSObjectPtr pSun, SSObjectPtr pMoon )
+{
+    SSBesselianElements elements;
+    SSCoordinates coords ( t0, SSSpherical ( 0.0, 0.0, -SSCoordinates::kKmPerEarthRadii ) );
+    double t[4], samples[8][4], e[8];
+
+    sampleHours ( hours, t );
+    for ( int i = 0; i < 4; i++ )
+    {
+        solarSample ( coords, pSun, pMoon, t0.jd + t[i] / 24.0, e );
+        for ( int j = 0; j < 8; j++ )
+            samples[j][i] = e[j];
+    }
+
+    // Greenwich hour angle increases by about 48 degrees between samples; unwrap it so the polynomial is smooth.
+
+    samples[3][0] = mod2pi ( samples[3][0] );
+    for ( int i = 1; i < 4; i++ )
+        samples[3][i] = samples[3][i - 1] + mod2pi ( samples[3][i] - samples[3][i - 1] );
+
+    elements.t0 = t0;
+    elements.tmin = t[0];
+    elements.tmax = t[3];
+    fitCubic ( t, samples[0], elements.x );
+    fitCubic ( t, samples[1], elements.y );
+    fitCubic ( t, samples[2], elements.d );
+    fitCubic ( t, samples[3], elements.mu );
+    fitCubic ( t, samples[4], elements.l1 );
+    fitCubic ( t, samples[5], elements.l2 );
+    elements.tanf1 = ( samples[6][1] + samples[6][2] ) / 2.0;
+    elements.tanf2 = ( samples[7][1] + samples[7][2] ) / 2.0;
+
+    return elements;
+}
+
+// Finds where the shadow axis meets the Earth and the eclipse magnitude there; see header.
+// Shadow cone radii at the point come from its height above the fundamental plane.
+
+bool SSEclipse::centralPoint ( const SSBesselianElements &elements, SSTime time, SSSpherical &point, double &magnitude )
+{
+    double t = hoursAfter ( elements.t0, time ), zeta = 0.0;
+    double d = SSBesselianElements::value ( elements.d, t );
+    double x = SSBesselianElements::value ( elements.x, t );
+    double y1 = SSBesselianElements::value ( elements.y, t ) / earthOutline ( d );
+
+    if ( ! pointOnEarth ( x, y1, d, SSBesselianElements::value ( elements.mu, t ), point, zeta ) )
+        return false;
+
+    double L1 = SSBesselianElements::value ( elements.l1, t ) - zeta * elements.tanf1;
+    double L2 = SSBesselianElements::value ( elements.l2, t ) - zeta * elements.tanf2;
+    magnitude = ( L1 - L2 ) / ( L1 + L2 );
+    return true;
+}
+
+// Computes the central line; see header. Its ends are where the shadow axis is tangent to the Earth's outline.
+
+int SSEclipse::centralLine ( const SSBesselianElements &elements, double step, vector<SSSpherical> &path )
+{
+    path.clear();
+
+    auto outside = [&] ( double t )
+    {
+        double x = SSBesselianElements::value ( elements.x, t );
+        double y1 = SSBesselianElements::value ( elements.y, t ) / earthOutline ( SSBesselianElements::value ( elements.d, t ) );
+        return x * x + y1 * y1 - 1.0;
+    };
+
+    double tg = closestApproach ( elements.x, elements.y, elements.tmin, elements.tmax );
+    if ( isnan ( tg ) || outside ( tg ) > 0.0 || step <= 0.0 )
+        return 0;
+
+    double t1 = bisect ( outside, elements.tmin, tg );
+    double t2 = bisect ( outside, tg, elements.tmax );
+    if ( isnan ( t1 ) || isnan ( t2 ) )
+        return 0;
+
+    for ( double t = t1; ; t += step * 24.0 )
+    {
+        SSSpherical point;
+        double magnitude = 0.0;
+        t = min ( t, t2 );
+        if ( centralPoint ( elements, contactTime ( elements.t0, t ), point, magnitude ) )
+            path.push_back ( point );
+        if ( t >= t2 )
+            break;
+    }
+
+    return (int) path.size();
+}
+
+// Computes circumstances of a solar eclipse near a new moon; see header. Greatest eclipse is where the shadow axis passes
+// closest to the Earth's center; contacts are where the shadow cones touch the Earth's outline. Where the axis misses the Earth,
+// the magnitude is measured at the point on the Earth's limb nearest the axis, where the cones' radii are l1 and l2.
+
+bool SSEclipse::solarEclipse ( SSTime newMoon, SSObjectPtr pSun, SSObjectPtr pMoon, SSEclipseEvent &eclipse )
+{
+    // Reject new moons where the shadow passes too far from the Earth, from one sample at the time of new moon.
+
+    SSCoordinates coords ( newMoon, SSSpherical ( 0.0, 0.0, -SSCoordinates::kKmPerEarthRadii ) );
+    double e[8];
+    solarSample ( coords, pSun, pMoon, newMoon.jd, e );
+    if ( kNodeMargin * sqrt ( e[0] * e[0] + e[1] * e[1] ) > 1.0 + e[4] )
+        return false;
+
+    // Fit Besselian elements around the nearest whole hour; find greatest eclipse.
+
+    SSTime t0 ( floor ( newMoon.jd * 24.0 + 0.5 ) / 24.0 );
+    SSBesselianElements &el = eclipse.elements;
+    el = besselianElements ( t0, kFitHours, pSun, pMoon );
+
+    double tg = closestApproach ( el.x, el.y, el.tmin, el.tmax );
+    if ( isnan ( tg ) )
+        return false;
+
+    auto x = [&] ( double t ) { return SSBesselianElements::value ( el.x, t ); };
+    auto y1 = [&] ( double t ) { return SSBesselianElements::value ( el.y, t ) / earthOutline ( SSBesselianElements::value ( el.d, t ) ); };
+    auto m = [&] ( double t ) { return sqrt ( x ( t ) * x ( t ) + y1 ( t ) * y1 ( t ) ); };
+    auto l1 = [&] ( double t ) { return SSBesselianElements::value ( el.l1, t ); };
+    auto l2 = [&] ( double t ) { return SSBesselianElements::value ( el.l2, t ); };
+
+    double mg = m ( tg ), l1g = l1 ( tg ), l2g = l2 ( tg );
+    if ( mg >= 1.0 + l1g )
+        return false;
+
+    double y = SSBesselianElements::value ( el.y, tg );
+    eclipse.greatest = contactTime ( t0, tg );
+    eclipse.gamma = copysign ( sqrt ( x ( tg ) * x ( tg ) + y * y ), y );
+    eclipse.penumbralMagnitude = 0.0;
+
+    double d = SSBesselianElements::value ( el.d, tg ), mu = SSBesselianElements::value ( el.mu, tg ), zeta = 0.0;
+    if ( mg < 1.0 )
+    {
+        // Central eclipse: total if the umbra reaches the point of greatest eclipse, annular if not;
+        // hybrid if the other kind at either end of the central line, where the umbra's radius is l2.
+
+        double magnitude = 0.0;
+        centralPoint ( el, eclipse.greatest, eclipse.location, magnitude );
+        eclipse.magnitude = magnitude;
+        eclipse.type = magnitude >= 1.0 ? kTotalSolarEclipse : kAnnularSolarEclipse;
+
+        auto outside = [&] ( double t ) { return m ( t ) - 1.0; };
+        double t1 = bisect ( outside, el.tmin, tg ), t2 = bisect ( outside, tg, el.tmax );
+        bool annularEnd = ( ! isnan ( t1 ) && l2 ( t1 ) > 0.0 ) || ( ! isnan ( t2 ) && l2 ( t2 ) > 0.0 );
+        if ( eclipse.type == kTotalSolarEclipse && annularEnd )
+            eclipse.type = kHybridSolarEclipse;
+    }
+    else
+    {
+        // Non-central eclipse: magnitude at the point on the limb nearest the shadow axis.
+
+        pointOnEarth ( x ( tg ) / mg, y1 ( tg ) / mg, d, mu, eclipse.location, zeta );
+        eclipse.magnitude = ( l1g - ( mg - 1.0 ) ) / ( l1g + l2g );
+        if ( mg < 1.0 + fabs ( l2g ) )
+            eclipse.type = l2g < 0.0 ? kTotalSolarEclipse : kAnnularSolarEclipse;
+        else
+            eclipse.type = kPartialSolarEclipse;
+    }
+
+    // Contacts of the penumbra and umbra with the Earth's outline.
+
+    auto penumbra = [&] ( double t ) { return m ( t ) - 1.0 - l1 ( t ); };
+    auto umbraOuter = [&] ( double t ) { return m ( t ) - 1.0 - fabs ( l2 ( t ) ); };
+    auto umbraInner = [&] ( double t ) { return m ( t ) - 1.0 + fabs ( l2 ( t ) ); };
+
+    eclipse.contacts[kP1] = contactTime ( t0, bisect ( penumbra, el.tmin, tg ) );
+    eclipse.contacts[kP4] = contactTime ( t0, bisect ( penumbra, tg, el.tmax ) );
+    eclipse.contacts[kU1] = contactTime ( t0, bisect ( umbraOuter, el.tmin, tg ) );
+    eclipse.contacts[kU4] = contactTime ( t0, bisect ( umbraOuter, tg, el.tmax ) );
+    eclipse.contacts[kU2] = contactTime ( t0, bisect ( umbraInner, el.tmin, tg ) );
+    eclipse.contacts[kU3] = contactTime ( t0, bisect ( umbraInner, tg, el.tmax ) );
+
+    return true;
+}
+
+// Computes circumstances of a lunar eclipse near a full moon; see header. Greatest eclipse is where the Moon's center
+// passes closest to the shadow axis; contacts are where the Moon's limb touches the edges of the umbra and penumbra.
+
+bool SSEclipse::lunarEclipse ( SSTime fullMoon, SSObjectPtr pSun, SSObjectPtr pMoon, SSEclipseEvent &eclipse )
+{
+    // Reject full moons where the Moon passes too far from the shadow, from one sample at the time of full moon.
+
+    SSCoordinates coords ( fullMoon, SSSpherical ( 0.0, 0.0, -SSCoordinates::kKmPerEarthRadii ) );
+    double e[6];
+    lunarSample ( coords, pSun, pMoon, fullMoon.jd, e );
+    if ( kNodeMargin * sqrt ( e[0] * e[0] + e[1] * e[1] ) > e[3] + e[4] )
+        return false;
+
+    // Fit the Moon's position relative to the shadow, shadow radii, and Moon's size and distance around the nearest whole hour.
+
+    SSTime t0 ( floor ( fullMoon.jd * 24.0 + 0.5 ) / 24.0 );
+    double t[4], samples[6][4], c[6][4];
+    sampleHours ( kFitHours, t );
+    for ( int i = 0; i < 4; i++ )
+    {
+        lunarSample ( coords, pSun, pMoon, t0.jd + t[i] / 24.0, e );
+        for ( int j = 0; j < 6; j++ )
+            samples[j][i] = e[j];
+    }
+
+    for ( int j = 0; j < 6; j++ )
+        fitCubic ( t, samples[j], c[j] );
+
+    double tg = closestApproach ( c[0], c[1], t[0], t[3] );
+    if ( isnan ( tg ) )
+        return false;
+
+    auto value = [&] ( int j, double t ) { return SSBesselianElements::value ( c[j], t ); };
+    auto sigma = [&] ( double t ) { return sqrt ( value ( 0, t ) * value ( 0, t ) + value ( 1, t ) * value ( 1, t ) ); };
+
+    double sg = sigma ( tg ), umbra = value ( 2, tg ), penumbra = value ( 3, tg ), semidiam = value ( 4, tg );
+    eclipse.penumbralMagnitude = ( penumbra + semidiam - sg ) / ( 2.0 * semidiam );
+    eclipse.magnitude = ( umbra + semidiam - sg ) / ( 2.0 * semidiam );
+    if ( eclipse.penumbralMagnitude <= 0.0 )
+        return false;
+
+    if ( eclipse.magnitude >= 1.0 )
+        eclipse.type = kTotalLunarEclipse;
+    else if ( eclipse.magnitude > 0.0 )
+        eclipse.type = kPartialLunarEclipse;
+    else
+        eclipse.type = kPenumbralLunarEclipse;
+
+    eclipse.greatest = contactTime ( t0, tg );
+    eclipse.gamma = copysign ( sin ( sg ) * value ( 5, tg ), value ( 1, tg ) );
+    eclipse.location = SSSpherical ( 0.0, 0.0, 0.0 );
+    eclipse.elements = SSBesselianElements();
+
+    auto penumbraOuter = [&] ( double t ) { return sigma ( t ) - value ( 3, t ) - value ( 4, t ); };
+    auto umbraOuter = [&] ( double t ) { return sigma ( t ) - value ( 2, t ) - value ( 4, t ); };
+    auto umbraInner = [&] ( double t ) { return sigma ( t ) - value ( 2, t ) + value ( 4, t ); };
+
+    eclipse.contacts[kP1] = contactTime ( t0, bisect ( penumbraOuter, t[0], tg ) );
+    eclipse.contacts[kP4] = contactTime ( t0, bisect ( penumbraOuter, tg, t[3] ) );
+    eclipse.contacts[kU1] = contactTime ( t0, bisect ( umbraOuter, t[0], tg ) );
+    eclipse.contacts[kU4] = contactTime ( t0, bisect ( umbraOuter, tg, t[3] ) );
+    eclipse.contacts[kU2] = contactTime ( t0, bisect ( umbraInner, t[0], tg ) );
+    eclipse.contacts[kU3] = contactTime ( t0, bisect ( umbraInner, tg, t[3] ) );
+
+    return true;
+}
+
+// Finds all eclipses in a time range; see header. Each new or full moon is found from the one before it, so the
+// search costs a few Sun and Moon positions per lunation, plus four more for each lunation with an eclipse.
+
+int SSEclipse::findEclipses ( SSTime start, SSTime stop, SSObjectPtr pSun, SSObjectPtr pMoon, bool solar, bool lunar, vector<SSEclipseEvent> &eclipses )
+{
+    vector<SSEclipseEvent> found;
+
+    for ( int kind = 0; kind < 2; kind++ )
+    {
+        if ( ( kind == 0 && ! solar ) || ( kind == 1 && ! lunar ) )
+            continue;
+
+        // Start a day early, since greatest eclipse can precede new or full moon by a few hours.
+
+        double phase = kind == 0 ? SSEvent::kNewMoon : SSEvent::kFullMoon;
+        for ( SSTime time = start - 1.0; time <= stop + 1.0; time += 1.0 )
+        {
+            time = SSEvent::nextMoonPhase ( time, pSun, pMoon, phase );
+            if ( time > stop + 1.0 )
+                break;
+
+            SSEclipseEvent eclipse;
+            bool isEclipse = kind == 0 ? solarEclipse ( time, pSun, pMoon, eclipse ) : lunarEclipse ( time, pSun, pMoon, eclipse );
+            if ( isEclipse && eclipse.greatest >= start && eclipse.greatest <= stop )
+                found.push_back ( eclipse );
+        }
+    }
+
+    stable_sort ( found.begin(), found.end(), [] ( const SSEclipseEvent &e1, const SSEclipseEvent &e2 ) { return e1.greatest < e2.greatest; } );
+    eclipses.insert ( eclipses.end(), found.begin(), found.end() );
+    return (int) found.size();
+}
@@ -0,0 +1,104 @@
+// SSEclipse.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// Finds solar and lunar eclipses, and computes their circumstances: type, time of greatest eclipse,
+// magnitude, gamma, contact times, and for solar eclipses, the location of greatest eclipse and
+// points along the central line. New and full moons are found with SSEvent::nextMoonPhase(); those
+// which are clearly too far from a node are rejected from the Sun and Moon's positions at that instant.
+// For the rest, the Sun and Moon's positions are computed at just four more instants, and the shadow
+// geometry is fitted with cubic polynomials in time - for solar eclipses, the classical Besselian elements -
+// from which all circumstances are then solved without any further ephemeris computation.
+
+#ifndef SSEclipse_hpp
+#define SSEclipse_hpp
+
+#include "SSCoordinates.hpp"
+#include "SSObject.hpp"
+
+enum SSEclipseType
+{
+    kNoEclipse = 0,
+    kPartialSolarEclipse = 1,       // Moon's umbra and antumbra miss the Earth; only its penumbra touches the Earth
+    kAnnularSolarEclipse = 2,       // Moon's antumbra touches the Earth
+    kTotalSolarEclipse = 3,         // Moon's umbra touches the Earth
+    kHybridSolarEclipse = 4,        // eclipse is annular at the ends of the central line, and total in the middle
+    kPenumbralLunarEclipse = 5,     // Moon enters Earth's penumbra, but not its umbra
+    kPartialLunarEclipse = 6,       // Moon partly enters Earth's umbra
+    kTotalLunarEclipse = 7          // Moon entirely enters Earth's umbra
+};
+
+// Besselian elements of a solar eclipse: the geometry of the Moon's shadow in the fundamental plane,
+// which passes through the Earth's center perpendicular to the shadow axis. Each element is a cubic
+// polynomial c[0] + c[1] * t + c[2] * t^2 + c[3] * t^3, where t is hours after the reference time t0.
+// Distances are in Earth equatorial radii, and angles in radians.
+
+struct SSBesselianElements
+{
+    SSTime t0;          // reference time [Julian Date in UTC]
+    double tmin, tmax;  // range of t over which polynomials were fitted [hours after t0]
+    double x[4];        // x coordinate of shadow axis in fundamental plane, positive toward east
+    double y[4];        // y coordinate of shadow axis in fundamental plane, positive toward north
+    double d[4];        // declination of shadow axis, in true equatorial frame of date
+    double mu[4];       // Greenwich hour angle of shadow axis
+    double l1[4];       // radius of penumbral cone in fundamental plane
+    double l2[4];       // radius of umbral cone in fundamental plane; negative where the eclipse is total
+    double tanf1;       // tangent of half-angle of penumbral cone
+    double tanf2;       // tangent of half-angle of umbral cone
+
+    static double value ( const double c[4], double t ) { return c[0] + t * ( c[1] + t * ( c[2] + t * c[3] ) ); }
+    static double rate ( const double c[4], double t ) { return c[1] + t * ( 2.0 * c[2] + t * 3.0 * c[3] ); }
+};
+
+// Circumstances of a solar or lunar eclipse, as seen from the Earth as a whole.
+
+struct SSEclipseEvent
+{
+    SSEclipseType type;         // type of eclipse
+    SSTime greatest;            // time of greatest eclipse, when shadow axis passes closest to the Earth's center (solar), or the Moon's center (lunar)
+    double magnitude;           // solar: fraction of Sun's diameter covered at the point of greatest eclipse; lunar: umbral magnitude
+    double penumbralMagnitude;  // lunar: fraction of Moon's diameter immersed in Earth's penumbra; zero for solar eclipses
+    double gamma;               // distance of shadow axis from Earth's center (solar) or Moon's center (lunar) at greatest eclipse in Earth radii; negative if south
+    SSTime contacts[6];         // first and last contacts of penumbra (P1, P4) and umbra (U1, U4), and internal contacts of umbra (U2, U3), in that order:
+                                // P1, U1, U2, U3, U4, P4. Julian Date is zero if a contact doesn't occur. For solar eclipses, contacts are with the Earth's disk.
+    SSSpherical location;       // solar: geographic longitude and latitude of point of greatest eclipse, east and north positive [radians]
+    SSBesselianElements elements;   // solar: Besselian elements; undefined for lunar eclipses
+};
+
+class SSEclipse
+{
+public:
+
+    static constexpr int kP1 = 0, kU1 = 1, kU2 = 2, kU3 = 3, kU4 = 4, kP4 = 5;     // indices of contacts in SSEclipseEvent
+
+    // Computes circumstances of the solar eclipse around the new moon nearest time (newMoon), or the lunar eclipse
+    // around the full moon nearest time (fullMoon). The time should be within an hour or so of the new or full moon.
+    // Sun and Moon are pointers to the Sun and Moon objects. Returns true and circumstances in (eclipse) if an eclipse
+    // takes place, or false if not. The Sun and Moon's positions will be recomputed/modified by these functions!
+
+    static bool solarEclipse ( SSTime newMoon, SSObjectPtr pSun, SSObjectPtr pMoon, SSEclipseEvent &eclipse );
+    static bool lunarEclipse ( SSTime fullMoon, SSObjectPtr pSun, SSObjectPtr pMoon, SSEclipseEvent &eclipse );
+
+    // Finds all solar eclipses (if solar is true) and lunar eclipses (if lunar is true) whose greatest eclipse lies
+    // between times (start) and (stop), and appends them to (eclipses) in time order. Returns number of eclipses found.
+    // The Sun and Moon's positions will be recomputed/modified by this function!
+
+    static int findEclipses ( SSTime start, SSTime stop, SSObjectPtr pSun, SSObjectPtr pMoon, bool solar, bool lunar, vector<SSEclipseEvent> &eclipses );
+
+    // Computes Besselian elements of a solar eclipse, fitted over (hours) either side of reference time (t0).
+
+    static SSBesselianElements besselianElements ( SSTime t0, double hours, SSObjectPtr pSun, SSObjectPtr pMoon );
+
+    // Returns geographic location (point) where the shadow axis described by Besselian elements (elements) meets
+    // the Earth's ellipsoid at time (time), and the eclipse magnitude there. Returns false if the axis misses the Earth.
+
+    static bool centralPoint ( const SSBesselianElements &elements, SSTime time, SSSpherical &point, double &magnitude );
+
+    // Computes points along the central line of a solar eclipse from Besselian elements (elements), every (step) days
+    // from where the shadow axis first meets the Earth to where it leaves. Returns number of points in (path).
+
+    static int centralLine ( const SSBesselianElements &elements, double step, vector<SSSpherical> &path );
+};
+
+#endif /* SSEclipse_hpp */
@@ -4,7 +4,15 @@
 // Created by Tim DeBenedictis on 4/18/20.
 // Copyright © 2020 Southern Stars. All rights reserved.
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 #include "SSEvent.hpp"
+#include "SSPlanet.hpp"
 
 // Computes the hour angle when an object with declination (dec)
 // as seen from latitude (lat) reaches an altitude (alt) above
@@ -200,6 +208,217 @@ SSPass SSEvent::riseTransitSet ( SSTime today, SSCoordinates &coords, SSObjectPt
     return pass;
 }
 
+// Daily table of geocentric apparent positions used by SSEvent::riseTransitSetTable(), in the equatorial frame
+// of date. Positions of solar system objects are in AU, so each site's parallax can be applied to them; positions
+// of other objects are unit vectors, since their parallax is negligible. Apparent sidereal time at Greenwich
+// is tabulated at the same times.
+
+namespace {
+
+struct RTSTable
+{
+    double jd0;                         // Julian Date of first tabulated time [UTC]
+    vector<double> gst;                 // Greenwich apparent sidereal time at each tabulated time [radians]
+    vector<vector<SSVector>> pos;       // each object's position at each tabulated time
+    vector<bool> topocentric;           // true if object's positions must be corrected for parallax
+    vector<double> alt;                 // each object's horizon altitude for rising and setting [radians]
+};
+
+}
+
+// Interpolates a table of vectors (table), tabulated at equally spaced times, at (x) steps after the first
+// with the cubic polynomial through the four tabulated values around x.
+
+static SSVector interpolateCubic ( const vector<SSVector> &table, double x )
+{
+    int i = min ( max ( (int) floor ( x ), 1 ), (int) table.size() - 3 );
+    double p = x - i;
+    
+    double c0 = -p * ( p - 1.0 ) * ( p - 2.0 ) / 6.0;
+    double c1 = ( p + 1.0 ) * ( p - 1.0 ) * ( p - 2.0 ) / 2.0;
+    double c2 = -( p + 1.0 ) * p * ( p - 2.0 ) / 2.0;
+    double c3 = ( p + 1.0 ) * p * ( p - 1.0 ) / 6.0;
+    
+    return table[i - 1] * c0 + table[i] * c1 + table[i + 1] * c2 + table[i + 2] * c3;
+}
+
+// Computes the time an object (obj) in a daily position table (table) rises, transits, or sets (sign)
+// above horizon altitude (alt), as seen from geographic location (site), closest to an initial time (jd).
+// Works like riseTransitSetSearch(), but takes positions and sidereal time from the table instead of
+// recomputing them. Returns the object's horizon coordinates at the time of the event in (hor).
+// If the object does not rise, returns -INFINITY; if it does not set, returns +INFINITY.
+
+static double tableRiseTransitSet ( const RTSTable &table, int obj, const SSSpherical &site, double jd, int sign, double alt, SSSpherical &hor )
+{
+    double lastjd = jd, lst = 0.0, precision = 1.0 / SSTime::kSecondsPerDay;
+    int i = 0, imax = 10;
+    SSVector equ;
+    
+    do
+    {
+        lastjd = jd;
+        
+        // Local sidereal time advances uniformly from the nearest tabulated value.
+        
+        double x = jd - table.jd0;
+        int k = min ( max ( (int) floor ( x + 0.5 ), 0 ), (int) table.gst.size() - 1 );
+        lst = table.gst[k] + SSAngle::kTwoPi * SSTime::kSiderealPerSolarDays * ( x - k ) + site.lon;
+        
+        // Interpolate the object's position; for solar system objects, subtract the observer's geocentric position.
+        
+        equ = interpolateCubic ( table.pos[obj], x );
+        if ( table.topocentric[obj] )
+            equ -= SSCoordinates::toGeocentric ( SSSpherical ( lst, site.lat, site.rad ), SSCoordinates::kKmPerEarthRadii, SSCoordinates::kEarthFlattening ) / SSCoordinates::kKmPerAU;
+        
+        SSSpherical radec ( equ );
+        SSAngle ha = SSEvent::semiDiurnalArc ( site.lat, radec.lat, alt );
+        
+        if ( ha == SSAngle::kPi && sign != 0 )
+            return INFINITY;
+        
+        if ( ha == 0.0 )
+            return -INFINITY;
+        
+        SSAngle theta = SSAngle ( radec.lon - lst + sign * ha ).modPi();
+        jd += theta / SSAngle::kTwoPi / SSTime::kSiderealPerSolarDays;
+        i++;
+    }
+    while ( fabs ( jd - lastjd ) > precision && i < imax );
+    
+    hor = SSSpherical ( SSCoordinates::getHorizonMatrix ( lst, site.lat ) * equ );
+    return jd;
+}
+
+// Computes circumstances of an object's rise, transit, or set (sign) on the local day starting at (start),
+// like riseTransitSetSearchDay(); other parameters are as for tableRiseTransitSet(). If the event does not
+// happen on that day, the returned time is -INFINITY for rising, or +INFINITY for transit and setting,
+// and azimuth and altitude are zero.
+
+static SSRTS tableRiseTransitSetDay ( const RTSTable &table, int obj, const SSSpherical &site, double start, double zone, int sign, double alt )
+{
+    SSSpherical hor;
+    double end = start + 1.0;
+    double jd = tableRiseTransitSet ( table, obj, site, start + 0.5, sign, alt, hor );
+    
+    if ( jd > end )
+        jd = tableRiseTransitSet ( table, obj, site, start - 0.5, sign, alt, hor );
+    else if ( jd < start )
+        jd = tableRiseTransitSet ( table, obj, site, end + 0.5, sign, alt, hor );
+    
+    SSRTS rts = { SSTime ( jd, zone ), 0.0, 0.0 };
+    if ( jd > end || jd < start )
+        rts.time = sign == SSEvent::kRise ? -INFINITY : INFINITY;
+    else
+    {
+        rts.azm = hor.lon;
+        rts.alt = hor.lat;
+    }
+    
+    return rts;
+}
+
+// Computes rise/transit/set tables for many objects, days, and sites; see header.
+
+int SSEvent::riseTransitSetTable ( SSTime start, int days, SSObjectVec &objects, vector<SSRTSSite> &sites, vector<SSPass> &passes, int threads )
+{
+    int nobj = (int) objects.size(), nsites = (int) sites.size();
+    if ( days < 1 || nobj < 1 || nsites < 1 )
+        return 0;
+    
+    // Find the start of each site's first local day, and the span of times all sites' days cover.
+    
+    vector<double> midnights ( nsites );
+    double first = INFINITY, last = -INFINITY;
+    for ( int s = 0; s < nsites; s++ )
+    {
+        midnights[s] = SSTime ( start.jd, sites[s].zone ).getLocalMidnight();
+        first = min ( first, midnights[s] );
+        last = max ( last, midnights[s] );
+    }
+    
+    // Searches look up to a day either side of each local day, and each interpolation
+    // uses a tabulated day either side of that, so tabulate from two days before the
+    // earliest midnight to three days after the end of the latest day.
+
+    RTSTable table;
+    table.jd0 = floor ( first ) - 2.0;
+    int ntimes = (int) ceil ( last + days - table.jd0 ) + 3;
+    
+    table.gst.resize ( ntimes );
+    table.pos.assign ( nobj, vector<SSVector> ( ntimes ) );
+    table.topocentric.resize ( nobj );
+    table.alt.resize ( nobj );
+    
+    for ( int o = 0; o < nobj; o++ )
+    {
+        SSPlanetPtr pPlanet = SSGetPlanetPtr ( objects[o] );
+        int64_t id = pPlanet ? pPlanet->getIdentifier().identifier() : -1;
+        table.topocentric[o] = pPlanet != nullptr;
+        if ( ( objects[o]->getType() == kTypePlanet && id == kSun ) || ( objects[o]->getType() == kTypeMoon && id == kLuna ) )
+            table.alt[o] = kSunMoonRiseSetAlt;
+        else
+            table.alt[o] = kDefaultRiseSetAlt;
+    }
+    
+    // Compute all objects' positions from the Earth's center once per day.
+    // With the observer at zero longitude, local sidereal time is Greenwich sidereal time.
+    
+    SSCoordinates coords ( table.jd0, SSSpherical ( 0.0, 0.0, -SSCoordinates::kKmPerEarthRadii ) );
+    for ( int t = 0; t < ntimes; t++ )
+    {
+        coords.setTime ( table.jd0 + t );
+        table.gst[t] = coords.getLST();
+        
+        for ( int o = 0; o < nobj; o++ )
+        {
+            SSObjectPtr pObj = objects[o];
+            pObj->computeEphemeris ( coords );
+            SSVector pos = table.topocentric[o] ? pObj->getDirection() * pObj->getDistance() : pObj->getDirection();
+            table.pos[o][t] = coords.transform ( kFundamental, kEquatorial, pos );
+        }
+    }
+    
+    // Now solve every site's events from the table. Sites are independent and only read the table,
+    // so they can be handed out to several threads; each writes only its own part of the output.
+    
+    passes.resize ( (size_t) nsites * days * nobj );
+    
+    if ( threads < 1 )
+        threads = max ( 1u, thread::hardware_concurrency() );
+
+    atomic<int> next ( 0 );
+    
+    auto worker = [&] ( void )
+    {
+        for ( int s = next++; s < nsites; s = next++ )
+        {
+            const SSSpherical &site = sites[s].location;
+            for ( int d = 0; d < days; d++ )
+            {
+                double midnight = midnights[s] + d;
+                for ( int o = 0; o < nobj; o++ )
+                {
+                    SSPass &pass = passes[ ( (size_t) s * days + d ) * nobj + o ];
+                    pass.rising = tableRiseTransitSetDay ( table, o, site, midnight, sites[s].zone, kRise, table.alt[o] );
+                    pass.transit = tableRiseTransitSetDay ( table, o, site, midnight, sites[s].zone, kTransit, 0.0 );
+                    pass.setting = tableRiseTransitSetDay ( table, o, site, midnight, sites[s].zone, kSet, table.alt[o] );
+                }
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for ( int i = 1; i < threads && i < nsites; i++ )
+        pool.push_back ( thread ( worker ) );
+    
+    worker();
+    
+    for ( thread &t : pool )
+        t.join();
+    
+    return (int) passes.size();
+}
+
 // Returns the Juliam Date of the next moon phase after the current time (time).
 // Objects pSun and pMoon are pointers to the SUn and Moon, respectively.
 // The angular value (phase) corresponds to the desired moon phase in radians:
@@ -324,6 +543,8 @@ void SSEvent::findEvents ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr
         // call this method recursively to search the interval between those times
         // with a search step 10x smaller, until the step is less than 1 second.
         // When we reach that precision, save the time and value, and return.
+        // The interval searched is padded by half the smaller step, so rounding in the accumulated
+        // time can't drop its last sample, where the event may be.
 
         if ( ! isinf ( oldVal ) && ! isinf ( curVal ) && ! isinf ( newVal ) )
         {
@@ -338,7 +559,7 @@ void SSEvent::findEvents ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr
                 }
                 else
                 {
-                    findEvents ( coords, pObj1, pObj2, time - step * 2.0, time, step / 10.0, min, limit, func, events, maxEvents );
+                    findEvents ( coords, pObj1, pObj2, time - step * 2.0, time + step / 20.0, step / 10.0, min, limit, func, events, maxEvents );
                 }
             }
         }
@@ -382,6 +603,8 @@ void SSEvent::findEqualityEvents ( SSCoordinates &coords, SSObjectPtr pObj1, SSO
         // call this method recursively to search the interval between those times
         // with a search step 10x smaller, until the step is less than 1 second.
         // When we reach that precision, save the time and value, and return.
+        // The interval searched is padded by half the smaller step, so rounding in the accumulated
+        // time can't drop its last sample, where the event may be.
 
         if ( ! isinf ( oldVal ) && ! isinf ( curVal ) )
         {
@@ -396,13 +619,676 @@ void SSEvent::findEqualityEvents ( SSCoordinates &coords, SSObjectPtr pObj1, SSO
                 }
                 else
                 {
-                    findEqualityEvents ( coords, pObj1, pObj2, time - step, time, step / 10.0, below, target, func, events, maxEvents );
+                    findEqualityEvents ( coords, pObj1, pObj2, time - step, time + step / 20.0, step / 10.0, below, target, func, events, maxEvents );
                 }
             }
         }
     }
 }
 
+// Searches the time range (start to stop) for extremum events (if equality is false) or equality events (if true)
+// on several threads at once; see findEventsParallel(). The range is split into chunks of whole search steps,
+// which share the last samples of one chunk with the first of the next (two for extrema, one for equality),
+// so every bracket of the serial search is tested by exactly one chunk, and an event straddling a chunk boundary
+// is neither missed nor found twice. Chunks are handed out in time order; once the chunks completed so far,
+// counting from the start, hold enough events to fill (maxEvents), later chunks are skipped.
+
+static void findEventsInChunks ( bool equality, SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool flag, double value, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, int threads )
+{
+    static const long kMinChunkSteps = 16;     // smallest chunk worth handing to a thread, in search steps
+    static const long kChunksPerThread = 4;    // more chunks than threads keeps threads busy when some chunks hold events
+
+    long room = (long) maxEvents - (long) events.size();
+    if ( room <= 0 || step <= 0.0 || stop < start )
+        return;
+    
+    if ( threads < 1 )
+        threads = max ( 1u, thread::hardware_concurrency() );
+
+    // Sample times of the serial search, accumulated step by step exactly as it does, so chunks sample
+    // (and refine brackets from) the very same times rather than ones which drift from them by rounding.
+    
+    vector<SSTime> samples;
+    for ( SSTime time = start; time <= stop; time += step )
+        samples.push_back ( time );
+    
+    // Number of search steps in the time range, chunk length in steps, number of samples shared by adjacent chunks,
+    // and steps from one chunk's start to the next. A chunk of (length) steps has (length + 1) samples.
+    
+    long steps = (long) samples.size() - 1;
+    long overlap = equality ? 1 : 2;
+    long length = max ( kMinChunkSteps, steps / ( threads * kChunksPerThread ) + overlap );
+    long stride = length - overlap + 1;
+    long nchunks = steps > length ? ( steps - length + stride - 1 ) / stride + 1 : 1;
+    
+    vector<vector<SSEventTime>> results ( nchunks );
+    vector<bool> done ( nchunks, false );
+    atomic<long> next ( 0 ), cutoff ( nchunks );
+    long prefix = 0, prefixEvents = 0;
+    mutex doneMutex;
+    
+    auto worker = [&] ( void )
+    {
+        SSCoordinates localCoords = coords;
+        SSObjectPtr pLocal1 = SSCloneObject ( pObj1 );
+        SSObjectPtr pLocal2 = SSCloneObject ( pObj2 );
+        
+        for ( long c = next++; c < cutoff; c = next++ )
+        {
+            // Chunk c searches steps (a) to (b). The last chunk ends exactly where the serial search does;
+            // others end half a step past their last step, so rounding doesn't drop it.
+            
+            long a = c * stride, b = min ( a + length, steps );
+            SSTime chunkStart = samples[a];
+            SSTime chunkStop = c == nchunks - 1 ? stop : samples[b] + 0.5 * step;
+            
+            if ( equality )
+                SSEvent::findEqualityEvents ( localCoords, pLocal1, pLocal2, chunkStart, chunkStop, step, flag, value, func, results[c], (int) room );
+            else
+                SSEvent::findEvents ( localCoords, pLocal1, pLocal2, chunkStart, chunkStop, step, flag, value, func, results[c], (int) room );
+            
+            // Advance the prefix of completed chunks; if it already holds enough events, skip the chunks after it.
+            
+            lock_guard<mutex> lock ( doneMutex );
+            done[c] = true;
+            while ( prefix < nchunks && done[prefix] )
+                prefixEvents += results[prefix++].size();
+            if ( prefixEvents >= room && prefix < cutoff )
+                cutoff = prefix;
+        }
+        
+        delete pLocal1;
+        delete pLocal2;
+    };
+    
+    vector<thread> pool;
+    for ( int i = 1; i < threads && i < nchunks; i++ )
+        pool.push_back ( thread ( worker ) );
+    
+    worker();
+    
+    for ( thread &t : pool )
+        t.join();
+
+    // Chunks are in time order, but refining an event near a chunk boundary can land a hair on either side of it,
+    // so sort the merged events before keeping the earliest ones.
+    
+    vector<SSEventTime> found;
+    for ( long c = 0; c < cutoff; c++ )
+        found.insert ( found.end(), results[c].begin(), results[c].end() );
+    
+    stable_sort ( found.begin(), found.end(), [] ( const SSEventTime &e1, const SSEventTime &e2 ) { return e1.time < e2.time; } );
+    if ( (long) found.size() > room )
+        found.resize ( room );
+    
+    events.insert ( events.end(), found.begin(), found.end() );
+}
+
+// Parallel version of findEvents(); see header. Caller's coordinates and objects are not modified.
+
+void SSEvent::findEventsParallel ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool min, double limit, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, int threads )
+{
+    findEventsInChunks ( false, coords, pObj1, pObj2, start, stop, step, min, limit, func, events, maxEvents, threads );
+}
+
+// Parallel version of findEqualityEvents(); see header. Caller's coordinates and objects are not modified.
+
+void SSEvent::findEqualityEventsParallel ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool below, double target, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, int threads )
+{
+    findEventsInChunks ( true, coords, pObj1, pObj2, start, stop, step, below, target, func, events, maxEvents, threads );
+}
+
+// Computes objects' (pObj1,pObj2) ephemerides at Julian Date (jd) in time zone (zone), then returns the value of event function (func).
+
+static double evaluateEvent ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, double jd, double zone, SSEventFunc func )
+{
+    coords.setTime ( SSTime ( jd, zone ) );
+    
+    if ( pObj1 )
+        pObj1->computeEphemeris ( coords );
+    
+    if ( pObj2 )
+        pObj2->computeEphemeris ( coords );
+
+    return func ( coords, pObj1, pObj2 );
+}
+
+// Finds the minimum of (sign * func) between times (a) and (b) with Brent's method, given a time (x) between them
+// where (fx) = sign * func is less than at either end. Combines parabolic interpolation through the best three points
+// so far with golden-section steps whenever the parabola misbehaves. Stops when the minimum is known to within (tol) days.
+// Returns the time of the minimum, and (sign * func) there in (fx).
+
+static double brentExtremum ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, double zone, SSEventFunc func, double sign, double a, double b, double x, double &fx, double tol )
+{
+    static const double kGolden = 0.381966011250105;    // ( 3 - sqrt ( 5 ) ) / 2
+    static const int kMaxIterations = 100;
+    
+    double w = x, v = x, fw = fx, fv = fx;
+    double d = 0.0, e = 0.0;
+    
+    for ( int i = 0; i < kMaxIterations; i++ )
+    {
+        double m = ( a + b ) / 2.0;
+        if ( fabs ( x - m ) <= 2.0 * tol - ( b - a ) / 2.0 )
+            break;
+        
+        // Try a parabolic step through (x,w,v), but only if it falls inside (a,b)
+        // and is shorter than half the step before last; otherwise take a golden-section step.
+        
+        bool golden = true;
+        if ( fabs ( e ) > tol )
+        {
+            double r = ( x - w ) * ( fx - fv );
+            double q = ( x - v ) * ( fx - fw );
+            double p = ( x - v ) * q - ( x - w ) * r;
+            q = 2.0 * ( q - r );
+            if ( q > 0.0 )
+                p = -p;
+            else
+                q = -q;
+            
+            double olde = e;
+            e = d;
+            if ( fabs ( p ) < fabs ( q * olde / 2.0 ) && p > q * ( a - x ) && p < q * ( b - x ) )
+            {
+                d = p / q;
+                if ( x + d - a < 2.0 * tol || b - x - d < 2.0 * tol )
+                    d = x < m ? tol : -tol;
+                golden = false;
+            }
+        }
+        
+        if ( golden )
+        {
+            e = ( x < m ? b : a ) - x;
+            d = kGolden * e;
+        }
+        
+        // Never evaluate closer than (tol) to the current best point.
+        
+        double u = fabs ( d ) >= tol ? x + d : x + ( d > 0.0 ? tol : -tol );
+        double fu = sign * evaluateEvent ( coords, pObj1, pObj2, u, zone, func );
+        
+        if ( fu <= fx )
+        {
+            if ( u < x )
+                b = x;
+            else
+                a = x;
+            v = w; fv = fw;
+            w = x; fw = fx;
+            x = u; fx = fu;
+        }
+        else
+        {
+            if ( u < x )
+                a = u;
+            else
+                b = u;
+            if ( fu <= fw || w == x )
+            {
+                v = w; fv = fw;
+                w = u; fw = fu;
+            }
+            else if ( fu <= fv || v == x || v == w )
+            {
+                v = u; fv = fu;
+            }
+        }
+    }
+    
+    return x;
+}
+
+// Finds the time between (a) and (b) where (func) equals (target), given the values (fa,fb) of (func - target) at (a) and (b),
+// which must have opposite signs; the objects' ephemerides must have been computed at (b). Without a rate function (rate),
+// uses Brent's method: inverse quadratic interpolation or secant steps, falling back to bisection whenever they don't shrink
+// the bracket fast enough. With a rate function, takes Newton steps using (rate), falling back to bisection whenever a step
+// leaves the bracket or converges too slowly. Stops when the event is known to within (tol) days. Returns the event time,
+// and the value of (func) there in (value).
+
+static double brentEquality ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, double zone, SSEventFunc func, SSEventFunc rate, double target, double a, double b, double fa, double fb, double &value, double tol )
+{
+    static const int kMaxIterations = 100;
+    
+    if ( rate )
+    {
+        // Orient the bracket so func - target is negative at (lo) and positive at (hi), then start from (b),
+        // where the objects' ephemerides were last computed.
+        
+        double lo = fa < 0.0 ? a : b, hi = fa < 0.0 ? b : a;
+        double x = b, fx = fb;
+        double dx = fabs ( b - a ), olddx = dx;
+        
+        for ( int i = 0; i < kMaxIterations && fx != 0.0; i++ )
+        {
+            double dfx = rate ( coords, pObj1, pObj2 );
+            if ( dfx == 0.0 || ( ( x - hi ) * dfx - fx ) * ( ( x - lo ) * dfx - fx ) > 0.0 || fabs ( 2.0 * fx ) > fabs ( olddx * dfx ) )
+            {
+                olddx = dx;
+                dx = ( hi - lo ) / 2.0;
+                x = lo + dx;
+            }
+            else
+            {
+                olddx = dx;
+                dx = fx / dfx;
+                x -= dx;
+            }
+            
+            fx = evaluateEvent ( coords, pObj1, pObj2, x, zone, func ) - target;
+            if ( fx < 0.0 )
+                lo = x;
+            else
+                hi = x;
+            
+            if ( fabs ( dx ) < tol || fabs ( hi - lo ) < tol )
+                break;
+        }
+        
+        value = fx + target;
+        return x;
+    }
+    
+    // Brent's method: (b) is the best estimate so far, (a) the previous one, and (c) the other end of the bracket.
+    
+    double c = a, fc = fa, d = b - a, e = d;
+    
+    for ( int i = 0; i < kMaxIterations; i++ )
+    {
+        if ( ( fb > 0.0 && fc > 0.0 ) || ( fb < 0.0 && fc < 0.0 ) )
+        {
+            c = a; fc = fa;
+            d = e = b - a;
+        }
+        
+        if ( fabs ( fc ) < fabs ( fb ) )
+        {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
+        }
+        
+        double m = ( c - b ) / 2.0;
+        if ( fabs ( m ) <= tol || fb == 0.0 )
+            break;
+        
+        if ( fabs ( e ) >= tol && fabs ( fa ) > fabs ( fb ) )
+        {
+            double s = fb / fa, p, q;
+            if ( a == c )
+            {
+                p = 2.0 * m * s;
+                q = 1.0 - s;
+            }
+            else
+            {
+                double r = fb / fc;
+                q = fa / fc;
+                p = s * ( 2.0 * m * q * ( q - r ) - ( b - a ) * ( r - 1.0 ) );
+                q = ( q - 1.0 ) * ( r - 1.0 ) * ( s - 1.0 );
+            }
+            
+            if ( p > 0.0 )
+                q = -q;
+            else
+                p = -p;
+            
+            if ( 2.0 * p < min ( 3.0 * m * q - fabs ( tol * q ), fabs ( e * q ) ) )
+            {
+                e = d;
+                d = p / q;
+            }
+            else
+            {
+                d = m;
+                e = d;
+            }
+        }
+        else
+        {
+            d = m;
+            e = d;
+        }
+        
+        a = b; fa = fb;
+        b += fabs ( d ) > tol ? d : ( m > 0.0 ? tol : -tol );
+        fb = evaluateEvent ( coords, pObj1, pObj2, b, zone, func ) - target;
+    }
+    
+    value = fb + target;
+    return b;
+}
+
+// Finds local minima or maxima of (func) like findEvents(), stepping through the time range exactly the same way,
+// but refines each extremum bracketed by three steps with brentExtremum(); see header. The limit (limit) is tested
+// against the refined value of (func) at the extremum, rather than the value at the middle step.
+
+void SSEvent::findEventsBrent ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool min, double limit, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, double precision )
+{
+    double newVal = INFINITY, curVal = INFINITY, oldVal = INFINITY;
+    double sign = min ? 1.0 : -1.0;
+    
+    for ( SSTime time = start; time <= stop && events.size() < maxEvents; time += step )
+    {
+        oldVal = curVal;
+        curVal = newVal;
+        newVal = evaluateEvent ( coords, pObj1, pObj2, time.jd, time.zone, func );
+        
+        if ( isinf ( oldVal ) || isinf ( curVal ) || isinf ( newVal ) )
+            continue;
+        
+        if ( ( min && newVal > curVal && curVal < oldVal ) || ( ! min && newVal < curVal && curVal > oldVal ) )
+        {
+            double fx = sign * curVal;
+            double jd = brentExtremum ( coords, pObj1, pObj2, time.zone, func, sign, time.jd - 2.0 * step, time.jd, time.jd - step, fx, precision / 2.0 );
+            double value = sign * fx;
+            
+            if ( ( min && value <= limit ) || ( ! min && value >= limit ) )
+            {
+                SSEventTime event = { SSTime ( jd, time.zone ), value };
+                events.push_back ( event );
+            }
+        }
+    }
+}
+
+// Finds equality events like findEqualityEvents(), stepping through the time range exactly the same way,
+// but refines each event bracketed by two steps with brentEquality(); see header.
+
+void SSEvent::findEqualityEventsBrent ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool below, double target, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, SSEventFunc rate, double precision )
+{
+    double curVal = INFINITY, oldVal = INFINITY;
+    
+    for ( SSTime time = start; time <= stop && events.size() < maxEvents; time += step )
+    {
+        oldVal = curVal;
+        curVal = evaluateEvent ( coords, pObj1, pObj2, time.jd, time.zone, func );
+        
+        if ( isinf ( oldVal ) || isinf ( curVal ) )
+            continue;
+        
+        if ( ( below && curVal >= target && oldVal < target ) || ( ! below && curVal <= target && oldVal > target ) )
+        {
+            double value = curVal;
+            double jd = time.jd;
+            
+            if ( curVal != target )
+                jd = brentEquality ( coords, pObj1, pObj2, time.zone, func, rate, target, time.jd - step, time.jd, oldVal - target, curVal - target, value, precision / 2.0 );
+            
+            SSEventTime event = { SSTime ( jd, time.zone ), value };
+            events.push_back ( event );
+        }
+    }
+}
+
+// Returns rate of change of object's altitude in radians per day; see header. The zenith turns about the true celestial pole
+// once per sidereal day; a solar system object's apparent direction changes with its velocity relative to the observer.
+
+double SSEvent::altitudeRate ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2 )
+{
+    static const double kSiderealRate = SSAngle::kTwoPi * 1.00273781191135;     // radians per day
+    
+    SSVector dir = pObj1->getDirection();
+    SSVector zenith = coords.transform ( kHorizon, kFundamental, SSVector ( 0.0, 0.0, 1.0 ) );
+    SSVector pole = coords.transform ( kEquatorial, kFundamental, SSVector ( 0.0, 0.0, 1.0 ) );
+    double rate = ( pole.crossProduct ( zenith ) * kSiderealRate ) * dir;
+    
+    SSPlanetPtr pPlanet = SSGetPlanetPtr ( pObj1 );
+    if ( pPlanet )
+    {
+        SSVector pos = pPlanet->getPosition() - coords.getObserverPosition();
+        SSVector vel = pPlanet->getVelocity() - coords.getObserverVelocity();
+        double dist = pos.magnitude();
+        if ( dist > 0.0 && ! isinf ( dist ) && ! isinf ( vel.magnitude() ) )
+            rate += zenith * ( ( vel - dir * ( dir * vel ) ) / dist );
+    }
+    
+    double cosalt = sqrt ( max ( 0.0, 1.0 - ( zenith * dir ) * ( zenith * dir ) ) );
+    return cosalt > 0.0 ? rate / cosalt : 0.0;
+}
+
+// Sorts objects whose indices are (indices) by J2000 ecliptic longitude of their apparent directions (dirs), which are
+// rotated to the ecliptic by (eclMat). Returns (longitude,index) pairs in (lons), with longitudes from 0 to 2pi.
+// Objects without a valid direction are left out, since a NaN longitude would break the sort.
+
+static void sortByLongitude ( const vector<int> &indices, const vector<SSVector> &dirs, const SSMatrix &eclMat, vector<pair<double,int>> &lons )
+{
+    lons.clear();
+    for ( int i : indices )
+    {
+        if ( ! isfinite ( dirs[i].x ) )
+            continue;
+        
+        SSVector ecl = eclMat * dirs[i];
+        lons.push_back ( make_pair ( (double) SSAngle::atan2Pi ( ecl.y, ecl.x ), i ) );
+    }
+    
+    sort ( lons.begin(), lons.end() );
+}
+
+// Appends to (result) indices of objects in (lons), sorted by sortByLongitude(), whose ecliptic longitudes could put them within
+// (radius) of a direction whose J2000 ecliptic coordinates are (lon,lat). That is every object whose longitude is within the longitude
+// extent of a circle of that radius, or all objects if the circle includes a pole.
+
+static void findByLongitude ( const vector<pair<double,int>> &lons, double lon, double lat, double radius, vector<int> &result )
+{
+    result.clear();
+    if ( fabs ( lat ) + radius >= SSAngle::kHalfPi )
+    {
+        for ( auto &l : lons )
+            result.push_back ( l.second );
+        return;
+    }
+    
+    double width = asin ( min ( 1.0, sin ( radius ) / cos ( lat ) ) );
+    double ranges[2][2] = { { lon - width, lon + width }, { 1.0, 0.0 } };
+    if ( ranges[0][0] < 0.0 )
+    {
+        ranges[1][0] = ranges[0][0] + SSAngle::kTwoPi;
+        ranges[1][1] = SSAngle::kTwoPi;
+        ranges[0][0] = 0.0;
+    }
+    else if ( ranges[0][1] >= SSAngle::kTwoPi )
+    {
+        ranges[1][0] = 0.0;
+        ranges[1][1] = ranges[0][1] - SSAngle::kTwoPi;
+        ranges[0][1] = SSAngle::kTwoPi;
+    }
+    
+    for ( int r = 0; r < 2; r++ )
+    {
+        auto it = lower_bound ( lons.begin(), lons.end(), make_pair ( ranges[r][0], INT_MIN ) );
+        for ( ; it != lons.end() && it->first <= ranges[r][1]; it++ )
+            result.push_back ( it->second );
+    }
+}
+
+// Returns apparent angular radius of a solar system object (pObj) in radians, from its physical radius and distance;
+// zero for other objects, or if the radius or distance is unknown.
+
+static double angularRadius ( SSObjectPtr pObj )
+{
+    SSPlanetPtr pPlanet = SSGetPlanetPtr ( pObj );
+    if ( pPlanet == nullptr )
+        return 0.0;
+    
+    double radius = pPlanet->getRadius(), distance = pPlanet->getDistance() * SSCoordinates::kKmPerAU;
+    if ( radius <= 0.0 || isinf ( radius ) || isinf ( distance ) || distance <= 0.0 )
+        return 0.0;
+    
+    return asin ( min ( 1.0, radius / distance ) );
+}
+
+// Finds conjunctions between all objects in a vector; see header. A pair is followed while it stays within its search radius:
+// the separation limit plus the distance the two objects could close at their current angular speeds in kSpeedMargin steps,
+// which is more than the pair can move in the 1.5 steps between its closest approach and the farthest step of the three
+// which bracket it. Non-solar-system objects' directions are refreshed every kFixedRefresh days; between refreshes,
+// aberration and proper motion move them by a few arcseconds at most, allowed for by kFixedMargin.
+
+int SSEvent::findAllConjunctions ( SSCoordinates &coords, SSObjectVec &objects, SSTime start, SSTime stop, double step, SSAngle limit, vector<SSConjunction> &conjunctions, int maxConjunctions )
+{
+    static const double kFixedRefresh = 10.0;                       // days between recomputing non-solar-system objects' directions
+    static const double kFixedMargin = 1.0 / SSAngle::kArcminPerRad; // allowance for their apparent motion between refreshes [radians]
+    static const double kSpeedMargin = 2.0;                         // search steps of relative motion added to pairs' search radius
+    static const double kOnSurface = 1.1;                           // observer closer than this many radii to an object is on its surface
+    static const double kFitMargin = 0.25;                          // search steps of relative motion allowed for error in estimated closest approach
+
+    // Pair of objects followed from step to step: separations at the last two steps, and number of consecutive steps followed.
+    
+    struct Track
+    {
+        double sep0, sep1;
+        int steps;
+    };
+    
+    if ( step <= 0.0 || maxConjunctions < 1 )
+        return 0;
+    
+    // Split objects into solar system objects, which move, and the rest, which are nearly fixed.
+    
+    int n = (int) objects.size();
+    vector<int> moving, fixed;
+    for ( int i = 0; i < n; i++ )
+        if ( SSGetPlanetPtr ( objects[i] ) )
+            moving.push_back ( i );
+        else
+            fixed.push_back ( i );
+    
+    SSMatrix eclMat = SSCoordinates::getEclipticMatrix ( SSCoordinates::getObliquity ( SSTime::kJ2000 ) );
+    SSCoordinates refineCoords = coords;
+    vector<SSVector> dirs ( n );
+    vector<double> speeds ( n, 0.0 );
+    vector<pair<double,int>> movingLons, fixedLons;
+    unordered_map<uint64_t,Track> tracks, nextTracks;
+    vector<SSConjunction> found;
+    vector<int> candidates;
+    double refreshed = -INFINITY, maxSpeed = 0.0;
+    long k = 0, lastStep = LONG_MAX;
+    
+    // Follows the pair of objects (i,j), whose relative angular speed is at most (speed), at step (time) if their separation
+    // is within (radius). If the pair was followed at the last two steps, and its separation then was a minimum, estimates
+    // the closest approach from a parabola through the squared separations at the three steps, which is exact for objects
+    // moving uniformly in straight lines. Unless that is clearly more than the limit, refines the minimum on copies of the objects.
+    
+    auto follow = [&] ( int i, int j, double radius, double speed, SSTime time )
+    {
+        double sep = dirs[i].angularSeparation ( dirs[j] );
+        if ( sep > radius )
+            return;
+        
+        uint64_t key = ( (uint64_t) i << 32 ) | (uint32_t) j;
+        Track track = { INFINITY, sep, 1 };
+        auto prev = tracks.find ( key );
+        if ( prev != tracks.end() )
+        {
+            track.sep0 = prev->second.sep1;
+            track.steps = prev->second.steps + 1;
+            
+            double y0 = prev->second.sep0 * prev->second.sep0, y1 = prev->second.sep1 * prev->second.sep1, y2 = sep * sep;
+            double a = ( y0 + y2 ) / 2.0 - y1, b = ( y2 - y0 ) / 2.0;
+            
+            if ( prev->second.steps >= 2 && y0 > y1 && y2 > y1 && sqrt ( max ( 0.0, y1 - b * b / ( 4.0 * a ) ) ) <= limit + kFitMargin * step * speed )
+            {
+                SSObjectPtr pObj1 = SSCloneObject ( objects[i] ), pObj2 = SSCloneObject ( objects[j] );
+                double value = prev->second.sep1;
+                double jd = brentExtremum ( refineCoords, pObj1, pObj2, time.zone, object_separation, 1.0, time.jd - 2.0 * step, time.jd, time.jd - step, value, 0.5 / SSTime::kSecondsPerDay );
+                if ( value <= limit )
+                {
+                    SSConjunction conj = { objects[i], objects[j], SSTime ( jd, time.zone ), value, value < angularRadius ( pObj1 ) + angularRadius ( pObj2 ) };
+                    found.push_back ( conj );
+                }
+                
+                delete pObj1;
+                delete pObj2;
+            }
+        }
+        
+        nextTracks[key] = track;
+    };
+    
+    // Compute solar system objects' directions one step before the start, so their angular speeds are known at the first step.
+    // Leave out objects without a direction, and objects the observer is standing on, e.g. the Earth for an observer on its surface.
+    
+    coords.setTime ( start - step );
+    vector<int> visible;
+    for ( int i : moving )
+    {
+        objects[i]->computeEphemeris ( coords );
+        dirs[i] = objects[i]->getDirection();
+        double radius = SSGetPlanetPtr ( objects[i] )->getRadius();
+        if ( ! isfinite ( dirs[i].x ) || objects[i]->getDistance() * SSCoordinates::kKmPerAU < kOnSurface * radius )
+            continue;
+        visible.push_back ( i );
+    }
+    
+    moving = visible;
+    
+    for ( SSTime time = start; time <= stop && k <= lastStep; time += step, k++ )
+    {
+        coords.setTime ( time );
+        
+        if ( time - refreshed >= kFixedRefresh )
+        {
+            for ( int i : fixed )
+            {
+                objects[i]->computeEphemeris ( coords );
+                dirs[i] = objects[i]->getDirection();
+            }
+            
+            sortByLongitude ( fixed, dirs, eclMat, fixedLons );
+            refreshed = time;
+        }
+        
+        maxSpeed = 0.0;
+        for ( int i : moving )
+        {
+            objects[i]->computeEphemeris ( coords );
+            SSVector dir = objects[i]->getDirection();
+            speeds[i] = dir.angularSeparation ( dirs[i] ) / step;
+            maxSpeed = max ( maxSpeed, speeds[i] );
+            dirs[i] = dir;
+        }
+        
+        sortByLongitude ( moving, dirs, eclMat, movingLons );
+        nextTracks.clear();
+        
+        for ( int i : moving )
+        {
+            SSVector ecl = eclMat * dirs[i];
+            double lon = SSAngle::atan2Pi ( ecl.y, ecl.x ), lat = asin ( max ( -1.0, min ( 1.0, ecl.z ) ) );
+            
+            // Other solar system objects: each pair is followed once, from the object which comes first in the vector.
+            
+            findByLongitude ( movingLons, lon, lat, limit + kSpeedMargin * step * ( speeds[i] + maxSpeed ), candidates );
+            for ( int j : candidates )
+                if ( j > i )
+                    follow ( i, j, limit + kSpeedMargin * step * ( speeds[i] + speeds[j] ), speeds[i] + speeds[j], time );
+            
+            // Fixed objects.
+            
+            double radius = limit + kSpeedMargin * step * speeds[i] + kFixedMargin;
+            findByLongitude ( fixedLons, lon, lat, radius, candidates );
+            for ( int j : candidates )
+                follow ( i, j, radius, speeds[i], time );
+        }
+        
+        swap ( tracks, nextTracks );
+        
+        // Minima found at one step can be up to a step later than minima found at the next,
+        // so search one more step after finding enough, then keep the earliest.
+        
+        if ( found.size() >= maxConjunctions && lastStep == LONG_MAX )
+            lastStep = k + 1;
+    }
+    
+    stable_sort ( found.begin(), found.end(), [] ( const SSConjunction &c1, const SSConjunction &c2 ) { return c1.time < c2.time; } );
+    if ( found.size() > maxConjunctions )
+        found.resize ( maxConjunctions );
+    
+    conjunctions.insert ( conjunctions.end(), found.begin(), found.end() );
+    return (int) found.size();
+}
+
 void SSEvent::findConjunctions ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, vector<SSEventTime> &events, int maxEvents )
 {
     findEvents ( coords, pObj1, pObj2, start, stop, 1.0, true, INFINITY, object_separation, events, maxEvents );
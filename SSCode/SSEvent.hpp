@@ -32,6 +32,14 @@ struct SSPass
     SSRTS setting;      // circumstances of setting event
 };
 
+// Describes an observing site for which SSEvent::riseTransitSetTable() computes rise/transit/set times.
+
+struct SSRTSSite
+{
+    SSSpherical location;   // geographic longitude and latitude [radians], east and north positive; and height above the ellipsoid [km]
+    double      zone;       // local time zone offset from UTC in hours east of Greenwich; defines the site's local days
+};
+
 // Describes circumstances of a generic event: conjunction, opposition, etc.
 
 struct SSEventTime
@@ -40,6 +48,17 @@ struct SSEventTime
     double value;       // value at time of event (angular distance in radiams, or physical distance in AU, etc.)
 };
 
+// Describes circumstances of a close approach between two objects found by SSEvent::findAllConjunctions()
+
+struct SSConjunction
+{
+    SSObjectPtr pObj1;      // first object; always a solar system object
+    SSObjectPtr pObj2;      // second object; a solar system object which follows pObj1 in the searched object vector, or any other object
+    SSTime      time;       // time of closest approach
+    double      separation; // apparent angular separation at closest approach [radians]
+    bool        occultation;// true if objects' apparent disks overlap at closest approach, i.e. one occults or transits the other
+};
+
 // Pointer to generic event-finding function
 
 typedef double (*SSEventFunc) ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2 );
@@ -71,12 +90,64 @@ public:
     static SSTime riseTransitSetSearchDay ( SSTime today, SSCoordinates &coords, SSObjectPtr pObj, int sign, SSAngle alt );
 
     static SSPass riseTransitSet ( SSTime today, SSCoordinates &coords, SSObjectPtr pObj, SSAngle alt );
+
+    // Computes rise/transit/set tables for many objects (objects), over (days) consecutive local days starting with the day
+    // containing time (start), as seen from many sites (sites). Each object's apparent position is computed once per day
+    // for the Earth's center and the observer's geocentric position is subtracted at each site, so ephemerides are never
+    // recomputed per site; times of events are then found as in riseTransitSet(), with positions interpolated from the
+    // daily table with cubic polynomials, and sidereal time from one value per day. The Sun and Moon rise and set at
+    // kSunMoonRiseSetAlt, other objects at kDefaultRiseSetAlt. Sites are shared between (threads) threads; zero means
+    // one per hardware core. The pass for object (o) on day (d) at site (s) is stored in (passes) at index
+    // (s * days + d) * objects.size() + o, with the same conventions as riseTransitSet(). Returns the number of passes.
+    // Will not work for objects which rise and set multiple times per day, e.g. artifical satellites, or for the Earth.
+    // The objects' positions will be recomputed/modified by this function!
+
+    static int riseTransitSetTable ( SSTime start, int days, SSObjectVec &objects, vector<SSRTSSite> &sites, vector<SSPass> &passes, int threads = 0 );
+
     static int findSatellitePasses ( SSCoordinates &coords, SSObjectPtr pSat, SSTime start, SSTime stop, double minAlt, vector<SSPass> &passes, int maxPasses );
 
     static SSTime nextMoonPhase ( SSTime time, SSObjectPtr pSun, SSObjectPtr pMoon, double phase );
     
     static void findEvents ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool max, double limit, SSEventFunc func, vector<SSEventTime> &events, int maxEvents );
     static void findEqualityEvents ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool max, double value, SSEventFunc func, vector<SSEventTime> &events, int maxEvents );
+
+    // Parallel versions of findEvents() and findEqualityEvents(). The time range (start to stop) is split into chunks
+    // of whole search steps which are searched on (threads) threads at once; zero means one per hardware core.
+    // Each thread works on its own copies of (coords), (pObj1), and (pObj2), so those are NOT modified by these methods.
+    // Events are appended to (events) in time order, and are the same ones the serial methods would find.
+
+    static void findEventsParallel ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool min, double limit, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, int threads = 0 );
+    static void findEqualityEventsParallel ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool below, double target, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, int threads = 0 );
+
+    // Alternatives to findEvents() and findEqualityEvents() which step through the time range (start to stop) the same way,
+    // but locate each event bracketed by those steps with Brent's method instead of repeated ten-times-smaller steps:
+    // parabolic interpolation with golden-section fallback for extrema, and inverse quadratic interpolation with bisection
+    // fallback for equalities. Event times are found to within (precision) days, one second by default, typically with
+    // 6-9 ephemeris evaluations per extremum and about 3 per equality, instead of about 96 and 40. If a rate function
+    // (rate) is given, it must return the derivative of (func) in units per day, and equality events are refined with
+    // safeguarded Newton steps which use it; an inexact rate only slows convergence, since (func) decides where events are.
+    // The coordinates (coords) and objects' (pObj1,pObj2) positions will be recomputed/modified by these methods!
+
+    static void findEventsBrent ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool min, double limit, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, double precision = 1.0 / SSTime::kSecondsPerDay );
+    static void findEqualityEventsBrent ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, double step, bool below, double target, SSEventFunc func, vector<SSEventTime> &events, int maxEvents, SSEventFunc rate = nullptr, double precision = 1.0 / SSTime::kSecondsPerDay );
+
+    // Finds all conjunctions between objects in (objects) from time (start) to (stop): every time two objects' apparent separation
+    // reaches a local minimum less than (limit), and at least one of them is a solar system object. Ephemerides of all solar system
+    // objects are computed once every (step) days; other objects' directions are recomputed every few days. Each time step,
+    // pairs within (limit) plus the distance they could close in two steps are found from lists of objects sorted by ecliptic
+    // longitude, so a solar system object is only compared with objects in a narrow longitude window around it. Pairs are followed
+    // from step to step, and each minimum bracketed by three steps is refined to one second with Brent's method on copies of the
+    // objects. The step must be short enough that each pair has only one minimum separation in two steps (e.g. 1/24 day for the Moon).
+    // Finds at most (maxConjunctions), appended to (conjunctions) in time order; returns the number found.
+    // The coordinates (coords) and objects' positions will be recomputed/modified by this function!
+
+    static int findAllConjunctions ( SSCoordinates &coords, SSObjectVec &objects, SSTime start, SSTime stop, double step, SSAngle limit, vector<SSConjunction> &conjunctions, int maxConjunctions );
+
+    // Returns rate of change of object (pObj1)'s altitude in radians per day, from the Earth's rotation and, for solar system objects,
+    // from the object's and observer's velocities. Ignores changes in aberration and refraction. Use as the rate of altitude events.
+
+    static double altitudeRate ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2 );
+
     static void findConjunctions ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, vector<SSEventTime> &events, int maxEvents );
     static void findOppositions ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, vector<SSEventTime> &events, int maxEvents );
     static void findNearestDistances ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2, SSTime start, SSTime stop, vector<SSEventTime> &events, int maxEvents );
@@ -0,0 +1,292 @@
+// SSGeometryCache.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+
+#include "SSGeometryCache.hpp"
+#include "SSConstellation.hpp"
+#include "SSStar.hpp"
+
+// Constructs an empty geometry cache; see header for parameters.
+
+SSGeometryCache::SSGeometryCache ( SSFrame frame, SSAngle resolution, SSAngle tolerance )
+{
+    _frame = frame;
+    _resolution = resolution;
+    _tolerance = tolerance;
+    _valid = false;
+}
+
+// Removes all lines and cached vertices.
+
+void SSGeometryCache::clear ( void )
+{
+    _lines.clear();
+    _vertices.clear();
+    _chunks.clear();
+    _valid = false;
+}
+
+// Adds a line to the cache; see header. Vertices are normalized to unit vectors.
+
+int SSGeometryCache::addLine ( const vector<SSVector> &vertices, SSFrame frame, int tag, bool closed )
+{
+    Line line = { vector<SSVector> ( vertices.size() ), frame, tag, closed };
+    for ( size_t i = 0; i < vertices.size(); i++ )
+        line.vertices[i] = vertices[i].normalize();
+
+    _lines.push_back ( line );
+    _valid = false;
+    return (int) _lines.size() - 1;
+}
+
+// Adds boundaries of all constellations; constellation boundaries are fixed in the fundamental frame.
+
+int SSGeometryCache::addConstellationBoundaries ( SSObjectVec &constellations )
+{
+    int n = 0;
+
+    for ( int i = 0; i < constellations.size(); i++ )
+    {
+        SSConstellationPtr pCon = SSGetConstellationPtr ( constellations[i] );
+        if ( pCon == nullptr )
+            continue;
+
+        vector<SSVector> bounds = pCon->getBoundary();
+        if ( bounds.size() < 2 )
+            continue;
+
+        // Boundaries returned by SSImportConstellationBoundaries() usually repeat their first vertex
+        // at the end; if not, close them.
+
+        bool closed = bounds.front().distance ( bounds.back() ) > 1.0e-9;
+        addLine ( bounds, kFundamental, i + 1, closed );
+        n++;
+    }
+
+    return n;
+}
+
+// Adds figures of all constellations as two-vertex lines between stars' J2000 positions.
+// Lines whose endpoint stars aren't found are skipped.
+
+int SSGeometryCache::addConstellationFigures ( SSObjectVec &constellations, SSObjectVec &stars )
+{
+    SSObjectMap map = SSMakeObjectMap ( stars, kCatHR );
+    int n = 0;
+
+    for ( int i = 0; i < constellations.size(); i++ )
+    {
+        SSConstellationPtr pCon = SSGetConstellationPtr ( constellations[i] );
+        if ( pCon == nullptr )
+            continue;
+
+        vector<int> figure = pCon->getFigure();
+        for ( size_t k = 0; k + 1 < figure.size(); k += 2 )
+        {
+            int i1 = map[ SSIdentifier ( kCatHR, figure[k] ) ];
+            int i2 = map[ SSIdentifier ( kCatHR, figure[k + 1] ) ];
+            SSStarPtr pStar1 = i1 > 0 ? SSGetStarPtr ( stars[i1 - 1] ) : nullptr;
+            SSStarPtr pStar2 = i2 > 0 ? SSGetStarPtr ( stars[i2 - 1] ) : nullptr;
+            if ( pStar1 == nullptr || pStar2 == nullptr )
+                continue;
+
+            addLine ( { pStar1->getFundamentalPosition(), pStar2->getFundamentalPosition() }, kFundamental, i + 1, false );
+            n++;
+        }
+    }
+
+    return n;
+}
+
+// Adds a coordinate grid; see header. Parallels are sampled at the cache resolution in longitude,
+// so successive vertices are never farther apart than the resolution and tessellation leaves them
+// as they are; great-circle steps between them differ from the true small circle by at most
+// resolution^2 / 8 radians (about 0.5 arcsec at the default one-degree resolution).
+
+int SSGeometryCache::addGrid ( SSFrame frame, SSAngle lonStep, SSAngle latStep )
+{
+    int n = 0;
+
+    if ( lonStep > 0.0 )
+    {
+        int nlon = max ( 1, (int) round ( SSAngle::kTwoPi / lonStep ) );
+        for ( int i = 0; i < nlon; i++ )
+        {
+            SSAngle lon = SSAngle::kTwoPi * i / nlon;
+            vector<SSVector> meridian = { SSVector ( SSSpherical ( lon, -SSAngle::kHalfPi ) ), SSVector ( SSSpherical ( lon, 0.0 ) ), SSVector ( SSSpherical ( lon, SSAngle::kHalfPi ) ) };
+            addLine ( meridian, frame, kTagMeridian, false );
+            n++;
+        }
+    }
+
+    if ( latStep > 0.0 )
+    {
+        int nlat = (int) ceil ( SSAngle::kHalfPi / latStep ) - 1;
+        int nverts = max ( 8, (int) ceil ( SSAngle::kTwoPi / _resolution ) );
+        for ( int j = -nlat; j <= nlat; j++ )
+        {
+            SSAngle lat = (double) latStep * j;
+            vector<SSVector> parallel ( nverts );
+            for ( int i = 0; i < nverts; i++ )
+                parallel[i] = SSVector ( SSSpherical ( SSAngle::kTwoPi * i / nverts, lat ) );
+            addLine ( parallel, frame, kTagParallel, true );
+            n++;
+        }
+    }
+
+    return n;
+}
+
+// Returns rotation angle in radians between two rotation matrices, from the rotation which takes m0 to m1.
+// The sine of the angle comes from the antisymmetric part of that rotation, and the cosine from its trace,
+// so the angle is accurate to machine precision even when very small.
+
+SSAngle SSGeometryCache::rotationAngle ( SSMatrix m0, SSMatrix m1 )
+{
+    SSMatrix r = m1 * m0.transpose();
+    double s = SSVector ( r.m21 - r.m12, r.m02 - r.m20, r.m10 - r.m01 ).magnitude() / 2.0;
+    double c = ( r.m00 + r.m11 + r.m22 - 1.0 ) / 2.0;
+    return SSAngle ( atan2 ( s, c ) );
+}
+
+// Rebuilds vertex buffer if needed; see header.
+
+bool SSGeometryCache::update ( SSCoordinates &coords )
+{
+    bool used[kHorizon + 1] = { false };
+    for ( const Line &line : _lines )
+        used[ line.frame ] = true;
+
+    bool rebuild = ! _valid;
+    SSMatrix matrices[kHorizon + 1];
+
+    for ( int f = 0; f <= kHorizon; f++ )
+    {
+        if ( ! used[f] )
+            continue;
+
+        matrices[f] = coords.getTransformMatrix ( (SSFrame) f, _frame );
+        if ( ! rebuild && rotationAngle ( _matrices[f], matrices[f] ) > _tolerance )
+            rebuild = true;
+    }
+
+    if ( ! rebuild )
+        return false;
+
+    for ( int f = 0; f <= kHorizon; f++ )
+        _matrices[f] = matrices[f];
+
+    build();
+    return true;
+}
+
+// Tessellates every source line into great-circle steps no longer than the resolution,
+// in the cache frame, then splits each tessellated line into chunks.
+
+void SSGeometryCache::build ( void )
+{
+    _vertices.clear();
+    _chunks.clear();
+
+    vector<SSVector> points;
+
+    for ( int l = 0; l < (int) _lines.size(); l++ )
+    {
+        const Line &line = _lines[l];
+        size_t n = line.vertices.size();
+        size_t segments = line.closed ? n : n - 1;
+        if ( n < 2 )
+            continue;
+
+        SSMatrix &mat = _matrices[ line.frame ];
+        points.clear();
+        points.push_back ( mat * line.vertices[0] );
+
+        for ( size_t i = 0; i < segments; i++ )
+        {
+            SSVector a = mat * line.vertices[i];
+            SSVector b = mat * line.vertices[ ( i + 1 ) % n ];
+            double angle = a.angularSeparation ( b );
+            int steps = max ( 1, (int) ceil ( angle / _resolution ) );
+            double sina = sin ( angle );
+
+            // Interpolate along the great circle from a to b. Endpoints which are nearly
+            // coincident or nearly opposite don't define a great circle; step between them linearly.
+
+            for ( int k = 1; k < steps; k++ )
+            {
+                double t = (double) k / steps;
+                if ( sina > 1.0e-9 )
+                    points.push_back ( ( a * sin ( ( 1.0 - t ) * angle ) + b * sin ( t * angle ) ) / sina );
+                else
+                    points.push_back ( ( a * ( 1.0 - t ) + b * t ).normalize() );
+            }
+
+            points.push_back ( b );
+        }
+
+        addChunks ( l, points );
+    }
+
+    _valid = true;
+}
+
+// Splits tessellated line (points) from source line index (line) into chunks and appends them to
+// the vertex buffer. Each chunk's bounding cap is centered on the normalized mean of its vertices.
+// Since every vertex lies within the cap, and the cap is smaller than a hemisphere, the great circle
+// arcs between them do too. If a chunk somehow spans a hemisphere, its cap is the whole sphere.
+
+void SSGeometryCache::addChunks ( int line, const vector<SSVector> &points )
+{
+    for ( size_t start = 0; start + 1 < points.size(); start += kChunkVertices - 1 )
+    {
+        Chunk chunk;
+        chunk.first = (uint32_t) _vertices.size();
+        chunk.count = (uint32_t) min ( (size_t) kChunkVertices, points.size() - start );
+        chunk.line = line;
+        chunk.tag = _lines[line].tag;
+
+        SSVector sum;
+        for ( size_t i = start; i < start + chunk.count; i++ )
+        {
+            _vertices.push_back ( points[i] );
+            sum += points[i];
+        }
+
+        double radius = 0.0;
+        chunk.center = sum.normalize();
+        for ( size_t i = start; i < start + chunk.count; i++ )
+            radius = max ( radius, (double) chunk.center.angularSeparation ( points[i] ) );
+
+        if ( sum.magnitude() == 0.0 || radius >= SSAngle::kHalfPi )
+            radius = SSAngle::kPi;
+
+        chunk.radius = radius;
+        chunk.cosr = cos ( radius );
+        chunk.sinr = sin ( radius );
+        _chunks.push_back ( chunk );
+    }
+}
+
+// Finds chunks which may be visible in a field of view; see header. A chunk may be visible if the
+// angle from the view center to the chunk's cap center is no more than the sum of the view's bounding
+// radius R and the cap radius r, i.e. if the dot product of the two centers is at least cos ( R + r ).
+
+size_t SSGeometryCache::cull ( SSView &view, vector<uint32_t> &chunks )
+{
+    chunks.clear();
+
+    double radius = view.getBoundingRadius();
+    SSVector center = view.getCenterVector();
+    double cosR = cos ( radius ), sinR = sin ( radius );
+
+    for ( uint32_t i = 0; i < _chunks.size(); i++ )
+    {
+        const Chunk &chunk = _chunks[i];
+        if ( radius + chunk.radius >= SSAngle::kPi || center * chunk.center >= cosR * chunk.cosr - sinR * chunk.sinr )
+            chunks.push_back ( i );
+    }
+
+    return chunks.size();
+}
@@ -0,0 +1,130 @@
+// SSGeometryCache.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// Caches line geometry on the celestial sphere - constellation boundaries and figures, coordinate
+// grid lines - pre-tessellated into short great-circle steps and stored in one flat vertex buffer,
+// ready to be projected with SSView::project() every frame. The tessellated lines are split into
+// short chunks, each with a bounding circle ("cap") on the sphere, so a chunk which lies entirely
+// outside a field of view can be rejected with one dot product before any of its vertices are
+// projected and clipped. Each source line remembers the frame it is fixed in; the cached vertices
+// are stored in the cache's own frame, and only rebuilt when the rotation between those frames
+// (i.e. precession and nutation) has changed by more than a tolerance since they were last built.
+
+#ifndef SSGeometryCache_hpp
+#define SSGeometryCache_hpp
+
+#include "SSCoordinates.hpp"
+#include "SSObject.hpp"
+#include "SSView.hpp"
+
+class SSGeometryCache
+{
+public:
+
+    static constexpr int kChunkVertices = 16;   // maximum number of vertices in one chunk
+    static constexpr int kTagMeridian = 0;      // tag of coordinate grid meridians (lines of constant longitude)
+    static constexpr int kTagParallel = 1;      // tag of coordinate grid parallels (lines of constant latitude)
+
+    // A run of up to kChunkVertices consecutive vertices from one source line, drawn as a polyline.
+    // The last vertex of one chunk is repeated as the first vertex of the next chunk from the same line.
+
+    struct Chunk
+    {
+        uint32_t first;     // index of chunk's first vertex in vertex buffer
+        uint32_t count;     // number of vertices in chunk; polyline has (count - 1) segments
+        int32_t  line;      // index of source line which chunk was tessellated from
+        int32_t  tag;       // tag of source line, e.g. constellation number
+        SSVector center;    // unit vector to center of chunk's bounding cap, in cache frame
+        double   radius;    // angular radius of bounding cap, in radians
+        double   cosr;      // cosine of bounding cap radius
+        double   sinr;      // sine of bounding cap radius
+    };
+
+protected:
+
+    // A line added to the cache, in the frame it is fixed in.
+
+    struct Line
+    {
+        vector<SSVector> vertices;  // unit vectors in source frame
+        SSFrame frame;              // frame in which vertices are fixed
+        int tag;                    // caller-defined tag
+        bool closed;                // if true, last vertex connects back to first
+    };
+
+    SSFrame _frame;                     // frame in which cached vertices are stored
+    double _resolution;                 // maximum angular step between tessellated vertices, in radians
+    double _tolerance;                  // largest change in source-to-cache frame rotation allowed before rebuilding, in radians
+    vector<Line> _lines;                // source lines
+    vector<SSVector> _vertices;         // tessellated vertex buffer, unit vectors in cache frame
+    vector<Chunk> _chunks;              // chunks of vertex buffer
+    SSMatrix _matrices[kHorizon + 1];   // source-to-cache frame rotation matrices used to build vertex buffer, indexed by source frame
+    bool _valid;                        // false if vertex buffer must be rebuilt
+
+    void build ( void );
+    void addChunks ( int line, const vector<SSVector> &points );
+
+public:
+
+    // Constructs an empty cache which stores vertices in frame (frame), tessellates lines into steps no
+    // longer than (resolution), and rebuilds when frames rotate relative to each other by more than (tolerance).
+    // Caching in kHorizon frame is allowed, but will rebuild almost every time the cache is updated.
+
+    SSGeometryCache ( SSFrame frame = kEquatorial, SSAngle resolution = SSAngle::fromDegrees ( 1.0 ), SSAngle tolerance = SSAngle::fromArcmin ( 1.0 ) );
+
+    SSFrame getFrame ( void ) { return _frame; }
+    SSAngle getResolution ( void ) { return _resolution; }
+    SSAngle getTolerance ( void ) { return _tolerance; }
+
+    // Adds a line through unit vectors (vertices) fixed in frame (frame) with a caller-defined (tag).
+    // If (closed) is true, the last vertex connects back to the first. Returns index of the new line.
+    // Lines are tessellated the next time the cache is updated.
+
+    int addLine ( const vector<SSVector> &vertices, SSFrame frame, int tag, bool closed );
+
+    // Adds boundaries or figures of all constellations in (constellations), which must be sorted
+    // alphabetically as SSImportConstellations() returns them; each line's tag is the constellation's
+    // number (1 = Andromeda ... 88 = Vulpecula). Figure lines connect stars' J2000 positions; stars
+    // are found by HR number in (stars). Returns number of lines added.
+
+    int addConstellationBoundaries ( SSObjectVec &constellations );
+    int addConstellationFigures ( SSObjectVec &constellations, SSObjectVec &stars );
+
+    // Adds a coordinate grid fixed in frame (frame), with meridians every (lonStep) from pole to pole,
+    // and parallels every (latStep) north and south of the equator, including the equator itself.
+    // Meridians are tagged kTagMeridian, and parallels kTagParallel. Returns number of lines added.
+
+    int addGrid ( SSFrame frame, SSAngle lonStep, SSAngle latStep );
+
+    // Removes all lines and cached vertices.
+
+    void clear ( void );
+
+    // Rebuilds the vertex buffer if lines were added since it was last built, or if the rotation from
+    // any source frame to the cache frame in (coords) differs by more than the tolerance from the one
+    // the buffer was built with. Call before drawing every frame; returns true if the buffer was rebuilt.
+
+    bool update ( SSCoordinates &coords );
+
+    // Returns rotation angle in radians between two rotation matrices.
+
+    static SSAngle rotationAngle ( SSMatrix m0, SSMatrix m1 );
+
+    // Finds chunks which may be visible in a field of view (view) whose center matrix is in the cache frame.
+    // Chunks whose bounding caps lie outside the view's bounding circle are rejected; remaining chunks'
+    // indices are returned in (chunks), in vertex buffer order. Returns number of chunks found.
+
+    size_t cull ( SSView &view, vector<uint32_t> &chunks );
+
+    // Accessors for the tessellated vertex buffer and its chunks.
+
+    const vector<SSVector> &getVertices ( void ) { return _vertices; }
+    const vector<Chunk> &getChunks ( void ) { return _chunks; }
+    size_t numLines ( void ) { return _lines.size(); }
+    size_t numVertices ( void ) { return _vertices.size(); }
+    size_t numChunks ( void ) { return _chunks.size(); }
+};
+
+#endif /* SSGeometryCache_hpp */
@@ -7,6 +7,7 @@
 #include <string.h>
 
 #include "SSHTM.hpp"
+#include "SSView.hpp"
 
 uint64_t cc_vector2ID ( double x, double y, double z, int depth );
 int cc_IDlevel ( uint64_t htmid );
@@ -90,6 +91,73 @@ vector<uint64_t> SSHTM::subRegionIDs ( uint64_t htmID )
     return  vector<uint64_t> ( { subID, subID + 1, subID + 2, subID + 3 } );
 }
 
+// Gets IDs of regions at each level of this HTM which intersect a view's field of view.
+
+vector<vector<uint64_t>> SSHTM::visibleRegions ( SSView &view )
+{
+    return view.htmRegions ( (int) _magLevels.size() );
+}
+
+// Recursively adds the ID of an HTM triangle (htmID) at a particular level (level) with vertices (v0,v1,v2)
+// to a vector of region IDs at each level (regions), if it passes an intersection test (test), then does
+// the same for its four sub-triangles. Sub-triangles are split exactly as in cc_name2Triangle(). If the
+// triangle is entirely inside the tested area, all of its sub-triangles are added without testing.
+
+static void addIntersectingRegions ( uint64_t htmID, size_t level, SSVector v0, SSVector v1, SSVector v2,
+                                     function<int(const SSVector &, const SSVector &, const SSVector &)> &test, vector<vector<uint64_t>> &regions )
+{
+    int result = test ( v0, v1, v2 );
+    if ( result == 0 )
+        return;
+    
+    if ( result == 2 )
+    {
+        for ( uint64_t first = htmID, last = htmID; level < regions.size(); level++, first *= 4, last = last * 4 + 3 )
+            for ( uint64_t id = first; id <= last; id++ )
+                regions[level].push_back ( id );
+        
+        return;
+    }
+    
+    regions[level].push_back ( htmID );
+    if ( level + 1 >= regions.size() )
+        return;
+    
+    SSVector w0 = ( v1 + v2 ).normalize();
+    SSVector w1 = ( v2 + v0 ).normalize();
+    SSVector w2 = ( v0 + v1 ).normalize();
+    
+    addIntersectingRegions ( htmID * 4 + 0, level + 1, v0, w2, w1, test, regions );
+    addIntersectingRegions ( htmID * 4 + 1, level + 1, v1, w0, w2, test, regions );
+    addIntersectingRegions ( htmID * 4 + 2, level + 1, v2, w1, w0, test, regions );
+    addIntersectingRegions ( htmID * 4 + 3, level + 1, w0, w1, w2, test, regions );
+}
+
+// Gets IDs of all HTM triangles at each level from 0 to (levels - 1) which intersect an area
+// of the celestial sphere defined by an intersection test function (test).
+
+vector<vector<uint64_t>> SSHTM::intersectingRegions ( int levels, function<int(const SSVector &v0, const SSVector &v1, const SSVector &v2)> test )
+{
+    vector<vector<uint64_t>> regions ( max ( levels, 0 ) );
+    if ( levels < 1 )
+        return regions;
+    
+    regions[0].push_back ( 0 );
+    for ( uint64_t htmID = 8; htmID <= 15 && levels > 1; htmID++ )
+    {
+        SSVector v0, v1, v2;
+        name2Triangle ( ID2name ( htmID ), v0, v1, v2 );
+        addIntersectingRegions ( htmID, 1, v0, v1, v2, test, regions );
+    }
+    
+    // If no root triangles intersect the area, neither does the origin region.
+    
+    if ( levels > 1 && regions[1].empty() )
+        regions[0].clear();
+    
+    return regions;
+}
+
 // Gets magnitude of the brightest (min) and faintest (max) stars in a particular HTM region.
 // Returns true if successful, or false if specified region ID is invalid.
 
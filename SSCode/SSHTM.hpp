@@ -8,11 +8,14 @@
 #define SSHTM_HPP
 
 #include <thread>
+#include <functional>
 
 #include "SSObject.hpp"
 #include "SSStar.hpp"
 #include "SSVector.hpp"
 
+class SSView;
+
 // No, not Hypertext Markup Language!
 // This class implements the Heirarchial Triangle Mesh, a method for subdividing the celestial sphere
 // into recursive triangular regions. Used by the Guide Star Catalog 2.x and Sloan Digital Sky Survey.
@@ -76,6 +79,19 @@ public:
     
     vector<uint64_t> subRegionIDs ( uint64_t id );
 
+    // Gets IDs of regions at each level of this HTM which intersect a view's field of view,
+    // so only those need to be loaded and drawn. See SSView::htmRegions().
+    
+    vector<vector<uint64_t>> visibleRegions ( SSView &view );
+
+    // Gets IDs of all HTM triangles which intersect an area of the celestial sphere, at each level
+    // from 0 (the origin region) to (levels - 1), in ascending order. The area is defined by a test
+    // function which returns 0 if the triangle with vertices (v0, v1, v2) is entirely outside it,
+    // 2 if entirely inside it, and 1 if partly inside or unknown. Triangles outside are skipped
+    // with all their sub-triangles; sub-triangles of triangles inside are not tested.
+    
+    static vector<vector<uint64_t>> intersectingRegions ( int levels, function<int(const SSVector &v0, const SSVector &v1, const SSVector &v2)> test );
+
     // wrappers around functions in original Johns Hopkins C HTM implementation, cc_aux.c
     
     static uint64_t vector2ID ( const SSVector &vector, int depth );
@@ -268,7 +268,8 @@ int64_t string_to_gj ( string str )
     string comps = pos == string::npos ? "" : str.substr ( pos, string::npos );
     
     int d = strtofloat64 ( str ) * 10.0 + 0.1;
-    int c = compmap[ comps ];
+    auto it = compmap.find ( comps );
+    int c = it == compmap.end() ? 0 : it->second;
 
     return 10 * d + c;
 }
@@ -381,13 +382,24 @@ string pngpk_to_string ( int64_t pngpk, SSCatalog cat )
         return format ( "%03.0f%c%04.1f", londec / 10.0, sign, latdec / 10.0 );
 }
 
+// Builds Bayer letter and constellation abbreviation maps the first time it's called.
+// The maps are built inside a function-local static initializer, which C++11 guarantees
+// runs exactly once even if called from several threads at once.
+
 static void mapinit ( void )
 {
-    for ( int i = 0; i < _bayvec.size(); i++ )
-        _baymap.insert ( { _bayvec[i], i + 1 } );
+    static bool init = [] ()
+    {
+        for ( int i = 0; i < _bayvec.size(); i++ )
+            _baymap.insert ( { _bayvec[i], i + 1 } );
 
-    for ( int i = 0; i < _convec.size(); i++ )
-        _conmap.insert ( { _convec[i], i + 1 } );
+        for ( int i = 0; i < _convec.size(); i++ )
+            _conmap.insert ( { _convec[i], i + 1 } );
+        
+        return true;
+    } ();
+    
+    (void) init;
 }
 
 SSIdentifier::SSIdentifier ( void )
@@ -419,8 +431,7 @@ SSIdentifier SSIdentifier::fromString ( string str )
 {
     size_t len = str.length();
     
-    if ( _conmap.size() == 0 || _baymap.size() == 0 )
-        mapinit();
+    mapinit();
 
     // if string begins with "M", attempt to parse a Messier number
     
@@ -608,7 +619,8 @@ SSIdentifier SSIdentifier::fromString ( string str )
     // attempt to parse Bayer/Flamsteed/GCVS identifier.
 
     vector<string> tokens = tokenize ( str, " " );
-    int con = tokens.size() >= 2 ? _conmap[ tokens[1] ] : 0;
+    auto it = tokens.size() >= 2 ? _conmap.find ( tokens[1] ) : _conmap.end();
+    int con = it == _conmap.end() ? 0 : it->second;
     if ( con )
     {
         string constr = tokens[1];
@@ -668,8 +680,7 @@ SSIdentifier SSIdentifier::fromString ( string str )
 
 string SSIdentifier::toString ( void )
 {
-    if ( _conmap.size() == 0 || _baymap.size() == 0 )
-        mapinit();
+    mapinit();
 
     SSCatalog cat = catalog();
     int64_t id = identifier();
@@ -851,7 +862,7 @@ int SSImportIdentifierNameMap ( const char *filename, SSIdentifierNameMap &nameM
 // from the input identifier-to-name map.  If no names correspond to any identifier,
 // returns a zero-length vector.
 
-vector<string> SSIdentifiersToNames ( SSIdentifierVec &idents, SSIdentifierNameMap &nameMap )
+vector<string> SSIdentifiersToNames ( SSIdentifierVec &idents, const SSIdentifierNameMap &nameMap )
 {
     vector<string> names;
 
@@ -890,7 +901,7 @@ bool SSAddIdentifier ( SSIdentifier ident, SSIdentifierVec &identVec )
 // Adds identifiers only if valid and not already present in the vector.
 // Returns number of new identifiers added to idents vector.
 
-int SSAddIdentifiers ( SSIdentifier key, SSIdentifierMap &map, SSIdentifierVec &idents )
+int SSAddIdentifiers ( SSIdentifier key, const SSIdentifierMap &map, SSIdentifierVec &idents )
 {
     int n = 0;
     
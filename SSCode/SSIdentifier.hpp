@@ -12,6 +12,7 @@
 #define SSIdentifier_hpp
 
 #include <string>
+#include <vector>
 #include <map>
 
 using namespace std;
@@ -91,15 +92,202 @@ public:
 };
 
 typedef vector<SSIdentifier> SSIdentifierVec;
-typedef multimap<SSIdentifier,SSIdentifier> SSIdentifierMap;
-typedef multimap<SSIdentifier,string> SSIdentifierNameMap;
+
+// A flat, open-addressing hash table which maps identifiers to one or more values of type T.
+// Works like multimap<SSIdentifier,T> for insert(), equal_range(), count(), and iteration over
+// a key's values, which are always returned in the order they were inserted. Unlike a map,
+// looking up a missing key never inserts anything; all lookups are const. Entries are stored
+// contiguously in insertion order; the table itself only holds 64-bit keys and entry indices,
+// so lookups touch one or two cache lines instead of walking a tree. Entries can't be erased.
+
+template <class T> class SSIdentifierHashMap
+{
+public:
+
+    typedef pair<SSIdentifier,T> value_type;
+
+protected:
+
+    struct Slot
+    {
+        int64_t key;            // identifier, as 64-bit integer
+        int32_t first;          // index of first entry with this key; -1 if slot is empty
+        int32_t last;           // index of last entry with this key
+    };
+
+    vector<value_type> _entries;    // all entries, in insertion order
+    vector<int32_t> _next;          // index of next entry with the same key, or -1
+    vector<Slot> _slots;            // hash table; size is always zero or a power of two
+    size_t _keys = 0;               // number of occupied slots (i.e. distinct keys)
+
+    // Returns hash table slot index for a key, using the 64-bit finalizer from MurmurHash3,
+    // which spreads sequential catalog numbers evenly over the table.
+
+    size_t home ( int64_t key ) const
+    {
+        uint64_t h = (uint64_t) key;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return (size_t) h & ( _slots.size() - 1 );
+    }
+
+    // Returns index of slot containing key, or index of empty slot where it would go.
+    // Table must not be empty, and must have at least one empty slot.
+
+    size_t probe ( int64_t key ) const
+    {
+        size_t i = home ( key );
+        while ( _slots[i].first >= 0 && _slots[i].key != key )
+            i = ( i + 1 ) & ( _slots.size() - 1 );
+        return i;
+    }
+
+    // Rebuilds the hash table with (n) slots, which must be a power of two larger than the key count.
+
+    void rehash ( size_t n )
+    {
+        vector<Slot> old;
+        old.swap ( _slots );
+        _slots.assign ( n, Slot { 0, -1, -1 } );
+        for ( const Slot &slot : old )
+            if ( slot.first >= 0 )
+                _slots[ probe ( slot.key ) ] = slot;
+    }
+
+public:
+
+    // Iterates over the entries for one key, in insertion order.
+
+    class const_iterator
+    {
+        const SSIdentifierHashMap *_map;
+        int32_t _i;
+
+    public:
+
+        const_iterator ( const SSIdentifierHashMap *map, int32_t i ) : _map ( map ), _i ( i ) { }
+        const value_type &operator * ( void ) const { return _map->_entries[_i]; }
+        const value_type *operator -> ( void ) const { return &_map->_entries[_i]; }
+        const_iterator &operator ++ ( void ) { _i = _map->_next[_i]; return *this; }
+        const_iterator operator ++ ( int ) { const_iterator old = *this; _i = _map->_next[_i]; return old; }
+        bool operator == ( const const_iterator &other ) const { return _i == other._i; }
+        bool operator != ( const const_iterator &other ) const { return _i != other._i; }
+    };
+
+    size_t size ( void ) const { return _entries.size(); }
+    bool empty ( void ) const { return _entries.empty(); }
+
+    // Removes all entries, and releases memory. Swaps with empty vectors, since clear() keeps their capacity.
+
+    void clear ( void )
+    {
+        vector<value_type>().swap ( _entries );
+        vector<int32_t>().swap ( _next );
+        vector<Slot>().swap ( _slots );
+        _keys = 0;
+    }
+
+    // Preallocates memory for (n) entries with distinct keys, to avoid rehashing while inserting them.
+
+    void reserve ( size_t n )
+    {
+        _entries.reserve ( n );
+        _next.reserve ( n );
+
+        size_t slots = 16;
+        while ( slots < n * 2 )
+            slots *= 2;
+
+        if ( slots > _slots.size() )
+            rehash ( slots );
+    }
+
+    // Adds a key-value pair (entry). Existing entries with the same key are kept; the new
+    // value is returned after them. Returns iterator pointing to the new entry.
+
+    const_iterator insert ( const value_type &entry )
+    {
+        if ( ( _keys + 1 ) * 2 > _slots.size() )
+            rehash ( max ( (size_t) 16, _slots.size() * 2 ) );
+
+        int32_t index = (int32_t) _entries.size();
+        _entries.push_back ( entry );
+        _next.push_back ( -1 );
+
+        Slot &slot = _slots[ probe ( entry.first ) ];
+        if ( slot.first < 0 )
+        {
+            slot.key = entry.first;
+            slot.first = index;
+            _keys++;
+        }
+        else
+        {
+            _next[ slot.last ] = index;
+        }
+
+        slot.last = index;
+        return const_iterator ( this, index );
+    }
+
+    // Returns range of entries whose key is (key). The range is empty if there are none.
+
+    pair<const_iterator,const_iterator> equal_range ( SSIdentifier key ) const
+    {
+        int32_t first = -1;
+
+        if ( _slots.size() > 0 )
+            first = _slots[ probe ( key ) ].first;
+
+        return { const_iterator ( this, first ), const_iterator ( this, -1 ) };
+    }
+
+    // Returns number of entries whose key is (key).
+
+    size_t count ( SSIdentifier key ) const
+    {
+        size_t n = 0;
+        auto range = equal_range ( key );
+        for ( auto i = range.first; i != range.second; ++i )
+            n++;
+        return n;
+    }
+
+    // Returns pointer to first value inserted with (key), or nullptr if there is none.
+
+    const T *find ( SSIdentifier key ) const
+    {
+        auto range = equal_range ( key );
+        return range.first != range.second ? &range.first->second : nullptr;
+    }
+
+    // Returns copy of first value inserted with (key), or a default-constructed T (zero, empty string, etc.)
+    // if there is none. Unlike std::map, never inserts anything.
+
+    T operator [] ( SSIdentifier key ) const
+    {
+        const T *p = find ( key );
+        return p ? *p : T();
+    }
+
+    // Iterate over all entries, in insertion order.
+
+    typename vector<value_type>::const_iterator begin ( void ) const { return _entries.begin(); }
+    typename vector<value_type>::const_iterator end ( void ) const { return _entries.end(); }
+};
+
+typedef SSIdentifierHashMap<SSIdentifier> SSIdentifierMap;
+typedef SSIdentifierHashMap<string> SSIdentifierNameMap;
 
 int SSImportIdentifierNameMap ( const char *filename, SSIdentifierNameMap &nameMap );
-vector<string> SSIdentifiersToNames ( SSIdentifierVec &idents, SSIdentifierNameMap &nameMap );
+vector<string> SSIdentifiersToNames ( SSIdentifierVec &idents, const SSIdentifierNameMap &nameMap );
 
 bool compareSSIdentifiers ( const SSIdentifier &id1, const SSIdentifier &id2 );
 
 bool SSAddIdentifier ( SSIdentifier ident, vector<SSIdentifier> &identVec );
-int SSAddIdentifiers ( SSIdentifier ident, SSIdentifierMap &map, SSIdentifierVec &idents );
+int SSAddIdentifiers ( SSIdentifier ident, const SSIdentifierMap &map, SSIdentifierVec &idents );
 
 #endif /* SSIdentifier_hpp */
@@ -74,8 +74,20 @@ int addGJComponentStars ( SSStarPtr pStar, string strGJ, string comps, SSObjectV
 // CNS lines representing multiple components are split into single components.
 // Returns the total number of stars imported (should be 3849 if successful);
 // original CNS3 contains 3803 lines; but multiples are split and Sun is excluded.
+// This just calls the two steps below, which can also be called separately:
+// the first only needs the CNS3 file, so it can run while gjACStars are being imported.
 
 int SSImportGJCNS3 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjectVec &gjACStars, SSObjectVec &stars )
+{
+    int numStars = SSImportGJCNS3 ( filename, stars );
+    SSMatchGJCNS3 ( nameMap, gjACStars, stars );
+    return numStars;
+}
+
+// Reads the CNS3 file only, storing stars in the provided vector of SSObjects (stars),
+// without accurate coordinates, HIP identifiers, or names. Returns number of stars imported.
+
+int SSImportGJCNS3 ( const char *filename, SSObjectVec &stars )
 {
     // Open file; return on failure.
 
@@ -226,6 +238,20 @@ int SSImportGJCNS3 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjec
         numStars += addGJComponentStars ( pStar, strGJ, comps, stars );
     }
     
+    // Return imported star count; file is closed automatically.
+
+    return numStars;
+}
+
+// Cross-matches CNS3 stars (stars) with GJ accurate coordinate stars (gjACStars).
+// Wherever a match is found, the CNS3 star's coordinates and proper motion are replaced
+// with accurate ones, it gets the matching star's HIP, Bayer, Flamsteed, and GCVS identifiers,
+// and names are added from nameMap. Returns the number of stars matched.
+
+int SSMatchGJCNS3 ( SSIdentifierNameMap &nameMap, SSObjectVec &gjACStars, SSObjectVec &stars )
+{
+    int numMatched = 0;
+
     // Set up GJ identifier mapping for retrieving accurate GJ coordinates and HIP identifiers.
     
     SSObjectMap map = SSMakeObjectMap ( gjACStars, kCatGJ );
@@ -273,6 +299,7 @@ int SSImportGJCNS3 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjec
             sort ( idents.begin(), idents.end(), compareSSIdentifiers );
             pStar->setIdentifiers ( idents );
             pStar->setFundamentalMotion ( coords, motion );
+            numMatched++;
         }
         
         // Finally add common names to individual stars
@@ -282,9 +309,7 @@ int SSImportGJCNS3 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjec
             pStar->setNames ( names );
     }
     
-    // Return imported star count; file is closed automatically.
-
-    return numStars;
+    return numMatched;
 }
 
 // Imports Accurate Coordinates for Gliese Catalog Stars:
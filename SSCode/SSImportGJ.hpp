@@ -11,6 +11,8 @@
 #include "SSStar.hpp"
 
 int SSImportGJCNS3 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjectVec &acStars, SSObjectVec &gjStars );
+int SSImportGJCNS3 ( const char *filename, SSObjectVec &gjStars );
+int SSMatchGJCNS3 ( SSIdentifierNameMap &nameMap, SSObjectVec &acStars, SSObjectVec &gjStars );
 int SSImportGJAC ( const char *filename, SSObjectVec &hipStars, SSObjectVec &acStars );
 
 #endif /* SSImportGJ_hpp */
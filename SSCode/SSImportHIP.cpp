@@ -212,7 +212,7 @@ int SSImportHIC ( const char *filename, SSObjectVec &stars )
         sort ( idents.begin(), idents.end(), compareSSIdentifiers );
         SSObjectType type = kTypeStar;
 
-        SSObjectPtr pObj = SSNewObject ( type );
+        SSObjectPtr pObj = SSNewObject ( type, stars.getArena() );
         SSStarPtr pStar = SSGetStarPtr ( pObj );
         
         if ( pStar != nullptr )
@@ -326,7 +326,7 @@ int SSImportHIP2 ( const char *filename, SSObjectVec &stars )
         sort ( idents.begin(), idents.end(), compareSSIdentifiers );
         SSObjectType type = kTypeStar;
 
-        SSObjectPtr pObj = SSNewObject ( type );
+        SSObjectPtr pObj = SSNewObject ( type, stars.getArena() );
         SSStarPtr pStar = SSGetStarPtr ( pObj );
         
         if ( pStar != nullptr )
@@ -500,7 +500,7 @@ int SSImportHIP ( const char *filename, SSIdentifierMap &hrMap, SSIdentifierMap
         sort ( idents.begin(), idents.end(), compareSSIdentifiers );
         SSObjectType type = kTypeStar;
 
-        SSObjectPtr pObj = SSNewObject ( type );
+        SSObjectPtr pObj = SSNewObject ( type, stars.getArena() );
          pStar = SSGetStarPtr ( pObj );
         
         if ( pStar != nullptr )
@@ -6,6 +6,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <thread>
+#include <cstring>
 
 #include "SSTime.hpp"
 #include "SSImportMPC.hpp"
@@ -132,7 +134,7 @@ int SSImportMPCComets ( const string &filename, SSObjectVec &comets )
 
         // Allocate new comet object with default values
         
-        SSPlanetPtr pComet = new SSPlanet ( kTypeComet );
+        SSPlanetPtr pComet = SSGetPlanetPtr ( SSNewObject ( kTypeComet, comets.getArena() ) );
         if ( pComet == nullptr )
             continue;
         
@@ -161,133 +163,428 @@ int SSImportMPCComets ( const string &filename, SSObjectVec &comets )
     return numComets;
 }
 
-// Read asteroid data from a Minor Planet Center asteroid orbit export file:
-// https://www.minorplanetcenter.net/iau/MPCORB/MPCORB.DAT
-// Imported data is appended to the input vector of SSObjects (asteroids).
-// Returns number of asteroids successfully imported.
+// Returns true if an asteroid with absolute magnitude (hmag) and MPC flags (flags) passes this filter.
 
-int SSImportMPCAsteroids ( const string &filename, SSObjectVec &asteroids )
+bool SSMPCFilter::accepts ( float hmag, uint16_t flags ) const
 {
-    // Open file; return on failure.
+    if ( hmag > maxHMagnitude )
+        return false;
+    
+    if ( orbitTypes && ! ( orbitTypes & ( 1ull << ( flags & kMPCFlagOrbitType ) ) ) )
+        return false;
+    
+    return ( flags & requiredFlags ) == requiredFlags;
+}
 
-    ifstream file ( filename );
-    if ( ! file )
-        return ( 0 );
+// Parses one line of a Minor Planet Center asteroid orbit export file (MPCORB.DAT) into (asteroid),
+// without allocating memory or copying any part of the line. The magnitude and flags are parsed first,
+// and checked against (filter) before anything else. Returns false if the line is not a valid
+// asteroid record, or the asteroid is rejected by the filter.
 
-    // Read file line-by-line until we reach end-of-file
+bool SSParseMPCAsteroid ( SSStringView line, const SSMPCFilter &filter, SSMPCAsteroid &asteroid )
+{
+    if ( line.len < 195 )
+        return false;
+    
+    const char *p = line.ptr;
+    
+    // col 9-13: absolute magnitude
 
-    string line = "";
-    int numLines = 0, numAsteroids = 0;
+    SSStringView field = trim ( SSStringView ( p + 8, 5 ) );
+    asteroid.hmag = field.empty() ? HUGE_VAL : strtofloat ( field );
 
-    while ( getline ( file, line ) )
+    // col 162-165: 4-hexadecimal-digit flags
+    
+    asteroid.flags = 0;
+    for ( int k = 161; k < 165; k++ )
     {
-        numLines++;
-        if ( line.length() < 195 )
-            continue;
-
-        // col 9-13: absolute magnitude
-        
-        string field = trim ( line.substr ( 8, 5 ) );
-        float hmag = field.empty() ? HUGE_VAL : strtofloat ( field );
-        
-        // col 15-19: magnitude slope parameter
-        
-        field = trim ( line.substr ( 14, 5 ) );
-        float gmag = field.empty() ? HUGE_VAL : strtofloat ( field );
-        
-        // col 21-25: epoch in packed form
-        
-        field = line.substr ( 20, 5 );
-        int year = 100 * ( 20 + toupper ( field[0] ) - 'K' );  // century
-        year += strtoint ( field.substr ( 1, 2 ) );
+        int c = toupper ( p[k] );
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 0;
+        asteroid.flags = asteroid.flags * 16 + digit;
+    }
+    
+    if ( ! filter.accepts ( asteroid.hmag, asteroid.flags ) )
+        return false;
+    
+    // col 15-19: magnitude slope parameter
+    
+    field = trim ( SSStringView ( p + 14, 5 ) );
+    asteroid.gmag = field.empty() ? HUGE_VAL : strtofloat ( field );
+    
+    // col 21-25: epoch in packed form. Nearly all asteroids in a file share the same epoch,
+    // so remember the last one converted on this thread, and skip conversion if it's the same.
+    
+    static thread_local char lastPacked[5] = { 0 };
+    static thread_local double lastEpoch = 0.0;
+    
+    const char *packed = p + 20;
+    if ( memcmp ( packed, lastPacked, 5 ) != 0 )
+    {
+        int year = 100 * ( 20 + toupper ( packed[0] ) - 'K' );  // century
+        year += strtoint ( SSStringView ( packed + 1, 2 ) );
         
         int month = 0;
-        if ( field[3] >= '1' && field[3] <= '9' )
-            month = 1 + field[3] - '1';
-        else if ( toupper( field[3] ) >= 'A' && toupper( field[3] ) <= 'C' )
-            month = 10 + toupper ( field[3] ) - 'A';
+        if ( packed[3] >= '1' && packed[3] <= '9' )
+            month = 1 + packed[3] - '1';
+        else if ( toupper( packed[3] ) >= 'A' && toupper( packed[3] ) <= 'C' )
+            month = 10 + toupper ( packed[3] ) - 'A';
         else
-            continue;
+            return false;
         
         double day = 0.0;
-        if ( field[4] >= '1' && field[4] <= '9' )
-            day = 1 + field[4] - '1';
-        else if ( toupper ( field[4] ) >= 'A' && toupper ( field[4] ) <= 'V' )
-            day = 10 + toupper ( field[4] ) - 'A';
+        if ( packed[4] >= '1' && packed[4] <= '9' )
+            day = 1 + packed[4] - '1';
+        else if ( toupper ( packed[4] ) >= 'A' && toupper ( packed[4] ) <= 'V' )
+            day = 10 + toupper ( packed[4] ) - 'A';
         else
-            continue;
+            return false;
         
-        double epoch = year && month && day ? SSTime ( SSDate ( kGregorian, 0.0, year, month, day, 0, 0, 0 ) ).jd : 0.0;
-        
-        // col 27-35: Mean anomaly in degrees
-        
-        field = trim ( line.substr ( 26, 9 ) );
-        double m = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
-        
-        // col 38-46: Argument of perihelion in degrees
-        
-        field = trim ( line.substr ( 37, 9 ) );
-        double w = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
-        
-        // col 49-57: Longitude of ascending node in degrees
-        
-        field = trim ( line.substr ( 48, 9 ) );
-        double n = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
-        
-        // col 60-68: Inclination in degrees
-        
-        field = trim ( line.substr ( 59, 9 ) );
-        double i = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
-        
-        // col 71-79: Eccentricity
-        
-        field = trim ( line.substr ( 70, 9 ) );
-        double e = field.empty() ? HUGE_VAL : strtofloat64 ( field );
-        
-        // col 81-91: Mean motion in degrees per day
-        
-        field = trim ( line.substr ( 80, 11 ) );
-        double mm = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
+        lastEpoch = year && month && day ? SSTime ( SSDate ( kGregorian, 0.0, year, month, day, 0, 0, 0 ) ).jd : 0.0;
+        memcpy ( lastPacked, packed, 5 );
+    }
+    
+    double epoch = lastEpoch;
+    
+    // col 27-35: Mean anomaly in degrees
+    
+    field = trim ( SSStringView ( p + 26, 9 ) );
+    double m = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
+    
+    // col 38-46: Argument of perihelion in degrees
+    
+    field = trim ( SSStringView ( p + 37, 9 ) );
+    double w = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
+    
+    // col 49-57: Longitude of ascending node in degrees
+    
+    field = trim ( SSStringView ( p + 48, 9 ) );
+    double n = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
+    
+    // col 60-68: Inclination in degrees
+    
+    field = trim ( SSStringView ( p + 59, 9 ) );
+    double i = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
+    
+    // col 71-79: Eccentricity
+    
+    field = trim ( SSStringView ( p + 70, 9 ) );
+    double e = field.empty() ? HUGE_VAL : strtofloat64 ( field );
+    
+    // col 81-91: Mean motion in degrees per day
+    
+    field = trim ( SSStringView ( p + 80, 11 ) );
+    double mm = field.empty() ? HUGE_VAL : degtorad ( strtofloat64 ( field ) );
+    
+    // col 93-103: Semimajor axis in AU.  If not found, compute from mean motion.
+    
+    field = trim ( SSStringView ( p + 92, 11 ) );
+    double a = strtofloat64 ( field );
+    if ( a <= 0.0 )
+        a = pow ( SSOrbit::kGaussGravHelio / ( mm * mm ), 1.0 / 3.0 );
+    
+    asteroid.orbit = SSOrbit ( epoch, a * ( 1.0 - e ), e, i, w, n, m, mm );
+    
+    // col 167-174: asteroid number in parentheses (may be blank).
+    // Only fall back to the general identifier parser for anything unusual.
+    
+    field = trim ( SSStringView ( p + 166, 8 ) );
+    asteroid.number = SSIdentifier ( kCatUnknown, 0 );
+    if ( field.len > 2 && field[0] == '(' && field[field.len - 1] == ')' && strtoint ( SSStringView ( field.ptr + 1, field.len - 2 ) ) > 0 )
+        asteroid.number = SSIdentifier ( kCatAstNum, strtoint ( SSStringView ( field.ptr + 1, field.len - 2 ) ) );
+    else if ( ! field.empty() )
+        asteroid.number = SSIdentifier::fromString ( field.str() );
+    
+    // col 176-194: Name or provisional designation
+    
+    asteroid.name = trim ( SSStringView ( p + 175, 19 ) );
+    return true;
+}
+
+// Reads the next block of about (size) bytes of whole lines from a file into (block).
+// Any partial line at the end of the block is moved to (rest), and is put at the start
+// of the next block. Returns false when there are no more lines.
+
+static bool readLineBlock ( FILE *file, size_t size, string &block, string &rest )
+{
+    block.swap ( rest );
+    rest.clear();
+    
+    while ( true )
+    {
+        size_t have = block.size();
+        block.resize ( have + size );
+        size_t got = fread ( &block[have], 1, size, file );
+        block.resize ( have + got );
         
-        // col 93-103: Semimajor axis in AU.  If not found, compute from mean motion.
+        // At end of file, the block ends with the last line, complete or not.
         
-        field = trim ( line.substr ( 92, 11 ) );
-        double a = strtofloat64 ( field );
-        if ( a <= 0.0 )
-            a = pow ( SSOrbit::kGaussGravHelio / ( mm * mm ), 1.0 / 3.0 );
+        if ( got < size )
+            return ! block.empty();
+
+        // Otherwise, break the block after its last newline. If there isn't one, read more.
         
-        // col 167-254: asteroid number (may be blank)
+        size_t last = block.rfind ( '\n' );
+        if ( last != string::npos && last >= have )
+        {
+            rest.assign ( block, last + 1, string::npos );
+            block.resize ( last + 1 );
+            return true;
+        }
+    }
+}
+
+// Parses all lines from (p) up to (end) which pass (filter), and calls (callback) for each.
+// Lines are separated exactly as getline() would separate them.
+
+template<class F> static int parseLines ( const char *p, const char *end, const SSMPCFilter &filter, F callback )
+{
+    SSMPCAsteroid asteroid;
+    int count = 0;
+    
+    while ( p < end )
+    {
+        const char *eol = (const char *) memchr ( p, '\n', end - p );
+        if ( eol == nullptr )
+            eol = end;
         
-        field = trim ( line.substr ( 166, 8 ) );
-        SSIdentifier number = SSIdentifier::fromString ( field );
+        if ( SSParseMPCAsteroid ( SSStringView ( p, eol - p ), filter, asteroid ) )
+        {
+            callback ( asteroid );
+            count++;
+        }
         
-        // col 167-254: Name or provisional designation
+        p = eol + 1;
+    }
+    
+    return count;
+}
+
+static constexpr size_t kMPCBlockSize = 4 * 1024 * 1024;
+
+// Reads asteroids from a Minor Planet Center asteroid orbit export file (MPCORB.DAT) in blocks,
+// and calls (callback) once for each asteroid which passes (filter), in file order. Only one block
+// of the file is held in memory at a time; the asteroid passed to the callback (including its
+// name) is only valid during the call. Returns number of asteroids passed to the callback.
+
+int SSReadMPCAsteroids ( const string &filename, const SSMPCFilter &filter, function<void(const SSMPCAsteroid &)> callback )
+{
+    FILE *file = fopen ( filename.c_str(), "rb" );
+    if ( file == nullptr )
+        return 0;
+    
+    string block, rest;
+    int count = 0;
+    
+    while ( readLineBlock ( file, kMPCBlockSize, block, rest ) )
+        count += parseLines ( block.data(), block.data() + block.size(), filter, callback );
+    
+    fclose ( file );
+    return count;
+}
+
+// Read asteroid data from a Minor Planet Center asteroid orbit export file:
+// https://www.minorplanetcenter.net/iau/MPCORB/MPCORB.DAT
+// Imported data is appended to the input vector of SSObjects (asteroids).
+// Returns number of asteroids successfully imported.
 
+int SSImportMPCAsteroids ( const string &filename, SSObjectVec &asteroids )
+{
+    auto addAsteroid = [&asteroids]( const SSMPCAsteroid &asteroid )
+    {
         vector<string> names;
-        field = trim ( line.substr ( 175, 19 ) );
-        if ( ! field.empty() )
-            names.push_back ( field );
+        if ( ! asteroid.name.empty() )
+            names.push_back ( asteroid.name.str() );
         
         // Allocate new asteroid object with default values
         
-        SSPlanetPtr pAsteroid = new SSPlanet ( kTypeAsteroid );
+        SSPlanetPtr pAsteroid = SSGetPlanetPtr ( SSNewObject ( kTypeAsteroid, asteroids.getArena() ) );
         if ( pAsteroid == nullptr )
-            continue;
+            return;
         
-        SSOrbit orbit ( epoch, a * ( 1.0 - e ), e, i, w, n, m, mm );
-
-        if ( number )
-            pAsteroid->setIdentifier ( number );
+        if ( asteroid.number )
+            pAsteroid->setIdentifier ( asteroid.number );
         
         pAsteroid->setNames ( names );
-        pAsteroid->setOrbit ( orbit );
-        pAsteroid->setHMagnitude ( hmag );
-        pAsteroid->setGMagnitude ( gmag );
-
+        pAsteroid->setOrbit ( asteroid.orbit );
+        pAsteroid->setHMagnitude ( asteroid.hmag );
+        pAsteroid->setGMagnitude ( asteroid.gmag );
+        
         // cout << pAsteroid->toCSV() << endl;
         asteroids.push_back ( pAsteroid );
-        numAsteroids++;
-    }
+    };
+    
+    return SSReadMPCAsteroids ( filename, SSMPCFilter(), addAsteroid );
+}
+
+void SSMPCOrbitTable::reserve ( size_t size )
+{
+    for ( vector<double> *v : { &t, &q, &e, &i, &w, &n, &m, &mm } )
+        v->reserve ( size );
+
+    hmag.reserve ( size );
+    gmag.reserve ( size );
+    ident.reserve ( size );
+    flags.reserve ( size );
+    nameEnd.reserve ( size );
+    names.reserve ( size * 12 );
+}
+
+void SSMPCOrbitTable::clear ( void )
+{
+    for ( vector<double> *v : { &t, &q, &e, &i, &w, &n, &m, &mm } )
+        v->clear();
+    
+    hmag.clear();
+    gmag.clear();
+    ident.clear();
+    flags.clear();
+    nameEnd.clear();
+    names.clear();
+}
+
+// Adds one asteroid to the end of the table.
+
+void SSMPCOrbitTable::append ( const SSMPCAsteroid &asteroid )
+{
+    const SSOrbit &orbit = asteroid.orbit;
+    
+    t.push_back ( orbit.t );
+    q.push_back ( orbit.q );
+    e.push_back ( orbit.e );
+    i.push_back ( orbit.i );
+    w.push_back ( orbit.w );
+    n.push_back ( orbit.n );
+    m.push_back ( orbit.m );
+    mm.push_back ( orbit.mm );
+    
+    hmag.push_back ( asteroid.hmag );
+    gmag.push_back ( asteroid.gmag );
+    ident.push_back ( (int64_t) asteroid.number );
+    flags.push_back ( asteroid.flags );
+    
+    names.append ( asteroid.name.ptr, asteroid.name.len );
+    nameEnd.push_back ( (uint32_t) names.size() );
+}
+
+// Adds all asteroids in another table to the end of this one.
+
+template<class T> static void appendVector ( vector<T> &to, const vector<T> &from )
+{
+    to.insert ( to.end(), from.begin(), from.end() );
+}
+
+void SSMPCOrbitTable::append ( const SSMPCOrbitTable &table )
+{
+    appendVector ( t, table.t );
+    appendVector ( q, table.q );
+    appendVector ( e, table.e );
+    appendVector ( i, table.i );
+    appendVector ( w, table.w );
+    appendVector ( n, table.n );
+    appendVector ( m, table.m );
+    appendVector ( mm, table.mm );
+    appendVector ( hmag, table.hmag );
+    appendVector ( gmag, table.gmag );
+    appendVector ( ident, table.ident );
+    appendVector ( flags, table.flags );
+    
+    uint32_t offset = (uint32_t) names.size();
+    for ( uint32_t end : table.nameEnd )
+        nameEnd.push_back ( offset + end );
+    
+    names.append ( table.names );
+}
+
+// Returns name or provisional designation of the asteroid at index (k) in the table.
+
+string SSMPCOrbitTable::getName ( size_t k ) const
+{
+    uint32_t start = k > 0 ? nameEnd[k - 1] : 0;
+    return names.substr ( start, nameEnd[k] - start );
+}
+
+// Allocates a new SSPlanet for the asteroid at index (k) in the table,
+// exactly like the one SSImportMPCAsteroids() would import into an SSObjectVec.
+
+SSPlanetPtr SSMPCOrbitTable::toPlanet ( size_t k ) const
+{
+    SSPlanetPtr pAsteroid = new SSPlanet ( kTypeAsteroid );
+    if ( pAsteroid == nullptr )
+        return nullptr;
+    
+    vector<string> names;
+    string name = getName ( k );
+    if ( ! name.empty() )
+        names.push_back ( name );
 
-    return numAsteroids;
+    if ( ident[k] )
+        pAsteroid->setIdentifier ( SSIdentifier ( ident[k] ) );
+
+    pAsteroid->setNames ( names );
+    pAsteroid->setOrbit ( getOrbit ( k ) );
+    pAsteroid->setHMagnitude ( hmag[k] );
+    pAsteroid->setGMagnitude ( gmag[k] );
+    return pAsteroid;
+}
+
+// Imports asteroids from a Minor Planet Center asteroid orbit export file (MPCORB.DAT) which pass
+// (filter) into a compact orbit table, appending them after any already in it, in file order.
+// The file is read in blocks of a few megabytes per thread; each block is split at line boundaries
+// into one chunk per thread, and the chunks are parsed in parallel into separate tables which are
+// then appended in order. Uses as many threads as hardware cores if (threads) is zero.
+// Returns number of asteroids imported.
+
+int SSImportMPCAsteroids ( const string &filename, SSMPCOrbitTable &table, const SSMPCFilter &filter, int threads )
+{
+    if ( threads < 1 )
+        threads = max ( 1u, thread::hardware_concurrency() );
+    
+    FILE *file = fopen ( filename.c_str(), "rb" );
+    if ( file == nullptr )
+        return 0;
+    
+    string block, rest;
+    vector<SSMPCOrbitTable> chunks ( threads );
+    int count = 0;
+    
+    while ( readLineBlock ( file, kMPCBlockSize * threads, block, rest ) )
+    {
+        // Split the block into one chunk of whole lines per thread.
+        
+        vector<const char *> bounds ( threads + 1 );
+        const char *begin = block.data(), *end = block.data() + block.size();
+        bounds[0] = begin;
+        for ( int k = 1; k < threads; k++ )
+        {
+            const char *p = max ( bounds[k - 1], begin + block.size() * k / threads );
+            const char *eol = p < end ? (const char *) memchr ( p, '\n', end - p ) : nullptr;
+            bounds[k] = eol ? eol + 1 : end;
+        }
+        bounds[threads] = end;
+        
+        // Parse each chunk into its own table, then append them in order.
+        
+        auto parseChunk = [&]( int k )
+        {
+            chunks[k].clear();
+            parseLines ( bounds[k], bounds[k + 1], filter, [&]( const SSMPCAsteroid &asteroid ) { chunks[k].append ( asteroid ); } );
+        };
+        
+        vector<thread> pool;
+        for ( int k = 1; k < threads; k++ )
+            pool.push_back ( thread ( parseChunk, k ) );
+        
+        parseChunk ( 0 );
+        for ( thread &th : pool )
+            th.join();
+        
+        for ( SSMPCOrbitTable &chunk : chunks )
+        {
+            table.append ( chunk );
+            count += (int) chunk.size();
+        }
+    }
+    
+    fclose ( file );
+    return count;
 }
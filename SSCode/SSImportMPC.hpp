@@ -8,9 +8,95 @@
 #ifndef SSImportMPC_hpp
 #define SSImportMPC_hpp
 
+#include <functional>
+
 #include "SSPlanet.hpp"
 
 int SSImportMPCComets ( const string &filename, SSObjectVec &comets );
 int SSImportMPCAsteroids ( const string &filename, SSObjectVec &comets );
 
+// Orbit types, from the low 6 bits of the flags in columns 162-165 of MPCORB.DAT
+
+enum SSMPCOrbitType
+{
+    kMPCOrbitUnclassified = 0,
+    kMPCOrbitAtira = 1,             // aphelion < 0.983 AU
+    kMPCOrbitAten = 2,              // a < 1.0 AU, aphelion > 0.983 AU
+    kMPCOrbitApollo = 3,            // a > 1.0 AU, q < 1.017 AU
+    kMPCOrbitAmor = 4,              // 1.017 AU < q < 1.3 AU
+    kMPCOrbitMarsCrosser = 5,       // q < 1.665 AU
+    kMPCOrbitHungaria = 6,
+    kMPCOrbitPhocaea = 7,
+    kMPCOrbitHilda = 8,
+    kMPCOrbitJupiterTrojan = 9,
+    kMPCOrbitDistant = 10
+};
+
+// Other MPCORB.DAT flag bits
+
+enum SSMPCFlags
+{
+    kMPCFlagOrbitType = 0x003F,     // mask for orbit type bits
+    kMPCFlagNEO = 0x0800,           // near-Earth object
+    kMPCFlagNEO1km = 0x1000,        // near-Earth object larger than 1 km
+    kMPCFlagOneOpposition = 0x2000, // one-opposition object seen at an earlier opposition
+    kMPCFlagCritical = 0x4000,      // critical-list numbered object
+    kMPCFlagPHA = 0x8000            // potentially hazardous asteroid
+};
+
+// One asteroid parsed from a line of MPCORB.DAT, without allocating any memory.
+// The name points into the line it was parsed from, and is only valid as long as that is.
+
+struct SSMPCAsteroid
+{
+    SSIdentifier number;    // asteroid number identifier (kCatAstNum), or whatever SSIdentifier::fromString() makes of an unusual number field; zero if blank
+    SSStringView name;      // name or provisional designation; may be empty
+    SSOrbit orbit;          // heliocentric J2000 ecliptic orbital elements
+    float hmag;             // absolute magnitude; infinite if unknown
+    float gmag;             // magnitude slope parameter; infinite if unknown
+    uint16_t flags;         // MPC flags; orbit type is (flags & kMPCFlagOrbitType)
+};
+
+// Selects which asteroids to keep while parsing. The default filter keeps everything.
+
+struct SSMPCFilter
+{
+    float maxHMagnitude = INFINITY; // keep only asteroids with absolute magnitude <= this; if finite, asteroids without H are dropped
+    uint64_t orbitTypes = 0;        // keep only orbit types whose bit (1 << type) is set; zero keeps all types
+    uint16_t requiredFlags = 0;     // keep only asteroids with all of these flag bits set, e.g. kMPCFlagNEO
+
+    bool accepts ( float hmag, uint16_t flags ) const;
+};
+
+bool SSParseMPCAsteroid ( SSStringView line, const SSMPCFilter &filter, SSMPCAsteroid &asteroid );
+
+// A compact structure-of-arrays table of asteroid orbits: about 100 bytes per asteroid,
+// instead of an SSPlanet on the heap with its own orbit, name strings, and ephemeris state.
+// Element arrays can be handed directly to batch computations. Use toPlanet() to create
+// a full SSPlanet for any asteroid that needs one.
+
+struct SSMPCOrbitTable
+{
+    vector<double> t, q, e, i, w, n, m, mm;     // orbital elements, as in SSOrbit
+    vector<float> hmag, gmag;                   // absolute magnitude and slope parameter
+    vector<int64_t> ident;                      // asteroid identifier, as in SSMPCAsteroid::number, or zero if none
+    vector<uint16_t> flags;                     // MPC flags
+    vector<uint32_t> nameEnd;                   // offset in names just past end of each asteroid's name
+    string names;                               // all names, concatenated
+
+    size_t size ( void ) const { return t.size(); }
+    void reserve ( size_t n );
+    void clear ( void );
+
+    void append ( const SSMPCAsteroid &asteroid );
+    void append ( const SSMPCOrbitTable &table );
+
+    SSOrbit getOrbit ( size_t k ) const { return SSOrbit ( t[k], q[k], e[k], i[k], w[k], n[k], m[k], mm[k] ); }
+    string getName ( size_t k ) const;
+    SSPlanetPtr toPlanet ( size_t k ) const;
+};
+
+int SSReadMPCAsteroids ( const string &filename, const SSMPCFilter &filter, function<void(const SSMPCAsteroid &)> callback );
+int SSImportMPCAsteroids ( const string &filename, SSMPCOrbitTable &table, const SSMPCFilter &filter = SSMPCFilter(), int threads = 0 );
+
 #endif /* SSImportMPC_hpp */
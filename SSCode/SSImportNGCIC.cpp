@@ -592,7 +592,7 @@ int SSImportDAML02 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjec
 
         // Allocate new deep sky object and store values if successful
         
-        SSDeepSky *pObject = new SSDeepSky ( kTypeOpenCluster );
+        SSDeepSky *pObject = SSGetDeepSkyPtr ( SSNewObject ( kTypeOpenCluster, clusters.getArena() ) );
         if ( pObject == nullptr )
             continue;
         
@@ -699,7 +699,7 @@ int SSImportMWGC ( const char *filename, SSIdentifierNameMap &nameMap, SSObjectV
 
         // Allocate new deep sky object and store values if successful
         
-        SSDeepSky *pObject = new SSDeepSky ( kTypeGlobularCluster );
+        SSDeepSky *pObject = SSGetDeepSkyPtr ( SSNewObject ( kTypeGlobularCluster, clusters.getArena() ) );
         if ( pObject == nullptr )
             continue;
         
@@ -930,7 +930,7 @@ int SSImportPNG ( const char *main_filename, const char *dist_filename, const ch
 
         // Allocate new deep sky object and store values if successful
         
-        SSDeepSky *pObject = new SSDeepSky ( kTypePlanetaryNebula );
+        SSDeepSky *pObject = SSGetDeepSkyPtr ( SSNewObject ( kTypePlanetaryNebula, nebulae.getArena() ) );
         if ( pObject == nullptr )
             continue;
         
@@ -184,10 +184,23 @@ string SKY2000VariableTypeString ( int type )
 // Hipparcos stars (hipStars) and Gliese-Jahreiss nearby stars (gjStars).
 // Nothing will be added if these star vectors are empty.
 // Returns number of SKY2000 stars imported (299460 if successful).
+// This just calls the two steps below, which can also be called separately:
+// the first doesn't need the Hipparcos or GJ stars, so it can run while they are being imported.
 
 // TODO: add HIP numbers and add'l Bayer letters from Hipparcos. Add nearby stars from RECONS.
 
 int SSImportSKY2000 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjectVec &hipStars, SSObjectVec &gjStars, SSObjectVec &stars )
+{
+    int numStars = SSImportSKY2000 ( filename, nameMap, stars );
+    SSMatchSKY2000 ( hipStars, gjStars, stars );
+    return numStars;
+}
+
+// Reads the SKY2000 file only, storing stars in the provided vector of SSObjects (stars),
+// with name strings from nameMap, but without identifiers from other catalogs.
+// Returns number of SKY2000 stars imported.
+
+int SSImportSKY2000 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjectVec &stars )
 {
     // Open file; return on failure.
 
@@ -195,11 +208,6 @@ int SSImportSKY2000 ( const char *filename, SSIdentifierNameMap &nameMap, SSObje
     if ( ! file )
         return 0;
 
-    // Make index of HD catalog numbers in the Hipparcos and GJ star vectors.
-    
-    SSObjectMap hipMap = SSMakeObjectMap ( hipStars, kCatHD );
-    SSObjectMap gjMap = SSMakeObjectMap ( gjStars, kCatHD );
-
     // Read file line-by-line until we reach end-of-file
 
     string line = "";
@@ -393,7 +401,7 @@ int SSImportSKY2000 ( const char *filename, SSIdentifierNameMap &nameMap, SSObje
         else
             type = kTypeStar;
 
-        SSObjectPtr pObj = SSNewObject ( type );
+        SSObjectPtr pObj = SSNewObject ( type, stars.getArena() );
         SSStarPtr pStar = SSGetStarPtr ( pObj );
         if ( pStar == nullptr )
             continue;
@@ -405,11 +413,6 @@ int SSImportSKY2000 ( const char *filename, SSIdentifierNameMap &nameMap, SSObje
         pStar->setBMagnitude ( bmag );
         pStar->setSpectralType ( strSpec );
 
-        // Add additional HIP, Bayer, and GJ identifiers from other catalogs.
-        // Sert star's identifier vector.
-        
-        addSKY2000StarData ( hipStars, hipMap, pStar );
-        addSKY2000StarData ( gjStars, gjMap, pStar );
         pStar->sortIdentifiers();
         
         SSVariableStarPtr pVar = SSGetVariableStarPtr ( pObj );
@@ -465,3 +468,39 @@ int SSImportSKY2000 ( const char *filename, SSIdentifierNameMap &nameMap, SSObje
     
     return numStars;
 }
+
+// Adds additional HIP, Bayer, and GJ identifiers to SKY2000 stars (stars) from vectors of
+// Hipparcos stars (hipStars) and Gliese-Jahreiss nearby stars (gjStars), matching stars
+// by HD number. Nothing will be added if these star vectors are empty.
+// Returns number of SKY2000 stars which gained identifiers.
+
+int SSMatchSKY2000 ( SSObjectVec &hipStars, SSObjectVec &gjStars, SSObjectVec &stars )
+{
+    int numMatched = 0;
+
+    // Make index of HD catalog numbers in the Hipparcos and GJ star vectors.
+    
+    SSObjectMap hipMap = SSMakeObjectMap ( hipStars, kCatHD );
+    SSObjectMap gjMap = SSMakeObjectMap ( gjStars, kCatHD );
+
+    for ( int i = 0; i < stars.size(); i++ )
+    {
+        SSStarPtr pStar = SSGetStarPtr ( stars[i] );
+        if ( pStar == nullptr )
+            continue;
+        
+        // Add additional HIP, Bayer, and GJ identifiers from other catalogs.
+        // Sort star's identifier vector.
+        
+        size_t numIdents = pStar->getIdentifiers().size();
+        addSKY2000StarData ( hipStars, hipMap, pStar );
+        addSKY2000StarData ( gjStars, gjMap, pStar );
+        if ( pStar->getIdentifiers().size() > numIdents )
+        {
+            pStar->sortIdentifiers();
+            numMatched++;
+        }
+    }
+    
+    return numMatched;
+}
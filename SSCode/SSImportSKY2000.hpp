@@ -17,5 +17,7 @@
 
 int SSImportIAUStarNames ( const char *filename, SSIdentifierNameMap &nameMap );
 int SSImportSKY2000 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjectVec &hipStars, SSObjectVec &gjStars, SSObjectVec &stars );
+int SSImportSKY2000 ( const char *filename, SSIdentifierNameMap &nameMap, SSObjectVec &stars );
+int SSMatchSKY2000 ( SSObjectVec &hipStars, SSObjectVec &gjStars, SSObjectVec &stars );
 
 #endif /* SSImportSKY2000_hpp */
@@ -4,6 +4,7 @@
 // Created by Tim DeBenedictis on 4/3/20.
 // Copyright © 2020 Southern Stars. All rights reserved.
 
+#include <mutex>
 #include "SSJPLDEphemeris.hpp"
 
 // Code is based on "C version software for the JPL planetary ephemerides"
@@ -656,6 +657,8 @@ void constan(char nam[][6], double val[], double sss[], int *n)
 }
 /*************************** THE END ***************************************/
 
+static int _generation = 0;
+
 // Opens epheneris file and reads header.
 // Returns true if successful or false on failure.
 // Closes any ephemeris file already open.
@@ -670,9 +673,15 @@ bool SSJPLDEphemeris::open ( const string &filename )
         return false;
     
     constan ( nams, vals , ss, &nvs );
+    _generation++;
     return true;
 }
 
+int SSJPLDEphemeris::getGeneration ( void )
+{
+    return _generation;
+}
+
 // Returns true/false depending on whether an ephemeris file open.
 
 bool SSJPLDEphemeris::isOpen ( void )
@@ -690,6 +699,7 @@ void SSJPLDEphemeris::close ( void )
     
     fclose ( F1 );
     F1 = NULL;
+    _generation++;
     
     memset ( PVSUN, 0, sizeof ( PVSUN ) );
     memset ( nams, 0, sizeof ( nams ) );
@@ -702,12 +712,18 @@ void SSJPLDEphemeris::close ( void )
 // in fundamental J2000 equatorial frame (ICRS) at a given Julian Ephemeris Date (jed),
 // relative to Sun (if bary is false) or to Solar System Barycenter (if bary is true).
 // Object identifier (id) is 1 - 9 for Mercury - Pluto, 0 for Sun, or 10 for Earth's Moon.
+// The underlying C code keeps its file position and interpolation buffers in global variables,
+// so concurrent calls from different threads are serialized with a mutex.
+
+static mutex _computeMutex;
 
 bool SSJPLDEphemeris::compute ( int id, double jed, bool bary, SSVector &position, SSVector &velocity )
 {
     if ( F1 == NULL || jed < ss[0] || jed > ss[1] || id < 0 || id > 10 )
         return false;
     
+    lock_guard<mutex> lock ( _computeMutex );
+    
     // Sun is 0 in our convention; 11 for JPL.
     
     if ( id == 0 )
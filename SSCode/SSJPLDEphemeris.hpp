@@ -20,7 +20,8 @@
 // CAUTION: This class is a thin C++ wrapper around original C code from:
 // https://apollo.astro.amu.edu.pl/PAD/index.php?n=Dybol.JPLEph
 // This is a singleton class; you should only ever instantiate one of these!
-// It is not thread safe, and is hard-coded to read only the DE43x series
+// It is not thread safe, except for compute(), which serializes concurrent callers
+// with a mutex; it is hard-coded to read only the DE43x series
 // in little-endian (Intel) binary format.  It will not read the ASCII format
 // of any ephemeris files, nor the DE43xt series which include time data.
 
@@ -34,6 +35,10 @@ public:
     static bool isOpen ( void );
     static void close ( void );
 
+    // Returns a number which changes whenever an ephemeris file is opened or closed.
+
+    static int getGeneration ( void );
+
     // Gets number of contants, name and value of i-th constant.
     
     static int getConstantNumber ( void );
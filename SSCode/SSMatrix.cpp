@@ -8,44 +8,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include "SSMatrix.hpp"
-
-// Constructs a 3x3 matrix whose elements are all initialized to zero.
-
-SSMatrix::SSMatrix ( void )
-{
-    m00 = 0.0;  m01 = 0.0; m02 = 0.0;
-    m10 = 0.0;  m11 = 0.0; m12 = 0.0;
-    m20 = 0.0;  m21 = 0.0; m22 = 0.0;
-}
-
-// Constructs a 3x3 matrix whose elements are specified individually by row.
-
-SSMatrix::SSMatrix ( double m00, double m01, double m02, double m10, double m11, double m12, double m20, double m21, double m22 )
-{
-    this->m00 = m00; this->m01 = m01; this->m02 = m02;
-    this->m10 = m10; this->m11 = m11; this->m12 = m12;
-    this->m20 = m20; this->m21 = m21; this->m22 = m22;
-}
-
-// Returns a 3x3 identity matrix.
-
-SSMatrix SSMatrix::identity ( void )
-{
-    return SSMatrix ( 1.0, 0.0, 0.0,
-                      0.0, 1.0, 0.0,
-                      0.0, 0.0, 1.0 );
-}
-
-// Returns a 3x3 matrix which is the transpose of this matrix.
-// Does not transpose this matrix in place!
-// For a rotation matrix, its transpose is also its inverse.
-
-SSMatrix SSMatrix::transpose ( void )
-{
-    return SSMatrix ( m00, m10, m20,
-                      m01, m11, m21,
-                      m02, m12, m22 );
-}
+#include "SSSIMD.hpp"
 
 // Returns a 3x3 matrix which is the inverse of this matrix.
 // Does not invert this matrix in place!
@@ -73,52 +36,62 @@ SSMatrix SSMatrix::inverse ( void )
                       w20, w21, w22 );
 }
 
-// Returns the determinant of this 3x3 matrix.
-// For a rotation matrix, the determinant is 1.0.
+// Multiplies an array of (n) vectors (in) by this matrix, and stores the products in
+// another array (out), which may be the same as the input array. Vectors are processed
+// two at a time with SIMD instructions; results are identical to multiply ( SSVector ).
 
-double SSMatrix::determinant ( void )
+void SSMatrix::multiply ( const SSVector *in, SSVector *out, size_t n )
 {
-    double det = m00 * ( m11 * m22 - m12 * m21 )
-               - m01 * ( m10 * m22 - m12 * m20 )
-               + m02 * ( m10 * m21 - m11 * m20 );
+    SSDouble2 a00 = SSDouble2::splat ( m00 ), a01 = SSDouble2::splat ( m01 ), a02 = SSDouble2::splat ( m02 );
+    SSDouble2 a10 = SSDouble2::splat ( m10 ), a11 = SSDouble2::splat ( m11 ), a12 = SSDouble2::splat ( m12 );
+    SSDouble2 a20 = SSDouble2::splat ( m20 ), a21 = SSDouble2::splat ( m21 ), a22 = SSDouble2::splat ( m22 );
+    size_t i = 0;
     
-    return ( det );
-}
-
-// Returns the product of this matrix and a 3-element vector
-// as another vector.  Does not modify the input vector (vec)!
-
-SSVector SSMatrix::multiply ( SSVector vec )
-{
-    double x = m00 * vec.x + m01 * vec.y + m02 * vec.z;
-    double y = m10 * vec.x + m11 * vec.y + m12 * vec.z;
-    double z = m20 * vec.x + m21 * vec.y + m22 * vec.z;
+    for ( ; i + 1 < n; i += 2 )
+    {
+        SSDouble2 x = SSDouble2::set ( in[i].x, in[i + 1].x );
+        SSDouble2 y = SSDouble2::set ( in[i].y, in[i + 1].y );
+        SSDouble2 z = SSDouble2::set ( in[i].z, in[i + 1].z );
+        
+        SSDouble2 ox = a00 * x + a01 * y + a02 * z;
+        SSDouble2 oy = a10 * x + a11 * y + a12 * z;
+        SSDouble2 oz = a20 * x + a21 * y + a22 * z;
+        
+        out[i] = SSVector ( ox.lane ( 0 ), oy.lane ( 0 ), oz.lane ( 0 ) );
+        out[i + 1] = SSVector ( ox.lane ( 1 ), oy.lane ( 1 ), oz.lane ( 1 ) );
+    }
     
-    return SSVector ( x, y, z );
+    if ( i < n )
+        out[i] = multiply ( in[i] );
 }
 
-// Returns the product of this matrix and another 3x3 matrix
-// as another matrix.  Does not modify the input matrix (mat)!
-// Note: matrix multiplication is NOT commutative; in other words,
-// this.multiply(that) and that.multiply(this) return different matrices!
+// Multiplies (n) vectors stored as separate arrays of x, y, z coordinates by this matrix,
+// and stores the products in output coordinate arrays (ox, oy, oz), which may be the same
+// as the input arrays. Results are identical to multiply ( SSVector ).
 
-SSMatrix SSMatrix::multiply ( SSMatrix mat )
+void SSMatrix::multiply ( const double *x, const double *y, const double *z, double *ox, double *oy, double *oz, size_t n )
 {
-    double x0 = m00 * mat.m00 + m01 * mat.m10 + m02 * mat.m20;
-    double x1 = m10 * mat.m00 + m11 * mat.m10 + m12 * mat.m20;
-    double x2 = m20 * mat.m00 + m21 * mat.m10 + m22 * mat.m20;
-
-    double y0 = m00 * mat.m01 + m01 * mat.m11 + m02 * mat.m21;
-    double y1 = m10 * mat.m01 + m11 * mat.m11 + m12 * mat.m21;
-    double y2 = m20 * mat.m01 + m21 * mat.m11 + m22 * mat.m21;
-
-    double z0 = m00 * mat.m02 + m01 * mat.m12 + m02 * mat.m22;
-    double z1 = m10 * mat.m02 + m11 * mat.m12 + m12 * mat.m22;
-    double z2 = m20 * mat.m02 + m21 * mat.m12 + m22 * mat.m22;
+    SSDouble2 a00 = SSDouble2::splat ( m00 ), a01 = SSDouble2::splat ( m01 ), a02 = SSDouble2::splat ( m02 );
+    SSDouble2 a10 = SSDouble2::splat ( m10 ), a11 = SSDouble2::splat ( m11 ), a12 = SSDouble2::splat ( m12 );
+    SSDouble2 a20 = SSDouble2::splat ( m20 ), a21 = SSDouble2::splat ( m21 ), a22 = SSDouble2::splat ( m22 );
+    size_t i = 0;
     
-    return SSMatrix ( x0, y0, z0,
-                      x1, y1, z1,
-                      x2, y2, z2 );
+    for ( ; i + 1 < n; i += 2 )
+    {
+        SSDouble2 vx = SSDouble2::load ( x + i ), vy = SSDouble2::load ( y + i ), vz = SSDouble2::load ( z + i );
+        
+        ( a00 * vx + a01 * vy + a02 * vz ).store ( ox + i );
+        ( a10 * vx + a11 * vy + a12 * vz ).store ( oy + i );
+        ( a20 * vx + a21 * vy + a22 * vz ).store ( oz + i );
+    }
+    
+    if ( i < n )
+    {
+        SSVector v = multiply ( SSVector ( x[i], y[i], z[i] ) );
+        ox[i] = v.x;
+        oy[i] = v.y;
+        oz[i] = v.z;
+    }
 }
 
 // Returns a matrix which represents this matrix rotated around
@@ -179,11 +152,3 @@ SSMatrix SSMatrix::rotation ( int n, ... )
     va_end ( ap );
     return ( m );
 }
-
-// Returns copy of matrix with middle row negated.
-// Used with left-handed horizon coordinates.
-
-SSMatrix SSMatrix::negateMiddleRow ( void )
-{
-    return SSMatrix ( m00, m01, m02, -m10, -m11, -m12, m20, m21, m22 );
-}
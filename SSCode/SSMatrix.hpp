@@ -11,29 +11,74 @@
 
 #include "SSVector.hpp"
 
+// Construction, transposition, determinant, and matrix-vector and matrix-matrix products are
+// defined inline and constexpr, for the same reasons as SSVector arithmetic. None modify this matrix!
+// Note matrix multiplication is NOT commutative: a.multiply ( b ) and b.multiply ( a ) differ.
+
 struct SSMatrix
 {
     double m00, m01, m02;
     double m10, m11, m12;
     double m20, m21, m22;
     
-    SSMatrix ( void );
-    SSMatrix ( double m00, double m01, double m02, double m10, double m11, double m12, double m20, double m21, double m22 );
+    constexpr SSMatrix ( void ) : m00 ( 0.0 ), m01 ( 0.0 ), m02 ( 0.0 ), m10 ( 0.0 ), m11 ( 0.0 ), m12 ( 0.0 ), m20 ( 0.0 ), m21 ( 0.0 ), m22 ( 0.0 ) { }
+    constexpr SSMatrix ( double m00, double m01, double m02, double m10, double m11, double m12, double m20, double m21, double m22 ) :
+        m00 ( m00 ), m01 ( m01 ), m02 ( m02 ), m10 ( m10 ), m11 ( m11 ), m12 ( m12 ), m20 ( m20 ), m21 ( m21 ), m22 ( m22 ) { }
     
-    SSMatrix transpose ( void );
+    // For a rotation matrix, the transpose is also the inverse, and the determinant is 1.0.
+
+    constexpr SSMatrix transpose ( void ) const
+    {
+        return SSMatrix ( m00, m10, m20,
+                          m01, m11, m21,
+                          m02, m12, m22 );
+    }
+
     SSMatrix inverse ( void );
-    double  determinant ( void );
+
+    constexpr double determinant ( void ) const
+    {
+        return m00 * ( m11 * m22 - m12 * m21 )
+             - m01 * ( m10 * m22 - m12 * m20 )
+             + m02 * ( m10 * m21 - m11 * m20 );
+    }
     
-    static SSMatrix identity ( void );
+    static constexpr SSMatrix identity ( void )
+    {
+        return SSMatrix ( 1.0, 0.0, 0.0,
+                          0.0, 1.0, 0.0,
+                          0.0, 0.0, 1.0 );
+    }
+
     static SSMatrix rotation ( int n, ... );
-    SSMatrix negateMiddleRow ( void );
 
-    SSVector multiply ( SSVector vec );
-    SSMatrix multiply ( SSMatrix mat );
+    // Returns copy of matrix with middle row negated. Used with left-handed horizon coordinates.
+
+    constexpr SSMatrix negateMiddleRow ( void ) const
+    {
+        return SSMatrix ( m00, m01, m02, -m10, -m11, -m12, m20, m21, m22 );
+    }
+
+    constexpr SSVector multiply ( const SSVector &vec ) const
+    {
+        return SSVector ( m00 * vec.x + m01 * vec.y + m02 * vec.z,
+                          m10 * vec.x + m11 * vec.y + m12 * vec.z,
+                          m20 * vec.x + m21 * vec.y + m22 * vec.z );
+    }
+
+    constexpr SSMatrix multiply ( const SSMatrix &mat ) const
+    {
+        return SSMatrix ( m00 * mat.m00 + m01 * mat.m10 + m02 * mat.m20, m00 * mat.m01 + m01 * mat.m11 + m02 * mat.m21, m00 * mat.m02 + m01 * mat.m12 + m02 * mat.m22,
+                          m10 * mat.m00 + m11 * mat.m10 + m12 * mat.m20, m10 * mat.m01 + m11 * mat.m11 + m12 * mat.m21, m10 * mat.m02 + m11 * mat.m12 + m12 * mat.m22,
+                          m20 * mat.m00 + m21 * mat.m10 + m22 * mat.m20, m20 * mat.m01 + m21 * mat.m11 + m22 * mat.m21, m20 * mat.m02 + m21 * mat.m12 + m22 * mat.m22 );
+    }
+
+    void multiply ( const SSVector *in, SSVector *out, size_t n );
+    void multiply ( const double *x, const double *y, const double *z, double *ox, double *oy, double *oz, size_t n );
     SSMatrix rotate ( int axis, double angle );
     
-    SSVector operator * ( SSVector other ) { return multiply ( other ); }
-    SSMatrix operator * ( SSMatrix other ) { return multiply ( other ); }
+    constexpr SSVector operator * ( const SSVector &other ) const { return multiply ( other ); }
+    constexpr SSMatrix operator * ( const SSMatrix &other ) const { return multiply ( other ); }
 };
 
 #endif /* SSMatrix_hpp */
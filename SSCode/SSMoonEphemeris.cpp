@@ -948,14 +948,17 @@ and velocities with one relatively simple function.
 
 #define DEGREES_TO_RADIANS (PI/180.)
 
-static double an[5], ae[5], ai[5];         // satellite position data
+// Satellite position data, and the date it was computed for, are kept per-thread
+// so Uranian moon positions can be computed concurrently from different threads.
+
+static thread_local double an[5], ae[5], ai[5];         // satellite position data
 
 //   OrbitalPosition
 //   Compute basic orbital position data for the satellites.
 
 static void gust86_mean_parameters( const double jde )
 {
-   static double curr_jde_set = -1.;
+   static thread_local double curr_jde_set = -1.;
 
    if( jde != curr_jde_set)
       {
@@ -1824,9 +1827,10 @@ bool SSMoonEphemeris::jupiterMoonPositionVelocity ( int id, double jed, SSVector
     pos *= 71420.0 / SSCoordinates::kKmPerAU;
     
     // transform from ecliptic frame of date to J2000 equatorial frame.
+    // Matrix is cached per-thread, so this is safe to call concurrently.
     
-    static double matrixJED = 0.0;
-    static SSMatrix matrix;
+    static thread_local double matrixJED = 0.0;
+    static thread_local SSMatrix matrix;
     
     if ( jed != matrixJED )
     {
@@ -0,0 +1,470 @@
+// SSNBody.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// Numerical integration of asteroid and comet orbits, perturbed by the major planets.
+
+#include <atomic>
+#include <thread>
+
+#include "SSNBody.hpp"
+
+// Sun's mass times the gravitational constant, in AU^3/day^2; i.e. the square of the Gaussian gravitational constant.
+
+static constexpr double kGMSun = SSOrbit::kGaussGravHelio * SSOrbit::kGaussGravHelio;
+
+// Planet masses are Sun/planet mass ratios from JPL DE430; Earth's includes the Moon.
+
+const double SSPlanetTable::kGM[kNumPlanets] =
+{
+    kGMSun / 6023597.400017,    // Mercury
+    kGMSun / 408523.718655,     // Venus
+    kGMSun / 328900.559708,     // Earth + Moon
+    kGMSun / 3098703.590291,    // Mars
+    kGMSun / 1047.348625,       // Jupiter
+    kGMSun / 3497.901768,       // Saturn
+    kGMSun / 22902.981613,      // Uranus
+    kGMSun / 19412.237346       // Neptune
+};
+
+// Constructs an empty planet table, which will tabulate positions every (step) days.
+
+SSPlanetTable::SSPlanetTable ( double step )
+{
+    _step = step;
+    _start = 0.0;
+}
+
+// Computes heliocentric positions and velocities of all planets at (jde).
+
+void SSPlanetTable::compute ( double jde, SSVector pos[kNumPlanets], SSVector vel[kNumPlanets] )
+{
+    for ( int j = 0; j < kNumPlanets; j++ )
+        SSPlanet::computeMajorPlanetPositionVelocity ( kMercury + j, jde, 0.0, pos[j], vel[j] );
+}
+
+// Returns true if the table covers all times from (jde0) to (jde1).
+
+bool SSPlanetTable::covers ( double jde0, double jde1 ) const
+{
+    size_t n = _pos[0].size();
+    return n >= 2 && min ( jde0, jde1 ) >= _start && max ( jde0, jde1 ) <= _start + ( n - 1 ) * _step;
+}
+
+// Extends the table to cover times from (jde0) to (jde1). Tabulated times are always whole
+// multiples of the step, so interpolated positions don't depend on what was covered before.
+// Positions already in the table are kept; only new ones are computed.
+
+void SSPlanetTable::cover ( double jde0, double jde1 )
+{
+    if ( covers ( jde0, jde1 ) )
+        return;
+    
+    size_t n = _pos[0].size();
+    double start = floor ( min ( jde0, jde1 ) / _step ) * _step - _step;
+    double end = ceil ( max ( jde0, jde1 ) / _step ) * _step + _step;
+    
+    if ( n > 0 )
+    {
+        start = min ( start, _start );
+        end = max ( end, _start + ( n - 1 ) * _step );
+    }
+    
+    size_t size = (size_t) llround ( ( end - start ) / _step ) + 1;
+    size_t offset = n > 0 ? (size_t) llround ( ( _start - start ) / _step ) : 0;
+    
+    for ( int j = 0; j < kNumPlanets; j++ )
+    {
+        vector<SSVector> pos ( size ), vel ( size );
+        copy ( _pos[j].begin(), _pos[j].end(), pos.begin() + offset );
+        copy ( _vel[j].begin(), _vel[j].end(), vel.begin() + offset );
+        _pos[j].swap ( pos );
+        _vel[j].swap ( vel );
+    }
+    
+    SSVector pos[kNumPlanets], vel[kNumPlanets];
+    for ( size_t i = 0; i < size; i++ )
+    {
+        if ( n > 0 && i >= offset && i < offset + n )
+            continue;
+        
+        compute ( start + i * _step, pos, vel );
+        for ( int j = 0; j < kNumPlanets; j++ )
+        {
+            _pos[j][i] = pos[j];
+            _vel[j][i] = vel[j];
+        }
+    }
+    
+    _start = start;
+}
+
+// Removes all tabulated positions.
+
+void SSPlanetTable::clear ( void )
+{
+    for ( int j = 0; j < kNumPlanets; j++ )
+    {
+        _pos[j].clear();
+        _vel[j].clear();
+    }
+}
+
+// Interpolates heliocentric planet positions (pos) at (jde) from the tabulated positions and velocities
+// on either side. Error is a few times 1e-8 AU for Mercury with a one-day step, and far smaller for the others.
+
+void SSPlanetTable::positions ( double jde, SSVector pos[kNumPlanets] ) const
+{
+    size_t n = _pos[0].size();
+    double x = ( jde - _start ) / _step;
+    size_t i = (size_t) min ( max ( floor ( x ), 0.0 ), (double) n - 2 );
+    double u = x - i, u2 = u * u, u3 = u2 * u;
+    
+    double h00 = 2.0 * u3 - 3.0 * u2 + 1.0;
+    double h10 = ( u3 - 2.0 * u2 + u ) * _step;
+    double h01 = 3.0 * u2 - 2.0 * u3;
+    double h11 = ( u3 - u2 ) * _step;
+    
+    for ( int j = 0; j < kNumPlanets; j++ )
+    {
+        const SSVector &p0 = _pos[j][i], &p1 = _pos[j][i + 1];
+        const SSVector &v0 = _vel[j][i], &v1 = _vel[j][i + 1];
+        
+        pos[j].x = h00 * p0.x + h10 * v0.x + h01 * p1.x + h11 * v1.x;
+        pos[j].y = h00 * p0.y + h10 * v0.y + h01 * p1.y + h11 * v1.y;
+        pos[j].z = h00 * p0.z + h10 * v0.z + h01 * p1.z + h11 * v1.z;
+    }
+}
+
+// Constructs an empty integrator which saves checkpoints every (interval) days,
+// and keeps the relative error of each integration step below (tolerance).
+
+SSNBody::SSNBody ( double interval, double tolerance )
+{
+    _interval = interval;
+    _tolerance = tolerance;
+    _perturbed = true;
+}
+
+// Adds all asteroids and comets in an object array (objects) to this integrator.
+// Stores pointers to the objects, but does not own them. Returns number of bodies added.
+
+int SSNBody::add ( SSObjectArray &objects )
+{
+    int n = 0;
+    
+    for ( size_t i = 0; i < objects.size(); i++ )
+    {
+        SSPlanetPtr pPlanet = SSGetPlanetPtr ( objects[i] );
+        if ( pPlanet == nullptr )
+            continue;
+        
+        if ( pPlanet->getType() != kTypeAsteroid && pPlanet->getType() != kTypeComet )
+            continue;
+        
+        add ( pPlanet );
+        n++;
+    }
+    
+    return n;
+}
+
+// Adds a single asteroid or comet (pPlanet). Keeps a pointer to the object, but does not own it.
+
+void SSNBody::add ( SSPlanetPtr pPlanet )
+{
+    add ( pPlanet->getOrbit() );
+    _bodies.back().pPlanet = pPlanet;
+}
+
+// Adds a body from its osculating heliocentric orbital elements (orbit), referred to the J2000 ecliptic.
+// Its first checkpoint is its position and velocity at the orbit epoch, in the fundamental frame.
+// The Sun's attraction uses the gravity constant implied by the elements' mean motion and periapse
+// distance, not the Gaussian constant: MPC elements round these inconsistently by up to 1e-7,
+// which would otherwise make integrated positions drift along-track from the elements' own orbit.
+
+void SSNBody::add ( const SSOrbit &orbit )
+{
+    static SSMatrix matrix = SSCoordinates::getEclipticMatrix ( SSCoordinates::getObliquity ( SSTime::kJ2000 ) );
+    
+    Body body = { orbit, nullptr, 0.0, 0, { } };
+    State state = {};
+    state.jde = orbit.t;
+    
+    body.gm = SSOrbit::gravityConstant ( orbit.e, orbit.q, orbit.mm );
+    body.gm *= body.gm;
+    body.orbit.toPositionVelocity ( orbit.t, state.pos, state.vel );
+    state.pos = matrix.multiply ( state.pos );
+    state.vel = matrix.multiply ( state.vel );
+    body.checkpoints.push_back ( state );
+    
+    _bodies.push_back ( body );
+}
+
+// Removes all bodies and their checkpoints. Does not delete the objects they came from!
+
+void SSNBody::clear ( void )
+{
+    _bodies.clear();
+    _states.clear();
+    _planets.clear();
+}
+
+// Computes time derivative (dy) of a body's heliocentric state vector (y): three position
+// components in AU, then three velocity components in AU/day, at time (jde). Acceleration is
+// the Sun's attraction (gm) plus each planet's direct pull on the body, minus its pull on the Sun.
+
+void SSNBody::derivative ( double jde, double gm, const double y[6], double dy[6] ) const
+{
+    double r2 = y[0] * y[0] + y[1] * y[1] + y[2] * y[2];
+    double s = -gm / ( r2 * sqrt ( r2 ) );
+    
+    dy[0] = y[3];
+    dy[1] = y[4];
+    dy[2] = y[5];
+    dy[3] = s * y[0];
+    dy[4] = s * y[1];
+    dy[5] = s * y[2];
+    
+    if ( ! _perturbed )
+        return;
+    
+    SSVector planets[SSPlanetTable::kNumPlanets];
+    _planets.positions ( jde, planets );
+
+    for ( int j = 0; j < SSPlanetTable::kNumPlanets; j++ )
+    {
+        const SSVector &p = planets[j];
+        double dx = p.x - y[0], dy2 = p.y - y[1], dz = p.z - y[2];
+        double d2 = dx * dx + dy2 * dy2 + dz * dz;
+        double p2 = p.x * p.x + p.y * p.y + p.z * p.z;
+        double gd = SSPlanetTable::kGM[j] / ( d2 * sqrt ( d2 ) );
+        double gp = SSPlanetTable::kGM[j] / ( p2 * sqrt ( p2 ) );
+        
+        dy[3] += gd * dx - gp * p.x;
+        dy[4] += gd * dy2 - gp * p.y;
+        dy[5] += gd * dz - gp * p.z;
+    }
+}
+
+// Integrates a body's (state) to time (jde) with the Dormand-Prince 5(4) embedded Runge-Kutta method,
+// adapting step size to keep each step's relative error below the tolerance. If the integration runs
+// past the body's first or last saved checkpoint, saves new checkpoints at each checkpoint epoch
+// along the way. Steps always end exactly on checkpoint epochs and (jde).
+
+void SSNBody::integrate ( State &state, double jde, Body &body ) const
+{
+    static const double c2 = 1.0 / 5.0, c3 = 3.0 / 10.0, c4 = 4.0 / 5.0, c5 = 8.0 / 9.0;
+    static const double a21 = 1.0 / 5.0;
+    static const double a31 = 3.0 / 40.0, a32 = 9.0 / 40.0;
+    static const double a41 = 44.0 / 45.0, a42 = -56.0 / 15.0, a43 = 32.0 / 9.0;
+    static const double a51 = 19372.0 / 6561.0, a52 = -25360.0 / 2187.0, a53 = 64448.0 / 6561.0, a54 = -212.0 / 729.0;
+    static const double a61 = 9017.0 / 3168.0, a62 = -355.0 / 33.0, a63 = 46732.0 / 5247.0, a64 = 49.0 / 176.0, a65 = -5103.0 / 18656.0;
+    static const double b1 = 35.0 / 384.0, b3 = 500.0 / 1113.0, b4 = 125.0 / 192.0, b5 = -2187.0 / 6784.0, b6 = 11.0 / 84.0;
+    static const double e1 = b1 - 5179.0 / 57600.0, e3 = b3 - 7571.0 / 16695.0, e4 = b4 - 393.0 / 640.0;
+    static const double e5 = b5 - -92097.0 / 339200.0, e6 = b6 - 187.0 / 2100.0, e7 = -1.0 / 40.0;
+    static const double kMinStep = 1.0e-9;     // shortest step error control may shrink to, in days
+
+    if ( state.jde == jde )
+        return;
+    
+    double dir = jde > state.jde ? 1.0 : -1.0;
+    double t = state.jde;
+    double y[6] = { state.pos.x, state.pos.y, state.pos.z, state.vel.x, state.vel.y, state.vel.z };
+    double k1[6], k2[6], k3[6], k4[6], k5[6], k6[6], k7[6], yt[6], yn[6];
+
+    // Initial step is a fiftieth of the period of a circular orbit at the body's current distance.
+    
+    double r = sqrt ( y[0] * y[0] + y[1] * y[1] + y[2] * y[2] );
+    double h = dir * M_2PI * r * sqrt ( r ) / SSOrbit::kGaussGravHelio / 50.0;
+    
+    derivative ( t, body.gm, y, k1 );
+    
+    while ( t != jde )
+    {
+        // Stop at the next unsaved checkpoint epoch, if there's one before (jde).
+        
+        double stop = jde;
+        int next = dir > 0 ? body.first + (int) body.checkpoints.size() : body.first - 1;
+        double tnext = body.orbit.t + next * _interval;
+        if ( dir * ( tnext - t ) > 0.0 && dir * ( jde - tnext ) >= 0.0 )
+            stop = tnext;
+        
+        // Take steps until we reach the stop.
+        
+        while ( t != stop )
+        {
+            double step = dir * ( t + h - stop ) > 0.0 ? stop - t : h;
+            
+            for ( int i = 0; i < 6; i++ )
+                yt[i] = y[i] + step * a21 * k1[i];
+            derivative ( t + c2 * step, body.gm, yt, k2 );
+            
+            for ( int i = 0; i < 6; i++ )
+                yt[i] = y[i] + step * ( a31 * k1[i] + a32 * k2[i] );
+            derivative ( t + c3 * step, body.gm, yt, k3 );
+
+            for ( int i = 0; i < 6; i++ )
+                yt[i] = y[i] + step * ( a41 * k1[i] + a42 * k2[i] + a43 * k3[i] );
+            derivative ( t + c4 * step, body.gm, yt, k4 );
+
+            for ( int i = 0; i < 6; i++ )
+                yt[i] = y[i] + step * ( a51 * k1[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i] );
+            derivative ( t + c5 * step, body.gm, yt, k5 );
+
+            for ( int i = 0; i < 6; i++ )
+                yt[i] = y[i] + step * ( a61 * k1[i] + a62 * k2[i] + a63 * k3[i] + a64 * k4[i] + a65 * k5[i] );
+            derivative ( t + step, body.gm, yt, k6 );
+
+            for ( int i = 0; i < 6; i++ )
+                yn[i] = y[i] + step * ( b1 * k1[i] + b3 * k3[i] + b4 * k4[i] + b5 * k5[i] + b6 * k6[i] );
+            derivative ( t + step, body.gm, yn, k7 );
+            
+            // Error estimate, relative to the size of the position and velocity vectors.
+            
+            double errp = 0.0, errv = 0.0, sizep = 0.0, sizev = 0.0;
+            for ( int i = 0; i < 3; i++ )
+            {
+                double ep = step * ( e1 * k1[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i] );
+                double ev = step * ( e1 * k1[i + 3] + e3 * k3[i + 3] + e4 * k4[i + 3] + e5 * k5[i + 3] + e6 * k6[i + 3] + e7 * k7[i + 3] );
+                errp += ep * ep;
+                errv += ev * ev;
+                sizep += yn[i] * yn[i];
+                sizev += yn[i + 3] * yn[i + 3];
+            }
+            
+            double err = max ( sqrt ( errp / sizep ), sqrt ( errv / sizev ) ) / _tolerance;
+            if ( ! isfinite ( err ) || ( err > 1.0 && fabs ( step ) < kMinStep ) )
+            {
+                // Give up on a body whose orbit can't be integrated (e.g. invalid elements),
+                // or whose steps have been rejected until they are shorter than the minimum.
+                // A short final step to a stop or to (jde) is fine as long as it's accepted.
+                
+                for ( int i = 0; i < 6; i++ )
+                    y[i] = NAN;
+                t = stop = jde;
+                break;
+            }
+
+            double scale = err > 0.0 ? min ( 5.0, max ( 0.2, 0.9 * pow ( err, -0.2 ) ) ) : 5.0;
+            if ( err <= 1.0 )
+            {
+                t = step == stop - t ? stop : t + step;
+                for ( int i = 0; i < 6; i++ )
+                {
+                    y[i] = yn[i];
+                    k1[i] = k7[i];
+                }
+                
+                // Don't let a short final step before a stop shrink the following steps.
+                
+                if ( step == h || scale < 1.0 )
+                    h = step * scale;
+            }
+            else
+            {
+                h = step * scale;
+            }
+        }
+        
+        if ( t == tnext && isfinite ( y[0] ) )
+        {
+            State checkpoint = { t, SSVector ( y[0], y[1], y[2] ), SSVector ( y[3], y[4], y[5] ) };
+            if ( dir > 0 )
+            {
+                body.checkpoints.push_back ( checkpoint );
+            }
+            else
+            {
+                body.checkpoints.insert ( body.checkpoints.begin(), checkpoint );
+                body.first--;
+            }
+        }
+    }
+    
+    state.jde = jde;
+    state.pos = SSVector ( y[0], y[1], y[2] );
+    state.vel = SSVector ( y[3], y[4], y[5] );
+}
+
+// Returns the saved checkpoint of a body which is nearest in time to (jde).
+
+static const SSNBody::State &nearestCheckpoint ( const SSOrbit &orbit, int first, const vector<SSNBody::State> &checkpoints, double jde, double interval )
+{
+    double k = round ( ( jde - orbit.t ) / interval ) - first;
+    k = min ( max ( k, 0.0 ), (double) checkpoints.size() - 1 );
+    return checkpoints[ (size_t) k ];
+}
+
+// Extends the planet table to cover integration of every body from its nearest checkpoint to (jde).
+
+void SSNBody::coverTimes ( double jde )
+{
+    if ( ! _perturbed || _bodies.empty() )
+        return;
+    
+    double jde0 = jde, jde1 = jde;
+    for ( Body &body : _bodies )
+    {
+        double start = nearestCheckpoint ( body.orbit, body.first, body.checkpoints, jde, _interval ).jde;
+        jde0 = min ( jde0, start );
+        jde1 = max ( jde1, start );
+    }
+    
+    _planets.cover ( jde0, jde1 );
+}
+
+// Computes one body's position and velocity at (jde), integrating from its nearest checkpoint,
+// and saving new checkpoints on the way if (jde) is beyond the ones it already has.
+
+SSNBody::State SSNBody::computePositionVelocity ( size_t i, double jde )
+{
+    Body &body = _bodies[i];
+    State state = nearestCheckpoint ( body.orbit, body.first, body.checkpoints, jde, _interval );
+
+    if ( _perturbed )
+        _planets.cover ( state.jde, jde );
+    
+    integrate ( state, jde, body );
+    return state;
+}
+
+// Computes all bodies' positions and velocities at (jde). Bodies are handed out to threads in small
+// blocks; each body is integrated by exactly one thread, so results don't depend on the number of threads.
+
+void SSNBody::computePositionVelocity ( double jde, int threads )
+{
+    static const size_t kBlockSize = 16;
+    size_t n = _bodies.size();
+    
+    coverTimes ( jde );
+    _states.resize ( n );
+    
+    if ( threads < 1 )
+        threads = max ( 1u, thread::hardware_concurrency() );
+    
+    threads = (int) min ( (size_t) threads, ( n + kBlockSize - 1 ) / kBlockSize );
+    
+    atomic<size_t> next ( 0 );
+    auto worker = [&] ( void )
+    {
+        for ( size_t first = next.fetch_add ( kBlockSize ); first < n; first = next.fetch_add ( kBlockSize ) )
+        {
+            for ( size_t i = first; i < first + kBlockSize && i < n; i++ )
+            {
+                Body &body = _bodies[i];
+                _states[i] = nearestCheckpoint ( body.orbit, body.first, body.checkpoints, jde, _interval );
+                integrate ( _states[i], jde, body );
+            }
+        }
+    };
+    
+    vector<thread> pool;
+    for ( int t = 1; t < threads; t++ )
+        pool.push_back ( thread ( worker ) );
+    
+    worker();
+    for ( thread &t : pool )
+        t.join();
+}
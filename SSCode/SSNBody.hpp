@@ -0,0 +1,129 @@
+// SSNBody.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// Numerical integration of asteroid and comet orbits, including perturbations by the major planets.
+// Pure two-body (Keplerian) positions drift by arcminutes within months of the MPC epoch;
+// integrating the equations of motion from the same elements stays accurate for years.
+// Planet positions come from SSPlanet::computeMajorPlanetPositionVelocity(), i.e. JPL DE43x
+// when it's open, otherwise VSOP2013 or Schlyter's formulae. They are computed once per day
+// and interpolated, so many objects can be integrated in parallel over the same time span
+// for little more than the cost of one. Each object's state is saved at regular checkpoint
+// epochs, so later queries start from the nearest checkpoint rather than the element epoch.
+
+#ifndef SSNBody_hpp
+#define SSNBody_hpp
+
+#include "SSPlanet.hpp"
+
+// Heliocentric positions of the major planets, tabulated at regular intervals and interpolated
+// between them with cubic Hermite polynomials. Earth's entry is the Earth itself, and carries
+// the combined mass of the Earth and Moon.
+
+class SSPlanetTable
+{
+public:
+
+    static const int kNumPlanets = 8;               // Mercury through Neptune
+    static const double kGM[kNumPlanets];           // planet masses, times the gravitational constant, in AU^3/day^2
+
+protected:
+
+    double _step;                                   // interval between tabulated positions, in days
+    double _start;                                  // Julian Ephemeris Date of first tabulated position
+    vector<SSVector> _pos[kNumPlanets];             // tabulated heliocentric positions in fundamental frame, AU
+    vector<SSVector> _vel[kNumPlanets];             // tabulated heliocentric velocities in fundamental frame, AU/day
+
+    void compute ( double jde, SSVector pos[kNumPlanets], SSVector vel[kNumPlanets] );
+    
+public:
+
+    SSPlanetTable ( double step = 1.0 );
+
+    // Extends the table, if needed, to cover Julian Ephemeris Dates from (jde0) to (jde1).
+    // Not thread-safe; extend the table before handing it to several threads.
+
+    void cover ( double jde0, double jde1 );
+    bool covers ( double jde0, double jde1 ) const;
+    void clear ( void );
+
+    // Interpolates heliocentric positions of all planets at (jde), which must be covered by the table.
+    
+    void positions ( double jde, SSVector pos[kNumPlanets] ) const;
+};
+
+// Integrates heliocentric orbits of many asteroids and comets, perturbed by the major planets.
+
+class SSNBody
+{
+public:
+
+    // An object's heliocentric position and velocity in the fundamental frame at one instant.
+    
+    struct State
+    {
+        double jde;         // Julian Ephemeris Date
+        SSVector pos;       // position, AU
+        SSVector vel;       // velocity, AU/day
+    };
+
+protected:
+
+    // Each body's checkpoints are states at the element epoch plus whole multiples of
+    // the checkpoint interval, from _first to _first + checkpoints.size() - 1.
+    
+    struct Body
+    {
+        SSOrbit orbit;                  // osculating heliocentric orbital elements, referred to J2000 ecliptic
+        SSPlanetPtr pPlanet;            // object the orbit came from, or null. Not owned!
+        double gm;                      // Sun's mass times gravitational constant implied by orbital elements, AU^3/day^2
+        int first;                      // checkpoint number of first saved state
+        vector<State> checkpoints;      // saved states, in time order
+    };
+
+    vector<Body>        _bodies;        // all bodies being integrated
+    vector<State>       _states;        // results of last computePositionVelocity() for all bodies
+    SSPlanetTable       _planets;       // perturbing planet positions
+    double              _interval;      // time between checkpoints, in days
+    double              _tolerance;     // relative error tolerance per integration step
+    bool                _perturbed;     // if false, integrate two-body motion only (for testing)
+    
+    void derivative ( double jde, double gm, const double y[6], double dy[6] ) const;
+    void integrate ( State &state, double jde, Body &body ) const;
+    void coverTimes ( double jde );
+
+public:
+
+    SSNBody ( double interval = 100.0, double tolerance = 1.0e-12 );
+
+    // add bodies to the integrator; clear all bodies
+    
+    int add ( SSObjectArray &objects );
+    void add ( SSPlanetPtr pPlanet );
+    void add ( const SSOrbit &orbit );
+    void clear ( void );
+    size_t size ( void ) { return _bodies.size(); }
+
+    void setPerturbed ( bool perturbed ) { _perturbed = perturbed; }
+    bool getPerturbed ( void ) { return _perturbed; }
+
+    // Computes one body's (i) heliocentric position and velocity in the fundamental frame at (jde),
+    // starting from its nearest saved checkpoint. Not thread-safe.
+
+    State computePositionVelocity ( size_t i, double jde );
+
+    // Computes positions and velocities of all bodies at (jde) on up to (threads) threads,
+    // or as many as there are hardware cores if zero.
+
+    void computePositionVelocity ( double jde, int threads = 0 );
+
+    // accessors for results of computePositionVelocity() for all bodies
+
+    SSPlanetPtr getPlanet ( size_t i ) { return _bodies[i].pPlanet; }
+    SSVector getPosition ( size_t i ) { return _states[i].pos; }
+    SSVector getVelocity ( size_t i ) { return _states[i].vel; }
+    size_t numCheckpoints ( size_t i ) { return _bodies[i].checkpoints.size(); }
+};
+
+#endif /* SSNBody_hpp */
@@ -11,6 +11,9 @@
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <thread>
+#include <atomic>
+#include <typeinfo>
 
 #include "SSObject.hpp"
 #include "SSPlanet.hpp"
@@ -72,9 +75,26 @@ string SSObject::typeToCode ( SSObjectType type )
     return _typeStrings[ type ];
 }
 
+// Looks up the type code without inserting unrecognized codes into the map,
+// so this is safe to call from several threads at once.
+
 SSObjectType SSObject::codeToType ( string code )
 {
-    return _stringTypes[ code ];
+    auto it = _stringTypes.find ( code );
+    return it == _stringTypes.end() ? kTypeNonexistent : it->second;
+}
+
+// As above, but compares a view of the type code with each two-character code directly,
+// without copying it into a string first, since this is done for every line of a CSV file.
+
+SSObjectType SSObject::codeToType ( SSStringView code )
+{
+    if ( code.size() == 2 )
+        for ( const auto &entry : _stringTypes )
+            if ( entry.first[0] == code[0] && entry.first[1] == code[1] )
+                return entry.second;
+    
+    return kTypeNonexistent;
 }
 
 SSObject::SSObject ( void ) : SSObject ( kTypeNonexistent )
@@ -85,7 +105,6 @@ SSObject::SSObject ( void ) : SSObject ( kTypeNonexistent )
 SSObject::SSObject ( SSObjectType type )
 {
     _type = type;
-    _names = vector<string> ( 0 );
     _direction = SSVector ( HUGE_VAL, HUGE_VAL, HUGE_VAL );
     _distance = HUGE_VAL;
     _magnitude = HUGE_VAL;
@@ -94,11 +113,46 @@ SSObject::SSObject ( SSObjectType type )
 string SSObject::getName ( int i )
 {
     if ( i >= 0 && i < _names.size() )
-        return _names[i];
+        return _names[i].str();
     else
         return string ( "" );
 }
 
+// Returns a copy of all of this object's name strings.
+
+vector<string> SSObject::getNames ( void )
+{
+    vector<string> names ( _names.size() );
+    
+    for ( int i = 0; i < _names.size(); i++ )
+        names[i] = getName ( i );
+    
+    return names;
+}
+
+// Replaces this object's name strings. The new names are stored on the heap, even if the
+// old ones were in a pool; the old ones are not freed until the pool is.
+
+void SSObject::setNames ( vector<string> names )
+{
+    SSCompactArray<SSCompactString> newNames ( names.size() );
+    SSCompactString *pNames = newNames.edit();
+    
+    for ( int i = 0; i < names.size(); i++ )
+        pNames[i] = SSCompactString ( names[i] );
+    
+    _names = move ( newNames );
+}
+
+// Moves this object's names into a pool (pPool), where they are shared with identical names
+// of other objects. Subclasses with other variable-length data should override this method,
+// and call their base class implementation.
+
+void SSObject::moveToPool ( SSPool *pPool )
+{
+    _names.moveToPool ( pPool );
+}
+
 // Default implementation of getIdentifer; overridden by subclasses.
 
 SSIdentifier SSObject::getIdentifier ( SSCatalog cat )
@@ -127,6 +181,48 @@ void SSObject::computeEphemeris ( SSCoordinates &coords )
     
 }
 
+// Computes ephemerides of all objects in an object array (objects) for the time and observer location
+// in an SSCoordinates object (coords), using several threads at once. The number of threads (threads)
+// defaults to the number of hardware cores if zero; if one, objects are computed serially on the calling thread.
+// Objects are handed out to threads in small blocks, so a few slow objects (e.g. satellites) don't hold up
+// the others. Every object is computed by exactly one thread, so results are identical to a serial loop.
+
+void SSComputeEphemerides ( SSCoordinates &coords, SSObjectVec &objects, int threads )
+{
+    static const size_t kBlockSize = 256;
+    size_t n = objects.size();
+    
+    if ( threads < 1 )
+        threads = max ( 1u, thread::hardware_concurrency() );
+
+    threads = (int) min ( (size_t) threads, ( n + kBlockSize - 1 ) / kBlockSize );
+    if ( threads <= 1 )
+    {
+        for ( size_t i = 0; i < n; i++ )
+            objects[i]->computeEphemeris ( coords );
+        return;
+    }
+    
+    // Each worker claims the next unclaimed block of objects until none are left.
+    // The calling thread does its share of the work too.
+    
+    atomic<size_t> next ( 0 );
+    auto worker = [&] ( void )
+    {
+        for ( size_t first = next.fetch_add ( kBlockSize ); first < n; first = next.fetch_add ( kBlockSize ) )
+            for ( size_t i = first; i < first + kBlockSize && i < n; i++ )
+                objects[i]->computeEphemeris ( coords );
+    };
+    
+    vector<thread> pool;
+    for ( int t = 1; t < threads; t++ )
+        pool.push_back ( thread ( worker ) );
+    
+    worker();
+    for ( thread &t : pool )
+        t.join();
+}
+
 // Given a vector of smart pointers to SSObject, creates a mapping of SSIdentifiers
 // in a particular catalog (cat) to index number within the vector.
 // Useful for fast object retrieval by identifier (see SSIdentifierToObject()).
@@ -134,6 +230,7 @@ void SSObject::computeEphemeris ( SSCoordinates &coords )
 SSObjectMap SSMakeObjectMap ( SSObjectVec &objects, SSCatalog cat )
 {
     SSObjectMap map;
+    map.reserve ( objects.size() );
     
     for ( int i = 0; i < objects.size(); i++ )
     {
@@ -151,14 +248,49 @@ SSObjectMap SSMakeObjectMap ( SSObjectVec &objects, SSCatalog cat )
     return map;
 }
 
+// As above, but maps every identifier of every object in the vector, in all catalogs,
+// so one map can look up stars by HR, HD, HIP, Bayer, etc., and planets by JPL, asteroid,
+// comet, or NORAD number. If several objects share an identifier, the first one wins.
+
+SSObjectMap SSMakeObjectMap ( SSObjectVec &objects )
+{
+    SSObjectMap map;
+    map.reserve ( objects.size() * 2 );
+    
+    for ( int i = 0; i < objects.size(); i++ )
+    {
+        SSObject *ptr = objects[i];
+        if ( ptr == nullptr )
+            continue;
+        
+        SSStarPtr pStar = SSGetStarPtr ( ptr );
+        SSPlanetPtr pPlanet = SSGetPlanetPtr ( ptr );
+        
+        if ( pStar != nullptr )
+        {
+            for ( SSIdentifier ident : pStar->getIdentifiers() )
+                if ( ident && map.find ( ident ) == nullptr )
+                    map.insert ( { ident, i + 1 } );
+        }
+        else if ( pPlanet != nullptr )
+        {
+            SSIdentifier ident = pPlanet->getIdentifier();
+            if ( ident && map.find ( ident ) == nullptr )
+                map.insert ( { ident, i + 1 } );
+        }
+    }
+    
+    return map;
+}
+
 // Given a catalog identifier (ident), a mapping of identifiers to object indices (map),
 // and a vector of smart pointers to objects (objects), this function returns a smart pointer
 // to the first object in the vector which matches ident.  If the identifier does not map to
 // any object in the vector, this function returns a smart pointer to null!
 
-SSObjectPtr SSIdentifierToObject ( SSIdentifier ident, SSObjectMap &map, SSObjectVec &objects )
+SSObjectPtr SSIdentifierToObject ( SSIdentifier ident, const SSObjectMap &map, SSObjectVec &objects )
 {
-    int k = map[ ident ];
+    int k = map[ ident ];   // never inserts; returns zero if ident is not in map
 
     if ( k > 0 )
         return objects[ k - 1 ];
@@ -166,12 +298,15 @@ SSObjectPtr SSIdentifierToObject ( SSIdentifier ident, SSObjectMap &map, SSObjec
         return SSObjectPtr ( nullptr );
 }
 
-// Allocates a new object of the specific object type and returns a shared pointer to it.
-// On failure, returns a shared pointer to null.
+// Allocates a new object of the specific object type and returns a pointer to it.
+// If (pArena) is not null, the object is allocated in that arena, and is owned by it.
+// On failure, returns a pointer to null.
 
-SSObjectPtr SSNewObject ( SSObjectType type )
+SSObjectPtr SSNewObject ( SSObjectType type, SSObjectArena *pArena )
 {
-    if ( type >= kTypePlanet && type <= kTypeSpacecraft )
+    if ( pArena )
+        return pArena->create ( type );
+    else if ( type >= kTypePlanet && type <= kTypeSpacecraft )
         return new SSPlanet ( type );
     else if ( type == kTypeStar )
         return new SSStar;
@@ -189,19 +324,241 @@ SSObjectPtr SSNewObject ( SSObjectType type )
         return nullptr;
 }
 
-// Allocates a new object which is a complete deep copy of an existing object (pObj)
-// Returns pointer to null if pObj is null.
+// Returns the slab arena for objects of a concrete type. If there is none yet, creates one
+// with blocks of (blockSize) bytes if (blockSize) is not zero, otherwise returns nullptr.
+// There are only a few types, so a linear search is faster than a map.
 
-SSObjectPtr SSCloneObject ( SSObject *pObj )
+SSArena *SSObjectArena::getSlab ( const type_info &type, size_t blockSize )
+{
+    for ( auto &slab : _slabs )
+        if ( *slab.first == type )
+            return slab.second;
+    
+    if ( blockSize == 0 )
+        return nullptr;
+    
+    _slabs.push_back ( { &type, new SSArena ( blockSize ) } );
+    return _slabs.back().second;
+}
+
+// Allocates memory for an object whose concrete type is T in the slab for that type,
+// and constructs the object there with the given arguments. Returns pointer to the object,
+// which this arena owns, and destroys when it is destroyed.
+
+template <class T, class... Args> T *SSObjectArena::construct ( Args &&... args )
+{
+    SSArena *pSlab = getSlab ( typeid ( T ), 4096 * sizeof ( T ) );
+    void *p = pSlab->allocate ( sizeof ( T ), max ( alignof ( T ), alignof ( double ) ) );
+    T *pObj = new ( p ) T ( std::forward<Args> ( args )... );
+    _objects.push_back ( pObj );
+    return pObj;
+}
+
+// Allocates a new object of the specific object type in this arena, like SSNewObject().
+// Returns nullptr if the type is not recognized.
+
+SSObjectPtr SSObjectArena::create ( SSObjectType type )
 {
-    if ( pObj )
+    if ( type >= kTypePlanet && type <= kTypeSpacecraft )
+        return construct<SSPlanet> ( type );
+    else if ( type == kTypeStar )
+        return construct<SSStar>();
+    else if ( type == kTypeDoubleStar )
+        return construct<SSDoubleStar>();
+    else if ( type == kTypeVariableStar )
+        return construct<SSVariableStar>();
+    else if ( type == kTypeDoubleVariableStar )
+        return construct<SSDoubleVariableStar>();
+    else if ( type >= kTypeOpenCluster && type <= kTypeGalaxy )
+        return construct<SSDeepSky> ( type );
+    else if ( type >= kTypeConstellation && type <= kTypeAsterism )
+        return construct<SSConstellation> ( type );
+    else
+        return nullptr;
+}
+
+// Copies an object (pObj) whose concrete type is T into the slab for that type, and deletes the original.
+// Returns pointer to the copy.
+
+template <class T> SSObjectPtr SSObjectArena::adoptAs ( SSObjectPtr pObj )
+{
+    T *pNewObj = construct<T> ( *dynamic_cast<T *> ( pObj ) );
+    delete pObj;
+    return pNewObj;
+}
+
+// Returns true if an object (pObj) is stored in one of this arena's slabs.
+
+bool SSObjectArena::owns ( SSObjectPtr pObj )
+{
+    SSArena *pSlab = getSlab ( typeid ( *pObj ), 0 );
+    return pSlab != nullptr && pSlab->contains ( pObj );
+}
+
+// Takes ownership of an object (pObj), and moves its names and identifiers into this arena's pool.
+// Objects created in this arena are kept where they are. Other objects must have been allocated
+// with new: those of the types SSNewObject() creates are copied into this arena and the original
+// is deleted, so the returned pointer must be used from now on, not (pObj)! Objects of other types
+// are kept on the heap, and deleted with the arena.
+
+SSObjectPtr SSObjectArena::adopt ( SSObjectPtr pObj )
+{
+    if ( pObj == nullptr )
+        return nullptr;
+    
+    if ( ! owns ( pObj ) )
     {
-        SSObjectPtr pNewObj = SSNewObject ( pObj->getType() );
-        *pNewObj = *pObj;
-        return pNewObj;
+        const type_info &type = typeid ( *pObj );
+        
+        if ( type == typeid ( SSStar ) )
+            pObj = adoptAs<SSStar> ( pObj );
+        else if ( type == typeid ( SSDoubleStar ) )
+            pObj = adoptAs<SSDoubleStar> ( pObj );
+        else if ( type == typeid ( SSVariableStar ) )
+            pObj = adoptAs<SSVariableStar> ( pObj );
+        else if ( type == typeid ( SSDoubleVariableStar ) )
+            pObj = adoptAs<SSDoubleVariableStar> ( pObj );
+        else if ( type == typeid ( SSDeepSky ) )
+            pObj = adoptAs<SSDeepSky> ( pObj );
+        else if ( type == typeid ( SSPlanet ) )
+            pObj = adoptAs<SSPlanet> ( pObj );
+        else if ( type == typeid ( SSSatellite ) )
+            pObj = adoptAs<SSSatellite> ( pObj );
+        else if ( type == typeid ( SSConstellation ) )
+            pObj = adoptAs<SSConstellation> ( pObj );
+        else
+            _heap.push_back ( pObj );
+    }
+    
+    pObj->moveToPool ( &_pool );
+    return pObj;
+}
+
+// Takes ownership of all objects, and all pooled data, in another arena (other), which is left empty.
+// Pointers to those objects and their data stay valid. Lets several threads each create objects in
+// an arena of their own, then hand them all over to one arena when finished.
+
+void SSObjectArena::absorb ( SSObjectArena &other )
+{
+    if ( &other == this )
+        return;
+    
+    for ( auto &slab : other._slabs )
+    {
+        SSArena *pSlab = getSlab ( *slab.first, 0 );
+        if ( pSlab == nullptr )
+        {
+            _slabs.push_back ( slab );
+        }
+        else
+        {
+            pSlab->absorb ( *slab.second );
+            delete slab.second;
+        }
     }
     
-    return nullptr;
+    _objects.insert ( _objects.end(), other._objects.begin(), other._objects.end() );
+    _heap.insert ( _heap.end(), other._heap.begin(), other._heap.end() );
+    _pool.absorb ( other._pool );
+    
+    other._slabs.clear();
+    other._objects.clear();
+    other._heap.clear();
+}
+
+// Destroys all objects owned by this arena, then frees all of their memory at once.
+// Destructors only free data which was changed after objects were moved into the pool.
+
+SSObjectArena::~SSObjectArena ( void )
+{
+    for ( SSObjectPtr pObj : _objects )
+        pObj->~SSObject();
+    
+    for ( SSObjectPtr pObj : _heap )
+        delete pObj;
+    
+    for ( auto &slab : _slabs )
+        delete slab.second;
+}
+
+// Returns total bytes of memory used by objects and their data in this arena,
+// not including objects of unknown types stored on the heap.
+
+size_t SSObjectArena::getUsed ( void )
+{
+    size_t used = _pool.getUsed();
+    
+    for ( auto &slab : _slabs )
+        used += slab.second->getUsed();
+    
+    return used;
+}
+
+// Returns total bytes of memory reserved by this arena, which is at least as much as getUsed().
+
+size_t SSObjectArena::getReserved ( void )
+{
+    size_t reserved = _pool.getReserved();
+    
+    for ( auto &slab : _slabs )
+        reserved += slab.second->getReserved();
+    
+    return reserved;
+}
+
+// Destroys an object array and all objects in it. In arena mode,
+// all objects are freed at once with the arena.
+
+SSObjectArray::~SSObjectArray ( void )
+{
+    if ( _arena )
+        delete _arena;
+    else
+        for ( SSObjectPtr pObj : _objects )
+            delete pObj;
+}
+
+// Allocates a new object which is a complete deep copy of an existing object (pObj) whose concrete type is T.
+// The copy's names and other variable-length data are allocated on the heap, even if the original's live in an arena.
+
+template <class T> static SSObjectPtr cloneAs ( SSObjectPtr pObj )
+{
+    return new T ( *dynamic_cast<T *> ( pObj ) );
+}
+
+// Allocates a new object which is a complete deep copy of an existing object (pObj)
+// Returns pointer to null if pObj is null. Objects are copied with their concrete type's
+// copy constructor, so subclass data (a planet's orbit, a star's position, etc.) is copied too;
+// objects of types SSNewObject() doesn't create are copied only as far as their SSObject base.
+
+SSObjectPtr SSCloneObject ( SSObject *pObj )
+{
+    if ( pObj == nullptr )
+        return nullptr;
+    
+    const type_info &type = typeid ( *pObj );
+    
+    if ( type == typeid ( SSStar ) )
+        return cloneAs<SSStar> ( pObj );
+    else if ( type == typeid ( SSDoubleStar ) )
+        return cloneAs<SSDoubleStar> ( pObj );
+    else if ( type == typeid ( SSVariableStar ) )
+        return cloneAs<SSVariableStar> ( pObj );
+    else if ( type == typeid ( SSDoubleVariableStar ) )
+        return cloneAs<SSDoubleVariableStar> ( pObj );
+    else if ( type == typeid ( SSDeepSky ) )
+        return cloneAs<SSDeepSky> ( pObj );
+    else if ( type == typeid ( SSPlanet ) )
+        return cloneAs<SSPlanet> ( pObj );
+    else if ( type == typeid ( SSSatellite ) )
+        return cloneAs<SSSatellite> ( pObj );
+    else if ( type == typeid ( SSConstellation ) )
+        return cloneAs<SSConstellation> ( pObj );
+    
+    SSObjectPtr pNewObj = SSNewObject ( pObj->getType() );
+    if ( pNewObj )
+        *pNewObj = *pObj;
+    return pNewObj;
 }
 
 // Exports a vector of objects to a CSV-formatted text file.
@@ -238,58 +595,125 @@ int SSExportObjectsToCSV ( const string &filename, SSObjectVec &objects )
     return i;
 }
 
+// Creates a new object from a line of CSV text which has already been split into fields.
+// Dispatches on the type code in the first field, so each line is only parsed once.
+// Stars are tried for any code other than a solar system object or constellation,
+// since SSStar::fromCSV() trims whitespace from the type code and the others don't.
+// The object is allocated in an arena (pArena) if not null. Returns nullptr if the fields
+// don't describe a valid object.
+
+static SSObjectPtr SSObjectFromCSVFields ( vector<SSStringView> &fields, SSObjectArena *pArena )
+{
+    SSObjectType type = SSObject::codeToType ( fields[0] );
+    
+    if ( type >= kTypePlanet && type <= kTypeComet )
+        return SSPlanet::fromCSV ( fields, pArena );
+    else if ( type >= kTypeConstellation && type <= kTypeAsterism )
+        return SSConstellation::fromCSV ( fields, pArena );
+    else
+        return SSStar::fromCSV ( fields, pArena );
+}
+
 // Imports objects from CSV-formatted text file (filename).
 // Imported objects are appended to the input vector of SSObjects (objects).
+// Lines are parsed on several threads at once if (threads) is greater than one,
+// or on as many threads as there are hardware cores if zero. Objects are appended
+// in file order, so results are identical to single-threaded parsing. If the object vector
+// is in arena mode, objects are created directly in its arena; with several threads, each thread
+// creates objects in an arena of its own, which are all absorbed into the vector's arena at the end.
 // Returns number of objects successfully imported.
 
-int SSImportObjectsFromCSV ( const string &filename, SSObjectVec &objects )
+int SSImportObjectsFromCSV ( const string &filename, SSObjectVec &objects, int threads )
 {
+    static const size_t kBlockSize = 256;
+    
     // Open file; return on failure.
 
     FILE *file = fopen ( filename.c_str(), "r" );
     if ( ! file )
         return 0;
 
-    // Read file line-by-line until we reach end-of-file
-
     string line = "";
+    vector<SSStringView> fields;
     int numObjects = 0;
 
-    while ( fgetline ( file, line ) )
+    if ( threads < 1 )
+        threads = max ( 1u, thread::hardware_concurrency() );
+
+    // Single-threaded: read file line-by-line until we reach end-of-file.
+    // Split each line into fields once; if they describe a valid object, add it to object vector.
+    
+    if ( threads == 1 )
     {
-        // Attempt to create solar system object from CSV file line; if successful add to object vector.
-        
-        SSObjectPtr pObject = SSPlanet::fromCSV ( line );
-        if ( pObject )
+        while ( fgetline ( file, line ) )
         {
-            objects.push_back ( pObject );
-            numObjects++;
-            continue;
+            split ( line, ',', fields );
+            SSObjectPtr pObject = SSObjectFromCSVFields ( fields, objects.getArena() );
+            if ( pObject )
+            {
+                objects.push_back ( pObject );
+                numObjects++;
+            }
         }
-
-        // Attempt to create star from CSV file line; if successful add to object vector.
-
-        pObject = SSStar::fromCSV ( line );
-        if ( pObject )
+        
+        fclose ( file );
+        return numObjects;
+    }
+    
+    // Multi-threaded: read all lines first, then have each thread claim the next unparsed block
+    // of lines until none are left. The calling thread does its share of the work too.
+    
+    vector<string> lines;
+    while ( fgetline ( file, line ) )
+        lines.push_back ( line );
+    
+    fclose ( file );
+    
+    size_t n = lines.size();
+    vector<SSObjectPtr> parsed ( n, nullptr );
+    atomic<size_t> next ( 0 );
+    
+    auto worker = [&] ( SSObjectArena *pArena )
+    {
+        vector<SSStringView> fields;
+        for ( size_t first = next.fetch_add ( kBlockSize ); first < n; first = next.fetch_add ( kBlockSize ) )
         {
-            objects.push_back ( pObject );
-            numObjects++;
-            continue;
+            for ( size_t i = first; i < first + kBlockSize && i < n; i++ )
+            {
+                split ( lines[i], ',', fields );
+                parsed[i] = SSObjectFromCSVFields ( fields, pArena );
+                if ( pArena )
+                    pArena->adopt ( parsed[i] );
+            }
         }
-        
-        // Attempt to create constellation from CSV file line; if successful add to object vector.
-
-        pObject = SSConstellation::fromCSV ( line );
+    };
+    
+    threads = (int) min ( (size_t) threads, ( n + kBlockSize - 1 ) / kBlockSize );
+    vector<unique_ptr<SSObjectArena>> arenas;
+    for ( int t = 0; t < threads && objects.usesArena(); t++ )
+        arenas.emplace_back ( new SSObjectArena );
+    
+    vector<thread> pool;
+    for ( int t = 1; t < threads; t++ )
+        pool.push_back ( thread ( worker, arenas.empty() ? nullptr : arenas[t].get() ) );
+    
+    worker ( arenas.empty() ? nullptr : arenas[0].get() );
+    for ( thread &t : pool )
+        t.join();
+    
+    for ( unique_ptr<SSObjectArena> &pArena : arenas )
+        objects.getArena()->absorb ( *pArena );
+    
+    // Append objects in file order, on the calling thread (SSObjectArray isn't thread-safe).
+    
+    for ( SSObjectPtr pObject : parsed )
+    {
         if ( pObject )
         {
             objects.push_back ( pObject );
             numObjects++;
-            continue;
         }
     }
     
-    // Close file. Return number of objects added to object vector.
-
-    fclose ( file );
     return numObjects;
 }
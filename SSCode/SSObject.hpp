@@ -18,9 +18,11 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <typeinfo>
 
 #include "SSVector.hpp"
 #include "SSIdentifier.hpp"
+#include "SSArena.hpp"
 
 using namespace std;
 
@@ -58,7 +60,7 @@ class SSObject
 protected:
     
     SSObjectType    _type;          // object type code
-    vector<string>  _names;         // vector of name string(s)
+    SSCompactArray<SSCompactString> _names;   // array of name string(s); may be stored in a pool, see moveToPool()
     SSVector        _direction;     // apparent direction to object as unit vector in fundamental reference frame; infinite if unknown
     double          _distance;      // distance to object in AU; infinite if unknown
     float           _magnitude;     // visual magnitude; infinite if unknown
@@ -74,14 +76,14 @@ public:
     // accessors
     
     SSObjectType getType ( void ) { return _type; }
-    vector<string> getNames ( void ) { return _names; }
+    vector<string> getNames ( void );
     SSVector getDirection ( void ) { return _direction; }
     double getDistance ( void ) { return _distance; }
     float getMagnitude ( void ) { return _magnitude; }
     
     // modifiers. Type cannot be changed after object construction!
     
-    void setNames ( vector<string> names ) { _names = names; }
+    void setNames ( vector<string> names );
     void setDirection ( SSVector dir ) { _direction = dir; }
     void setDistance ( double dist ) { _distance = dist; }
     void setMagnitude ( float mag ) { _magnitude = mag; }
@@ -90,6 +92,7 @@ public:
     
     static string typeToCode ( SSObjectType type );
     static SSObjectType codeToType ( string );
+    static SSObjectType codeToType ( SSStringView code );
 
     virtual string getName ( int i );                           // returns copy of i-th name string
     virtual SSIdentifier getIdentifier ( SSCatalog cat );       // returns identifier in the specified catalog, or null identifier if object has none in that catalog.
@@ -97,35 +100,95 @@ public:
     virtual void computeEphemeris ( class SSCoordinates &dyn );    // computes direction, distance, magnitude for the given dynamical state
 
     virtual string toCSV ( void );
+
+    // Moves this object's names (and any other variable-length data stored by subclasses) into a pool.
+    
+    virtual void moveToPool ( SSPool *pPool );
 };
 
 typedef SSObject *SSObjectPtr;
 
+// This class stores objects of each concrete type contiguously in large slabs of memory, and their
+// names and identifiers in a pool which stores each distinct string or identifier list only once,
+// so a large catalog needs a handful of allocations instead of several per object, and is freed
+// all at once. Used by SSObjectArray in arena mode; objects it owns must never be deleted individually!
+
+class SSObjectArena
+{
+protected:
+
+    vector<pair<const type_info *,SSArena *>> _slabs;  // slab arena for each concrete object type
+    vector<SSObjectPtr> _objects;       // objects stored in slabs, whose destructors must be called before slabs are freed
+    vector<SSObjectPtr> _heap;          // objects of types this class doesn't know how to store; deleted normally
+    SSPool _pool;                       // deduplicated names, identifiers, and other variable-length data
+
+    template <class T, class... Args> T *construct ( Args &&... args );
+    template <class T> SSObjectPtr adoptAs ( SSObjectPtr pObj );
+    SSArena *getSlab ( const type_info &type, size_t blockSize );
+    bool owns ( SSObjectPtr pObj );
+
+public:
+
+    SSObjectArena ( void ) { }
+    ~SSObjectArena ( void );
+
+    SSObjectArena ( const SSObjectArena & ) = delete;
+    SSObjectArena &operator = ( const SSObjectArena & ) = delete;
+
+    SSObjectPtr create ( SSObjectType type );
+    SSObjectPtr adopt ( SSObjectPtr pObj );
+    void absorb ( SSObjectArena &other );
+
+    SSPool &getPool ( void ) { return _pool; }
+    size_t getUsed ( void );
+    size_t getReserved ( void );
+};
+
 // This class stores a vector of pointers to SSObject, and deletes them when class instance is destroyed.
+// In arena mode, objects should be created in the array's arena with SSNewObject ( type, getArena() ),
+// then added with push_back() once their data is set; push_back() moves their names and identifiers
+// into the arena's pool. Objects allocated anywhere else are copied into the arena and the original
+// is deleted, so push_back() may store a different pointer than the one passed in! It returns the
+// pointer actually stored; callers that keep using the object after adding it must use that returned
+// pointer, never the one they passed in. Arena-mode objects are all freed together when the array
+// is destroyed, and must never be deleted individually.
 
 class SSObjectArray
 {
 protected:
     vector<SSObjectPtr> _objects;
+    SSObjectArena *_arena;
 
 public:
-    ~SSObjectArray ( void ) { for ( SSObjectPtr pObj : _objects ) delete pObj; }
+    explicit SSObjectArray ( bool arena = false ) { _arena = arena ? new SSObjectArena : nullptr; }
+    ~SSObjectArray ( void );
+
+    // Copying would delete the same objects, or arena, twice when both copies are destroyed.
+
+    SSObjectArray ( const SSObjectArray & ) = delete;
+    SSObjectArray &operator = ( const SSObjectArray & ) = delete;
+
     SSObjectPtr at ( size_t index ) { return index >= 0 && index < size() ? _objects.at ( index ) : nullptr; }
     SSObjectPtr operator [] ( size_t index ) { return at ( index ); }
-    void push_back ( SSObjectPtr pObj ) { _objects.push_back ( pObj ); }
+    SSObjectPtr push_back ( SSObjectPtr pObj ) { _objects.push_back ( _arena ? _arena->adopt ( pObj ) : pObj ); return _objects.back(); }   // use returned pointer, not (pObj), from now on!
     size_t size ( void ) { return _objects.size(); }
     void clear ( void ) { _objects.clear(); }   // empties object vector but DOES NOT delete individual objects!!!
+    bool usesArena ( void ) { return _arena != nullptr; }
+    SSObjectArena *getArena ( void ) { return _arena; }    // null unless in arena mode
 };
 
 typedef SSObjectArray SSObjectVec;          // legacy declaration was typedef vector<SSObjectPtr> SSObjectVec; now we use SSObjectArray class
-typedef map<SSIdentifier,int> SSObjectMap;
+typedef SSIdentifierHashMap<int> SSObjectMap;   // maps identifiers to object index + 1; see SSMakeObjectMap()
 
-SSObjectPtr SSNewObject ( SSObjectType type );
+SSObjectPtr SSNewObject ( SSObjectType type, SSObjectArena *pArena = nullptr );
 SSObjectPtr SSCloneObject ( SSObject *pObj );
 SSObjectMap SSMakeObjectMap ( SSObjectVec &objects, SSCatalog cat );
-SSObjectPtr SSIdentifierToObject ( SSIdentifier ident, SSObjectMap &map, SSObjectVec &objects );
+SSObjectMap SSMakeObjectMap ( SSObjectVec &objects );
+SSObjectPtr SSIdentifierToObject ( SSIdentifier ident, const SSObjectMap &map, SSObjectVec &objects );
+
+void SSComputeEphemerides ( class SSCoordinates &coords, SSObjectVec &objects, int threads = 0 );
 
-int SSImportObjectsFromCSV ( const string &filename, SSObjectVec &objects );
+int SSImportObjectsFromCSV ( const string &filename, SSObjectVec &objects, int threads = 1 );
 int SSExportObjectsToCSV ( const string &filename, SSObjectVec &objects );
 
 #pragma pack ( pop )
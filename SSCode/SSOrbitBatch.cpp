@@ -0,0 +1,334 @@
+// SSOrbitBatch.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A structure-of-arrays container for large numbers of Keplerian orbits,
+// with a SIMD Kepler solver for computing their positions and velocities in bulk.
+
+#include <algorithm>
+
+#include "SSOrbitBatch.hpp"
+#include "SSImportMPC.hpp"
+#include "SSCoordinates.hpp"
+#include "SSChebyshevEphemeris.hpp"
+#include "SSSIMD.hpp"
+
+// Number of Halley's method iterations used by the SIMD Kepler solver. Starting from Danby's
+// initial guess, three iterations converge to better than 1.0e-15 radians for all eccentricities
+// below kMaxBatchEccentricity; the fourth is a safety margin. Any lane which still hasn't
+// converged afterwards is recomputed with SSOrbit::solveKeplerEquation().
+
+static const int kKeplerIterations = 4;
+static constexpr double kKeplerTolerance = 1.0e-12;
+
+// Rounds both lanes to the nearest integer. Adding and subtracting 1.5 * 2^52 is exact IEEE
+// arithmetic for values smaller than 2^51, so this works without SSE4.1 round instructions.
+
+static inline SSDouble2 roundInt ( SSDouble2 x )
+{
+    SSDouble2 magic = SSDouble2::splat ( 6755399441055744.0 );
+    return ( x + magic ) - magic;
+}
+
+// Computes sines (s) and cosines (c) of both lanes of (x), which should be within a few
+// hundred radians of zero. Reduces argument to -pi/4 .. +pi/4 with a two-part pi/2, then uses
+// the minimax polynomials from FDLIBM's __kernel_sin() and __kernel_cos(); error is about 1 ulp.
+
+static inline void sincos ( SSDouble2 x, SSDouble2 &s, SSDouble2 &c )
+{
+    const SSDouble2 zero = SSDouble2::splat ( 0.0 ), one = SSDouble2::splat ( 1.0 ), half = SSDouble2::splat ( 0.5 );
+
+    SSDouble2 k = roundInt ( x * SSDouble2::splat ( M_2_PI ) );
+    SSDouble2 r = x - k * SSDouble2::splat ( 1.57079632673412561417e+00 );
+    r = r - k * SSDouble2::splat ( 6.07710050650619224932e-11 );
+    
+    SSDouble2 z = r * r;
+    SSDouble2 ps = SSDouble2::splat ( 2.75573137070700676789e-06 ) + z * ( SSDouble2::splat ( -2.50507602534068634195e-08 ) + z * SSDouble2::splat ( 1.58969099521155010221e-10 ) );
+    ps = SSDouble2::splat ( 8.33333333332248946124e-03 ) + z * ( SSDouble2::splat ( -1.98412698298579493134e-04 ) + z * ps );
+    SSDouble2 sr = r + z * r * ( SSDouble2::splat ( -1.66666666666666324348e-01 ) + z * ps );
+    
+    SSDouble2 pc = SSDouble2::splat ( -2.75573143513906633035e-07 ) + z * ( SSDouble2::splat ( 2.08757232129817482790e-09 ) + z * SSDouble2::splat ( -1.13596475577881948265e-11 ) );
+    pc = SSDouble2::splat ( 4.16666666666666019037e-02 ) + z * ( SSDouble2::splat ( -1.38888888888741095749e-03 ) + z * ( SSDouble2::splat ( 2.48015872894767294178e-05 ) + z * pc ) );
+    SSDouble2 cr = one - ( half * z - z * ( z * pc ) );
+    
+    // Quadrant (0-3) is k modulo 4; floor ( k / 4 ) is round ( ( k - 1.5 ) / 4 ) for integer k.
+    
+    SSDouble2 quad = k - SSDouble2::splat ( 4.0 ) * roundInt ( ( k - SSDouble2::splat ( 1.5 ) ) * SSDouble2::splat ( 0.25 ) );
+    SSMask2 q1 = quad == one, q2 = quad == SSDouble2::splat ( 2.0 ), q3 = quad == SSDouble2::splat ( 3.0 );
+    SSMask2 swap = q1 || q3;
+    
+    s = select ( swap, cr, sr );
+    c = select ( swap, sr, cr );
+    s = select ( q2 || q3, zero - s, s );
+    c = select ( q1 || q2, zero - c, c );
+}
+
+// Constructs an empty orbit batch.
+
+SSOrbitBatch::SSOrbitBatch ( void )
+{
+
+}
+
+// Constructs a batch containing the orbits of all asteroids and comets
+// in an object array (objects). Other object types are ignored.
+
+SSOrbitBatch::SSOrbitBatch ( SSObjectArray &objects )
+{
+    add ( objects );
+}
+
+// Reserves memory for at least (n) orbits, to avoid reallocation while adding them.
+
+void SSOrbitBatch::reserve ( size_t n )
+{
+    _t.reserve ( n ); _m.reserve ( n ); _mm.reserve ( n );
+    _e.reserve ( n ); _a.reserve ( n ); _b.reserve ( n );
+    _px.reserve ( n ); _py.reserve ( n ); _pz.reserve ( n );
+    _qx.reserve ( n ); _qy.reserve ( n ); _qz.reserve ( n );
+    _orbits.reserve ( n );
+    _planets.reserve ( n );
+}
+
+// Adds orbits of all asteroids and comets in an object array (objects) to this batch.
+// The batch stores pointers to the objects, but does not own them. Returns number of orbits added.
+
+int SSOrbitBatch::add ( SSObjectArray &objects )
+{
+    int n = 0;
+    
+    reserve ( size() + objects.size() );
+    for ( size_t i = 0; i < objects.size(); i++ )
+    {
+        SSPlanetPtr pPlanet = SSGetPlanetPtr ( objects[i] );
+        if ( pPlanet == nullptr )
+            continue;
+        
+        if ( pPlanet->getType() != kTypeAsteroid && pPlanet->getType() != kTypeComet )
+            continue;
+        
+        add ( pPlanet );
+        n++;
+    }
+    
+    return n;
+}
+
+// Adds all orbits in an MPC asteroid orbit table to this batch, in order. Returns number of orbits added.
+
+int SSOrbitBatch::add ( const SSMPCOrbitTable &table )
+{
+    reserve ( size() + table.size() );
+    for ( size_t i = 0; i < table.size(); i++ )
+        add ( table.getOrbit ( i ) );
+    
+    return (int) table.size();
+}
+
+// Adds the orbit of a single asteroid or comet (pPlanet) to this batch.
+// The batch keeps a pointer to the object, but does not own it.
+
+void SSOrbitBatch::add ( SSPlanetPtr pPlanet )
+{
+    add ( pPlanet->getOrbit() );
+    _planets.back() = pPlanet;
+}
+
+// Adds a heliocentric orbit (orbit), referred to the J2000 ecliptic, to this batch.
+// For elliptical orbits, precomputes the axes and orientation of the orbit in the
+// fundamental frame, so computing position and velocity only needs Kepler's equation.
+
+void SSOrbitBatch::add ( const SSOrbit &orbit )
+{
+    static SSMatrix matrix = SSCoordinates::getEclipticMatrix ( SSCoordinates::getObliquity ( SSTime::kJ2000 ) );
+    
+    bool batch = orbit.e >= 0.0 && orbit.e < kMaxBatchEccentricity && orbit.q > 0.0 && isfinite ( orbit.mm ) && isfinite ( orbit.m ) && isfinite ( orbit.t );
+    double a = 0.0, b = 0.0, e = 0.0;
+    SSVector p ( 0.0, 0.0, 0.0 ), q ( 0.0, 0.0, 0.0 );
+
+    if ( batch )
+    {
+        e = orbit.e;
+        a = orbit.q / ( 1.0 - e );
+        b = a * sqrt ( 1.0 - e * e );
+
+        double cw = cos ( orbit.w ), sw = sin ( orbit.w );
+        double cn = cos ( orbit.n ), sn = sin ( orbit.n );
+        double ci = cos ( orbit.i ), si = sin ( orbit.i );
+        
+        p = matrix.multiply ( SSVector ( cw * cn - sw * ci * sn, cw * sn + sw * ci * cn, sw * si ) );
+        q = matrix.multiply ( SSVector ( -sw * cn - cw * ci * sn, -sw * sn + cw * ci * cn, cw * si ) );
+    }
+    else
+    {
+        _special.push_back ( (uint32_t) _orbits.size() );
+    }
+    
+    _t.push_back ( batch ? orbit.t : 0.0 );
+    _m.push_back ( batch ? orbit.m : 0.0 );
+    _mm.push_back ( batch ? orbit.mm : 0.0 );
+    _e.push_back ( e );
+    _a.push_back ( a );
+    _b.push_back ( b );
+    _px.push_back ( p.x ); _py.push_back ( p.y ); _pz.push_back ( p.z );
+    _qx.push_back ( q.x ); _qy.push_back ( q.y ); _qz.push_back ( q.z );
+    _orbits.push_back ( orbit );
+    _planets.push_back ( nullptr );
+}
+
+// Removes all orbits from this batch and releases computed results.
+// Does not delete the objects the batch was built from!
+
+void SSOrbitBatch::clear ( void )
+{
+    _t.clear(); _m.clear(); _mm.clear();
+    _e.clear(); _a.clear(); _b.clear();
+    _px.clear(); _py.clear(); _pz.clear();
+    _qx.clear(); _qy.clear(); _qz.clear();
+    _orbits.clear();
+    _planets.clear();
+    _special.clear();
+    
+    _x.clear(); _y.clear(); _z.clear();
+    _vx.clear(); _vy.clear(); _vz.clear();
+}
+
+// Computes position and velocity of one orbit (k) at Julian Ephemeris Date (jde) from its
+// orbital elements, exactly as SSPlanet::computeMinorPlanetPositionVelocity() does when
+// no precomputed Chebyshev ephemeris covers the object.
+
+void SSOrbitBatch::computeOne ( size_t k, double jde )
+{
+    static SSMatrix matrix = SSCoordinates::getEclipticMatrix ( SSCoordinates::getObliquity ( SSTime::kJ2000 ) );
+    SSVector pos, vel;
+    
+    _orbits[k].toPositionVelocity ( jde, pos, vel );
+    pos = matrix.multiply ( pos );
+    vel = matrix.multiply ( vel );
+    
+    _x[k] = pos.x; _y[k] = pos.y; _z[k] = pos.z;
+    _vx[k] = vel.x; _vy[k] = vel.y; _vz[k] = vel.z;
+}
+
+// Computes heliocentric positions and velocities for all orbits in this batch
+// at Julian Ephemeris Date (jde), minus per-orbit light times (lt) if not null.
+
+void SSOrbitBatch::computePositionVelocity ( double jde, const double *lt )
+{
+    computePositionVelocity ( jde, lt, 0, size() );
+}
+
+// Computes positions and velocities for a contiguous range of (count) orbits starting at index
+// (first). Disjoint ranges may be computed concurrently from different threads, so long as the
+// first call on a batch of a given size is made from one thread. Results for elliptical orbits
+// agree with SSOrbit::toPositionVelocity() to within rounding error, mostly from rounding
+// the time differently (under 1.0e-10 AU); results for all other orbits are identical. Objects covered by the Chebyshev ephemeris
+// in use, if any, are computed from it instead, as in SSPlanet.
+
+void SSOrbitBatch::computePositionVelocity ( double jde, const double *lt, size_t first, size_t count )
+{
+    if ( _x.size() != size() )
+    {
+        _x.resize ( size() ); _y.resize ( size() ); _z.resize ( size() );
+        _vx.resize ( size() ); _vy.resize ( size() ); _vz.resize ( size() );
+    }
+    
+    if ( first >= size() )
+        return;
+    
+    count = min ( count, size() - first );
+    
+    const SSDouble2 zero = SSDouble2::splat ( 0.0 ), one = SSDouble2::splat ( 1.0 ), half = SSDouble2::splat ( 0.5 );
+    const SSDouble2 time = SSDouble2::splat ( jde ), danby = SSDouble2::splat ( 0.85 );
+    const SSDouble2 twoPi1 = SSDouble2::splat ( 4.0 * 1.57079632673412561417e+00 );
+    const SSDouble2 twoPi1t = SSDouble2::splat ( 4.0 * 6.07710050650619224932e-11 );
+    const SSDouble2 tolerance = SSDouble2::splat ( kKeplerTolerance );
+    
+    // Vectorized pass: two orbits per iteration. The odd orbit left over at the end
+    // is computed with the scalar code; so are any lanes which fail to converge.
+    
+    size_t end = first + ( count & ~(size_t) 1 );
+    for ( size_t k = first; k < end; k += 2 )
+    {
+        SSDouble2 e = SSDouble2::load ( &_e[k] );
+        
+        // Mean anomaly, reduced to -pi .. +pi with a two-part 2 pi.
+        
+        SSDouble2 dt = time - SSDouble2::load ( &_t[k] );
+        if ( lt != nullptr )
+            dt = dt - SSDouble2::load ( &lt[k] );
+        
+        SSDouble2 ma = SSDouble2::load ( &_m[k] ) + SSDouble2::load ( &_mm[k] ) * dt;
+        SSDouble2 rev = roundInt ( ma * SSDouble2::splat ( 0.5 * M_1_PI ) );
+        ma = ma - rev * twoPi1 - rev * twoPi1t;
+        
+        // Danby's initial guess E = M + 0.85 e sign(M), then Halley's method.
+        
+        SSDouble2 ea = ma + select ( ma < zero, zero - danby * e, danby * e );
+        SSDouble2 s, c;
+        
+        for ( int i = 0; i < kKeplerIterations; i++ )
+        {
+            sincos ( ea, s, c );
+            SSDouble2 f = ea - e * s - ma;
+            SSDouble2 df = one - e * c;
+            SSDouble2 d2f = e * s;
+            ea = ea - f / ( df - half * f * d2f / df );
+        }
+        
+        sincos ( ea, s, c );
+        SSDouble2 res = ea - e * s - ma;
+        int failed = 3 & ~bits ( res < tolerance && zero - res < tolerance );
+        
+        // Position and velocity in the orbit plane, then rotated into the fundamental frame.
+        
+        SSDouble2 a = SSDouble2::load ( &_a[k] ), b = SSDouble2::load ( &_b[k] );
+        SSDouble2 x = a * ( c - e ), y = b * s;
+        SSDouble2 dea = SSDouble2::load ( &_mm[k] ) / ( one - e * c );
+        SSDouble2 vx = zero - a * s * dea, vy = b * c * dea;
+        
+        SSDouble2 px = SSDouble2::load ( &_px[k] ), py = SSDouble2::load ( &_py[k] ), pz = SSDouble2::load ( &_pz[k] );
+        SSDouble2 qx = SSDouble2::load ( &_qx[k] ), qy = SSDouble2::load ( &_qy[k] ), qz = SSDouble2::load ( &_qz[k] );
+        
+        ( px * x + qx * y ).store ( &_x[k] );
+        ( py * x + qy * y ).store ( &_y[k] );
+        ( pz * x + qz * y ).store ( &_z[k] );
+        ( px * vx + qx * vy ).store ( &_vx[k] );
+        ( py * vx + qy * vy ).store ( &_vy[k] );
+        ( pz * vx + qz * vy ).store ( &_vz[k] );
+        
+        if ( failed & 1 )
+            computeOne ( k, lt ? jde - lt[k] : jde );
+        
+        if ( failed & 2 )
+            computeOne ( k + 1, lt ? jde - lt[k + 1] : jde );
+    }
+    
+    if ( end < first + count )
+        computeOne ( end, lt ? jde - lt[end] : jde );
+    
+    // Scalar pass: near-parabolic, hyperbolic, and invalid orbits in the range.
+    // Their lanes were computed with zero axes above, so are simply overwritten here.
+    
+    auto it = lower_bound ( _special.begin(), _special.end(), (uint32_t) first );
+    for ( ; it != _special.end() && *it < first + count; it++ )
+        computeOne ( *it, lt ? jde - lt[*it] : jde );
+    
+    // Finally overwrite objects which the Chebyshev ephemeris in use covers, like
+    // SSPlanet::computeMinorPlanetPositionVelocity(). Orbits added without an object can't be in it.
+    
+    SSChebyshevEphemeris *pCheb = SSPlanet::getChebyshevEphemeris();
+    if ( pCheb == nullptr )
+        return;
+    
+    for ( size_t k = first; k < first + count; k++ )
+    {
+        SSVector pos, vel;
+        if ( _planets[k] && pCheb->compute ( _planets[k]->getIdentifier(), lt ? jde - lt[k] : jde, pos, vel ) )
+        {
+            _x[k] = pos.x; _y[k] = pos.y; _z[k] = pos.z;
+            _vx[k] = vel.x; _vy[k] = vel.y; _vz[k] = vel.z;
+        }
+    }
+}
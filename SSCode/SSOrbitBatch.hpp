@@ -0,0 +1,85 @@
+// SSOrbitBatch.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A structure-of-arrays container for large numbers of Keplerian orbits, such as the
+// asteroids and comets in an MPC orbit file. Computes heliocentric positions and velocities
+// for every orbit at once with a SIMD Kepler solver, instead of one call per object to
+// SSPlanet::computeMinorPlanetPositionVelocity(). Elliptical orbits are solved two at a time
+// with a fixed number of iterations and no data-dependent branches; near-parabolic and
+// hyperbolic orbits are computed separately, with exactly the same code SSPlanet uses.
+// Like SSPlanet, objects in the Chebyshev ephemeris set with SSPlanet::useChebyshevEphemeris()
+// are computed from it rather than from their elements.
+
+#ifndef SSOrbitBatch_hpp
+#define SSOrbitBatch_hpp
+
+#include "SSPlanet.hpp"
+
+struct SSMPCOrbitTable;
+
+class SSOrbitBatch
+{
+protected:
+
+    // Elements of elliptical orbits, reorganized for the SIMD solver. For orbits which can't
+    // be solved that way, eccentricity and axes are zero, and _special lists their indices.
+
+    vector<double>      _t, _m, _mm;        // epoch (JED), mean anomaly at epoch (radians), mean motion (radians/day)
+    vector<double>      _e, _a, _b;         // eccentricity, semimajor axis, semiminor axis (AU)
+    vector<double>      _px, _py, _pz;      // unit vector toward periapse, in fundamental J2000 equatorial frame
+    vector<double>      _qx, _qy, _qz;      // unit vector 90 degrees ahead of periapse in orbit plane, in fundamental frame
+    vector<SSOrbit>     _orbits;            // original orbital elements, referred to J2000 ecliptic
+    vector<SSPlanetPtr> _planets;           // pointers to objects the batch was built from; null if orbit was added directly. Not owned!
+    vector<uint32_t>    _special;           // indices of orbits computed one at a time (near-parabolic, hyperbolic, or invalid)
+
+    vector<double>      _x, _y, _z;         // heliocentric positions in fundamental frame (AU), computed by computePositionVelocity()
+    vector<double>      _vx, _vy, _vz;      // heliocentric velocities in fundamental frame (AU/day), computed by computePositionVelocity()
+
+    void computeOne ( size_t k, double jde );
+
+public:
+
+    // Orbits with eccentricity below this are solved with the SIMD solver.
+    
+    static constexpr double kMaxBatchEccentricity = 0.95;
+    
+    SSOrbitBatch ( void );
+    SSOrbitBatch ( SSObjectArray &objects );
+
+    // add orbits to the batch; clear all orbits from the batch
+    
+    void reserve ( size_t n );
+    int add ( SSObjectArray &objects );
+    int add ( const SSMPCOrbitTable &table );
+    void add ( SSPlanetPtr pPlanet );
+    void add ( const SSOrbit &orbit );
+    void clear ( void );
+    size_t size ( void ) { return _orbits.size(); }
+    size_t numSpecial ( void ) { return _special.size(); }
+
+    // Compute positions and velocities of all orbits at a Julian Ephemeris Date (jde).
+    // If (lt) is not null, it points to one light time in days per orbit, which is subtracted from jde.
+
+    void computePositionVelocity ( double jde, const double *lt = nullptr );
+    void computePositionVelocity ( double jde, const double *lt, size_t first, size_t count );
+
+    // per-orbit accessors for results of computePositionVelocity()
+
+    SSPlanetPtr getPlanet ( size_t i ) { return _planets[i]; }
+    const SSOrbit &getOrbit ( size_t i ) { return _orbits[i]; }
+    SSVector getPosition ( size_t i ) { return SSVector ( _x[i], _y[i], _z[i] ); }
+    SSVector getVelocity ( size_t i ) { return SSVector ( _vx[i], _vy[i], _vz[i] ); }
+
+    // raw array accessors for consumers of results in bulk
+
+    const double *getPositionX ( void ) { return _x.data(); }
+    const double *getPositionY ( void ) { return _y.data(); }
+    const double *getPositionZ ( void ) { return _z.data(); }
+    const double *getVelocityX ( void ) { return _vx.data(); }
+    const double *getVelocityY ( void ) { return _vy.data(); }
+    const double *getVelocityZ ( void ) { return _vz.data(); }
+};
+
+#endif /* SSOrbitBatch_hpp */
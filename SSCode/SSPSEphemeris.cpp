@@ -161,7 +161,7 @@ SSSpherical SSPSEphemeris::neptune ( double jed, SSVector &pos, SSVector &vel )
 // of AU and AU per day. Returns equivalent heliocentric spherical coordinates:
 // ecliptic longitude and latitude in radians, and heliocentic distance in AU.
 // The formulae below are a curve-fit to numerical integration, and are valid
-// from about 1800 to 2100. Pluto's velocity is not computed.
+// from about 1800 to 2100. Pluto's velocity is not computed; it's returned as zero.
 
 SSSpherical SSPSEphemeris::pluto ( double jed, SSVector &pos, SSVector &vel )
 {
@@ -194,6 +194,7 @@ SSSpherical SSPSEphemeris::pluto ( double jed, SSVector &pos, SSVector &vel )
 
     SSSpherical ecl ( lonecl, latecl, r );
     pos = SSVector ( ecl );
+    vel = SSVector ( 0.0, 0.0, 0.0 );
     return ecl;
 }
 
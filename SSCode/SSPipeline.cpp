@@ -0,0 +1,203 @@
+// SSPipeline.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A small dependency-graph task runner, and the star catalog build pipeline.
+// See SSPipeline.hpp for an overview.
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <algorithm>
+
+#include "SSPipeline.hpp"
+#include "SSCoordinates.hpp"
+#include "SSImportHIP.hpp"
+#include "SSImportGJ.hpp"
+#include "SSImportSKY2000.hpp"
+
+SSPipeline::SSPipeline ( void )
+{
+    _seconds = 0.0;
+}
+
+int SSPipeline::addStage ( const string &name, function<int(void)> work, const vector<int> &inputs )
+{
+    int index = (int) _stages.size();
+    for ( int input : inputs )
+        if ( input < 0 || input >= index )
+            throw invalid_argument ( "SSPipeline stage " + name + " has invalid input" );
+
+    _stages.push_back ( { name, work, inputs, 0, 0.0, 0.0 } );
+    return index;
+}
+
+double SSPipeline::run ( int threads )
+{
+    int n = (int) _stages.size();
+    double start = clocksec();
+
+    if ( threads < 1 )
+        threads = max ( 1u, thread::hardware_concurrency() );
+
+    threads = min ( threads, max ( n, 1 ) );
+
+    // For each stage, count inputs which haven't finished yet, and list stages which use it as an input.
+
+    vector<int> waiting ( n, 0 );
+    vector<vector<int>> outputs ( n );
+    for ( int i = 0; i < n; i++ )
+    {
+        waiting[i] = (int) _stages[i].inputs.size();
+        for ( int input : _stages[i].inputs )
+            outputs[input].push_back ( i );
+    }
+
+    vector<bool> failed ( n, false );
+    exception_ptr error = nullptr;
+
+    mutex lock;
+    condition_variable changed;
+    deque<int> ready;
+    int finished = 0;
+
+    for ( int i = 0; i < n; i++ )
+        if ( waiting[i] == 0 )
+            ready.push_back ( i );
+
+    // Each worker takes the lowest-numbered ready stage, runs it, then makes any stages
+    // whose inputs are now all finished ready. A stage whose inputs failed is skipped.
+
+    auto worker = [&]()
+    {
+        unique_lock<mutex> guard ( lock );
+
+        while ( finished < n )
+        {
+            if ( ready.empty() )
+            {
+                changed.wait ( guard );
+                continue;
+            }
+
+            auto next = min_element ( ready.begin(), ready.end() );
+            int i = *next;
+            ready.erase ( next );
+
+            Stage &stage = _stages[i];
+            bool skip = false;
+            for ( int input : stage.inputs )
+                skip = skip || failed[input];
+
+            guard.unlock();
+
+            stage.start = clocksec() - start;
+            stage.result = 0;
+            bool ok = ! skip;
+            exception_ptr e = nullptr;
+
+            if ( ! skip && stage.work )
+            {
+                try
+                {
+                    stage.result = stage.work();
+                }
+                catch ( ... )
+                {
+                    e = current_exception();
+                    ok = false;
+                }
+            }
+
+            stage.seconds = clocksec() - start - stage.start;
+
+            guard.lock();
+
+            failed[i] = ! ok;
+            if ( e != nullptr && error == nullptr )
+                error = e;
+
+            for ( int output : outputs[i] )
+                if ( --waiting[output] == 0 )
+                    ready.push_back ( output );
+
+            finished++;
+            changed.notify_all();
+        }
+    };
+
+    vector<thread> pool;
+    for ( int t = 1; t < threads; t++ )
+        pool.push_back ( thread ( worker ) );
+
+    worker();
+    for ( thread &t : pool )
+        t.join();
+
+    _seconds = clocksec() - start;
+
+    if ( error != nullptr )
+        rethrow_exception ( error );
+
+    return _seconds;
+}
+
+string SSPipeline::report ( void )
+{
+    string str = format ( "%-28s %9s %9s %9s\n", "Stage", "Result", "Start", "Seconds" );
+
+    for ( Stage &stage : _stages )
+        str += format ( "%-28s %9d %9.3f %9.3f\n", stage.name.c_str(), stage.result, stage.start, stage.seconds );
+
+    str += format ( "%-28s %9s %9s %9.3f\n", "Total", "", "", _seconds );
+    return str;
+}
+
+// Adds all of the stages needed to build the SSCore star catalogs from the original catalog files
+// to a pipeline. Imported identifiers, names, and stars are stored in (catalogs), which must outlive
+// the pipeline's run. The stages and their inputs are:
+//
+//   HIP HR, Bayer, GCVS identifiers, HIP names, HIC, HIP2, IAU names, star names: none
+//   GJ CNS3 (reading the file only): none
+//   SKY2000 (reading the file only): IAU names
+//   HIP: HIP identifiers and names, HIC, HIP2
+//   GJ accurate coordinates: HIP
+//   GJ CNS3 cross-match: GJ CNS3, GJ accurate coordinates, star names
+//   SKY2000 cross-match: SKY2000, HIP, GJ CNS3 cross-match
+//
+// So the two largest files, HIP and SKY2000, are read at the same time, and the CNS3 file is read
+// while the Hipparcos catalogs are. Results are identical to importing everything serially.
+
+void SSMakeStarCatalogPipeline ( const SSStarCatalogFiles &files, SSStarCatalogs &cats, SSPipeline &pipeline )
+{
+    // Each stage returns zero without doing anything if its file path is empty.
+
+    auto stage = [&pipeline]( const string &name, const string &path, function<int(const char *)> work, const vector<int> &inputs )
+    {
+        return pipeline.addStage ( name, [path, work]() { return path.empty() ? 0 : work ( path.c_str() ); }, inputs );
+    };
+
+    int hr = stage ( "HIP HR identifiers", files.hipHRIdents, [&cats]( const char *path ) { return SSImportHIPHRIdentifiers ( path, cats.hipHRMap ); }, {} );
+    int bay = stage ( "HIP Bayer identifiers", files.hipBayerIdents, [&cats]( const char *path ) { return SSImportHIPBayerIdentifiers ( path, cats.hipBayMap ); }, {} );
+    int gcvs = stage ( "HIP GCVS identifiers", files.hipGCVSIdents, [&cats]( const char *path ) { return SSImportHIPGCVSIdentifiers ( path, cats.hipGCVSMap ); }, {} );
+    int names = stage ( "HIP names", files.hipNames, [&cats]( const char *path ) { return SSImportHIPNames ( path, cats.hipNames ); }, {} );
+    int hic = stage ( "HIC", files.hic, [&cats]( const char *path ) { return SSImportHIC ( path, cats.hicStars ); }, {} );
+    int hip2 = stage ( "HIP2", files.hip2, [&cats]( const char *path ) { return SSImportHIP2 ( path, cats.hip2Stars ); }, {} );
+    int iau = stage ( "IAU star names", files.iauNames, [&cats]( const char *path ) { return SSImportIAUStarNames ( path, cats.iauNames ); }, {} );
+    int starNames = stage ( "Star names", files.starNames, [&cats]( const char *path ) { return SSImportIdentifierNameMap ( path, cats.starNames ); }, {} );
+    int cns3 = stage ( "GJ CNS3", files.gjCNS3, [&cats]( const char *path ) { return SSImportGJCNS3 ( path, cats.gjStars ); }, {} );
+    int sky = stage ( "SKY2000", files.sky2000, [&cats]( const char *path ) { return SSImportSKY2000 ( path, cats.iauNames, cats.skyStars ); }, { iau } );
+
+    int hip = stage ( "HIP", files.hip, [&cats]( const char *path )
+    {
+        return SSImportHIP ( path, cats.hipHRMap, cats.hipBayMap, cats.hipGCVSMap, cats.hipNames, cats.hicStars, cats.hip2Stars, cats.hipStars );
+    }, { hr, bay, gcvs, names, hic, hip2 } );
+
+    int gjAC = stage ( "GJ accurate coordinates", files.gjAC, [&cats]( const char *path ) { return SSImportGJAC ( path, cats.hipStars, cats.gjACStars ); }, { hip } );
+
+    int cns3Match = pipeline.addStage ( "GJ CNS3 cross-match", [&cats]() { return SSMatchGJCNS3 ( cats.starNames, cats.gjACStars, cats.gjStars ); }, { cns3, gjAC, starNames } );
+    pipeline.addStage ( "SKY2000 cross-match", [&cats]() { return SSMatchSKY2000 ( cats.hipStars, cats.gjStars, cats.skyStars ); }, { sky, hip, cns3Match } );
+}
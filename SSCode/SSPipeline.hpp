@@ -0,0 +1,103 @@
+// SSPipeline.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A small dependency-graph task runner for multi-step jobs like catalog builds.
+// Each stage runs as soon as all of the stages it depends on have finished,
+// on a pool of threads, and the pipeline records how long each stage took.
+// Also includes a complete pipeline for building the SSCore star catalogs
+// from the original Hipparcos, SKY2000, and Gliese-Jahreiss catalog files.
+
+#ifndef SSPipeline_hpp
+#define SSPipeline_hpp
+
+#include <functional>
+
+#include "SSStar.hpp"
+
+class SSPipeline
+{
+public:
+
+    struct Stage
+    {
+        string name;                // stage name, for reporting
+        function<int(void)> work;   // does the stage's work; returns number of items produced
+        vector<int> inputs;         // indices of stages which must finish before this one starts
+        int result;                 // value returned by work(), after stage has run
+        double start;               // time when stage started, in seconds after pipeline started
+        double seconds;             // time stage took to run, in seconds
+    };
+
+protected:
+
+    vector<Stage> _stages;          // all stages, in the order they were added
+    double _seconds;                // total time taken by last call to run(), in seconds
+
+public:
+
+    SSPipeline ( void );
+
+    // Adds a stage which runs (work) after the stages whose indices are in (inputs).
+    // Inputs must have been added earlier. Returns index of new stage.
+
+    int addStage ( const string &name, function<int(void)> work, const vector<int> &inputs = {} );
+
+    // Runs all stages on up to (threads) threads, or as many threads as there are hardware
+    // cores if zero. If one, stages run serially on the calling thread in the order they were added.
+    // Returns after all stages have finished, with total time taken in seconds. If any stage
+    // throws an exception, stages which depend on it are skipped and the first exception is rethrown.
+
+    double run ( int threads = 0 );
+
+    const vector<Stage> &getStages ( void ) { return _stages; }
+    int getResult ( int stage ) { return _stages[stage].result; }
+    double getSeconds ( void ) { return _seconds; }
+
+    // Returns a table of stage names, results, start times and durations, one line per stage.
+
+    string report ( void );
+};
+
+// Paths to the original catalog files used to build the SSCore star catalogs.
+// Any file left empty is skipped, along with everything that needs it.
+
+struct SSStarCatalogFiles
+{
+    string hipHRIdents;         // Hipparcos HR identifiers, TABLES/IDENT3.DOC
+    string hipBayerIdents;      // Hipparcos Bayer/Flamsteed identifiers, TABLES/IDENT4.DOC
+    string hipGCVSIdents;       // Hipparcos GCVS identifiers, TABLES/IDENT5.DOC
+    string hipNames;            // Hipparcos star names, TABLES/IDENT6.DOC
+    string hic;                 // Hipparcos Input Catalog, main.dat
+    string hip2;                // Hipparcos New Reduction 2007, hip2.dat
+    string hip;                 // Hipparcos main catalog, CATS/HIP_MAIN.DAT
+    string iauNames;            // IAU official star names, IAU-CSN.txt
+    string starNames;           // SSCore star names, SSData/Stars/Names.csv
+    string gjAC;                // GJ accurate coordinates, table1.dat
+    string gjCNS3;              // Gliese-Jahreiss Catalog of Nearby Stars, catalog.dat
+    string sky2000;             // SKY2000 Master Star Catalog, ATT_sky2kv5.cat
+};
+
+// Everything imported while building the star catalogs.
+
+struct SSStarCatalogs
+{
+    SSIdentifierMap hipHRMap;
+    SSIdentifierMap hipBayMap;
+    SSIdentifierMap hipGCVSMap;
+    SSIdentifierNameMap hipNames;
+    SSIdentifierNameMap iauNames;
+    SSIdentifierNameMap starNames;
+
+    SSObjectVec hicStars;
+    SSObjectVec hip2Stars;
+    SSObjectVec hipStars;
+    SSObjectVec gjACStars;
+    SSObjectVec gjStars;
+    SSObjectVec skyStars;
+};
+
+void SSMakeStarCatalogPipeline ( const SSStarCatalogFiles &files, SSStarCatalogs &catalogs, SSPipeline &pipeline );
+
+#endif /* SSPipeline_hpp */
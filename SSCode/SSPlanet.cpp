@@ -8,6 +8,7 @@
 #include "SSPlanet.hpp"
 #include "SSPSEphemeris.hpp"
 #include "SSJPLDEphemeris.hpp"
+#include "SSChebyshevEphemeris.hpp"
 #include "SSMoonEphemeris.hpp"
 #include "SSTLE.hpp"
 
@@ -29,10 +30,13 @@
 #include "VSOP2013.hpp"
 #include "ELPMPP02.hpp"
 static bool _useVSOPELP = true;
-static VSOP2013 _vsop;
+static int _vsopelpGeneration = 0;
+static thread_local VSOP2013 _vsop;     // per-thread, because VSOP2013 keeps intermediate results in member variables
 static ELPMPP02 _elp;
 #endif
 
+static SSChebyshevEphemeris *_pChebyshev = nullptr;
+
 SSPlanet::SSPlanet ( SSObjectType type ) : SSObject ( type )
 {
     _id = SSIdentifier();
@@ -114,8 +118,10 @@ void SSPlanet::computeMajorPlanetPositionVelocity ( int id, double jed, double l
 
 void SSPlanet::computePSPlanetMoonPositionVelocity ( int id, double jed, double lt, SSVector &pos, SSVector &vel )
 {
-    static double orbMatJED = 0.0;
-    static SSMatrix orbMat;
+    // Orbital-to-equatorial matrix is cached per-thread, so this is safe to call concurrently.
+
+    static thread_local double orbMatJED = 0.0;
+    static thread_local SSMatrix orbMat;
     
     if ( jed != orbMatJED )
     {
@@ -162,9 +168,14 @@ void SSPlanet::computePSPlanetMoonPositionVelocity ( int id, double jed, double
 // Current time (jed) is Julian Ephemeris Date in dynamic time (TDT), not civil time (UTC).
 // Light travel time to object (lt) is in days; may be zero for first approximation.
 // Returned position (pos) and velocity (vel) vectors are both in fundamental J2000 equatorial frame.
+// Uses precomputed Chebyshev ephemeris instead of orbital elements if one is in use and covers (jed).
+// Objects whose identifiers are shared, like comet fragments, are never in one, so use their own elements.
 
 void SSPlanet::computeMinorPlanetPositionVelocity ( double jed, double lt, SSVector &pos, SSVector &vel )
 {
+    if ( _pChebyshev && _pChebyshev->compute ( _id, jed - lt, pos, vel ) )
+        return;
+
     static SSMatrix matrix = SSCoordinates::getEclipticMatrix ( SSCoordinates::getObliquity ( SSTime::kJ2000 ) );
     _orbit.toPositionVelocity ( jed - lt, pos, vel );
     pos = matrix.multiply ( pos );
@@ -178,8 +189,12 @@ void SSPlanet::computeMinorPlanetPositionVelocity ( double jed, double lt, SSVec
 
 void SSPlanet::computeMoonPositionVelocity ( double jed, double lt, SSVector &pos, SSVector &vel )
 {
-    static SSVector primaryPos[10], primaryVel[10];
-    static double primaryJED[10] = { 0.0 };
+    // Primary planet positions are cached per-thread, so this is safe to call concurrently.
+    // They're recomputed when the major planet ephemeris changes, not just the time.
+
+    static thread_local SSVector primaryPos[10], primaryVel[10];
+    static thread_local double primaryJED[10] = { 0.0 };
+    static thread_local int primaryGen[10] = { 0 };
 
     // Get moona and primary planet identifier.
     
@@ -236,12 +251,14 @@ void SSPlanet::computeMoonPositionVelocity ( double jed, double lt, SSVector &po
             computeMinorPlanetPositionVelocity ( jed, lt, pos, vel );
     }
     
-    // If JED has changed since last time we computed primary's position and velocity, recompute them.
+    // If JED or ephemeris has changed since last time we computed primary's position and velocity, recompute them.
     
-    if ( jed != primaryJED[p] )
+    int gen = getEphemerisGeneration();
+    if ( jed != primaryJED[p] || gen != primaryGen[p] )
     {
         computeMajorPlanetPositionVelocity ( p, jed, 0.0, primaryPos[p], primaryVel[p] );
         primaryJED[p] = jed;
+        primaryGen[p] = gen;
     }
     
     // Add primary's position (antedated for light time) and velocity to moon's position and velocity.
@@ -459,7 +476,7 @@ string SSPlanet::toCSV ( void )
     csv += _id ? _id.toString() + "," : ",";
         
     for ( int i = 0; i < _names.size(); i++ )
-        csv += _names[i] + ",";
+        csv += getName ( i ) + ",";
 
     return csv;
 }
@@ -469,8 +486,17 @@ string SSPlanet::toCSV ( void )
 
 SSObjectPtr SSPlanet::fromCSV ( string csv )
 {
-    vector<string> fields = split ( csv, "," );
-    
+    vector<SSStringView> fields;
+    split ( csv, ',', fields );
+    return fromCSV ( fields );
+}
+
+// Allocates a new SSPlanet and initializes it from a CSV-formatted string which has already
+// been split into fields, without copying them. Returns nullptr on error, like fromCSV ( string ).
+// The planet is allocated in an arena (pArena) if not null, as with SSNewObject().
+
+SSObjectPtr SSPlanet::fromCSV ( vector<SSStringView> &fields, SSObjectArena *pArena )
+{
     SSObjectType type = SSObject::codeToType ( fields[0] );
     if ( type < kTypePlanet || type > kTypeComet || fields.size() < 14 )
         return nullptr;
@@ -497,13 +523,13 @@ SSObjectPtr SSPlanet::fromCSV ( string csv )
     if ( type == kTypePlanet || type == kTypeMoon )
         ident = SSIdentifier ( kCatJPLanet, strtoint ( fields[12] ) );
     else
-        ident = SSIdentifier::fromString ( fields[12] );
+        ident = SSIdentifier::fromString ( fields[12].str() );
 
     vector<string> names;
     for ( int i = 13; i < fields.size(); i++ )
-        names.push_back ( trim ( fields[i] ) );
+        names.push_back ( trim ( fields[i] ).str() );
     
-	SSObjectPtr pObject = SSNewObject ( type );
+	SSObjectPtr pObject = SSNewObject ( type, pArena );
     SSPlanetPtr pPlanet = SSGetPlanetPtr ( pObject );
     if ( pPlanet == nullptr )
         return nullptr;
@@ -524,8 +550,7 @@ SSSatellite::SSSatellite ( SSTLE &tle ) : SSPlanet ( kTypeSatellite )
 {
     _tle = tle;
 
-    _names.push_back ( tle.name );
-    _names.push_back ( tle.desig );
+    setNames ( { tle.name, tle.desig } );
     
     _id = SSIdentifier ( kCatNORADSat, tle.norad );
     
@@ -565,9 +590,11 @@ float SSSatellite::computeMagnitude ( double rad, double dist, double phase )
 
 void SSSatellite::computePositionVelocity ( double jed, double lt, SSVector &pos, SSVector &vel )
 {
-    static SSVector earthPos, earthVel;
-    static SSMatrix earthMat;
-    static double earthJED = 0.0, deltaT = 0.0;
+    // Earth position and precession matrix are cached per-thread, so this is safe to call concurrently.
+
+    static thread_local SSVector earthPos, earthVel;
+    static thread_local SSMatrix earthMat;
+    static thread_local double earthJED = 0.0, deltaT = 0.0;
     
     // Recompute Earth's position and velocity relative to Sun if JED has changed.
     // Asssume Earth's velocity is constant over light time duration.
@@ -842,6 +869,8 @@ int SSImportSatelliteFrequencyData ( const string &filename, SSObjectVec &object
 
 void SSPlanet::useVSOPELP ( bool use )
 {
+    if ( use != _useVSOPELP )
+        _vsopelpGeneration++;
     _useVSOPELP = use;
 }
 
@@ -863,6 +892,29 @@ bool SSPlanet::useVSOPELP ( void )
 
 #endif
 
+int SSPlanet::getEphemerisGeneration ( void )
+{
+#if USE_VSOP_ELP
+    return SSJPLDEphemeris::getGeneration() + _vsopelpGeneration;
+#else
+    return SSJPLDEphemeris::getGeneration();
+#endif
+}
+
+// Sets or clears the precomputed Chebyshev ephemeris used for asteroids and comets.
+
+void SSPlanet::useChebyshevEphemeris ( SSChebyshevEphemeris *pEphem )
+{
+    _pChebyshev = pEphem;
+}
+
+// Returns the precomputed Chebyshev ephemeris in use, or null if none.
+
+SSChebyshevEphemeris *SSPlanet::getChebyshevEphemeris ( void )
+{
+    return _pChebyshev;
+}
+
 // Calculates planet's rotational elements at the specified Julian Ephemeris Date (jed).
 // Returns J2000 right ascension (a0) and declination (d0) of planet's north pole in radians;
 // argument of planet's prime meridian (w) and rotation rate (wd) in radians and rad/day.
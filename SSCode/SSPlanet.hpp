@@ -16,6 +16,8 @@
 #include "SSCoordinates.hpp"
 #include "SSTLE.hpp"
 
+class SSChebyshevEphemeris;
+
 enum SSPlanetID
 {
     kSun = 0,
@@ -128,6 +130,19 @@ public:
     
     static void useVSOPELP ( bool use );
     static bool useVSOPELP ( void );
+
+    // Returns a number which changes whenever the source of major planet positions changes,
+    // i.e. a JPL ephemeris file is opened or closed, or VSOP/ELP is turned on or off.
+
+    static int getEphemerisGeneration ( void );
+
+    // Sets a precomputed Chebyshev ephemeris to compute asteroid and comet positions from, instead of their
+    // orbital elements, for objects and dates it covers; or null to stop using one. The ephemeris is not
+    // copied and must stay open while in use! Set this before computing positions on other threads.
+
+    static void useChebyshevEphemeris ( SSChebyshevEphemeris *pEphem );
+    static SSChebyshevEphemeris *getChebyshevEphemeris ( void );
+
     double flattening ( void );
 
     static void computeMajorPlanetPositionVelocity ( int id, double jed, double lt, SSVector &pos, SSVector &vel );
@@ -142,6 +157,7 @@ public:
     // imports/exports from/to CSV-format text string
     
     static SSObjectPtr fromCSV ( string csv );
+    static SSObjectPtr fromCSV ( vector<SSStringView> &fields, SSObjectArena *pArena = nullptr );
     string toCSV ( void );
 };
 
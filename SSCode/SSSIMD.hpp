@@ -0,0 +1,206 @@
+// SSSIMD.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A minimal, header-only wrapper around two-lane double-precision SIMD registers.
+// Uses SSE2 on x86/x64, NEON on 64-bit ARM, and plain scalar code everywhere else,
+// so kernels written with it compile unchanged on every platform SSCore supports.
+// All operations are IEEE-754 exact (add, subtract, multiply, divide, square root),
+// so SIMD kernels produce bit-identical results to equivalent scalar code.
+
+#ifndef SSSIMD_hpp
+#define SSSIMD_hpp
+
+#include <math.h>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SS_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined ( __ARM_NEON ) && defined ( __aarch64__ )
+#define SS_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define SS_SIMD_NONE 1
+#endif
+
+// Represents a pair of lane-wise comparison results; each lane is all ones (true) or all zeros (false).
+
+struct SSMask2
+{
+#if SS_SIMD_SSE2
+    __m128d m;
+#elif SS_SIMD_NEON
+    uint64x2_t m;
+#else
+    bool m[2];
+#endif
+};
+
+// Represents a pair of double-precision values which are operated on together.
+
+struct SSDouble2
+{
+#if SS_SIMD_SSE2
+    __m128d v;
+#elif SS_SIMD_NEON
+    float64x2_t v;
+#else
+    double v[2];
+#endif
+
+    // Loads two consecutive doubles from memory (p), which need not be aligned.
+
+    static inline SSDouble2 load ( const double *p )
+    {
+        SSDouble2 r;
+#if SS_SIMD_SSE2
+        r.v = _mm_loadu_pd ( p );
+#elif SS_SIMD_NEON
+        r.v = vld1q_f64 ( p );
+#else
+        r.v[0] = p[0]; r.v[1] = p[1];
+#endif
+        return r;
+    }
+
+    // Loads two consecutive floats from memory (p) and widens them to double.
+
+    static inline SSDouble2 load ( const float *p )
+    {
+        SSDouble2 r;
+#if SS_SIMD_SSE2
+        r.v = _mm_set_pd ( p[1], p[0] );
+#elif SS_SIMD_NEON
+        r.v = vcvt_f64_f32 ( vld1_f32 ( p ) );
+#else
+        r.v[0] = p[0]; r.v[1] = p[1];
+#endif
+        return r;
+    }
+
+    // Returns a pair with values (a) in lane 0 and (b) in lane 1.
+
+    static inline SSDouble2 set ( double a, double b )
+    {
+        SSDouble2 r;
+#if SS_SIMD_SSE2
+        r.v = _mm_set_pd ( b, a );
+#elif SS_SIMD_NEON
+        r.v = vsetq_lane_f64 ( b, vdupq_n_f64 ( a ), 1 );
+#else
+        r.v[0] = a; r.v[1] = b;
+#endif
+        return r;
+    }
+
+    // Returns a pair with the same value (d) in both lanes.
+
+    static inline SSDouble2 splat ( double d )
+    {
+        SSDouble2 r;
+#if SS_SIMD_SSE2
+        r.v = _mm_set1_pd ( d );
+#elif SS_SIMD_NEON
+        r.v = vdupq_n_f64 ( d );
+#else
+        r.v[0] = r.v[1] = d;
+#endif
+        return r;
+    }
+
+    // Stores both lanes to two consecutive doubles in memory (p), which need not be aligned.
+
+    inline void store ( double *p ) const
+    {
+#if SS_SIMD_SSE2
+        _mm_storeu_pd ( p, v );
+#elif SS_SIMD_NEON
+        vst1q_f64 ( p, v );
+#else
+        p[0] = v[0]; p[1] = v[1];
+#endif
+    }
+
+    // Returns the value in one lane (i = 0 or 1).
+
+    inline double lane ( int i ) const
+    {
+        double d[2];
+        store ( d );
+        return d[i];
+    }
+};
+
+// Lane-wise arithmetic operators.
+
+#if SS_SIMD_SSE2
+
+inline SSDouble2 operator + ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = _mm_add_pd ( a.v, b.v ); return r; }
+inline SSDouble2 operator - ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = _mm_sub_pd ( a.v, b.v ); return r; }
+inline SSDouble2 operator * ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = _mm_mul_pd ( a.v, b.v ); return r; }
+inline SSDouble2 operator / ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = _mm_div_pd ( a.v, b.v ); return r; }
+inline SSDouble2 sqrt ( SSDouble2 a ) { SSDouble2 r; r.v = _mm_sqrt_pd ( a.v ); return r; }
+inline SSDouble2 min ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = _mm_min_pd ( a.v, b.v ); return r; }
+inline SSDouble2 max ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = _mm_max_pd ( a.v, b.v ); return r; }
+
+inline SSMask2 operator == ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m = _mm_cmpeq_pd ( a.v, b.v ); return r; }
+inline SSMask2 operator < ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m = _mm_cmplt_pd ( a.v, b.v ); return r; }
+inline SSMask2 operator > ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m = _mm_cmpgt_pd ( a.v, b.v ); return r; }
+inline SSMask2 operator && ( SSMask2 a, SSMask2 b ) { SSMask2 r; r.m = _mm_and_pd ( a.m, b.m ); return r; }
+inline SSMask2 operator || ( SSMask2 a, SSMask2 b ) { SSMask2 r; r.m = _mm_or_pd ( a.m, b.m ); return r; }
+
+// Returns a where mask is true, and b where it is false.
+
+inline SSDouble2 select ( SSMask2 mask, SSDouble2 a, SSDouble2 b )
+{
+    SSDouble2 r;
+    r.v = _mm_or_pd ( _mm_and_pd ( mask.m, a.v ), _mm_andnot_pd ( mask.m, b.v ) );
+    return r;
+}
+
+// Returns bit 0 set if lane 0 is true, and bit 1 set if lane 1 is true.
+
+inline int bits ( SSMask2 mask ) { return _mm_movemask_pd ( mask.m ); }
+
+#elif SS_SIMD_NEON
+
+inline SSDouble2 operator + ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = vaddq_f64 ( a.v, b.v ); return r; }
+inline SSDouble2 operator - ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = vsubq_f64 ( a.v, b.v ); return r; }
+inline SSDouble2 operator * ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = vmulq_f64 ( a.v, b.v ); return r; }
+inline SSDouble2 operator / ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = vdivq_f64 ( a.v, b.v ); return r; }
+inline SSDouble2 sqrt ( SSDouble2 a ) { SSDouble2 r; r.v = vsqrtq_f64 ( a.v ); return r; }
+inline SSDouble2 min ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = vminq_f64 ( a.v, b.v ); return r; }
+inline SSDouble2 max ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = vmaxq_f64 ( a.v, b.v ); return r; }
+
+inline SSMask2 operator == ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m = vceqq_f64 ( a.v, b.v ); return r; }
+inline SSMask2 operator < ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m = vcltq_f64 ( a.v, b.v ); return r; }
+inline SSMask2 operator > ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m = vcgtq_f64 ( a.v, b.v ); return r; }
+inline SSMask2 operator && ( SSMask2 a, SSMask2 b ) { SSMask2 r; r.m = vandq_u64 ( a.m, b.m ); return r; }
+inline SSMask2 operator || ( SSMask2 a, SSMask2 b ) { SSMask2 r; r.m = vorrq_u64 ( a.m, b.m ); return r; }
+
+inline SSDouble2 select ( SSMask2 mask, SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v = vbslq_f64 ( mask.m, a.v, b.v ); return r; }
+inline int bits ( SSMask2 mask ) { return (int) ( vgetq_lane_u64 ( mask.m, 0 ) & 1 ) | (int) ( ( vgetq_lane_u64 ( mask.m, 1 ) & 1 ) << 1 ); }
+
+#else
+
+inline SSDouble2 operator + ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v[0] = a.v[0] + b.v[0]; r.v[1] = a.v[1] + b.v[1]; return r; }
+inline SSDouble2 operator - ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v[0] = a.v[0] - b.v[0]; r.v[1] = a.v[1] - b.v[1]; return r; }
+inline SSDouble2 operator * ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v[0] = a.v[0] * b.v[0]; r.v[1] = a.v[1] * b.v[1]; return r; }
+inline SSDouble2 operator / ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v[0] = a.v[0] / b.v[0]; r.v[1] = a.v[1] / b.v[1]; return r; }
+inline SSDouble2 sqrt ( SSDouble2 a ) { SSDouble2 r; r.v[0] = ::sqrt ( a.v[0] ); r.v[1] = ::sqrt ( a.v[1] ); return r; }
+inline SSDouble2 min ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v[0] = a.v[0] < b.v[0] ? a.v[0] : b.v[0]; r.v[1] = a.v[1] < b.v[1] ? a.v[1] : b.v[1]; return r; }
+inline SSDouble2 max ( SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v[0] = a.v[0] > b.v[0] ? a.v[0] : b.v[0]; r.v[1] = a.v[1] > b.v[1] ? a.v[1] : b.v[1]; return r; }
+
+inline SSMask2 operator == ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m[0] = a.v[0] == b.v[0]; r.m[1] = a.v[1] == b.v[1]; return r; }
+inline SSMask2 operator < ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m[0] = a.v[0] < b.v[0]; r.m[1] = a.v[1] < b.v[1]; return r; }
+inline SSMask2 operator > ( SSDouble2 a, SSDouble2 b ) { SSMask2 r; r.m[0] = a.v[0] > b.v[0]; r.m[1] = a.v[1] > b.v[1]; return r; }
+inline SSMask2 operator && ( SSMask2 a, SSMask2 b ) { SSMask2 r; r.m[0] = a.m[0] && b.m[0]; r.m[1] = a.m[1] && b.m[1]; return r; }
+inline SSMask2 operator || ( SSMask2 a, SSMask2 b ) { SSMask2 r; r.m[0] = a.m[0] || b.m[0]; r.m[1] = a.m[1] || b.m[1]; return r; }
+
+inline SSDouble2 select ( SSMask2 mask, SSDouble2 a, SSDouble2 b ) { SSDouble2 r; r.v[0] = mask.m[0] ? a.v[0] : b.v[0]; r.v[1] = mask.m[1] ? a.v[1] : b.v[1]; return r; }
+inline int bits ( SSMask2 mask ) { return ( mask.m[0] ? 1 : 0 ) | ( mask.m[1] ? 2 : 0 ); }
+
+#endif
+
+#endif /* SSSIMD_hpp */
@@ -0,0 +1,584 @@
+// SSSearch.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// An index for finding objects by name or catalog designation, with prefix completion
+// and ranked fuzzy matching. See SSSearch.hpp for an overview.
+
+#include <string.h>
+#include <algorithm>
+
+#include "SSSearch.hpp"
+#include "SSStar.hpp"
+#include "SSPlanet.hpp"
+
+// Returns true if (c) is kept in normalized strings: ASCII letters and digits,
+// and all bytes of multi-byte UTF-8 characters, so non-English names still work.
+
+static bool keepChar ( unsigned char c )
+{
+    return ( c >= '0' && c <= '9' ) || ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c >= 0x80;
+}
+
+string SSSearchIndex::normalize ( const string &str )
+{
+    string key;
+    key.reserve ( str.length() );
+
+    for ( unsigned char c : str )
+        if ( keepChar ( c ) )
+            key.push_back ( c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c );
+
+    return key;
+}
+
+SSSearchIndex::SSSearchIndex ( void )
+{
+    _maxKeyLen = 0;
+    _lcpLeaves = 0;
+}
+
+SSSearchIndex::SSSearchIndex ( SSObjectVec &objects )
+{
+    build ( objects );
+}
+
+void SSSearchIndex::clear ( void )
+{
+    _entries.clear();
+    _keys.clear();
+    _labels.clear();
+    _objects.clear();
+    _maxKeyLen = 0;
+    _lcpLeaves = 0;
+    _lcpTree.clear();
+    _tree.clear();
+}
+
+// Adds an entry for string (str) pointing to object index (object) with the given rank.
+// If (words) is true, also adds entries for each word after the first, so "Alpha Centauri" can be
+// found by typing "cen", and "C/2020 F3 (NEOWISE)" by typing "neo". Apostrophes don't start words,
+// so "Barnard's Star" is not found by typing "s". A word's key is just the end of the whole string's
+// key, since normalizing the end of a string gives the end of its normalized key.
+
+void SSSearchIndex::addEntry ( const string &str, int object, int rank, bool words )
+{
+    string key = normalize ( str );
+    if ( key.empty() || key.length() > UINT16_MAX || str.length() > UINT16_MAX )
+        return;
+
+    Entry entry;
+    entry.key = (uint32_t) _keys.length();
+    entry.keyLen = (uint16_t) key.length();
+    _keys.append ( key );
+    entry.label = (uint32_t) _labels.length();
+    entry.labelLen = (uint16_t) str.length();
+    _labels.append ( str );
+    entry.object = object;
+    entry.rank = rank;
+    _entries.push_back ( entry );
+    _maxKeyLen = max ( _maxKeyLen, key.length() );
+
+    if ( ! words )
+        return;
+
+    // (n) counts characters of the normalized key which precede position (i) in the original string.
+
+    size_t n = 0;
+    for ( size_t i = 0; i < str.length(); i++ )
+    {
+        if ( ! keepChar ( str[i] ) )
+            continue;
+
+        if ( i > 0 && n > 0 && ! keepChar ( str[i - 1] ) && str[i - 1] != '\'' )
+        {
+            Entry word = entry;
+            word.key += n;
+            word.keyLen -= n;
+            word.rank = 3;
+            _entries.push_back ( word );
+        }
+
+        n++;
+    }
+}
+
+// Builds the index from all names and identifiers of all objects in an array.
+// Bayer identifiers are indexed both with the full Greek letter name ("alpha CMa"),
+// and with its standard three-letter abbreviation ("alp CMa"). JPL planet numbers
+// are not indexed, since they would swamp searches for small numbers.
+
+void SSSearchIndex::build ( SSObjectVec &objects )
+{
+    clear();
+    _objects.reserve ( objects.size() );
+    _entries.reserve ( objects.size() * 3 );
+
+    for ( int i = 0; i < objects.size(); i++ )
+    {
+        SSObjectPtr pObj = objects[i];
+        _objects.push_back ( pObj );
+        if ( pObj == nullptr )
+            continue;
+
+        vector<string> names = pObj->getNames();
+        for ( int k = 0; k < names.size(); k++ )
+            addEntry ( names[k], i, k == 0 ? 0 : 1, true );
+
+        SSIdentifierVec idents;
+        SSStarPtr pStar = SSGetStarPtr ( pObj );
+        SSPlanetPtr pPlanet = SSGetPlanetPtr ( pObj );
+
+        if ( pStar != nullptr )
+            idents = pStar->getIdentifiers();
+        else if ( pPlanet != nullptr && pPlanet->getIdentifier() )
+            idents.push_back ( pPlanet->getIdentifier() );
+
+        for ( SSIdentifier ident : idents )
+        {
+            if ( ident.catalog() == kCatJPLanet )
+                continue;
+
+            string str = ident.toString();
+            addEntry ( str, i, 2, false );
+
+            if ( ident.catalog() == kCatBayer )
+            {
+                size_t len = 0;
+                while ( len < str.length() && str[len] >= 'a' && str[len] <= 'z' )
+                    len++;
+
+                if ( len > 3 )
+                    addEntry ( str.substr ( 0, 3 ) + str.substr ( len ), i, 2, false );
+            }
+        }
+    }
+
+    // Sort entries alphabetically by key; for equal keys, put better-ranked entries first.
+
+    const char *text = _keys.data();
+    sort ( _entries.begin(), _entries.end(), [text]( const Entry &a, const Entry &b )
+    {
+        int c = memcmp ( text + a.key, text + b.key, min ( a.keyLen, b.keyLen ) );
+        if ( c != 0 )
+            return c < 0;
+        if ( a.keyLen != b.keyLen )
+            return a.keyLen < b.keyLen;
+        if ( a.rank != b.rank )
+            return a.rank < b.rank;
+        return a.object < b.object;
+    } );
+
+    // Store length of prefix shared by adjacent keys in the leaves of a min-tree, so fuzzy matching
+    // can quickly skip over all keys with a common prefix. Unused leaves are zero. Then copy keys
+    // into sorted order, so searching reads them sequentially; adjacent identical keys are stored once.
+
+    size_t n = _entries.size();
+    for ( _lcpLeaves = 1; _lcpLeaves < n; _lcpLeaves *= 2 )
+        continue;
+
+    _lcpTree.assign ( 2 * _lcpLeaves, 0 );
+    uint8_t *lcp = &_lcpTree[ _lcpLeaves ];
+
+    string keys;
+    keys.reserve ( _keys.length() );
+
+    for ( size_t i = 0; i < n; i++ )
+    {
+        Entry &b = _entries[i];
+        if ( i > 0 )
+        {
+            const Entry &a = _entries[i - 1];
+            size_t len = min ( a.keyLen, b.keyLen ), k = 0;
+            while ( k < len && keys[ a.key + k ] == text[ b.key + k ] )
+                k++;
+
+            lcp[i] = (uint8_t) min ( k, (size_t) UINT8_MAX );
+            if ( k == a.keyLen && k == b.keyLen )
+            {
+                b.key = a.key;
+                continue;
+            }
+        }
+
+        uint32_t offset = (uint32_t) keys.length();
+        keys.append ( text + b.key, b.keyLen );
+        b.key = offset;
+    }
+
+    _keys.swap ( keys );
+    _keys.shrink_to_fit();
+
+    for ( size_t i = _lcpLeaves; i-- > 1; )
+        _lcpTree[i] = min ( _lcpTree[ 2 * i ], _lcpTree[ 2 * i + 1 ] );
+
+    // Build bottom-up segment tree: leaves are entry indices, and each parent is the better-ranked of its children.
+
+    _tree.assign ( 2 * n, 0 );
+    for ( size_t i = 0; i < n; i++ )
+        _tree[ n + i ] = (uint32_t) i;
+
+    for ( size_t i = n; i-- > 1; )
+        _tree[i] = bestEntry ( _tree[ 2 * i ], _tree[ 2 * i + 1 ] );
+}
+
+// Returns index of first entry after (i) whose key does not begin with the first (len) characters of entry i's key,
+// i.e. the first entry after i whose shared prefix length is less than (len). Climbs the min-tree from entry i+1 to the
+// first subtree which contains such an entry, then descends to its leftmost one, so this takes logarithmic time however
+// many entries are skipped. Since shared prefix lengths are clipped at 255, this may stop early for longer prefixes,
+// which is harmless.
+
+size_t SSSearchIndex::skipPrefix ( size_t i, size_t len ) const
+{
+    size_t n = _entries.size();
+    if ( i + 1 >= n )
+        return n;
+
+    size_t k = _lcpLeaves + i + 1;
+    while ( _lcpTree[k] >= len )
+    {
+        while ( k & 1 )
+            k /= 2;
+
+        if ( k == 0 )
+            return n;
+
+        k++;
+    }
+
+    while ( k < _lcpLeaves )
+    {
+        k *= 2;
+        if ( _lcpTree[k] >= len )
+            k++;
+    }
+
+    return min ( k - _lcpLeaves, n );
+}
+
+// Returns index of better-ranked entry, (a) or (b), for prefix completion: names before identifiers
+// before words within names, then shorter keys before longer ones, then objects in array order.
+// This matches better() for candidates at the same distance which match only a prefix.
+
+uint32_t SSSearchIndex::bestEntry ( uint32_t a, uint32_t b ) const
+{
+    const Entry &ea = _entries[a], &eb = _entries[b];
+
+    if ( ea.rank != eb.rank )
+        return ea.rank < eb.rank ? a : b;
+    if ( ea.keyLen != eb.keyLen )
+        return ea.keyLen < eb.keyLen ? a : b;
+    if ( ea.object != eb.object )
+        return ea.object < eb.object ? a : b;
+    return min ( a, b );
+}
+
+// Returns index of best-ranked entry in the range from (first) up to but not including (last),
+// which must not be empty.
+
+uint32_t SSSearchIndex::bestInRange ( size_t first, size_t last ) const
+{
+    size_t n = _entries.size();
+    uint32_t best = (uint32_t) first;
+
+    for ( first += n, last += n; first < last; first /= 2, last /= 2 )
+    {
+        if ( first & 1 )
+            best = bestEntry ( best, _tree[ first++ ] );
+        if ( last & 1 )
+            best = bestEntry ( best, _tree[ --last ] );
+    }
+
+    return best;
+}
+
+// Returns true if the entry's key begins with the (len) characters at (prefix).
+
+bool SSSearchIndex::startsWith ( const Entry &entry, const char *prefix, size_t len ) const
+{
+    return entry.keyLen >= len && memcmp ( _keys.data() + entry.key, prefix, len ) == 0;
+}
+
+// Returns true if candidate (a) should be listed before candidate (b): closer matches first,
+// then whole-key matches before prefixes, then names before identifiers before words within names,
+// then shorter keys before longer ones, and finally objects in array order.
+
+bool SSSearchIndex::better ( const Candidate &a, const Candidate &b ) const
+{
+    if ( a.distance != b.distance )
+        return a.distance < b.distance;
+    if ( a.complete != b.complete )
+        return a.complete;
+    if ( a.pEntry->rank != b.pEntry->rank )
+        return a.pEntry->rank < b.pEntry->rank;
+    if ( a.pEntry->keyLen != b.pEntry->keyLen )
+        return a.pEntry->keyLen < b.pEntry->keyLen;
+    return a.pEntry->object < b.pEntry->object;
+}
+
+// Adds a candidate to a list of the (maxResults) best candidates so far, kept sorted best first.
+// Each object appears in the list at most once, with its best-matching entry.
+
+void SSSearchIndex::addCandidate ( vector<Candidate> &top, const Candidate &cand, size_t maxResults ) const
+{
+    if ( maxResults == 0 )
+        return;
+
+    // If the list is full and the candidate is no better than the worst one in it,
+    // it's also no better than any entry for the same object which may already be there.
+
+    if ( top.size() >= maxResults && ! better ( cand, top.back() ) )
+        return;
+
+    auto compare = [this]( const Candidate &a, const Candidate &b ) { return better ( a, b ); };
+
+    for ( Candidate &other : top )
+    {
+        if ( other.pEntry->object == cand.pEntry->object )
+        {
+            if ( better ( cand, other ) )
+            {
+                other = cand;
+                sort ( top.begin(), top.end(), compare );
+            }
+            return;
+        }
+    }
+
+    if ( top.size() < maxResults )
+        top.push_back ( cand );
+    else
+        top.back() = cand;
+
+    sort ( top.begin(), top.end(), compare );
+}
+
+// Converts sorted list of candidates to search results.
+
+vector<SSSearchMatch> SSSearchIndex::toMatches ( const vector<Candidate> &top ) const
+{
+    vector<SSSearchMatch> matches;
+    matches.reserve ( top.size() );
+
+    for ( const Candidate &cand : top )
+    {
+        const Entry &entry = *cand.pEntry;
+        SSSearchMatch match;
+        match.pObject = _objects[ entry.object ];
+        match.index = entry.object;
+        match.text = _labels.substr ( entry.label, entry.labelLen );
+        match.distance = cand.distance;
+        match.complete = cand.complete;
+        matches.push_back ( match );
+    }
+
+    return matches;
+}
+
+// Finds the range of entries from (first) up to but not including (last) whose keys begin with
+// the (len) characters at (prefix). Returns false if there are none.
+
+bool SSSearchIndex::findPrefix ( const char *prefix, size_t len, size_t &first, size_t &last ) const
+{
+    const char *text = _keys.data();
+    auto compare = [text, len]( const Entry &entry, const char *prefix )
+    {
+        int c = memcmp ( text + entry.key, prefix, min ( (size_t) entry.keyLen, len ) );
+        return c != 0 ? c < 0 : entry.keyLen < len;
+    };
+
+    first = lower_bound ( _entries.begin(), _entries.end(), prefix, compare ) - _entries.begin();
+    if ( first >= _entries.size() || ! startsWith ( _entries[first], prefix, len ) )
+        return false;
+
+    last = skipPrefix ( first, len );
+    while ( last < _entries.size() && startsWith ( _entries[last], prefix, len ) )
+        last = skipPrefix ( last, len );
+
+    return true;
+}
+
+// Adds candidates for all entries whose keys begin with normalized query (key) to list of best candidates (top).
+// Matching entries are contiguous in the sorted array. Exact matches sort first, and are all added. The rest
+// are taken best-ranked first from the segment tree: each time we take the best entry in a range, we split
+// the range on either side of it, so we never examine more than a few entries per result, even when a short
+// prefix matches millions of keys.
+
+void SSSearchIndex::prefixCandidates ( const string &key, vector<Candidate> &top, size_t maxResults ) const
+{
+    size_t first = 0, last = 0;
+    if ( key.empty() || ! findPrefix ( key.data(), key.length(), first, last ) )
+        return;
+
+    while ( first < last && _entries[first].keyLen == key.length() )
+    {
+        addCandidate ( top, { 0, true, &_entries[first] }, maxResults );
+        first++;
+    }
+
+    if ( first == last )
+        return;
+
+    // Ranges of entries still to search, ordered so the one whose best entry ranks best is on top.
+
+    struct Range { size_t first, last; uint32_t best; };
+    auto worse = [this]( const Range &a, const Range &b ) { return bestEntry ( a.best, b.best ) != a.best; };
+    vector<Range> heap = { { first, last, bestInRange ( first, last ) } };
+
+    while ( heap.size() > 0 && top.size() < maxResults )
+    {
+        pop_heap ( heap.begin(), heap.end(), worse );
+        Range range = heap.back();
+        heap.pop_back();
+
+        addCandidate ( top, { 0, false, &_entries[ range.best ] }, maxResults );
+
+        if ( range.best > range.first )
+        {
+            heap.push_back ( { range.first, range.best, bestInRange ( range.first, range.best ) } );
+            push_heap ( heap.begin(), heap.end(), worse );
+        }
+
+        if ( range.best + 1 < range.last )
+        {
+            heap.push_back ( { range.best + 1, range.last, bestInRange ( range.best + 1, range.last ) } );
+            push_heap ( heap.begin(), heap.end(), worse );
+        }
+    }
+}
+
+// Adds candidates for all entries whose keys are within (maxDist) edits of normalized query (key).
+// This walks the sorted entries as if they were a trie. The edit distance matrix between the query
+// and the current key has one row per key character; rows for the prefix shared with the previous key
+// are reused. As soon as every value in a row exceeds (maxDist), no key with that prefix can match,
+// so we skip past all of them. Uses the optimal string alignment distance, i.e. Levenshtein
+// distance plus transpositions of adjacent characters, which are the most common typing errors.
+
+void SSSearchIndex::fuzzyCandidates ( const string &key, int maxDist, size_t exactPrefix, vector<Candidate> &top, size_t maxResults ) const
+{
+    size_t first = 0, last = _entries.size();
+    if ( key.empty() || maxDist < 0 || _entries.empty() )
+        return;
+
+    // If the first (exactPrefix) characters must match exactly, we only need to search keys which begin with them.
+
+    exactPrefix = min ( exactPrefix, key.length() );
+    if ( exactPrefix > 0 && ! findPrefix ( key.data(), exactPrefix, first, last ) )
+        return;
+
+    const char *text = _keys.data();
+    const char *q = key.data();
+    size_t m = key.length();
+    size_t cols = m + 1;
+
+    vector<int> rows ( ( _maxKeyLen + 1 ) * cols );
+    for ( size_t j = 0; j <= m; j++ )
+        rows[j] = (int) j;
+
+    const char *rowsKey = nullptr;      // key whose prefix the valid rows were computed for
+    size_t valid = 0;                   // number of valid rows after row zero
+
+    size_t i = first, n = last;
+    while ( i < n )
+    {
+        const Entry &entry = _entries[i];
+        const char *s = text + entry.key;
+        size_t len = entry.keyLen;
+
+        // Find how many rows we can reuse from the previous key.
+
+        size_t d = 0, limit = min ( valid, len );
+        while ( d < limit && s[d] == rowsKey[d] )
+            d++;
+
+        rowsKey = s;
+        valid = d;
+
+        // Compute remaining rows, stopping if one exceeds the maximum distance everywhere.
+
+        bool pruned = false;
+        while ( d < len )
+        {
+            d++;
+            int *row = &rows[ d * cols ];
+            const int *prev = row - cols;
+            char c = s[d - 1];
+            int rowMin = row[0] = (int) d;
+
+            for ( size_t j = 1; j <= m; j++ )
+            {
+                int v = min ( prev[j] + 1, row[j - 1] + 1 );
+                v = min ( v, prev[j - 1] + ( c == q[j - 1] ? 0 : 1 ) );
+                if ( d > 1 && j > 1 && c == q[j - 2] && s[d - 2] == q[j - 1] )
+                    v = min ( v, prev[ (ptrdiff_t) j - 2 - (ptrdiff_t) cols ] + 1 );
+                row[j] = v;
+                rowMin = min ( rowMin, v );
+            }
+
+            valid = d;
+            if ( rowMin > maxDist )
+            {
+                pruned = true;
+                break;
+            }
+        }
+
+        if ( pruned )
+        {
+            i = min ( skipPrefix ( i, d ), n );
+            continue;
+        }
+
+        int dist = rows[ len * cols + m ];
+        if ( dist <= maxDist )
+        {
+            addCandidate ( top, { dist, true, &entry }, maxResults );
+            i++;
+        }
+        else
+        {
+            // Skip any following entries with the same key, e.g. a common word in many names.
+
+            for ( i++; i < n && len <= UINT8_MAX && _entries[i].keyLen == len && _lcpTree[ _lcpLeaves + i ] >= len; i++ )
+                continue;
+        }
+    }
+}
+
+vector<SSSearchMatch> SSSearchIndex::completePrefix ( const string &prefix, size_t maxResults ) const
+{
+    vector<Candidate> top;
+    prefixCandidates ( normalize ( prefix ), top, maxResults );
+    return toMatches ( top );
+}
+
+vector<SSSearchMatch> SSSearchIndex::findFuzzy ( const string &query, int maxDistance, size_t maxResults, size_t exactPrefix ) const
+{
+    vector<Candidate> top;
+    fuzzyCandidates ( normalize ( query ), maxDistance, exactPrefix, top, maxResults );
+    return toMatches ( top );
+}
+
+// Combines prefix and fuzzy matching. Fuzzy matching is only used for queries of four or more
+// characters, allowing one edit for up to seven characters and two for longer queries; shorter
+// queries with typos match too many unrelated designations to be useful. It also assumes the first
+// character is typed correctly, as nearly all typos are later in the word. That keeps a fuzzy
+// search from visiting the top levels of the implicit trie under every other letter, which is
+// most of the work in a large, dense index. Finally, each wider search is only done if the
+// narrower ones found nothing: completions are shown while the query is a prefix of something,
+// and fuzzy matches ("did you mean?") only when it isn't.
+
+vector<SSSearchMatch> SSSearchIndex::search ( const string &query, size_t maxResults ) const
+{
+    string key = normalize ( query );
+    vector<Candidate> top;
+
+    prefixCandidates ( key, top, maxResults );
+
+    int maxDist = key.length() < 4 ? 0 : key.length() < 8 ? 1 : 2;
+    for ( int dist = 1; dist <= maxDist && top.empty(); dist++ )
+        fuzzyCandidates ( key, dist, 1, top, maxResults );
+
+    return toMatches ( top );
+}
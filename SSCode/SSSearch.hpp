@@ -0,0 +1,113 @@
+// SSSearch.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// An index for finding objects by name or catalog designation, as a user types them into
+// a search field. Names and identifier strings are normalized (case and whitespace-insensitive)
+// and kept in one sorted array, which works like an implicit trie. Prefix completion is a binary
+// search plus a range-minimum query for the best-ranked completions. Fuzzy matching walks the
+// array computing edit distances once per shared prefix, skipping whole subtrees of keys which
+// can't match. Both typically take well under a millisecond over a million names, so there's
+// no need to parse the query with SSIdentifier::fromString() or scan every object's names
+// on each keystroke.
+
+#ifndef SSSearch_hpp
+#define SSSearch_hpp
+
+#include "SSObject.hpp"
+
+// One search result.
+
+struct SSSearchMatch
+{
+    SSObjectPtr pObject;    // pointer to matching object
+    int         index;      // index of matching object in the object array the index was built from
+    string      text;       // name or identifier string which matched the query, e.g. "Betelgeuse", "HR 2061", "alp Ori"
+    int         distance;   // edit distance from query to matched text; zero for exact and prefix matches
+    bool        complete;   // true if query matched entire text, not just a prefix of it
+};
+
+class SSSearchIndex
+{
+protected:
+
+    // Each entry in the index is a normalized key string pointing to one object.
+    // Keys are stored in _keys, and labels (the original strings shown to the user) in _labels.
+
+    struct Entry
+    {
+        uint32_t    key;        // offset of normalized key string in _keys
+        uint32_t    label;      // offset of original name or identifier string in _labels
+        uint16_t    keyLen;     // length of normalized key string
+        uint16_t    labelLen;   // length of original string
+        int32_t     object;     // index of object in _objects
+        uint8_t     rank;       // kind of string: 0 = primary name, 1 = other name, 2 = identifier, 3 = word within name
+    };
+
+    // A candidate result, while searching.
+
+    struct Candidate
+    {
+        int         distance;   // edit distance from query
+        bool        complete;   // true if query matched the whole key
+        const Entry *pEntry;    // matching index entry
+    };
+
+    vector<Entry>       _entries;   // all entries, sorted by key
+    string              _keys;      // storage for all key strings, in the same order as entries
+    string              _labels;    // storage for all label strings
+    vector<SSObjectPtr> _objects;   // objects the index was built from
+    size_t              _maxKeyLen; // length of longest key
+    size_t              _lcpLeaves; // number of leaves in _lcpTree: smallest power of two >= number of entries
+    vector<uint8_t>     _lcpTree;   // min-tree whose leaves are the lengths of prefix each entry's key shares with the previous key, up to 255
+    vector<uint32_t>    _tree;      // segment tree giving best-ranked entry in any range of entries, for prefix completion
+
+    void addEntry ( const string &str, int object, int rank, bool words );
+    bool startsWith ( const Entry &entry, const char *prefix, size_t len ) const;
+    size_t skipPrefix ( size_t i, size_t len ) const;
+    bool findPrefix ( const char *prefix, size_t len, size_t &first, size_t &last ) const;
+    uint32_t bestEntry ( uint32_t a, uint32_t b ) const;
+    uint32_t bestInRange ( size_t first, size_t last ) const;
+    bool better ( const Candidate &a, const Candidate &b ) const;
+    void addCandidate ( vector<Candidate> &top, const Candidate &cand, size_t maxResults ) const;
+    void prefixCandidates ( const string &key, vector<Candidate> &top, size_t maxResults ) const;
+    void fuzzyCandidates ( const string &key, int maxDist, size_t exactPrefix, vector<Candidate> &top, size_t maxResults ) const;
+    vector<SSSearchMatch> toMatches ( const vector<Candidate> &top ) const;
+
+public:
+
+    SSSearchIndex ( void );
+    SSSearchIndex ( SSObjectVec &objects );
+
+    // Rebuilds index from an object array. Must be called again if the array is modified;
+    // the index stores pointers to the objects, but does not own them.
+
+    void build ( SSObjectVec &objects );
+    void clear ( void );
+
+    size_t size ( void ) const { return _entries.size(); }
+
+    // Returns best matches for a query, ranked: exact matches first, then prefix completions.
+    // If there are none, returns fuzzy matches for longer queries, closest first.
+    // This is what a search box should call on each keystroke.
+
+    vector<SSSearchMatch> search ( const string &query, size_t maxResults = 20 ) const;
+
+    // Returns objects with a name or identifier beginning with (prefix), best first.
+
+    vector<SSSearchMatch> completePrefix ( const string &prefix, size_t maxResults = 20 ) const;
+
+    // Returns objects with a name or identifier within (maxDistance) edits of (query), best first.
+    // Edits are insertions, deletions, substitutions, and transpositions of adjacent characters.
+    // If (exactPrefix) is nonzero, only matches whose first (exactPrefix) characters equal the query's
+    // are returned; this is much faster, particularly for two or more edits in a large index.
+
+    vector<SSSearchMatch> findFuzzy ( const string &query, int maxDistance = 2, size_t maxResults = 20, size_t exactPrefix = 0 ) const;
+
+    // Lowercases ASCII letters and removes spaces and punctuation, so "alp CMa", "ALP  cma", and "alpcma" all match.
+
+    static string normalize ( const string &str );
+};
+
+#endif /* SSSearch_hpp */
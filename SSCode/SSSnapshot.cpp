@@ -0,0 +1,492 @@
+// SSSnapshot.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// Reads and writes compact binary snapshots of entire object arrays.
+// A snapshot file starts with a fixed-size header, followed by one record per object.
+// Each record is a one-byte object type code, a four-byte payload length, and the payload.
+// All values are stored in the native byte order of the machine which wrote the file;
+// strings are stored as a two-byte length followed by that many bytes, without terminators.
+
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+
+#include "SSSnapshot.hpp"
+#include "SSPlanet.hpp"
+#include "SSStar.hpp"
+#include "SSConstellation.hpp"
+
+static const char kSnapshotMagic[8] = { 'S', 'S', 'C', 'O', 'R', 'E', 'O', 'B' };
+static const uint32_t kSnapshotByteOrder = 0x01020304;
+
+// Snapshot file header. Byte order mark lets readers reject files written on machines with different
+// endianness; total file size lets them reject truncated files before reading any records.
+
+struct SSSnapshotHeader
+{
+    char     magic[8];      // always kSnapshotMagic
+    uint32_t version;       // snapshot format version, kSSSnapshotVersion
+    uint32_t byteOrder;     // kSnapshotByteOrder, as written by the machine which created the file
+    uint64_t count;         // number of object records following the header
+    uint64_t size;          // total file size in bytes, including header
+};
+
+// Appends raw bytes of a fixed-size value (value) to a binary buffer (buf).
+
+template <class T> static void put ( string &buf, T value )
+{
+    buf.append ( (const char *) &value, sizeof ( T ) );
+}
+
+// Appends a string (str) to a binary buffer (buf) as a four-byte length followed by characters.
+
+static void putString ( string &buf, const string &str )
+{
+    put ( buf, (uint32_t) str.size() );
+    buf.append ( str.data(), str.size() );
+}
+
+static void putVector ( string &buf, const SSVector &vec )
+{
+    put ( buf, vec.x );
+    put ( buf, vec.y );
+    put ( buf, vec.z );
+}
+
+// Reads values sequentially from a block of binary snapshot data in memory.
+// Reading past the end of the block sets the error flag and returns zeros or empty strings,
+// so a truncated or corrupt record can never read outside the memory-mapped file.
+
+struct SSSnapshotReader
+{
+    const char *p;          // current read position
+    const char *end;        // end of readable data
+    bool error;             // set if an attempt was made to read past end
+
+    SSSnapshotReader ( const char *begin, const char *stop ) : p ( begin ), end ( stop ), error ( false ) { }
+
+    template <class T> T get ( void )
+    {
+        T value = T();
+        if ( end - p >= (ptrdiff_t) sizeof ( T ) )
+        {
+            memcpy ( &value, p, sizeof ( T ) );
+            p += sizeof ( T );
+        }
+        else
+        {
+            error = true;
+        }
+        return value;
+    }
+
+    // Reads the four-byte count of a list whose entries each take at least (minSize) bytes.
+    // Sets the error flag and returns zero if the rest of the data is too short to hold them,
+    // so a corrupt count can never make the caller allocate a huge list.
+
+    uint32_t getCount ( size_t minSize )
+    {
+        uint32_t count = get<uint32_t>();
+        if ( (size_t) ( end - p ) / minSize < count )
+        {
+            error = true;
+            count = 0;
+        }
+        return count;
+    }
+
+    string getString ( void )
+    {
+        uint32_t len = get<uint32_t>();
+        if ( (size_t) ( end - p ) < len )
+        {
+            error = true;
+            len = 0;
+        }
+        string str ( p, len );
+        p += len;
+        return str;
+    }
+
+    SSVector getVector ( void )
+    {
+        double x = get<double>();
+        double y = get<double>();
+        double z = get<double>();
+        return SSVector ( x, y, z );
+    }
+};
+
+// Appends an object's type-specific data to a binary buffer (buf).
+// The reader in getObject() must read exactly the same fields in exactly the same order!
+
+static void putObject ( string &buf, SSObjectPtr pObj )
+{
+    vector<string> names = pObj->getNames();
+
+    put ( buf, (uint32_t) names.size() );
+    for ( const string &name : names )
+        putString ( buf, name );
+
+    // Direction is catalog data for some objects, e.g. constellation centers.
+
+    putVector ( buf, pObj->getDirection() );
+    put ( buf, pObj->getDistance() );
+    put ( buf, pObj->getMagnitude() );
+
+    SSPlanetPtr pPlanet = SSGetPlanetPtr ( pObj );
+    if ( pPlanet )
+    {
+        SSOrbit orbit = pPlanet->getOrbit();
+
+        put ( buf, (int64_t) pPlanet->getIdentifier() );
+        put ( buf, orbit.t );
+        put ( buf, orbit.q );
+        put ( buf, orbit.e );
+        put ( buf, orbit.i );
+        put ( buf, orbit.w );
+        put ( buf, orbit.n );
+        put ( buf, orbit.m );
+        put ( buf, orbit.mm );
+        put ( buf, pPlanet->getHMagnitude() );
+        put ( buf, pPlanet->getGMagnitude() );
+        put ( buf, pPlanet->getRadius() );
+
+        // Satellites also store their TLE, since it can't be recovered from the orbit.
+
+        SSSatellitePtr pSat = SSGetSatellitePtr ( pObj );
+        put ( buf, (uint8_t) ( pSat ? 1 : 0 ) );
+        if ( pSat )
+        {
+            SSTLE tle = pSat->getTLE();
+
+            putString ( buf, tle.name );
+            putString ( buf, tle.desig );
+            put ( buf, (int32_t) tle.norad );
+            put ( buf, tle.jdepoch );
+            put ( buf, tle.xndt2o );
+            put ( buf, tle.xndd6o );
+            put ( buf, tle.bstar );
+            put ( buf, tle.xincl );
+            put ( buf, tle.xnodeo );
+            put ( buf, tle.eo );
+            put ( buf, tle.omegao );
+            put ( buf, tle.xmo );
+            put ( buf, tle.xno );
+            put ( buf, (uint8_t) tle.deep );
+        }
+    }
+
+    SSStarPtr pStar = SSGetStarPtr ( pObj );
+    if ( pStar )
+    {
+        vector<SSIdentifier> idents = pStar->getIdentifiers();
+
+        put ( buf, (uint32_t) idents.size() );
+        for ( SSIdentifier ident : idents )
+            put ( buf, (int64_t) ident );
+
+        putVector ( buf, pStar->getFundamentalPosition() );
+        putVector ( buf, pStar->getFundamentalVelocity() );
+        put ( buf, pStar->getParallax() );
+        put ( buf, pStar->getRadVel() );
+        put ( buf, pStar->getVMagnitude() );
+        put ( buf, pStar->getBMagnitude() );
+        putString ( buf, pStar->getSpectralType() );
+
+        SSDoubleStarPtr pDouble = SSGetDoubleStarPtr ( pObj );
+        if ( pDouble )
+        {
+            putString ( buf, pDouble->getComponents() );
+            put ( buf, pDouble->getMagnitudeDelta() );
+            put ( buf, pDouble->getSeparation() );
+            put ( buf, pDouble->getPositionAngle() );
+            put ( buf, pDouble->getPositionAngleYear() );
+        }
+
+        SSVariableStarPtr pVariable = SSGetVariableStarPtr ( pObj );
+        if ( pVariable )
+        {
+            putString ( buf, pVariable->getVariableType() );
+            put ( buf, pVariable->getMaximumMagnitude() );
+            put ( buf, pVariable->getMinimumMagnitude() );
+            put ( buf, pVariable->getPeriod() );
+            put ( buf, pVariable->getEpoch() );
+        }
+
+        SSDeepSkyPtr pDeepSky = SSGetDeepSkyPtr ( pObj );
+        if ( pDeepSky )
+        {
+            put ( buf, pDeepSky->getMajorAxis() );
+            put ( buf, pDeepSky->getMinorAxis() );
+            put ( buf, pDeepSky->getPositionAngle() );
+        }
+    }
+
+    SSConstellationPtr pCon = SSGetConstellationPtr ( pObj );
+    if ( pCon )
+    {
+        vector<SSVector> bounds = pCon->getBoundary();
+        vector<int> figure = pCon->getFigure();
+
+        put ( buf, pCon->getArea() );
+        put ( buf, (int32_t) pCon->getRank() );
+
+        put ( buf, (uint32_t) bounds.size() );
+        for ( SSVector &vec : bounds )
+            putVector ( buf, vec );
+
+        put ( buf, (uint32_t) figure.size() );
+        for ( int hr : figure )
+            put ( buf, (int32_t) hr );
+    }
+}
+
+// Creates a new object of the specified type (type) from an object record's data (in),
+// exactly mirroring putObject(). Returns nullptr if the type is not recognized.
+
+static SSObjectPtr getObject ( SSSnapshotReader &in, SSObjectType type )
+{
+    vector<string> names ( in.getCount ( sizeof ( uint32_t ) ) );
+    for ( string &name : names )
+        name = in.getString();
+
+    SSVector direction = in.getVector();
+    double distance = in.get<double>();
+    float magnitude = in.get<float>();
+    SSObjectPtr pObj = nullptr;
+
+    if ( type >= kTypePlanet && type <= kTypeSpacecraft )
+    {
+        SSIdentifier ident ( in.get<int64_t>() );
+        SSOrbit orbit;
+
+        orbit.t = in.get<double>();
+        orbit.q = in.get<double>();
+        orbit.e = in.get<double>();
+        orbit.i = in.get<double>();
+        orbit.w = in.get<double>();
+        orbit.n = in.get<double>();
+        orbit.m = in.get<double>();
+        orbit.mm = in.get<double>();
+
+        float hmag = in.get<float>();
+        float gmag = in.get<float>();
+        float radius = in.get<float>();
+
+        if ( in.get<uint8_t>() )
+        {
+            SSTLE tle;
+
+            tle.name = in.getString();
+            tle.desig = in.getString();
+            tle.norad = in.get<int32_t>();
+            tle.jdepoch = in.get<double>();
+            tle.xndt2o = in.get<double>();
+            tle.xndd6o = in.get<double>();
+            tle.bstar = in.get<double>();
+            tle.xincl = in.get<double>();
+            tle.xnodeo = in.get<double>();
+            tle.eo = in.get<double>();
+            tle.omegao = in.get<double>();
+            tle.xmo = in.get<double>();
+            tle.xno = in.get<double>();
+            tle.deep = in.get<uint8_t>() != 0;
+
+            pObj = new SSSatellite ( tle );
+        }
+        else
+        {
+            pObj = new SSPlanet ( type );
+        }
+
+        SSPlanetPtr pPlanet = SSGetPlanetPtr ( pObj );
+        pPlanet->setIdentifier ( ident );
+        pPlanet->setOrbit ( orbit );
+        pPlanet->setHMagnitude ( hmag );
+        pPlanet->setGMagnitude ( gmag );
+        pPlanet->setRadius ( radius );
+    }
+    else if ( type >= kTypeStar && type <= kTypeGalaxy )
+    {
+        pObj = SSNewObject ( type );
+        SSStarPtr pStar = SSGetStarPtr ( pObj );
+        if ( pStar == nullptr )
+        {
+            delete pObj;
+            return nullptr;
+        }
+
+        vector<SSIdentifier> idents ( in.getCount ( sizeof ( int64_t ) ) );
+        for ( SSIdentifier &ident : idents )
+            ident = SSIdentifier ( in.get<int64_t>() );
+
+        pStar->setIdentifiers ( idents );
+        pStar->setFundamentalPosition ( in.getVector() );
+        pStar->setFundamentalVelocity ( in.getVector() );
+        pStar->setParallax ( in.get<float>() );
+        pStar->setRadVel ( in.get<float>() );
+        pStar->setVMagnitude ( in.get<float>() );
+        pStar->setBMagnitude ( in.get<float>() );
+        pStar->setSpectralType ( in.getString() );
+
+        SSDoubleStarPtr pDouble = SSGetDoubleStarPtr ( pObj );
+        if ( pDouble )
+        {
+            pDouble->setComponents ( in.getString() );
+            pDouble->setMagnitudeDelta ( in.get<float>() );
+            pDouble->setSeparation ( in.get<float>() );
+            pDouble->setPositionAngle ( in.get<float>() );
+            pDouble->setPositionAngleYear ( in.get<float>() );
+        }
+
+        SSVariableStarPtr pVariable = SSGetVariableStarPtr ( pObj );
+        if ( pVariable )
+        {
+            pVariable->setVariableType ( in.getString() );
+            pVariable->setMaximumMagnitude ( in.get<float>() );
+            pVariable->setMinimumMagnitude ( in.get<float>() );
+            pVariable->setPeriod ( in.get<double>() );
+            pVariable->setEpoch ( in.get<double>() );
+        }
+
+        SSDeepSkyPtr pDeepSky = SSGetDeepSkyPtr ( pObj );
+        if ( pDeepSky )
+        {
+            pDeepSky->setMajorAxis ( in.get<float>() );
+            pDeepSky->setMinorAxis ( in.get<float>() );
+            pDeepSky->setPositionAngle ( in.get<float>() );
+        }
+    }
+    else if ( type >= kTypeConstellation && type <= kTypeAsterism )
+    {
+        SSConstellationPtr pCon = new SSConstellation ( type );
+
+        pCon->setArea ( in.get<double>() );
+        pCon->setRank ( in.get<int32_t>() );
+
+        vector<SSVector> bounds ( min ( (size_t) in.get<uint32_t>(), (size_t) ( in.end - in.p ) / ( 3 * sizeof ( double ) ) ) );
+        for ( SSVector &vec : bounds )
+            vec = in.getVector();
+
+        vector<int> figure ( min ( (size_t) in.get<uint32_t>(), (size_t) ( in.end - in.p ) / sizeof ( int32_t ) ) );
+        for ( int &hr : figure )
+            hr = in.get<int32_t>();
+
+        pCon->setBoundary ( bounds );
+        pCon->setFigure ( figure );
+        pObj = pCon;
+    }
+
+    if ( pObj )
+    {
+        pObj->setNames ( names );
+        pObj->setDirection ( direction );
+        pObj->setDistance ( distance );
+        pObj->setMagnitude ( magnitude );
+    }
+
+    return pObj;
+}
+
+// Exports all objects in an object vector (objects) to a binary snapshot file (filename),
+// overwriting any existing file. Objects of unrecognized types are skipped.
+// Returns the number of objects exported, or zero if the file can't be written.
+
+int SSExportObjectsToSnapshot ( const string &filename, SSObjectVec &objects )
+{
+    // Build each record in memory, then append it with its type code and length.
+
+    string buf ( sizeof ( SSSnapshotHeader ), '\0' ), record;
+    uint64_t count = 0;
+
+    for ( size_t i = 0; i < objects.size(); i++ )
+    {
+        SSObjectPtr pObj = objects[i];
+        if ( pObj == nullptr )
+            continue;
+
+        SSObjectType type = pObj->getType();
+        if ( ! ( ( type >= kTypePlanet && type <= kTypeSpacecraft ) || ( type >= kTypeStar && type <= kTypeGalaxy ) || ( type >= kTypeConstellation && type <= kTypeAsterism ) ) )
+            continue;
+
+        record.clear();
+        putObject ( record, pObj );
+
+        put ( buf, (uint8_t) type );
+        put ( buf, (uint32_t) record.size() );
+        buf += record;
+        count++;
+    }
+
+    // Now that the record count and total size are known, fill in the header.
+
+    SSSnapshotHeader header = {};
+    memcpy ( header.magic, kSnapshotMagic, sizeof ( header.magic ) );
+    header.version = kSSSnapshotVersion;
+    header.byteOrder = kSnapshotByteOrder;
+    header.count = count;
+    header.size = buf.size();
+    memcpy ( &buf[0], &header, sizeof ( header ) );
+
+    FILE *file = fopen ( filename.c_str(), "wb" );
+    if ( ! file )
+        return 0;
+
+    bool ok = fwrite ( buf.data(), 1, buf.size(), file ) == buf.size();
+    ok = fclose ( file ) == 0 && ok;
+
+    return ok ? (int) count : 0;
+}
+
+// Imports objects from a binary snapshot file (filename) written by SSExportObjectsToSnapshot(),
+// and appends them to an object vector (objects). The file is memory-mapped, not read.
+// Returns the number of objects imported, or zero if the file can't be opened, was written by a
+// different snapshot format version or on a machine with different byte order, or is truncated.
+
+int SSImportObjectsFromSnapshot ( const string &filename, SSObjectVec &objects )
+{
+    SSMappedFile file ( filename );
+    if ( file.data() == nullptr || file.size() < sizeof ( SSSnapshotHeader ) )
+        return 0;
+
+    SSSnapshotHeader header;
+    memcpy ( &header, file.data(), sizeof ( header ) );
+    if ( memcmp ( header.magic, kSnapshotMagic, sizeof ( header.magic ) ) != 0 || header.version != kSSSnapshotVersion
+        || header.byteOrder != kSnapshotByteOrder || header.size != file.size() )
+        return 0;
+
+    SSSnapshotReader in ( file.data() + sizeof ( header ), file.data() + file.size() );
+    int numObjects = 0;
+
+    for ( uint64_t i = 0; i < header.count; i++ )
+    {
+        SSObjectType type = (SSObjectType) in.get<uint8_t>();
+        uint32_t length = in.get<uint32_t>();
+        if ( in.error || in.end - in.p < length )
+            break;
+
+        // Read each record with its own reader, so a record of unknown type can be skipped,
+        // and a damaged record can't run into the next one.
+
+        SSSnapshotReader record ( in.p, in.p + length );
+        in.p += length;
+
+        SSObjectPtr pObj = getObject ( record, type );
+        if ( pObj == nullptr )
+            continue;
+
+        if ( record.error )
+        {
+            delete pObj;
+            break;
+        }
+
+        objects.push_back ( pObj );
+        numObjects++;
+    }
+
+    return numObjects;
+}
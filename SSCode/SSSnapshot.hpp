@@ -0,0 +1,25 @@
+// SSSnapshot.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// Reads and writes compact binary snapshots of entire object arrays: every object's type,
+// names, identifiers, catalog data, orbital elements and TLEs. Loading a snapshot memory-maps
+// the file and builds objects directly from it, with no text parsing, so large catalogs load
+// many times faster than from CSV. Snapshots are a cache, not an interchange format: they are
+// only readable by the same version of SSCore, on a machine with the same byte order, and should
+// be regenerated from the original CSV and TLE files whenever those change.
+
+#ifndef SSSnapshot_hpp
+#define SSSnapshot_hpp
+
+#include "SSObject.hpp"
+
+// Current snapshot format version. Increment whenever the layout of any object record changes!
+
+static constexpr int kSSSnapshotVersion = 2;
+
+int SSExportObjectsToSnapshot ( const string &filename, SSObjectVec &objects );
+int SSImportObjectsFromSnapshot ( const string &filename, SSObjectVec &objects );
+
+#endif /* SSSnapshot_hpp */
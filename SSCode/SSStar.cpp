@@ -16,16 +16,11 @@
 
 SSStar::SSStar ( SSObjectType type ) : SSObject ( type )
 {
-    _names = vector<string> ( 0 );
-    _idents = vector<SSIdentifier> ( 0 );
-
     _parallax = 0.0;
     _radvel = HUGE_VAL;
     _position = _velocity = SSVector ( HUGE_VAL, HUGE_VAL, HUGE_VAL );
     _Vmag = HUGE_VAL;
     _Bmag = HUGE_VAL;
-    
-    _spectrum = "";
 }
 
 // Constructs single star with type code set to indicate "single star".
@@ -41,7 +36,6 @@ SSStar::SSStar ( void ) : SSStar ( kTypeStar )
 
 SSVariableStar::SSVariableStar ( void ) : SSStar ( kTypeVariableStar )
 {
-    _varType = "";
     _varMaxMag = HUGE_VAL;
     _varMinMag = HUGE_VAL;
     _varPeriod = HUGE_VAL;
@@ -53,7 +47,6 @@ SSVariableStar::SSVariableStar ( void ) : SSStar ( kTypeVariableStar )
 
 SSDoubleStar::SSDoubleStar ( void ) : SSStar ( kTypeDoubleStar )
 {
-    _comps = "";
     _magDelta = HUGE_VAL;
     _sep = HUGE_VAL;
     _PA = HUGE_VAL;
@@ -83,21 +76,67 @@ SSDeepSky::SSDeepSky ( SSObjectType type ) : SSStar ( type )
 
 SSIdentifier SSStar::getIdentifier ( SSCatalog cat )
 {
-    for ( int i = 0; i < _idents.size(); i++ )
-        if ( _idents[i].catalog() == cat )
-            return _idents[i];
+    for ( SSIdentifier ident : _idents )
+        if ( ident.catalog() == cat )
+            return ident;
     
     return SSIdentifier();
 }
 
+// Adds an identifier to this star, if the identifier is valid and not already present.
+// Returns true if identifier was added, false otherwise.
+
 bool SSStar::addIdentifier ( SSIdentifier ident )
 {
-    return SSAddIdentifier ( ident, _idents );
+    if ( ident && find ( _idents.begin(), _idents.end(), ident ) == _idents.end() )
+    {
+        _idents.push_back ( ident );
+        return true;
+    }
+    
+    return false;
 }
 
 void SSStar::sortIdentifiers ( void )
 {
-    sort ( _idents.begin(), _idents.end(), compareSSIdentifiers );
+    SSIdentifier *pIdents = _idents.edit();
+    sort ( pIdents, pIdents + _idents.size(), compareSSIdentifiers );
+}
+
+// Moves this star's names, identifiers, and spectral type into a pool (pPool).
+// Overrides SSObject::moveToPool().
+
+void SSStar::moveToPool ( SSPool *pPool )
+{
+    SSObject::moveToPool ( pPool );
+    _idents.moveToPool ( pPool );
+    _spectrum.moveToPool ( pPool );
+}
+
+// Moves double star data into a pool, in addition to base star data.
+
+void SSDoubleStar::moveToPool ( SSPool *pPool )
+{
+    SSStar::moveToPool ( pPool );
+    _comps.moveToPool ( pPool );
+}
+
+// Moves variable star data into a pool, in addition to base star data.
+
+void SSVariableStar::moveToPool ( SSPool *pPool )
+{
+    SSStar::moveToPool ( pPool );
+    _varType.moveToPool ( pPool );
+}
+
+// Moves both double and variable star data into a pool, in addition to base star data.
+// Calls SSStar::moveToPool() directly so base data is only moved once.
+
+void SSDoubleVariableStar::moveToPool ( SSPool *pPool )
+{
+    SSStar::moveToPool ( pPool );
+    _comps.moveToPool ( pPool );
+    _varType.moveToPool ( pPool );
 }
 
 // Compute star's apparent direction, distance, and magnitude at the Julian Ephemeris Date
@@ -123,9 +162,10 @@ void SSStar::computeEphemeris ( SSCoordinates &coords )
 
     // If star's apparent direction is the same as in J2000, we ignored both its space motion and parallax.
     // If star's parallax is known, convert to distance in AU; otherwise set distance to infinity.
-    // Star's current visual magnitude equals its J2000 magnitude.
+    // Star's current visual magnitude equals its J2000 magnitude. Compare components: SSVector's
+    // conversion to double would make == compare the vectors' magnitudes instead.
 
-    if ( _direction == _position )
+    if ( _direction.x == _position.x && _direction.y == _position.y && _direction.z == _position.z )
     {
         _distance = _parallax > 0.0 ? coords.kAUPerParsec / _parallax : HUGE_VAL;
         _magnitude = _Vmag;
@@ -404,7 +444,8 @@ string SSStar::toCSV1 ( void )
     
     // If spectrum contains a comma, put it in quotes.
     
-    csv += _spectrum.find ( "," ) == string::npos ? _spectrum + "," : "\"" + _spectrum + "\",";
+    string spectrum = getSpectralType();
+    csv += spectrum.find ( "," ) == string::npos ? spectrum + "," : "\"" + spectrum + "\",";
     
     return csv;
 }
@@ -415,11 +456,11 @@ string SSStar::toCSV2 ( void )
 {
     string csv = "";
     
-    for ( int i = 0; i < _idents.size(); i++ )
-        csv += _idents[i].toString() + ",";
+    for ( SSIdentifier ident : _idents )
+        csv += ident.toString() + ",";
     
     for ( int i = 0; i < _names.size(); i++ )
-        csv += _names[i] + ",";
+        csv += getName ( i ) + ",";
 
     return csv;
 }
@@ -437,7 +478,7 @@ string SSDoubleStar::toCSVD ( void )
 {
     string csv = "";
     
-    csv += _comps + ",";
+    csv += getComponents() + ",";
     csv += isinf ( _magDelta ) ? "," : format ( "%+.2f,", _magDelta );
     csv += isinf ( _sep ) ? "," : format ( "%.1f,", _sep * SSAngle::kArcsecPerRad );
     csv += isinf ( _PA ) ? "," : format ( "%.1f,", _PA * SSAngle::kDegPerRad );
@@ -460,7 +501,7 @@ string SSVariableStar::toCSVV ( void )
 {
     string csv = "";
     
-    csv += _varType + ",";
+    csv += getVariableType() + ",";
     csv += isinf ( _varMinMag ) ? "," : format ( "%+.2f,", _varMinMag );
     csv += isinf ( _varMaxMag ) ? "," : format ( "%+.2f,", _varMaxMag );
     csv += isinf ( _varPeriod ) ? "," : format ( "%.2f,", _varPeriod );
@@ -511,10 +552,18 @@ string SSDeepSky::toCSV ( void )
 
 SSObjectPtr SSStar::fromCSV ( string csv )
 {
-    // split string into comma-delimited fields,
-    // remove leading & trailing whitespace from each field.
-    
-    vector<string> fields = split ( csv, "," );
+    vector<SSStringView> fields;
+    split ( csv, ',', fields );
+    return fromCSV ( fields );
+}
+
+// Allocates a new SSStar and initializes it from a CSV-formatted string which has already
+// been split into fields, without copying them. Returns nullptr on error, like fromCSV ( string ).
+// Trims leading & trailing whitespace from each field in place. The star is allocated in an
+// arena (pArena) if not null, as with SSNewObject().
+
+SSObjectPtr SSStar::fromCSV ( vector<SSStringView> &fields, SSObjectArena *pArena )
+{
     for ( int i = 0; i < fields.size(); i++ )
         fields[i] = trim ( fields[i] );
     
@@ -540,8 +589,8 @@ SSObjectPtr SSStar::fromCSV ( string csv )
     if ( fields.size() < fid )
         return nullptr;
     
-    SSHourMinSec ra ( fields[1] );
-    SSDegMinSec dec ( fields[2] );
+    SSHourMinSec ra ( strtodeg ( fields[1] ) );
+    SSDegMinSec dec ( strtodeg ( fields[2] ) );
     
     double pmRA = fields[3].empty() ? HUGE_VAL : SSAngle::kRadPerArcsec * strtofloat64 ( fields[3] ) * 15.0;
     double pmDec = fields[4].empty() ? HUGE_VAL : SSAngle::kRadPerArcsec * strtofloat64 ( fields[4] );
@@ -551,7 +600,7 @@ SSObjectPtr SSStar::fromCSV ( string csv )
     
     float dist = fields[7].empty() ? HUGE_VAL : strtofloat ( fields[7] ) * SSCoordinates::kLYPerParsec;
     float radvel = fields[8].empty() ? HUGE_VAL : strtofloat ( fields[8] ) / SSCoordinates::kLightKmPerSec;
-    string spec = trim ( fields[9] );
+    string spec = fields[9].str();
     
     // For remaining fields, attempt to parse an identifier.
     // If we succeed, add it to the identifier vector; otherwise add it to the name vector.
@@ -564,14 +613,15 @@ SSObjectPtr SSStar::fromCSV ( string csv )
         if ( fields[i].empty() )
             continue;
         
-        SSIdentifier ident = SSIdentifier::fromString ( fields[i] );
+        string field = fields[i].str();
+        SSIdentifier ident = SSIdentifier::fromString ( field );
         if ( ident )
             idents.push_back ( ident );
         else
-            names.push_back ( fields[i] );
+            names.push_back ( field );
     }
     
-    SSObjectPtr pObject = SSNewObject ( type );
+    SSObjectPtr pObject = SSNewObject ( type, pArena );
     SSStarPtr pStar = SSGetStarPtr ( pObject );
     SSDoubleStarPtr pDoubleStar = SSGetDoubleStarPtr ( pObject );
     SSVariableStarPtr pVariableStar = SSGetVariableStarPtr ( pObject );
@@ -592,7 +642,7 @@ SSObjectPtr SSStar::fromCSV ( string csv )
     
     if ( pDoubleStar )
     {
-        string comps = fields[10];
+        string comps = fields[10].str();
         float dmag = fields[11].empty() ? HUGE_VAL : strtofloat ( fields[11] );
         float sep = fields[12].empty() ? HUGE_VAL : strtofloat ( fields[12] ) / SSAngle::kArcsecPerRad;
         float pa = fields[13].empty() ? HUGE_VAL : strtofloat ( fields[13] ) / SSAngle::kDegPerRad;
@@ -609,7 +659,7 @@ SSObjectPtr SSStar::fromCSV ( string csv )
     {
         int fv = ( type == kTypeVariableStar ) ? 10 : 15;
             
-        string vtype = fields[fv];
+        string vtype = fields[fv].str();
         float vmin = fields[fv+1].empty() ? HUGE_VAL : strtofloat ( fields[fv+1] );
         float vmax = fields[fv+2].empty() ? HUGE_VAL : strtofloat ( fields[fv+2] );
         float vper = fields[fv+3].empty() ? HUGE_VAL : strtofloat ( fields[fv+3] );
@@ -26,7 +26,7 @@ class SSStar : public SSObject
 {
 protected:
     
-    vector<SSIdentifier> _idents;
+    SSCompactArray<SSIdentifier> _idents;  // identifiers in other catalogs; may be stored in a pool, like names
     
     SSVector _position;     // heliocentric position unit vector in fundamental frame at epoch J2000
     SSVector _velocity;     // heliocentric space velocity vector in fundamental frame at epoch J2000, divided by distance; infinite if unknown
@@ -37,7 +37,7 @@ protected:
     float   _Vmag;          // visual magnitude at J2000
     float   _Bmag;          // blue magnitude at J2000
 
-    string  _spectrum;      // Spectral type string
+    SSCompactString _spectrum;  // Spectral type string
     
     SSStar ( SSObjectType type ); // constructs a star with a specific type code
     string toCSV1 ( void );       // returns CSV string from base data (excluding names and identifiers).
@@ -47,18 +47,20 @@ public:
     
     SSStar ( void );
     
-    void setIdentifiers ( vector<SSIdentifier> idents ) { _idents = idents; }
+    void setIdentifiers ( vector<SSIdentifier> idents ) { _idents.assign ( idents.data(), idents.size() ); }
     void setFundamentalPosition ( SSVector pos ) { _position = pos; }
     void setFundamentalVelocity ( SSVector vel ) { _velocity = vel; }
     void setFundamentalCoords ( SSSpherical coords );
     void setFundamentalMotion ( SSSpherical coords, SSSpherical motion );
     void setVMagnitude ( float vmag ) { _Vmag = vmag; }
     void setBMagnitude ( float bmag ) { _Bmag = bmag; }
-    void setSpectralType ( string spectrum ) { _spectrum = spectrum; }
+    void setSpectralType ( string spectrum ) { _spectrum = SSCompactString ( spectrum ); }
+    void setParallax ( float parallax ) { _parallax = parallax; }
+    void setRadVel ( float radvel ) { _radvel = radvel; }
     
     bool addIdentifier ( SSIdentifier ident );
     SSIdentifier getIdentifier ( SSCatalog cat );
-    vector<SSIdentifier> getIdentifiers ( void ) { return _idents; }
+    vector<SSIdentifier> getIdentifiers ( void ) { return vector<SSIdentifier> ( _idents.begin(), _idents.end() ); }
     void sortIdentifiers ( void );
     
     SSVector getFundamentalPosition ( void ) { return _position; }
@@ -67,15 +69,17 @@ public:
     SSSpherical getFundamentalMotion ( void );
     float getVMagnitude ( void ) { return _Vmag; }
     float getBMagnitude ( void ) { return _Bmag; }
-    string getSpectralType ( void ) { return _spectrum; }
+    string getSpectralType ( void ) { return _spectrum.str(); }
     float getParallax ( void ) { return _parallax; }
     float getRadVel ( void ) { return _radvel; }
     
     void computeEphemeris ( SSCoordinates &dyn );
+    virtual void moveToPool ( SSPool *pPool );
     
     // imports/exports from/to CSV-format text string
     
     static SSObjectPtr fromCSV ( string csv );
+    static SSObjectPtr fromCSV ( vector<SSStringView> &fields, SSObjectArena *pArena = nullptr );
     virtual string toCSV ( void );
     
     // magnitude and color conversion utilities
@@ -101,7 +105,7 @@ class SSDoubleStar : virtual public SSStar
 {
 protected:
 
-    string _comps;              // component string, e.g. "A" for primary, "B" for secondary, "AB" for primary-secondary pair, etc.; empty if unknown
+    SSCompactString _comps;     // component string, e.g. "A" for primary, "B" for secondary, "AB" for primary-secondary pair, etc.; empty if unknown
     float _magDelta;            // magnitude difference between components; infinite if unknown
     float _sep;                 // angular separation between components in radians; infinite if unknown
     float _PA;                  // position angle from brighter to fainter component in fundamental mean J2000 equatorial frame; infinite if unknown
@@ -113,19 +117,20 @@ public:
     
     SSDoubleStar ( void );
     
-    void setComponents ( string comps ) { _comps = comps; }
+    void setComponents ( string comps ) { _comps = SSCompactString ( comps ); }
     void setMagnitudeDelta ( float delta ) { _magDelta = delta; }
     void setSeparation ( float sep ) { _sep = sep; }
     void setPositionAngle ( float pa ) { _PA = pa; }
     void setPositionAngleYear ( float year ) { _PAyr = year; }
     
-    string getComponents ( void ) { return _comps; }
+    string getComponents ( void ) { return _comps.str(); }
     float getMagnitudeDelta ( void ) { return _magDelta; }
     float getSeparation ( void ) { return _sep; }
     float getPositionAngle ( void ) { return _PA; }
     float getPositionAngleYear ( void ) { return _PAyr; }
 
     virtual string toCSV ( void );
+    virtual void moveToPool ( SSPool *pPool );
 };
 
 // This subclass of SSStar stores data for variable stars
@@ -135,7 +140,7 @@ class SSVariableStar : virtual public SSStar
 {
 protected:
     
-    string _varType;             // Variability type code string; empty if unknown
+    SSCompactString _varType;    // Variability type code string; empty if unknown
     float _varMaxMag;            // Maximum visual magnitude (i.e. when faintest); infinite if unknown
     float _varMinMag;            // Minimum visual magnitude (i.e. when brightest); infinity if unknown
     double _varPeriod;           // Variability period, in days; infinite if unknown
@@ -147,19 +152,20 @@ public:
     
     SSVariableStar ( void );
 
-    void setVariableType ( string varType ) { _varType = varType; }
+    void setVariableType ( string varType ) { _varType = SSCompactString ( varType ); }
     void setMaximumMagnitude ( float maxMag ) { _varMaxMag = maxMag; }
     void setMinimumMagnitude ( float minMag ) { _varMinMag = minMag; }
-    void setPeriod ( float period ) { _varPeriod = period; }
+    void setPeriod ( double period ) { _varPeriod = period; }
     void setEpoch ( double epoch ) { _varEpoch = epoch; }
     
-    string getVariableType ( void ) { return _varType; }
+    string getVariableType ( void ) { return _varType.str(); }
     float getMaximumMagnitude ( void ) { return _varMaxMag; }
     float getMinimumMagnitude ( void ) { return _varMinMag; }
     double getPeriod ( void ) { return _varPeriod; }
     double getEpoch ( void ) { return _varEpoch; }
     
     virtual string toCSV ( void );
+    virtual void moveToPool ( SSPool *pPool );
 };
 
 // This subclass of SSStar inherits from both SSDoubleStar and SSVariableStar,
@@ -172,6 +178,7 @@ public:
     SSDoubleVariableStar ( void );
 
     virtual string toCSV ( void );
+    virtual void moveToPool ( SSPool *pPool );
 };
 
 // This subclass of SSStar stores data for star clusters, nebulae, and galaxies.
@@ -193,12 +200,12 @@ public:
     void setMajorAxis ( float maj ) { _majAxis = maj; }
     void setMinorAxis ( float min ) { _minAxis = min; }
     void setPositionAngle ( float pa ) { _PA = pa; }
-    void setGalaxyType ( string type ) { _spectrum = type; }
+    void setGalaxyType ( string type ) { setSpectralType ( type ); }
     
     float getMajorAxis ( void ) { return _majAxis; }
     float getMinorAxis ( void ) { return _minAxis; }
     float getPositionAngle ( void ) { return _PA; }
-    string getGalaxyType ( void ) { return _spectrum; }
+    string getGalaxyType ( void ) { return getSpectralType(); }
 
     virtual string toCSV ( void );
 };
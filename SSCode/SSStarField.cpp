@@ -0,0 +1,267 @@
+// SSStarField.cpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A packed, structure-of-arrays container for large numbers of stars,
+// with SIMD kernels for computing their apparent places in bulk.
+
+#include "SSStarField.hpp"
+#include "SSSIMD.hpp"
+
+// Constructs an empty star field.
+
+SSStarField::SSStarField ( void )
+{
+
+}
+
+// Constructs a star field containing all of the stars and deep sky objects
+// in an object array (objects). Other object types are ignored.
+
+SSStarField::SSStarField ( SSObjectArray &objects )
+{
+    add ( objects );
+}
+
+// Reserves memory for at least (n) stars, to avoid reallocation while adding them.
+
+void SSStarField::reserve ( size_t n )
+{
+    _px.reserve ( n ); _py.reserve ( n ); _pz.reserve ( n );
+    _vx.reserve ( n ); _vy.reserve ( n ); _vz.reserve ( n );
+    _parallax.reserve ( n );
+    _Vmag.reserve ( n );
+    _stars.reserve ( n );
+}
+
+// Adds all stars and deep sky objects in an object array (objects) to this star field.
+// The field stores pointers to the objects, but does not own them. Returns number of stars added.
+
+int SSStarField::add ( SSObjectArray &objects )
+{
+    int n = 0;
+
+    reserve ( size() + objects.size() );
+    for ( size_t i = 0; i < objects.size(); i++ )
+    {
+        SSStarPtr pStar = SSGetStarPtr ( objects[i] );
+        if ( pStar == nullptr )
+            continue;
+
+        add ( pStar );
+        n++;
+    }
+
+    return n;
+}
+
+// Adds a single star (pStar) to this star field. The field keeps a pointer
+// to the star so results can be copied back with updateObjects(), but does not own it.
+
+void SSStarField::add ( SSStarPtr pStar )
+{
+    add ( pStar->getFundamentalPosition(), pStar->getFundamentalVelocity(), pStar->getParallax(), pStar->getVMagnitude() );
+    _stars.back() = pStar;
+}
+
+// Adds a star to this star field from its J2000 heliocentric position unit vector (position),
+// space velocity divided by distance in units per Julian year (velocity), parallax in arcseconds,
+// and J2000 visual magnitude (vmag). Velocity may be infinite and parallax may be zero if unknown.
+
+void SSStarField::add ( SSVector position, SSVector velocity, float parallax, float vmag )
+{
+    if ( isinf ( velocity.x ) )
+        velocity = SSVector ( 0.0, 0.0, 0.0 );
+
+    if ( ! ( parallax > 0.0 ) )
+        parallax = 0.0;
+
+    _px.push_back ( position.x );
+    _py.push_back ( position.y );
+    _pz.push_back ( position.z );
+    _vx.push_back ( velocity.x );
+    _vy.push_back ( velocity.y );
+    _vz.push_back ( velocity.z );
+    _parallax.push_back ( parallax );
+    _Vmag.push_back ( vmag );
+    _stars.push_back ( nullptr );
+}
+
+// Removes all stars from this star field and releases computed results.
+// Does not delete the objects the field was built from!
+
+void SSStarField::clear ( void )
+{
+    _px.clear(); _py.clear(); _pz.clear();
+    _vx.clear(); _vy.clear(); _vz.clear();
+    _parallax.clear();
+    _Vmag.clear();
+    _stars.clear();
+
+    _dx.clear(); _dy.clear(); _dz.clear();
+    _delta.clear();
+    _distance.clear();
+    _magnitude.clear();
+}
+
+// Computes apparent directions, distances, and magnitudes for all stars in this field
+// at the time and observer location of an SSCoordinates object (coords).
+
+void SSStarField::computeEphemeris ( SSCoordinates &coords )
+{
+    computeEphemeris ( coords, 0, size() );
+}
+
+// Computes apparent directions, distances, and magnitudes for a contiguous range of (count) stars
+// starting at index (first). Disjoint ranges may be computed concurrently from different threads,
+// so long as the first call on a field of a given size is made from one thread.
+// This performs exactly the same arithmetic as SSStar::computeEphemeris(), in the same order,
+// so results are identical to the per-object path.
+
+void SSStarField::computeEphemeris ( SSCoordinates &coords, size_t first, size_t count )
+{
+    if ( _dx.size() != size() )
+    {
+        _dx.resize ( size() ); _dy.resize ( size() ); _dz.resize ( size() );
+        _delta.resize ( size() );
+        _distance.resize ( size() );
+        _magnitude.resize ( size() );
+    }
+
+    if ( first >= size() )
+        return;
+
+    count = min ( count, size() - first );
+
+    // Everything that depends only on the coordinates object is computed once, outside the loops.
+
+    bool motion = coords.getStarMotion();
+    bool parallax = coords.getStarParallax();
+    bool aberration = coords.getAberration();
+
+    SSDouble2 years = SSDouble2::splat ( coords.getJED() - SSTime::kJ2000 );
+    SSDouble2 daysPerYear = SSDouble2::splat ( SSTime::kDaysPerJulianYear );
+    SSDouble2 auPerParsec = SSDouble2::splat ( SSCoordinates::kAUPerParsec );
+
+    SSVector obs = coords.getObserverPosition();
+    SSDouble2 ox = SSDouble2::splat ( obs.x ), oy = SSDouble2::splat ( obs.y ), oz = SSDouble2::splat ( obs.z );
+
+    SSVector v = coords.getObserverVelocity() / SSCoordinates::kLightAUPerDay;
+    double beta = sqrt ( 1.0 - v * v );
+    SSDouble2 bx = SSDouble2::splat ( v.x ), by = SSDouble2::splat ( v.y ), bz = SSDouble2::splat ( v.z );
+    SSDouble2 b = SSDouble2::splat ( beta ), b1 = SSDouble2::splat ( 1.0 + beta );
+    SSDouble2 one = SSDouble2::splat ( 1.0 );
+
+    // Vectorized pass: two stars per iteration. The odd star left over at the end is copied into
+    // a pair of two-element buffers so it goes through exactly the same kernel as the others.
+
+    for ( size_t i = first; i < first + count; i += 2 )
+    {
+        bool pair = i + 1 < first + count;
+        double tpx[2], tpy[2], tpz[2], tvx[2], tvy[2], tvz[2];
+        float tplx[2];
+        double tdx[2], tdy[2], tdz[2], tdelta[2];
+
+        const double *px = &_px[i], *py = &_py[i], *pz = &_pz[i];
+        const double *vx = &_vx[i], *vy = &_vy[i], *vz = &_vz[i];
+        const float *plx = &_parallax[i];
+        double *dx = &_dx[i], *dy = &_dy[i], *dz = &_dz[i], *delta = &_delta[i];
+
+        if ( ! pair )
+        {
+            tpx[0] = tpx[1] = _px[i]; tpy[0] = tpy[1] = _py[i]; tpz[0] = tpz[1] = _pz[i];
+            tvx[0] = tvx[1] = _vx[i]; tvy[0] = tvy[1] = _vy[i]; tvz[0] = tvz[1] = _vz[i];
+            tplx[0] = tplx[1] = _parallax[i];
+            px = tpx; py = tpy; pz = tpz; vx = tvx; vy = tvy; vz = tvz; plx = tplx;
+            dx = tdx; dy = tdy; dz = tdz; delta = tdelta;
+        }
+
+        SSDouble2 x0 = SSDouble2::load ( px ), y0 = SSDouble2::load ( py ), z0 = SSDouble2::load ( pz );
+        SSDouble2 x = x0, y = y0, z = z0;
+
+        // Add space velocity times years since J2000 to J2000 position.
+
+        if ( motion )
+        {
+            x = x + SSDouble2::load ( vx ) * years / daysPerYear;
+            y = y + SSDouble2::load ( vy ) * years / daysPerYear;
+            z = z + SSDouble2::load ( vz ) * years / daysPerYear;
+        }
+
+        // Subtract observer's position divided by star's J2000 distance.
+
+        if ( parallax )
+        {
+            SSDouble2 p = SSDouble2::load ( plx ) / auPerParsec;
+            x = x - ox * p;
+            y = y - oy * p;
+            z = z - oz * p;
+        }
+
+        // Normalize to unit vector unless every component is unchanged from J2000, as SSStar does;
+        // then the distance ratio is exactly one.
+
+        SSMask2 same = x == x0 && y == y0 && z == z0;
+        SSDouble2 d = select ( same, one, sqrt ( x * x + y * y + z * z ) );
+        x = select ( same, x, x / d );
+        y = select ( same, y, y / d );
+        z = select ( same, z, z / d );
+
+        // Apply aberration of light.
+
+        if ( aberration )
+        {
+            SSDouble2 dot = bx * x + by * y + bz * z;
+            SSDouble2 s = one + dot / b1;
+            SSDouble2 n = one + dot;
+            x = ( x * b + bx * s ) / n;
+            y = ( y * b + by * s ) / n;
+            z = ( z * b + bz * s ) / n;
+        }
+
+        x.store ( dx ); y.store ( dy ); z.store ( dz ); d.store ( delta );
+
+        if ( ! pair )
+        {
+            _dx[i] = tdx[0]; _dy[i] = tdy[0]; _dz[i] = tdz[0]; _delta[i] = tdelta[0];
+        }
+    }
+
+    // Scalar pass: distances and magnitudes. Only stars whose distance changed since J2000 need log10();
+    // with a ratio of exactly one, the other branch would give the same results.
+
+    for ( size_t i = first; i < first + count; i++ )
+    {
+        double delta = _delta[i];
+        float plx = _parallax[i];
+
+        if ( delta == 1.0 )
+        {
+            _distance[i] = plx > 0.0 ? SSCoordinates::kAUPerParsec / plx : HUGE_VAL;
+            _magnitude[i] = _Vmag[i];
+        }
+        else
+        {
+            _distance[i] = plx > 0.0 ? delta * SSCoordinates::kAUPerParsec / plx : HUGE_VAL;
+            _magnitude[i] = _Vmag[i] + 5.0 * log10 ( delta );
+        }
+    }
+}
+
+// Copies apparent directions, distances, and magnitudes computed by the most recent
+// call to computeEphemeris() back into the SSStar objects this field was built from.
+
+void SSStarField::updateObjects ( void )
+{
+    for ( size_t i = 0; i < _stars.size() && i < _dx.size(); i++ )
+    {
+        SSStarPtr pStar = _stars[i];
+        if ( pStar == nullptr )
+            continue;
+
+        pStar->setDirection ( SSVector ( _dx[i], _dy[i], _dz[i] ) );
+        pStar->setDistance ( _distance[i] );
+        pStar->setMagnitude ( _magnitude[i] );
+    }
+}
@@ -0,0 +1,72 @@
+// SSStarField.hpp
+// SSCore
+//
+// Copyright © 2020 Southern Stars. All rights reserved.
+//
+// A packed, structure-of-arrays container for large numbers of stars.
+// Computes apparent directions, distances, and magnitudes for every star in the field
+// from a single SSCoordinates snapshot with SIMD kernels, instead of one virtual
+// SSStar::computeEphemeris() call per star. Results are identical to the per-object path.
+
+#ifndef SSStarField_hpp
+#define SSStarField_hpp
+
+#include "SSStar.hpp"
+#include "SSCoordinates.hpp"
+
+// This class stores star positions, space velocities, parallaxes, and magnitudes in parallel arrays.
+// Stars with unknown space velocity or parallax are stored with zero velocity or parallax, which
+// gives exactly the same result as SSStar::computeEphemeris() skipping those corrections.
+
+class SSStarField
+{
+protected:
+
+    vector<double>      _px, _py, _pz;      // heliocentric position unit vectors in fundamental frame at epoch J2000
+    vector<double>      _vx, _vy, _vz;      // heliocentric space velocity vectors in fundamental frame at epoch J2000, divided by distance; zero if unknown
+    vector<float>       _parallax;          // heliocentric parallax in arcseconds; zero if unknown
+    vector<float>       _Vmag;              // visual magnitude at J2000
+    vector<SSStarPtr>   _stars;             // pointers to stars the field was built from; null if star was added directly. Not owned!
+
+    vector<double>      _dx, _dy, _dz;      // apparent direction unit vectors in fundamental frame, computed by computeEphemeris()
+    vector<double>      _delta;             // ratio of current to J2000 distance, computed by computeEphemeris()
+    vector<double>      _distance;          // distance in AU, computed by computeEphemeris(); infinite if unknown
+    vector<float>       _magnitude;         // visual magnitude, computed by computeEphemeris()
+
+public:
+
+    SSStarField ( void );
+    SSStarField ( SSObjectArray &objects );
+
+    // add stars to the field; clear all stars from the field
+
+    void reserve ( size_t n );
+    int add ( SSObjectArray &objects );
+    void add ( SSStarPtr pStar );
+    void add ( SSVector position, SSVector velocity, float parallax, float vmag );
+    void clear ( void );
+    size_t size ( void ) { return _px.size(); }
+
+    // compute apparent directions, distances, and magnitudes for all stars
+
+    void computeEphemeris ( SSCoordinates &coords );
+    void computeEphemeris ( SSCoordinates &coords, size_t first, size_t count );
+    void updateObjects ( void );
+
+    // per-star accessors for results of computeEphemeris()
+
+    SSStarPtr getStar ( size_t i ) { return _stars[i]; }
+    SSVector getDirection ( size_t i ) { return SSVector ( _dx[i], _dy[i], _dz[i] ); }
+    double getDistance ( size_t i ) { return _distance[i]; }
+    float getMagnitude ( size_t i ) { return _magnitude[i]; }
+
+    // raw array accessors for renderers which consume results in bulk
+
+    const double *getDirectionX ( void ) { return _dx.data(); }
+    const double *getDirectionY ( void ) { return _dy.data(); }
+    const double *getDirectionZ ( void ) { return _dz.data(); }
+    const double *getDistances ( void ) { return _distance.data(); }
+    const float *getMagnitudes ( void ) { return _magnitude.data(); }
+};
+
+#endif /* SSStarField_hpp */
@@ -10,9 +10,43 @@
 #include <sys/time.h>
 #endif
 
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
 #include "SSAngle.hpp"
 #include "SSTime.hpp"
 
+// Observed Delta T values and leap seconds, as (Julian Date, seconds) pairs sorted by date.
+// Leap second table stores TAI - UTC; these are empty unless imported from files.
+
+typedef vector<pair<double,double>> SSTimeTable;
+
+static SSTimeTable _observedDeltaT;
+static SSTimeTable _leapSeconds;
+static double _leapSecondsExpiry = 0.0;
+static int _deltaTGeneration = 0;      // changes whenever the tables above change
+
+// Linearly interpolates a value at Julian Date (jd) in a sorted time table (table).
+// If (step) is true, returns the value at the latest entry on or before jd instead of interpolating,
+// and the table applies indefinitely after its last entry. Returns false if jd is outside the table.
+
+static bool interpolateTimeTable ( const SSTimeTable &table, double jd, bool step, double &value )
+{
+    if ( table.empty() || jd < table.front().first || ( ! step && jd > table.back().first ) )
+        return false;
+    
+    auto next = upper_bound ( table.begin(), table.end(), jd, [] ( double d, const pair<double,double> &e ) { return d < e.first; } );
+    auto prev = next - 1;
+    
+    if ( step || next == table.end() )
+        value = prev->second;
+    else
+        value = prev->second + ( next->second - prev->second ) * ( jd - prev->first ) / ( next->first - prev->first );
+
+    return true;
+}
+
 // Constructs a calendar date/time from the specified calendar system, local time zone in hours east of UTC,
 // and year/month/day including fractional part of day.
 
@@ -261,12 +295,29 @@ int SSTime::getWeekday ( void )
 
 // Returns the time offset in seconds from civil time (UT) to dynamic time (DT)
 // at this time object's current Julian Date, i.e. DT = UT + DeltaT.
-// From an algorithm by F. Espenak and J. Meeus, described here:
-// https://eclipse.gsfc.nasa.gov/SEhelp/deltatpoly2004.html
+// If leap seconds have been imported, and this time is covered by them, returns
+// the exact offset from UTC to TT. Otherwise, if observed Delta T values have been
+// imported and cover this time, interpolates them. Otherwise, returns polynomialDeltaT().
 
 double SSTime::getDeltaT ( void )
 {
-    double y = toJulianYear() - 0.5 / 12.0;
+    double dt = 0.0;
+    
+    if ( jd <= _leapSecondsExpiry && interpolateTimeTable ( _leapSeconds, jd, true, dt ) )
+        dt += 32.184;
+    else if ( ! interpolateTimeTable ( _observedDeltaT, jd, false, dt ) )
+        dt = polynomialDeltaT ( toJulianYear() - 0.5 / 12.0 );
+    
+    return dt;
+}
+
+// Returns Delta T in seconds at a given year (year), which should be a Julian year
+// offset by half a month, as in SSTime::getDeltaT(), from the piecewise polynomials in
+// an algorithm by F. Espenak and J. Meeus, described here:
+// https://eclipse.gsfc.nasa.gov/SEhelp/deltatpoly2004.html
+
+double SSTime::polynomialDeltaT ( double y )
+{
     double u, u2, u3, u4, u5, u6;
     double t, t2, t3, t4, t5, t6, t7;
     double dt = 0;
@@ -406,6 +457,175 @@ double SSTime::getJulianEphemerisDate ( void )
     return jd + getDeltaT() / kSecondsPerDay;
 }
 
+// Returns the offset in days from Terrestrial Time (TT) to Barycentric Dynamical Time (TDB)
+// at a Julian Date (jd) in either time scale. The difference is periodic, under 0.002 seconds.
+// From the "Explanatory Supplement to the Astronomical Almanac" (1992), p. 42.
+
+static double TDBminusTT ( double jd )
+{
+    double g = SSAngle::fromDegrees ( 357.53 + 0.98560028 * ( jd - SSTime::kJ2000 ) );
+    return ( 0.001657 * sin ( g ) + 0.000014 * sin ( 2.0 * g ) ) / SSTime::kSecondsPerDay;
+}
+
+// Returns the Julian Date in Barycentric Dynamical Time (TDB) corresponding
+// to this time object's current Julian Date, which is in UTC.
+
+double SSTime::getBarycentricDynamicalTime ( void )
+{
+    double jed = getJulianEphemerisDate();
+    return jed + TDBminusTT ( jed );
+}
+
+// Imports observed Delta T values from a text file (filename); for example, from USNO's "deltat.data"
+// or "deltat.preds" files. Each line contains a year, month, day, and Delta T in seconds ("deltat.data");
+// or a Modified Julian Date, decimal year, Delta T, UT1 - UTC, and error, all in seconds but the first two
+// ("deltat.preds"); or a decimal Julian year and Delta T in seconds. Other lines are ignored. Values are merged with any imported
+// previously. Within the range of observed values, getDeltaT() interpolates them instead of using
+// polynomialDeltaT(). Returns number of values imported. Not thread safe: import before computing!
+
+int SSTime::importDeltaT ( const string &filename )
+{
+    ifstream file ( filename );
+    if ( ! file )
+        return 0;
+    
+    string line;
+    int n = 0;
+    
+    while ( getline ( file, line ) )
+    {
+        istringstream fields ( line );
+        vector<double> values;
+        double value = 0.0;
+        
+        while ( fields >> value )
+            values.push_back ( value );
+
+        if ( values.size() == 4 )
+        {
+            SSDate date ( kGregorian, 0.0, (int) values[0], (short) values[1], values[2] );
+            _observedDeltaT.push_back ( make_pair ( SSTime ( date ).jd, values[3] ) );
+            n++;
+        }
+        else if ( values.size() == 5 )
+        {
+            _observedDeltaT.push_back ( make_pair ( values[0] + 2400000.5, values[2] ) );
+            n++;
+        }
+        else if ( values.size() == 2 )
+        {
+            _observedDeltaT.push_back ( make_pair ( fromJulianYear ( values[0] ).jd, values[1] ) );
+            n++;
+        }
+    }
+    
+    sort ( _observedDeltaT.begin(), _observedDeltaT.end() );
+    _deltaTGeneration++;
+    return n;
+}
+
+// Imports leap seconds from a text file (filename) in the format of the IERS "leap-seconds.list" file:
+// each line contains a time in seconds since 1.0 January 1900 (the NTP epoch) and TAI - UTC in seconds
+// from then on. A line beginning with "#@" gives the file's expiration time in the same units;
+// if missing, leap seconds are assumed valid for one year after the last one. Until expiration,
+// getDeltaT() returns the exact offset TT - UTC = TAI - UTC + 32.184 seconds for dates covered by the
+// file. Returns number of leap seconds imported. Not thread safe: import before computing!
+
+int SSTime::importLeapSeconds ( const string &filename )
+{
+    static constexpr double kNTPEpoch = 2415020.5;      // JD of 1.0 January 1900 UTC
+    
+    ifstream file ( filename );
+    if ( ! file )
+        return 0;
+    
+    string line;
+    double expiry = 0.0;
+    int n = 0;
+    
+    while ( getline ( file, line ) )
+    {
+        double seconds = 0.0, offset = 0.0;
+        
+        if ( line.compare ( 0, 2, "#@" ) == 0 )
+        {
+            if ( istringstream ( line.substr ( 2 ) ) >> seconds )
+                expiry = kNTPEpoch + seconds / kSecondsPerDay;
+        }
+        else if ( line[0] != '#' && istringstream ( line ) >> seconds >> offset )
+        {
+            _leapSeconds.push_back ( make_pair ( kNTPEpoch + seconds / kSecondsPerDay, offset ) );
+            n++;
+        }
+    }
+    
+    sort ( _leapSeconds.begin(), _leapSeconds.end() );
+    if ( expiry == 0.0 && _leapSeconds.size() > 0 )
+        expiry = _leapSeconds.back().first + kDaysPerJulianYear;
+    
+    _leapSecondsExpiry = max ( _leapSecondsExpiry, expiry );
+    _deltaTGeneration++;
+    return n;
+}
+
+// Discards all imported observed Delta T values and leap seconds,
+// so getDeltaT() goes back to using only polynomialDeltaT().
+
+void SSTime::clearDeltaT ( void )
+{
+    _observedDeltaT.clear();
+    _leapSeconds.clear();
+    _leapSecondsExpiry = 0.0;
+    _deltaTGeneration++;
+}
+
+// Returns a number which changes whenever observed Delta T values or leap seconds are imported
+// or cleared, so callers caching values derived from Delta T know to recompute them.
+
+int SSTime::getDeltaTGeneration ( void )
+{
+    return _deltaTGeneration;
+}
+
+// Converts an array of (n) Julian Dates in UTC (utc) to Terrestrial Time (tt), i.e. Julian Ephemeris Dates.
+// Results are identical to SSTime::getJulianEphemerisDate().
+
+void SSTime::UTCtoTT ( const double *utc, double *tt, size_t n )
+{
+    for ( size_t i = 0; i < n; i++ )
+        tt[i] = SSTime ( utc[i] ).getJulianEphemerisDate();
+}
+
+// Converts an array of (n) Terrestrial Time Julian Dates (tt) to UTC (utc).
+// Delta T is evaluated at the approximate UTC, so this inverts UTCtoTT() to the
+// precision of a double-precision Julian Date (about 50 microseconds), except within a leap second.
+
+void SSTime::TTtoUTC ( const double *tt, double *utc, size_t n )
+{
+    for ( size_t i = 0; i < n; i++ )
+    {
+        double jd = tt[i] - SSTime ( tt[i] ).getDeltaT() / kSecondsPerDay;
+        utc[i] = tt[i] - SSTime ( jd ).getDeltaT() / kSecondsPerDay;
+    }
+}
+
+// Converts an array of (n) Terrestrial Time Julian Dates (tt) to Barycentric Dynamical Time (tdb).
+
+void SSTime::TTtoTDB ( const double *tt, double *tdb, size_t n )
+{
+    for ( size_t i = 0; i < n; i++ )
+        tdb[i] = tt[i] + TDBminusTT ( tt[i] );
+}
+
+// Converts an array of (n) Barycentric Dynamical Time Julian Dates (tdb) to Terrestrial Time (tt).
+// The periodic TDB - TT offset is so small that evaluating it at TDB instead of TT is exact to 1.0e-12 seconds.
+
+void SSTime::TDBtoTT ( const double *tdb, double *tt, size_t n )
+{
+    for ( size_t i = 0; i < n; i++ )
+        tt[i] = tdb[i] - TDBminusTT ( tdb[i] );
+}
+
 // Returns local mean sidereal time as an angle in radians
 // at this time object's current Julian Date and a particular longitude
 // in radians, where east is positive, wast is negative.
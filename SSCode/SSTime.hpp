@@ -10,6 +10,7 @@
 #define SSTime_hpp
 
 #include <string>
+#include <vector>
 #include <stdio.h>
 #include <math.h>
 #include <time.h>
@@ -109,8 +110,24 @@ struct SSTime
     int     getWeekday ( void );
     double  getDeltaT ( void );
     double  getJulianEphemerisDate ( void );
+    double  getBarycentricDynamicalTime ( void );
     SSAngle getSiderealTime ( SSAngle lon );
     SSTime  getLocalMidnight ( void );
+    
+    // Delta T model and optional observed Delta T and leap second tables
+    
+    static double polynomialDeltaT ( double year );
+    static int    importDeltaT ( const string &filename );
+    static int    importLeapSeconds ( const string &filename );
+    static void   clearDeltaT ( void );
+    static int    getDeltaTGeneration ( void );
+    
+    // Bulk time scale conversions over arrays of (n) Julian Dates; input and output arrays may be the same.
+    
+    static void   UTCtoTT ( const double *utc, double *tt, size_t n );
+    static void   TTtoUTC ( const double *tt, double *utc, size_t n );
+    static void   TTtoTDB ( const double *tt, double *tdb, size_t n );
+    static void   TDBtoTT ( const double *tdb, double *tt, size_t n );
 };
 
 #endif /* SSTime_hpp */
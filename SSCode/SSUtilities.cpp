@@ -5,6 +5,7 @@
 // Copyright © 2020 Southern Stars. All rights reserved.
 
 #include <cstdarg>
+#include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
 #include <limits.h>
@@ -15,6 +16,9 @@
 #include <direct.h>
 #else
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #endif
 
@@ -181,6 +185,234 @@ double strtodeg ( string str )
     return cstr[0] == '-' ? -deg : deg;
 }
 
+// Returns a view of a string with leading and trailing whitespace removed,
+// exactly as trim() does, but without copying any characters.
+
+SSStringView trim ( SSStringView str )
+{
+    size_t start = 0, end = str.len;
+
+    while ( start < end && strchr ( " \t\r\n", str.ptr[start] ) && str.ptr[start] )
+        start++;
+
+    while ( end > start && strchr ( " \t\r\n", str.ptr[end - 1] ) && str.ptr[end - 1] )
+        end--;
+
+    return SSStringView ( str.ptr + start, end - start );
+}
+
+// Splits a string (str) into views of the fields separated by a delimiter character (delim),
+// exactly as split() does, but without copying any characters. The views point into (str),
+// which must not be modified or destroyed while they are in use. Reuses the (fields) vector's
+// memory, so splitting many lines into the same vector doesn't allocate after the first.
+
+void split ( const string &str, char delim, vector<SSStringView> &fields )
+{
+    const char *p = str.data(), *end = p + str.size();
+
+    fields.clear();
+    while ( true )
+    {
+        const char *q = (const char *) memchr ( p, delim, end - p );
+        if ( q == nullptr )
+            break;
+
+        fields.push_back ( SSStringView ( p, q - p ) );
+        p = q + 1;
+    }
+
+    fields.push_back ( SSStringView ( p, end - p ) );
+}
+
+// Copies a string view (str) into a null-terminated buffer (buf) of (size) bytes,
+// so it can be passed to C library functions. Returns false if it doesn't fit.
+
+static bool viewtobuf ( SSStringView str, char *buf, size_t size )
+{
+    if ( str.len >= size )
+        return false;
+
+    memcpy ( buf, str.ptr, str.len );
+    buf[ str.len ] = 0;
+    return true;
+}
+
+// Parses a plain decimal number like "-12.345" or "1.502E+02" at the start of a string view (str)
+// into an integer mantissa (mant), decimal exponent (exp10), and sign (neg), skipping leading whitespace.
+// Succeeds only if the number is followed by whitespace or the end of the view and has no more than
+// 19 significant digits; anything else (hex, inf, nan, trailing junk) fails, so callers can fall back
+// to the C library and get exactly its result. On success, returns number of characters consumed.
+
+static size_t parsedecimal ( SSStringView str, uint64_t &mant, int &exp10, bool &neg )
+{
+    const char *p = str.ptr, *end = str.ptr + str.len;
+    int digits = 0;
+    bool any = false;
+
+    mant = 0;
+    exp10 = 0;
+    neg = false;
+
+    while ( p < end && isspace ( *p ) )
+        p++;
+
+    if ( p < end && ( *p == '+' || *p == '-' ) )
+        neg = *p++ == '-';
+
+    for ( ; p < end && isdigit ( *p ); p++ )
+    {
+        any = true;
+        if ( mant == 0 && *p == '0' )
+            continue;
+        if ( digits++ == 19 )
+            return 0;
+        mant = mant * 10 + ( *p - '0' );
+    }
+
+    if ( p < end && *p == '.' )
+    {
+        for ( p++; p < end && isdigit ( *p ); p++ )
+        {
+            any = true;
+            exp10--;
+            if ( mant == 0 && *p == '0' )
+                continue;
+            if ( digits++ == 19 )
+                return 0;
+            mant = mant * 10 + ( *p - '0' );
+        }
+    }
+
+    if ( ! any )
+        return 0;
+
+    if ( p < end && ( *p == 'e' || *p == 'E' ) )
+    {
+        bool eneg = false;
+        int e = 0;
+
+        p++;
+        if ( p < end && ( *p == '+' || *p == '-' ) )
+            eneg = *p++ == '-';
+
+        if ( p == end || ! isdigit ( *p ) )
+            return 0;
+
+        for ( ; p < end && isdigit ( *p ); p++ )
+            e = min ( e * 10 + ( *p - '0' ), 10000 );
+
+        exp10 += eneg ? -e : e;
+    }
+
+    if ( p < end && ! isspace ( *p ) )
+        return 0;
+
+    return p - str.ptr;
+}
+
+// Converts string view to 32-bit signed integer, exactly like strtoint(),
+// without allocating memory. Returns zero if string cannot be converted.
+
+int strtoint ( SSStringView str )
+{
+    char buf[64];
+
+    if ( viewtobuf ( str, buf, sizeof ( buf ) ) )
+        return atoi ( buf );
+    else
+        return strtoint ( str.str() );
+}
+
+// Converts string view to 32-bit single precision floating point value, with exactly
+// the same result as strtofloat(). When the decimal mantissa and its power of ten are both
+// exactly representable as floats, a single correctly-rounded float multiply or divide gives
+// the correctly-rounded result, so the C library is only needed for unusual inputs.
+
+float strtofloat ( SSStringView str )
+{
+    static const float kPow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    uint64_t mant = 0;
+    int exp10 = 0;
+    bool neg = false;
+
+    if ( parsedecimal ( str, mant, exp10, neg ) && mant <= ( 1 << 24 ) && ( mant == 0 || abs ( exp10 ) <= 10 ) )
+    {
+        float f = (float) mant;
+        if ( mant && exp10 < 0 )
+            f = f / kPow10[ -exp10 ];
+        else if ( mant )
+            f = f * kPow10[ exp10 ];
+        return neg ? -f : f;
+    }
+
+    char buf[64];
+    if ( viewtobuf ( str, buf, sizeof ( buf ) ) )
+        return strtof ( buf, nullptr );
+    else
+        return strtofloat ( str.str() );
+}
+
+// Converts string view to 64-bit double precision floating point value, with exactly
+// the same result as strtofloat64(), using the same exact fast path as strtofloat().
+
+double strtofloat64 ( SSStringView str )
+{
+    static const double kPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    uint64_t mant = 0;
+    int exp10 = 0;
+    bool neg = false;
+
+    if ( parsedecimal ( str, mant, exp10, neg ) && mant <= ( 1ULL << 53 ) && ( mant == 0 || abs ( exp10 ) <= 22 ) )
+    {
+        double d = (double) mant;
+        if ( mant && exp10 < 0 )
+            d = d / kPow10[ -exp10 ];
+        else if ( mant )
+            d = d * kPow10[ exp10 ];
+        return neg ? -d : d;
+    }
+
+    char buf[64];
+    if ( viewtobuf ( str, buf, sizeof ( buf ) ) )
+        return strtod ( buf, nullptr );
+    else
+        return strtofloat64 ( str.str() );
+}
+
+// Converts a string view representing an angle in deg min sec to decimal degrees,
+// with exactly the same result as strtodeg(). Assumes leading whitespace has been removed!
+
+double strtodeg ( SSStringView str )
+{
+    double dms[3] = { 0.0, 0.0, 0.0 };
+    SSStringView rest = str;
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        uint64_t mant = 0;
+        int exp10 = 0;
+        bool neg = false;
+
+        rest = trim ( rest );
+        if ( rest.empty() )
+            break;
+
+        // Each of up to three numbers must be followed by whitespace or end of string;
+        // otherwise, let sscanf() deal with it.
+
+        size_t len = parsedecimal ( rest, mant, exp10, neg );
+        if ( len == 0 )
+            return strtodeg ( str.str() );
+
+        dms[i] = strtofloat64 ( SSStringView ( rest.ptr, len ) );
+        rest = SSStringView ( rest.ptr + len, rest.len - len );
+    }
+
+    double deg = fabs ( dms[0] ) + dms[1] / 60.0 + dms[2] / 3600.0;
+    return str.len > 0 && str.ptr[0] == '-' ? -deg : deg;
+}
+
 // Converts angle in degrees to radians.
 
 double degtorad ( double deg )
@@ -361,3 +593,75 @@ double clocksec_since ( double &start )
     start = now;
     return since;
 }
+
+// Memory-maps an entire file read-only. See SSMappedFile in SSUtilities.hpp.
+
+#ifdef _WIN32
+
+SSMappedFile::SSMappedFile ( const string &filename )
+{
+    _data = nullptr;
+    _size = 0;
+    _mapping = NULL;
+    _file = CreateFileA ( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( _file == INVALID_HANDLE_VALUE )
+        return;
+
+    LARGE_INTEGER size = { 0 };
+    if ( ! GetFileSizeEx ( _file, &size ) || size.QuadPart == 0 )
+        return;
+
+    _mapping = CreateFileMappingA ( _file, NULL, PAGE_READONLY, 0, 0, NULL );
+    if ( _mapping == NULL )
+        return;
+
+    _data = (const char *) MapViewOfFile ( _mapping, FILE_MAP_READ, 0, 0, 0 );
+    _size = _data ? (size_t) size.QuadPart : 0;
+}
+
+SSMappedFile::~SSMappedFile ( void )
+{
+    if ( _data )
+        UnmapViewOfFile ( _data );
+
+    if ( _mapping != NULL )
+        CloseHandle ( _mapping );
+
+    if ( _file != INVALID_HANDLE_VALUE )
+        CloseHandle ( _file );
+}
+
+#else
+
+SSMappedFile::SSMappedFile ( const string &filename )
+{
+    _data = nullptr;
+    _size = 0;
+
+    int fd = open ( filename.c_str(), O_RDONLY );
+    if ( fd < 0 )
+        return;
+
+    struct stat st;
+    if ( fstat ( fd, &st ) == 0 && st.st_size > 0 )
+    {
+        void *p = mmap ( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( p != MAP_FAILED )
+        {
+            _data = (const char *) p;
+            _size = st.st_size;
+        }
+    }
+
+    // The mapping stays valid after the file descriptor is closed.
+
+    close ( fd );
+}
+
+SSMappedFile::~SSMappedFile ( void )
+{
+    if ( _data )
+        munmap ( (void *) _data, _size );
+}
+
+#endif
@@ -35,6 +35,25 @@ extern "C" FILE *android_fopen ( const char *fname, const char *mode );
 
 #define M_2PI (2*M_PI)
 
+// A non-owning reference to a run of characters inside another string;
+// a minimal C++11 stand-in for C++17's std::string_view. The string it
+// refers to must outlive it!
+
+struct SSStringView
+{
+    const char *ptr;    // pointer to first character; not necessarily null-terminated!
+    size_t len;         // number of characters
+
+    SSStringView ( void ) : ptr ( "" ), len ( 0 ) { }
+    SSStringView ( const char *p, size_t n ) : ptr ( p ), len ( n ) { }
+    SSStringView ( const string &str ) : ptr ( str.data() ), len ( str.size() ) { }
+
+    bool empty ( void ) const { return len == 0; }
+    size_t size ( void ) const { return len; }
+    char operator [] ( size_t i ) const { return ptr[i]; }
+    string str ( void ) const { return string ( ptr, len ); }
+};
+
 string getcwd ( void );
 bool fgetline ( FILE *infile, string &line );
 
@@ -43,11 +62,19 @@ string format ( const char *fmt, ... );
 vector<string> split ( string str, string delim );
 vector<string> tokenize ( string str, string delim );
 
+SSStringView trim ( SSStringView str );
+void split ( const string &str, char delim, vector<SSStringView> &fields );
+
 int strtoint ( string str );
 int64_t strtoint64 ( string str );
 float strtofloat ( string str );
 double strtofloat64 ( string str );
 
+int strtoint ( SSStringView str );
+float strtofloat ( SSStringView str );
+double strtofloat64 ( SSStringView str );
+double strtodeg ( SSStringView str );
+
 double strtodeg ( string str );
 double degtorad ( double deg );
 double radtodeg ( double rad );
@@ -71,4 +98,30 @@ double unixtime_since ( double &start );
 double clocksec ( void );
 double clocksec_since ( double &start );
 
+// Read-only memory mapping of an entire file. Maps nothing if the file can't be opened,
+// or is empty; check data() before using the mapping. Unmaps file when destroyed.
+// Pages are shared with every other process which maps the same file.
+
+class SSMappedFile
+{
+protected:
+
+    const char *_data;
+    size_t _size;
+#ifdef _WIN32
+    void *_file, *_mapping;     // Windows file and file mapping HANDLEs
+#endif
+
+public:
+
+    SSMappedFile ( const string &filename );
+    ~SSMappedFile ( void );
+
+    SSMappedFile ( const SSMappedFile & ) = delete;
+    SSMappedFile &operator = ( const SSMappedFile & ) = delete;
+
+    const char *data ( void ) const { return _data; }
+    size_t size ( void ) const { return _size; }
+};
+
 #endif /* SSUtilities_hpp */
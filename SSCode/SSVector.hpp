@@ -35,49 +35,74 @@ struct SSSpherical
 };
 
 // Represents a point in a rectangular (x,y,z) coordinate system.
+// Arithmetic is defined inline here, rather than in SSVector.cpp, so the compiler can inline it
+// into the hot loops which call it (ephemeris computation, coordinate transformation, projection).
+// Everything except square roots is constexpr, so vectors can also be computed at compile time.
 
 struct SSVector
 {
     double x, y, z;    // Point's distance from origin along X, Y, Z axes, in arbitrary units.
 
-    SSVector ( void );
-    SSVector ( double x, double y, double z );
+    // Constructs a vector at the origin; from X, Y, Z coordinates in arbitrary units; or from spherical coordinates.
+
+    constexpr SSVector ( void ) : x ( 0.0 ), y ( 0.0 ), z ( 0.0 ) { }
+    constexpr SSVector ( double x, double y, double z ) : x ( x ), y ( y ), z ( z ) { }
     SSVector ( SSSpherical lbr );
     
-    double magnitude ( void );
-    SSVector normalize ( void );
-    SSVector normalize ( double &magnitude );
-
-    SSVector add ( SSVector other );
-    SSVector subtract ( SSVector other );
-    SSVector multiplyBy ( double s );
-    SSVector divideBy ( double s );
+    // Returns this vector's magnitude (length) measured from the origin, and copies of it normalized to unit length.
+
+    double magnitude ( void ) const { return sqrt ( x * x + y * y + z * z ); }
+    SSVector normalize ( void ) const { double mag; return normalize ( mag ); }
+    SSVector normalize ( double &magnitude ) const;
+
+    // Vector arithmetic. These all return new vectors; none modify this vector!
+    // Note that a.crossProduct ( b ) is the negative of b.crossProduct ( a ).
+
+    constexpr SSVector add ( const SSVector &other ) const { return SSVector ( x + other.x, y + other.y, z + other.z ); }
+    constexpr SSVector subtract ( const SSVector &other ) const { return SSVector ( x - other.x, y - other.y, z - other.z ); }
+    constexpr SSVector multiplyBy ( double s ) const { return SSVector ( x * s, y * s, z * s ); }
+    constexpr SSVector divideBy ( double s ) const { return SSVector ( x / s, y / s, z / s ); }
     
-    double dotProduct ( SSVector other );
-    SSVector crossProduct ( SSVector other );
+    constexpr double dotProduct ( const SSVector &other ) const { return x * other.x + y * other.y + z * other.z; }
+    constexpr SSVector crossProduct ( const SSVector &other ) const { return SSVector ( y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x ); }
     
-    operator double() { return magnitude(); }
+    operator double() const { return magnitude(); }
     
-    SSVector operator + ( SSVector other ) { return add ( other ); }
-    SSVector operator - ( SSVector other ) { return subtract ( other ); }
-    double   operator * ( SSVector other ) { return dotProduct ( other ); }
-    SSVector operator * ( double scale )  { return multiplyBy ( scale ); }
-    SSVector operator / ( double scale )  { return divideBy ( scale ); }
-
-    void operator += ( SSVector other ) { *this = add ( other ); }
-    void operator -= ( SSVector other ) { *this = subtract ( other ); }
-    void operator *= ( double scale )  { *this = multiplyBy ( scale ); }
-    void operator /= ( double scale )  { *this = divideBy ( scale ); }
-
-    bool isinf ( void ) { return std::isinf ( x ) || std::isinf ( y ) || std::isinf ( z ); }
+    constexpr SSVector operator + ( const SSVector &other ) const { return add ( other ); }
+    constexpr SSVector operator - ( const SSVector &other ) const { return subtract ( other ); }
+    constexpr double   operator * ( const SSVector &other ) const { return dotProduct ( other ); }
+    constexpr SSVector operator * ( double scale ) const { return multiplyBy ( scale ); }
+    constexpr SSVector operator / ( double scale ) const { return divideBy ( scale ); }
+
+    void operator += ( const SSVector &other ) { *this = add ( other ); }
+    void operator -= ( const SSVector &other ) { *this = subtract ( other ); }
+    void operator *= ( double scale ) { *this = multiplyBy ( scale ); }
+    void operator /= ( double scale ) { *this = divideBy ( scale ); }
+
+    bool isinf ( void ) const { return std::isinf ( x ) || std::isinf ( y ) || std::isinf ( z ); }
     
     SSAngle angularSeparation ( SSVector other );
     SSAngle positionAngle ( SSVector other );
     
-    double distance ( SSVector other );
+    // Returns distance from this point to another, in the same units as X, Y, Z coordinates.
+
+    double distance ( const SSVector &other ) const { return subtract ( other ).magnitude(); }
 
     SSSpherical toSpherical ( void );
     SSSpherical toSphericalVelocity ( SSVector vvec );
 };
 
+// Returns a copy of this vector normalized to unit length, and returns its original magnitude.
+// If the original vector was a zero-length vector, the returned vector will also be zero length.
+// Does not modify this vector!
+
+inline SSVector SSVector::normalize ( double &mag ) const
+{
+    mag = magnitude();
+    if ( mag > 0.0 )
+        return divideBy ( mag );
+    else
+        return SSVector ( 0.0, 0.0, 0.0 );
+}
+
 #endif /* SSVector_hpp */
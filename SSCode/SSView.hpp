@@ -102,7 +102,14 @@ public:
     
     SSVector project ( SSVector cvec );
     SSVector unproject ( SSVector vvec );
-    
+
+    // projects an array of (count) points from celestial sphere (cvecs) onto rectangular field of view,
+    // two at a time with SIMD instructions. Writes 2D coordinates to (x,y) arrays; if (visible) is not null,
+    // sets each element to 1 if point is inside view's 2D bounding rectangle, or 0 if not.
+    // Returns number of visible points. See SSView.cpp for accuracy compared to project().
+
+    size_t project ( const SSVector *cvecs, size_t count, double *x, double *y, uint8_t *visible = nullptr );
+
     SSVector transform ( SSVector cvec ) { return _matrix * cvec; }
     SSVector untransform ( SSVector vvec ) { return _matrix.transpose() * vvec; }
 
@@ -118,6 +125,18 @@ public:
     bool inBoundRect ( double xmin, double ymin, double xmax, double ymax );
     bool inCircle ( double xc, double yc, double r );
 
+    // Returns angular radius of a circle around the view center which contains the whole field of view,
+    // or kPi if the field of view may cover the whole sky.
+
+    SSAngle getBoundingRadius ( void );
+
+    // Returns IDs of HTM regions which intersect field of view, at each HTM level from 0 to (levels - 1),
+    // in ascending order; see SSHTM. Regions are culled against a bounding circle around the view's corners
+    // and edges, and against the edges of the field of view where the projection makes them simple planes.
+    // The result may include a few regions just outside the field of view, but never omits one inside it.
+
+    vector<vector<uint64_t>> htmRegions ( int levels );
+
     // converts horizontal/vertical distance from chart center in radians to pixels, and vice-versa
     
     double radiansToPixelsX ( SSAngle radians );
@@ -10,6 +10,8 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <atomic>
+#include <mutex>
 
 #include "SSCoordinates.hpp"
 #include "ELPMPP02.hpp"
@@ -4304,7 +4306,8 @@ void get_position_velocity ( double tj, double *xyz )
     xyz[5] = ( -pwra * xp1 + qwra * xp2 + ( pw2 + qw2 - 1.0 ) * xp3 - ppwra * x1 + qpwra * x2 + ( ppw2 + qpw2 ) * x3 ) / sc;
 }
 
-static bool _init = false;  // initialization flag ensures series are only loaded once.
+static atomic<bool> _init ( false );     // initialization flag ensures series are only loaded once.
+static mutex _initMutex;                 // serializes initialization when first called from several threads at once.
 
 ELPMPP02::ELPMPP02 ( void )
 {
@@ -4371,12 +4374,17 @@ bool setup_Elp_series ()
 
 // Copies data from ELPMPP02 series embedded in this C++ source code
 // into Kam's main and perturbation series arrays. Only do this once!
+// Safe to call concurrently; only the first caller does any work.
 
 bool ELPMPP02::initSeries ( void )
 {
     if ( ! _init )
-        if ( setup_Elp_series() )
-            _init = true;
+    {
+        lock_guard<mutex> lock ( _initMutex );
+        if ( ! _init )
+            if ( setup_Elp_series() )
+                _init = true;
+    }
 
     return _init;
 }
@@ -4,8 +4,13 @@
 //  Created by Tim DeBenedictis on 2/24/20.
 //  Copyright © 2020 Southern Stars. All rights reserved.
 
+#include <chrono>
+#include <climits>
 #include <cstdio>
 #include <iostream>
+#include <random>
+#include <atomic>
+#include <thread>
 
 #if defined __APPLE__
 #include <TargetConditionals.h>
@@ -19,15 +24,26 @@
 #include "SSOrbit.hpp"
 #include "SSPlanet.hpp"
 #include "SSStar.hpp"
+#include "SSStarField.hpp"
 #include "SSConstellation.hpp"
 #include "SSImportHIP.hpp"
 #include "SSImportSKY2000.hpp"
 #include "SSImportNGCIC.hpp"
 #include "SSImportMPC.hpp"
 #include "SSImportGJ.hpp"
+#include "SSPipeline.hpp"
+#include "SSSnapshot.hpp"
+#include "SSSearch.hpp"
+#include "SSEclipse.hpp"
 #include "SSJPLDEphemeris.hpp"
+#include "SSOrbitBatch.hpp"
+#include "SSNBody.hpp"
+#include "SSChebyshevEphemeris.hpp"
 #include "SSTLE.hpp"
 #include "SSEvent.hpp"
+#include "SSView.hpp"
+#include "SSHTM.hpp"
+#include "SSGeometryCache.hpp"
 #include "VSOP2013.hpp"
 #include "ELPMPP02.hpp"
 
@@ -40,210 +56,2226 @@ void exportCatalog ( SSObjectVec &objects, SSCatalog cat, int first, int last )
         int i = map[ SSIdentifier ( cat, n ) ];
         if ( i > 0 )
         {
-            SSObjectPtr pObj = objects[ i - 1 ];
-            cout << pObj->toCSV() << endl;
+            SSObjectPtr pObj = objects[ i - 1 ];
+            cout << pObj->toCSV() << endl;
+        }
+    }
+}
+
+void TestTime ( void )
+{
+    SSTime now = SSTime::fromSystem();
+    SSDate date = now;
+
+    cout << "Current local date is " << format ( "%04hd-%02hd-%0hd", date.year, date.month, date.day ) << endl;
+    cout << "Current local time is " << format ( "%02hd:%02hd:%04.1f", date.hour, date.min, date.sec ) << endl;
+    cout << "Current local time is " << format ( "%+.2f", date.zone ) << " hours east of UTC" << endl;
+    cout << "Current Julian Date is " << format ( "%.6f", now.jd ) << endl;
+
+    cout << "Current working directory is " << getcwd() << endl << endl;
+
+    cout << "Before is "
+         << format("%04hd-%02hd-%02.0f %02hd:%02hd:%04.1f",
+              date.year,
+              date.month,
+              floor(date.day),
+              date.hour,
+              date.min,
+              date.sec)
+         << endl;
+    SSTime time2 = date;
+    SSDate date2 = time2;
+    cout << "After is "
+         << format("%04hd-%02hd-%02.0f %02hd:%02hd:%04.1f",
+              date2.year,
+              date2.month,
+              floor(date2.day),
+              date2.hour,
+              date2.min,
+              date2.sec)
+         << endl;
+};
+
+// Writes small observed Delta T and leap second files in all supported formats to the output directory,
+// imports them, and checks that getDeltaT() interpolates observed values, steps exactly at each leap second,
+// honors the leap second file's expiry, and falls back to SSTime::polynomialDeltaT() outside them and after
+// clearDeltaT(). Then checks that the bulk UTC/TT and TT/TDB conversions agree with SSTime and invert each other.
+
+void TestDeltaT ( string outputDir )
+{
+    int failed = 0, checks = 0;
+    auto check = [&] ( bool ok ) { failed += ! ok; checks++; };
+    auto polyDeltaT = [] ( SSTime t ) { return SSTime::polynomialDeltaT ( t.toJulianYear() - 0.5 / 12.0 ); };
+    auto date = [] ( int y, int m, double d ) { return SSTime ( SSDate ( kGregorian, 0.0, y, m, d ) ); };
+
+    // With nothing imported, Delta T is exactly the polynomial model, from antiquity into the future.
+    
+    SSTime::clearDeltaT();
+    for ( double jd = SSTime::fromJulianYear ( -1000.0 ); jd < SSTime::fromJulianYear ( 3000.0 ); jd += 1234.567 )
+        check ( SSTime ( jd ).getDeltaT() == polyDeltaT ( jd ) );
+    
+    // USNO deltat.data (y m d dT), deltat.preds (MJD year dT UT1-UTC error), and decimal year formats.
+    // Other lines, including headers with the wrong number of numbers, are ignored.
+    
+    string dataPath = outputDir + "/deltat.data", predsPath = outputDir + "/deltat.preds", yearsPath = outputDir + "/deltat.years";
+    ofstream ( dataPath ) << " 1973  2  1  43.4724\n 1973  3  1  43.5648\nYear Month Day DeltaT\n 1973  4  1  43.6737\n";
+    ofstream ( predsPath ) << "    MJD        YEAR    TT-UT Pred  UT1-UTC Pred  ERROR\n 61000.000  2025.75    69.20      -0.0158     0.096\n 61091.000  2026.00    69.24      -0.0535     0.144\n";
+    ofstream ( yearsPath ) << "1900.0 -2.72\n1901.0 -1.54 0.0 0.0 0.0 0.0\n1902.0 0.03\n";
+    
+    int generation = SSTime::getDeltaTGeneration();
+    check ( SSTime::importDeltaT ( dataPath ) == 3 );
+    check ( SSTime::importDeltaT ( predsPath ) == 2 );
+    check ( SSTime::importDeltaT ( yearsPath ) == 2 );
+    check ( SSTime::importDeltaT ( outputDir + "/nonexistent" ) == 0 );
+    check ( SSTime::getDeltaTGeneration() != generation );
+    
+    check ( fabs ( date ( 1973, 3, 1 ).getDeltaT() - 43.5648 ) < 1.0e-9 );
+    check ( fabs ( date ( 1973, 3, 15 ).getDeltaT() - ( 43.5648 + ( 43.6737 - 43.5648 ) * 14.0 / 31.0 ) ) < 1.0e-9 );
+    check ( fabs ( SSTime ( 61000.0 + 2400000.5 ).getDeltaT() - 69.20 ) < 1.0e-9 );
+    check ( fabs ( SSTime ( 61045.5 + 2400000.5 ).getDeltaT() - 69.22 ) < 1.0e-9 );
+    check ( fabs ( SSTime::fromJulianYear ( 1901.0 ).getDeltaT() - ( -2.72 + 0.03 ) / 2.0 ) < 1.0e-9 );
+    
+    // Dates between or beyond the observed files' spans interpolate across them (1902 to 1973 here),
+    // or fall back to the model (before 1900 and after 2026).
+    
+    check ( fabs ( SSTime::fromJulianYear ( 1920.0 ).getDeltaT() - polyDeltaT ( SSTime::fromJulianYear ( 1920.0 ) ) ) > 5.0 );
+    check ( SSTime::fromJulianYear ( 1899.0 ).getDeltaT() == polyDeltaT ( SSTime::fromJulianYear ( 1899.0 ) ) );
+    check ( SSTime::fromJulianYear ( 2027.0 ).getDeltaT() == polyDeltaT ( SSTime::fromJulianYear ( 2027.0 ) ) );
+
+    // IERS leap-seconds.list format: NTP seconds and TAI - UTC, with "#@" expiry on 28 June 2025.
+    // Delta T jumps by exactly one second at the start of each leap second date, and is TAI - UTC + 32.184 until expiry.
+    
+    string leapPath = outputDir + "/leap-seconds.list";
+    ofstream ( leapPath ) << "#\tLeap seconds\n#@\t3960057600\n2272060800\t10\t# 1 Jan 1972\n2287785600\t11\t# 1 Jul 1972\n3644697600\t36\t# 1 Jul 2015\n3692217600\t37\t# 1 Jan 2017\n";
+    check ( SSTime::importLeapSeconds ( leapPath ) == 4 );
+    
+    SSTime leap1972 = date ( 1972, 7, 1 ), leap2017 = date ( 2017, 1, 1 );
+    check ( fabs ( SSTime ( leap1972.jd - 1.0e-6 ).getDeltaT() - 42.184 ) < 1.0e-9 && fabs ( leap1972.getDeltaT() - 43.184 ) < 1.0e-9 );
+    check ( fabs ( SSTime ( leap2017.jd - 1.0e-6 ).getDeltaT() - 68.184 ) < 1.0e-9 && fabs ( leap2017.getDeltaT() - 69.184 ) < 1.0e-9 );
+    check ( fabs ( date ( 1973, 3, 15 ).getDeltaT() - 43.184 ) < 1.0e-9 );
+    check ( fabs ( date ( 2025, 6, 27 ).getDeltaT() - 69.184 ) < 1.0e-9 );
+    check ( fabs ( date ( 2025, 6, 29 ).getDeltaT() - 69.184 ) > 1.0e-3 );
+    check ( fabs ( SSTime ( 61000.0 + 2400000.5 ).getDeltaT() - 69.20 ) < 1.0e-9 );
+    check ( fabs ( date ( 1971, 12, 31 ).getDeltaT() - 42.184 ) > 1.0e-3 );
+    
+    // Without "#@", leap seconds are valid for one year after the last one.
+
+    SSTime::clearDeltaT();
+    ofstream ( leapPath ) << "2272060800\t10\n3692217600\t37\n";
+    check ( SSTime::importLeapSeconds ( leapPath ) == 2 );
+    check ( fabs ( date ( 2017, 12, 31 ).getDeltaT() - 69.184 ) < 1.0e-9 );
+    check ( date ( 2018, 1, 2 ).getDeltaT() == polyDeltaT ( date ( 2018, 1, 2 ) ) );
+    
+    // Bulk conversions agree with SSTime and invert each other, in place and out of place, away from leap seconds.
+    
+    vector<double> utc, tt, tdb, back;
+    for ( double jd = SSTime::fromJulianYear ( -1000.0 ); jd < SSTime::fromJulianYear ( 3000.0 ); jd += 987.654321 )
+        utc.push_back ( jd );
+    
+    tt.resize ( utc.size() );
+    tdb.resize ( utc.size() );
+    back.resize ( utc.size() );
+    
+    for ( int pass = 0; pass < 2; pass++ )
+    {
+        double maxUTC = 0.0, maxTT = 0.0;
+        
+        SSTime::UTCtoTT ( utc.data(), tt.data(), utc.size() );
+        SSTime::TTtoUTC ( tt.data(), back.data(), tt.size() );
+        for ( size_t i = 0; i < utc.size(); i++ )
+        {
+            check ( tt[i] == SSTime ( utc[i] ).getJulianEphemerisDate() );
+            maxUTC = max ( maxUTC, fabs ( back[i] - utc[i] ) );
+        }
+
+        SSTime::TTtoTDB ( tt.data(), tdb.data(), tt.size() );
+        back = tdb;
+        SSTime::TDBtoTT ( back.data(), back.data(), back.size() );
+        for ( size_t i = 0; i < utc.size(); i++ )
+        {
+            check ( tdb[i] == SSTime ( utc[i] ).getBarycentricDynamicalTime() );
+            maxTT = max ( maxTT, fabs ( back[i] - tt[i] ) );
+        }
+
+        // A double Julian Date resolves about 40 microseconds; allow a few of those.
+        
+        check ( maxUTC < 2.0e-9 && maxTT < 2.0e-9 );
+        cout << "Delta T: UTC->TT->UTC error " << maxUTC * SSTime::kSecondsPerDay * 1.0e6 << " us, TT->TDB->TT error " << maxTT * SSTime::kSecondsPerDay * 1.0e6 << " us" << ( pass ? " with leap seconds." : "." ) << endl;
+        
+        // Second pass with leap seconds imported; keep test dates a day away from them.
+        
+        SSTime::clearDeltaT();
+        ofstream ( leapPath ) << "#@\t3960057600\n2272060800\t10\n3692217600\t37\n";
+        SSTime::importLeapSeconds ( leapPath );
+        utc.push_back ( date ( 2017, 1, 2 ).jd );
+        utc.push_back ( date ( 2016, 12, 30 ).jd );
+        tt.resize ( utc.size() );
+        tdb.resize ( utc.size() );
+        back.resize ( utc.size() );
+    }
+    
+    // Clearing imported values restores the model everywhere.
+    
+    generation = SSTime::getDeltaTGeneration();
+    SSTime::clearDeltaT();
+    check ( SSTime::getDeltaTGeneration() != generation );
+    check ( date ( 2017, 1, 2 ).getDeltaT() == polyDeltaT ( date ( 2017, 1, 2 ) ) );
+    check ( date ( 1973, 3, 15 ).getDeltaT() == polyDeltaT ( date ( 1973, 3, 15 ) ) );
+    
+    cout << "Delta T: " << failed << " of " << checks << " checks failed." << endl;
+}
+
+void TestSatellites ( string inputDir, string outputDir )
+{
+    string filename = inputDir + "/SolarSystem/Satellites/visual.txt";
+    FILE *file = fopen ( filename.c_str(), "r" );
+    if ( ! file )
+    {
+        cout << "Failed to open " << filename << endl;
+        return;
+    }
+    
+    string outfilename = outputDir + "/ExportedSatellites.tle";
+    ofstream outfile ( outfilename );
+    if ( ! outfile )
+    {
+        cout << "Failed to open " << outfilename << endl;
+        return;
+    }
+    
+    SSTLE tle;
+    
+    while ( tle.read ( file ) == 0 )
+    {
+        tle.write ( cout );
+ 
+        SSVector pos, vel;
+
+        tle.toPositionVelocity ( tle.jdepoch + 10.0, pos, vel );
+
+        cout << format ( "JD %.6f  ", tle.jdepoch + 10.0 );
+        cout << format ( "pos %+10.3f %+10.3f %+10.3f  ", pos.x, pos.y, pos.z );
+        cout << format ( "vel %+7.3f %+7.3f %+7.3f",   vel.x, vel.y, vel.z ) << endl;
+
+        SSTLE tle1 = tle;
+        tle1.fromPositionVelocity ( tle.jdepoch + 10.0, pos, vel );
+        
+        SSTLE tle2 = tle1;
+        tle1.toPositionVelocity ( tle1.jdepoch - 10.0, pos, vel );
+        tle2.fromPositionVelocity ( tle1.jdepoch - 10.0, pos, vel );
+        tle2.write ( cout );
+        tle2.write ( outfile );
+     }
+}
+
+void TestSolarSystem ( string inputDir, string outputDir )
+{
+    SSObjectVec planets;
+    int numPlanets = SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", planets );
+    cout << "Imported " << numPlanets << " major planets" << endl;
+    numPlanets = SSExportObjectsToCSV ( "", planets );
+    
+    SSObjectVec moons;
+    int numMoons = SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", moons );
+    cout << "Imported " << numMoons << " natural satellites" << endl;
+    
+    SSObjectVec comets;
+    int numComets = SSImportMPCComets ( inputDir + "/SolarSystem/Comets.txt", comets );
+    cout << "Imported " << numComets << " MPC comets" << endl;
+
+    SSObjectVec asteroids;
+    int numAsteroids = SSImportMPCAsteroids ( inputDir + "/SolarSystem/Asteroids.txt", asteroids );
+    cout << "Imported " << numAsteroids << " MPC asteroids" << endl;
+
+    if ( ! outputDir.empty() )
+    {
+        numMoons = SSExportObjectsToCSV ( outputDir + "/ExportedMoons.csv", moons );
+        cout << "Exported " << numMoons << " natural satellites to " << outputDir + "/ExportedMoons.csv" << endl;
+
+        numComets = SSExportObjectsToCSV ( outputDir + "/ExportedComets.csv", comets );
+        cout << "Exported " << numComets << " MPC comets to " << outputDir + "/ExportedComets.csv" << endl;
+
+        numAsteroids = SSExportObjectsToCSV ( outputDir + "/ExportedAsteroids.csv", asteroids );
+        cout << "Exported " << numAsteroids << " MPC asteroids to " << outputDir + "/ExportedAsteroids.csv" << endl;
+    }
+}
+
+// Imports the MPC asteroid sample into an SSObjectVec, and into SSMPCOrbitTables on one and four threads.
+// Every asteroid in the tables must turn into an SSPlanet whose CSV matches the one in the object vector.
+// Then imports with SSMPCFilters selecting by absolute magnitude, orbit type, NEO flag, and all three;
+// each must keep exactly the asteroids in the unfiltered table that match, in the same order.
+
+void TestMPCImport ( string inputDir )
+{
+    string filename = inputDir + "/SolarSystem/Asteroids.txt";
+    SSObjectVec asteroids;
+    SSImportMPCAsteroids ( filename, asteroids );
+    int failed = asteroids.size() == 0, tested = 1;
+    
+    for ( int threads : { 1, 4 } )
+    {
+        SSMPCOrbitTable table;
+        int n = SSImportMPCAsteroids ( filename, table, SSMPCFilter(), threads );
+        failed += n != asteroids.size() || table.size() != asteroids.size();
+        for ( size_t k = 0; k < table.size() && k < asteroids.size(); k++ )
+        {
+            SSPlanetPtr pPlanet = table.toPlanet ( k );
+            failed += pPlanet->toCSV() != asteroids[k]->toCSV();
+            delete pPlanet;
+        }
+        tested += asteroids.size() + 1;
+    }
+    
+    SSMPCOrbitTable all;
+    SSImportMPCAsteroids ( filename, all, SSMPCFilter(), 1 );
+    
+    SSMPCFilter bright, nearEarth, neo, combined;
+    bright.maxHMagnitude = 10.0;
+    nearEarth.orbitTypes = ( 1ull << kMPCOrbitAten ) | ( 1ull << kMPCOrbitApollo ) | ( 1ull << kMPCOrbitAmor );
+    neo.requiredFlags = kMPCFlagNEO;
+    combined.maxHMagnitude = 18.0;
+    combined.orbitTypes = nearEarth.orbitTypes;
+    combined.requiredFlags = kMPCFlagNEO;
+    
+    for ( const SSMPCFilter *pFilter : { &bright, &nearEarth, &neo, &combined } )
+    {
+        vector<size_t> expected;
+        for ( size_t k = 0; k < all.size(); k++ )
+        {
+            int type = all.flags[k] & kMPCFlagOrbitType;
+            bool keep = all.hmag[k] <= pFilter->maxHMagnitude;
+            keep = keep && ( pFilter->orbitTypes == 0 || type == kMPCOrbitAten || type == kMPCOrbitApollo || type == kMPCOrbitAmor );
+            keep = keep && ( pFilter->requiredFlags == 0 || ( all.flags[k] & kMPCFlagNEO ) );
+            if ( keep )
+                expected.push_back ( k );
+        }
+        
+        failed += expected.empty() || expected.size() == all.size();
+        for ( int threads : { 1, 4 } )
+        {
+            SSMPCOrbitTable table;
+            SSImportMPCAsteroids ( filename, table, *pFilter, threads );
+            failed += table.size() != expected.size();
+            for ( size_t k = 0; k < table.size() && k < expected.size(); k++ )
+                failed += table.ident[k] != all.ident[ expected[k] ] || table.getName ( k ) != all.getName ( expected[k] ) || table.flags[k] != all.flags[ expected[k] ];
+            tested += expected.size() + 1;
+        }
+    }
+    
+    cout << "MPC import: " << failed << " of " << tested << " asteroids imported into orbit tables failed to match SSObjectVec import or filters." << endl;
+}
+
+void TestConstellations ( string inputDir, string outputDir )
+{
+    SSObjectVec constellations;
+    
+    int numCons = SSImportConstellations ( inputDir + "/Constellations/Constellations.csv", constellations );
+    cout << "Imported " << numCons << " IAU constellations" << endl;
+    
+    int numVerts = SSImportConstellationBoundaries ( inputDir + "/Constellations/Boundaries.csv", constellations );
+    cout << "Imported " << numVerts << " IAU constellation boundary vertices" << endl;
+
+    int numLines = SSImportConstellationShapes ( inputDir + "/Constellations/Shapes.csv", constellations );
+    cout << "Imported " << numLines << " IAU constellation shape lines" << endl;
+
+    if ( ! outputDir.empty() )
+    {
+        numCons = SSExportObjectsToCSV ( outputDir + "/ExportedConstellations.csv", constellations );
+        cout << "Exported " << numCons << " constellations to " << outputDir + "/ExportedConstellations.csv" << endl;
+    }
+}
+
+// Imports every CSV file in SSData with SSImportObjectsFromCSV() on one thread, four threads, and as many threads
+// as there are cores; and with the original per-class parsers, which try SSPlanet::fromCSV(), SSStar::fromCSV(),
+// and SSConstellation::fromCSV() on each line in turn. All must import the same objects in the same order,
+// and export them to identical CSV lines.
+
+void TestCSVImport ( string inputDir )
+{
+    const char *files[] = { "Stars/Brightest.csv", "Stars/Nearest.csv", "Stars/Names.csv", "SolarSystem/Planets.csv", "SolarSystem/Moons.csv",
+                            "SolarSystem/Satellites/je9pel.csv", "DeepSky/Messier.csv", "DeepSky/Caldwell.csv", "DeepSky/Names.csv",
+                            "Constellations/Constellations.csv", "Constellations/Boundaries.csv", "Constellations/Shapes.csv" };
+    int failed = 0, tested = 0;
+    
+    for ( const char *file : files )
+    {
+        string filename = inputDir + "/" + file;
+        vector<string> expected;
+        
+        FILE *pFile = fopen ( filename.c_str(), "r" );
+        string line;
+        while ( pFile && fgetline ( pFile, line ) )
+        {
+            SSObjectPtr pObj = SSPlanet::fromCSV ( line );
+            if ( pObj == nullptr )
+                pObj = SSStar::fromCSV ( line );
+            if ( pObj == nullptr )
+                pObj = SSConstellation::fromCSV ( line );
+            if ( pObj != nullptr )
+                expected.push_back ( pObj->toCSV() );
+            delete pObj;
+        }
+        
+        if ( pFile )
+            fclose ( pFile );
+        
+        for ( int threads : { 1, 4, 0 } )
+        {
+            SSObjectVec objects;
+            int n = SSImportObjectsFromCSV ( filename, objects, threads );
+            failed += n != expected.size() || objects.size() != expected.size();
+            for ( size_t i = 0; i < expected.size() && i < objects.size(); i++ )
+                failed += objects[i]->toCSV() != expected[i];
+            tested += expected.size() + 1;
+        }
+    }
+    
+    cout << "CSV import: " << failed << " of " << tested << " objects imported on 1, 4, and all threads failed to match per-class parsing." << endl;
+}
+
+void TestStars ( string inputDir, string outputDir )
+{
+    SSObjectVec nearest, brightest;
+    
+    int numStars = SSImportObjectsFromCSV ( inputDir + "/Stars/Nearest.csv", nearest );
+    cout << "Imported " << numStars << " nearby stars" << endl;
+    
+    numStars = SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", brightest );
+    cout << "Imported " << numStars << " bright stars" << endl;
+    
+    if ( ! outputDir.empty() )
+    {
+        numStars = SSExportObjectsToCSV ( outputDir + "/ExportedNearbyStars.csv", nearest );
+        cout << "Exported " << numStars << " nearby stars to " << outputDir + "/ExportedNearbyStars.csv" << endl;
+
+        numStars = SSExportObjectsToCSV ( outputDir + "/ExportedBrightStars.csv", brightest );
+        cout << "Exported " << numStars << " bright stars to " << outputDir + "/ExportedBrightStars.csv" << endl;
+    }
+}
+
+// Checks that SSStarField computes exactly the same directions, distances, and magnitudes as SSStar::computeEphemeris()
+// with space motion and parallax each on and off, so stars both take and skip the normalization of their directions.
+
+void TestStarField ( string inputDir )
+{
+    SSObjectVec stars;
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", stars );
+    SSStarField field ( stars );
+
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSCoordinates coords ( SSTime ( SSDate ( kGregorian, 0.0, 2020, 4, 15.0, 0, 0, 0.0 ) ), here );
+    coords.setAberration ( true );
+
+    int failed = 0, tested = 0;
+    for ( int flags = 0; flags < 4; flags++ )
+    {
+        coords.setStarMotion ( flags & 1 );
+        coords.setStarParallax ( flags & 2 );
+        field.computeEphemeris ( coords );
+
+        for ( size_t i = 0; i < field.size(); i++ )
+        {
+            SSStarPtr pStar = field.getStar ( i );
+            pStar->computeEphemeris ( coords );
+            SSVector dir = pStar->getDirection(), fdir = field.getDirection ( i );
+            failed += dir.x != fdir.x || dir.y != fdir.y || dir.z != fdir.z || pStar->getDistance() != field.getDistance ( i ) || pStar->getMagnitude() != field.getMagnitude ( i );
+            tested++;
+        }
+    }
+
+    cout << "Star field: " << failed << " of " << tested << " star ephemerides failed to match SSStar exactly." << endl;
+}
+
+// Times a full star field update, the way a planetarium display redraws the sky: for every bright star,
+// compute apparent direction with space motion, parallax, and aberration, transform to the local horizon
+// frame, and project onto a 90-degree stereographic view. Times both the per-object path (SSStar::computeEphemeris(),
+// SSCoordinates::transform(), and SSView::project() for each star) and the batched path (SSStarField, then
+// the array versions of transform() and project()) in the same run, and reports average time per star for each.
+
+void TestStarFieldSpeed ( string inputDir, int passes )
+{
+    SSObjectVec stars;
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", stars );
+    if ( stars.size() == 0 || passes < 1 )
+        return;
+
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSCoordinates coords ( SSTime ( SSDate ( kGregorian, 0.0, 2020, 4, 15.0, 0, 0, 0.0 ) ), here );
+    coords.setAberration ( true );
+
+    SSView view ( kStereographic, SSAngle::fromDegrees ( 90.0 ), 1920.0, 1080.0, 960.0, 540.0 );
+    view.setCenter ( 0.0, SSAngle::fromDegrees ( 45.0 ), 0.0 );
+
+    size_t visible = 0;
+    auto start = chrono::steady_clock::now();
+
+    for ( int pass = 0; pass < passes; pass++ )
+    {
+        visible = 0;
+        for ( int i = 0; i < stars.size(); i++ )
+        {
+            SSStar *pStar = SSGetStarPtr ( stars[i] );
+            if ( pStar == nullptr )
+                continue;
+
+            pStar->computeEphemeris ( coords );
+            SSVector hvec = coords.transform ( kFundamental, kHorizon, pStar->getDirection() );
+            SSVector pvec = view.project ( hvec );
+            if ( view.inBoundRect ( pvec.x, pvec.y ) )
+                visible++;
+        }
+    }
+
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    double perObject = elapsed.count() / ( (double) passes * stars.size() );
+
+    SSStarField field ( stars );
+    size_t n = field.size(), fieldVisible = 0;
+    vector<SSVector> hvecs ( n );
+    vector<double> x ( n ), y ( n );
+    start = chrono::steady_clock::now();
+
+    for ( int pass = 0; pass < passes; pass++ )
+    {
+        field.computeEphemeris ( coords );
+        const double *dx = field.getDirectionX(), *dy = field.getDirectionY(), *dz = field.getDirectionZ();
+        for ( size_t i = 0; i < n; i++ )
+            hvecs[i] = SSVector ( dx[i], dy[i], dz[i] );
+        
+        coords.transform ( kFundamental, kHorizon, hvecs.data(), hvecs.data(), n );
+        fieldVisible = view.project ( hvecs.data(), n, x.data(), y.data() );
+    }
+
+    elapsed = chrono::steady_clock::now() - start;
+    double batched = elapsed.count() / ( (double) passes * n );
+    
+    cout << format ( "Star field update: %d stars (%d visible) in %.1f ns per star per object, %d stars (%d visible) in %.1f ns per star batched; %.2fx faster",
+                     (int) stars.size(), (int) visible, perObject, (int) n, (int) fieldVisible, batched, perObject / batched ) << endl;
+}
+
+// Returns a random unit vector, uniformly distributed over the sphere.
+
+static SSVector RandomUnitVector ( mt19937 &gen )
+{
+    normal_distribution<double> normal;
+    SSVector v ( normal ( gen ), normal ( gen ), normal ( gen ) );
+    return v / v.magnitude();
+}
+
+// Checks the array versions of SSMatrix::multiply(), SSCoordinates::transform(), and SSCoordinates::toSpherical() against
+// the single-vector versions, for vectors stored as SSVectors (AoS) and as separate x, y, z arrays (SoA), out of place and
+// in place, with array sizes including zero, odd sizes, and sizes crossing toSpherical()'s 256-vector blocks. Array versions
+// must give exactly what one multiply by getTransformMatrix() gives; per-vector transform() multiplies by two matrices instead,
+// so it may differ in the last bit or two.
+
+void TestBatchTransforms ( void )
+{
+    mt19937 gen ( 20200419 );
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSCoordinates coords ( SSTime ( SSDate ( kGregorian, 0.0, 2020, 4, 15.0, 0, 0, 0.0 ) ), here );
+    int failed = 0, tested = 0;
+    double maxErr = 0.0;
+    
+    for ( size_t n : { 0, 1, 2, 3, 255, 256, 257, 1001 } )
+    {
+        vector<SSVector> in ( n );
+        vector<double> x ( n ), y ( n ), z ( n );
+        for ( size_t i = 0; i < n; i++ )
+        {
+            in[i] = RandomUnitVector ( gen ) * ( 1.0 + 1000.0 * ( gen() / 4294967296.0 ) );
+            x[i] = in[i].x;
+            y[i] = in[i].y;
+            z[i] = in[i].z;
+        }
+        
+        for ( int from = kFundamental; from <= kHorizon; from++ )
+        {
+            for ( int to = kFundamental; to <= kHorizon; to++ )
+            {
+                SSMatrix mat = coords.getTransformMatrix ( (SSFrame) from, (SSFrame) to );
+                vector<SSVector> out ( n ), inPlace ( in );
+                vector<double> ox ( n ), oy ( n ), oz ( n ), ix ( x ), iy ( y ), iz ( z );
+                vector<double> lon ( n ), lat ( n ), rad ( n );
+                vector<SSSpherical> sph ( n );
+                
+                mat.multiply ( in.data(), out.data(), n );
+                mat.multiply ( x.data(), y.data(), z.data(), ox.data(), oy.data(), oz.data(), n );
+                
+                for ( size_t i = 0; i < n; i++ )
+                {
+                    SSVector v = mat * in[i];
+                    failed += out[i].x != v.x || out[i].y != v.y || out[i].z != v.z || ox[i] != v.x || oy[i] != v.y || oz[i] != v.z;
+                }
+                
+                coords.transform ( (SSFrame) from, (SSFrame) to, inPlace.data(), inPlace.data(), n );
+                coords.transform ( (SSFrame) from, (SSFrame) to, ix.data(), iy.data(), iz.data(), ix.data(), iy.data(), iz.data(), n );
+                coords.toSpherical ( (SSFrame) from, (SSFrame) to, in.data(), sph.data(), n );
+                coords.toSpherical ( (SSFrame) from, (SSFrame) to, x.data(), y.data(), z.data(), lon.data(), lat.data(), rad.data(), n );
+                
+                for ( size_t i = 0; i < n; i++ )
+                {
+                    SSVector v = mat * in[i], t = coords.transform ( (SSFrame) from, (SSFrame) to, in[i] );
+                    SSSpherical s ( v );
+                    failed += inPlace[i].x != v.x || inPlace[i].y != v.y || inPlace[i].z != v.z || ix[i] != v.x || iy[i] != v.y || iz[i] != v.z;
+                    failed += sph[i].lon != s.lon || sph[i].lat != s.lat || sph[i].rad != s.rad || lon[i] != s.lon || lat[i] != s.lat || rad[i] != s.rad;
+                    
+                    double err = ( t - v ).magnitude() / v.magnitude();
+                    failed += err > 1.0e-15;
+                    maxErr = max ( maxErr, err );
+                    tested++;
+                }
+            }
+        }
+    }
+    
+    cout << "Batch transforms: " << failed << " of " << tested << " vectors failed to match single-vector transforms; max relative difference from transform() " << maxErr << endl;
+}
+
+// Checks the array version of SSView::project() against the single-point version, for all seven projections,
+// upright and inverted, centered at random. Input is an odd number of random points plus points where the view
+// frame x, y, or z is zero (with both signs of zero), the view center, its antipode, and points just behind
+// the view. Gnomonic, orthographic, and stereographic projections must give bit-identical results; the others
+// must agree within 2e-15 radians. Also checks the visibility flags and count, and that nothing is written
+// past the end of the output arrays.
+
+void TestViewProject ( void )
+{
+    mt19937 gen ( 20200415 );
+    vector<SSVector> points;
+    
+    for ( int i = 0; i < 10001; i++ )
+        points.push_back ( RandomUnitVector ( gen ) );
+    
+    for ( double a : { 0.0, -0.0 } )
+        for ( double b : { 0.0, -0.0 } )
+        {
+            points.push_back ( SSVector ( a, b, 1.0 ) );
+            points.push_back ( SSVector ( a, b, -1.0 ) );
+            points.push_back ( SSVector ( a, 1.0, b ) );
+            points.push_back ( SSVector ( a, -1.0, b ) );
+            points.push_back ( SSVector ( 1.0, a, b ) );
+            points.push_back ( SSVector ( -1.0, a, b ) );
+            points.push_back ( SSVector ( a, sqrt ( 0.5 ), -sqrt ( 0.5 ) ) );
+            points.push_back ( SSVector ( a, b, b ) );
+        }
+    
+    for ( double x : { -0.9, -0.9000000000000001, -0.8999999999999999, -1.0e-300, 1.0e-300 } )
+        points.push_back ( SSVector ( x, sqrt ( 1.0 - x * x ), 0.0 ) );
+    
+    if ( points.size() % 2 == 0 )
+        points.push_back ( RandomUnitVector ( gen ) );
+    
+    size_t n = points.size();
+    int failed = 0, tested = 0;
+    double maxErr = 0.0;
+    
+    for ( int proj = kGnomonic; proj <= kSinusoidal; proj++ )
+    {
+        bool exact = proj <= kStereographic;
+        
+        for ( int inverted = 0; inverted < 2; inverted++ )
+        {
+            SSView view ( (SSProjection) proj, SSAngle::fromDegrees ( 90.0 ), inverted ? -1920.0 : 1920.0, inverted ? -1080.0 : 1080.0, 960.0, 540.0 );
+            
+            for ( int center = 0; center < 3; center++ )
+            {
+                if ( center == 0 )
+                    view.setCenterMatrix ( SSMatrix::identity() );
+                else
+                    view.setCenter ( SSAngle ( SSAngle::kTwoPi * ( gen() / 4294967296.0 ) ), SSAngle ( asin ( 2.0 * gen() / 4294967296.0 - 1.0 ) ), SSAngle ( SSAngle::kTwoPi * ( gen() / 4294967296.0 ) ) );
+                
+                // Project a prefix of one point, three points, and all points, with guard values past the end.
+                
+                for ( size_t count : { (size_t) 1, (size_t) 3, n } )
+                {
+                    vector<double> x ( count + 1, -12345.0 ), y ( count + 1, -12345.0 );
+                    vector<uint8_t> visible ( count + 1, 99 );
+                    size_t numVisible = view.project ( points.data(), count, x.data(), y.data(), visible.data() );
+                    
+                    failed += x[count] != -12345.0 || y[count] != -12345.0 || visible[count] != 99;
+                    size_t counted = 0;
+                    
+                    for ( size_t i = 0; i < count; i++ )
+                    {
+                        SSVector v = view.project ( points[i] );
+                        double errX = v.x == x[i] ? 0.0 : fabs ( ( v.x - x[i] ) * view.getScaleX() );
+                        double errY = v.y == y[i] ? 0.0 : fabs ( ( v.y - y[i] ) * view.getScaleY() );
+                        double err = max ( errX, errY );
+                        
+                        failed += exact ? err != 0.0 : ! ( err <= 2.0e-15 );
+                        failed += visible[i] != view.inBoundRect ( x[i], y[i] );
+                        counted += visible[i];
+                        maxErr = max ( maxErr, err );
+                        tested++;
+                    }
+                    
+                    failed += numVisible != counted;
+                }
+            }
+        }
+    }
+    
+    cout << "View project: " << failed << " of " << tested << " projected points failed to match SSView::project(); max error " << maxErr << " rad." << endl;
+}
+
+// Checks that SSView::htmRegions() never omits a region containing a visible point. For each projection, upright and
+// inverted, at several field widths up to the projection's maximum and at random centers, samples points on the sky
+// at random and at random pixels inside the view; for every point that projects inside the view's bounding rectangle,
+// the ID of the HTM triangle containing it at each level must be among the regions returned for that level.
+
+void TestViewHTMRegions ( void )
+{
+    static constexpr int kLevels = 6;
+    mt19937 gen ( 20200416 );
+    uniform_real_distribution<double> uniform ( 0.0, 1.0 );
+    int failed = 0, tested = 0;
+    size_t regions = 0;
+    
+    for ( int proj = kGnomonic; proj <= kSinusoidal; proj++ )
+    {
+        for ( int inverted = 0; inverted < 2; inverted++ )
+        {
+            for ( double degrees : { 1.0, 30.0, 90.0, 179.0, 360.0 } )
+            {
+                SSView view ( (SSProjection) proj, SSAngle::fromDegrees ( 90.0 ), inverted ? -1920.0 : 1920.0, inverted ? -1080.0 : 1080.0, 960.0, 540.0 );
+                view.setAngularWidth ( min ( SSAngle::fromDegrees ( degrees ), view.maxAngularWidth() ) );
+                view.setCenter ( SSAngle ( SSAngle::kTwoPi * uniform ( gen ) ), SSAngle ( asin ( 2.0 * uniform ( gen ) - 1.0 ) ), SSAngle ( SSAngle::kTwoPi * uniform ( gen ) ) );
+                
+                vector<vector<uint64_t>> ids = view.htmRegions ( kLevels );
+                for ( int level = 0; level < kLevels; level++ )
+                    regions += ids[level].size();
+                
+                for ( int i = 0; i < 4000; i++ )
+                {
+                    SSVector cvec;
+                    if ( i % 2 )
+                        cvec = RandomUnitVector ( gen );
+                    else
+                        cvec = view.unproject ( SSVector ( view.getLeft() + uniform ( gen ) * fabs ( view.getWidth() ), view.getTop() + uniform ( gen ) * fabs ( view.getHeight() ), 0.0 ) );
+                    
+                    if ( ! ( cvec.magnitude() < INFINITY ) )
+                        continue;
+                    
+                    SSVector vvec = view.project ( cvec );
+                    if ( ! view.inBoundRect ( vvec.x, vvec.y ) )
+                        continue;
+                    
+                    for ( int level = 0; level < kLevels; level++ )
+                    {
+                        uint64_t id = level > 0 ? SSHTM::vector2ID ( cvec, level - 1 ) : 0;
+                        failed += ! binary_search ( ids[level].begin(), ids[level].end(), id );
+                        tested++;
+                    }
+                }
+            }
+        }
+    }
+    
+    cout << "View HTM regions: " << failed << " of " << tested << " visible points were outside the " << regions << " regions returned." << endl;
+}
+
+// Checks SSGeometryCache with constellation boundaries and figures, and an ecliptic grid, cached in the equatorial frame.
+// Steps the time through ten years and checks that update() rebuilds exactly when some source frame has rotated more
+// than the tolerance since the last build, and after a line is added. Then, for every projection, upright and inverted,
+// at several field widths and random centers, checks that no chunk rejected by cull() has a vertex or segment midpoint
+// inside the view's bounding rectangle.
+
+void TestGeometryCache ( string inputDir )
+{
+    SSObjectVec constellations, stars;
+    SSImportConstellations ( inputDir + "/Constellations/Constellations.csv", constellations );
+    SSImportConstellationBoundaries ( inputDir + "/Constellations/Boundaries.csv", constellations );
+    SSImportConstellationShapes ( inputDir + "/Constellations/Shapes.csv", constellations );
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", stars );
+
+    SSGeometryCache cache ( kEquatorial );
+    cache.addConstellationBoundaries ( constellations );
+    cache.addConstellationFigures ( constellations, stars );
+    cache.addGrid ( kEcliptic, SSAngle::fromDegrees ( 15.0 ), SSAngle::fromDegrees ( 10.0 ) );
+
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSTime start = SSTime ( SSDate ( kGregorian, 0.0, 2020, 1, 1.0, 0, 0, 0.0 ) );
+    SSCoordinates coords ( start, here );
+    SSFrame frames[] = { kFundamental, kEcliptic };
+    SSMatrix built[2];
+    int failed = 0, tested = 0, rebuilds = 0;
+    
+    // Rebuilds on the first update, and after adding a line, whatever the time.
+    
+    for ( int step = 0; step < 2; step++ )
+    {
+        failed += ! cache.update ( coords ) || cache.update ( coords );
+        tested++;
+        if ( step == 0 )
+            cache.addLine ( { SSVector ( 1.0, 0.0, 0.0 ), SSVector ( 0.0, 1.0, 0.0 ) }, kFundamental, -1, false );
+    }
+    
+    for ( int f = 0; f < 2; f++ )
+        built[f] = coords.getTransformMatrix ( frames[f], kEquatorial );
+    
+    for ( double t = 0.0; t < 3652.5; t += 5.0 )
+    {
+        coords.setTime ( start + t );
+        
+        bool expected = false;
+        for ( int f = 0; f < 2; f++ )
+            expected = expected || SSGeometryCache::rotationAngle ( built[f], coords.getTransformMatrix ( frames[f], kEquatorial ) ) > cache.getTolerance();
+        
+        bool rebuilt = cache.update ( coords );
+        failed += rebuilt != expected;
+        tested++;
+        
+        if ( rebuilt )
+        {
+            rebuilds++;
+            for ( int f = 0; f < 2; f++ )
+                built[f] = coords.getTransformMatrix ( frames[f], kEquatorial );
+        }
+    }
+    
+    // Precession alone moves the equatorial frame about 50 arcsec per year, so ten years need several rebuilds, not hundreds.
+    
+    failed += rebuilds < 5 || rebuilds > 100;
+    
+    mt19937 gen ( 20200417 );
+    uniform_real_distribution<double> uniform ( 0.0, 1.0 );
+    const vector<SSVector> &vertices = cache.getVertices();
+    const vector<SSGeometryCache::Chunk> &chunks = cache.getChunks();
+    size_t culled = 0;
+    
+    for ( int proj = kGnomonic; proj <= kSinusoidal; proj++ )
+    {
+        for ( int inverted = 0; inverted < 2; inverted++ )
+        {
+            for ( double degrees : { 1.0, 20.0, 90.0, 180.0 } )
+            {
+                for ( int i = 0; i < 10; i++ )
+                {
+                    SSView view ( (SSProjection) proj, SSAngle::fromDegrees ( 90.0 ), inverted ? -1920.0 : 1920.0, inverted ? -1080.0 : 1080.0, 960.0, 540.0 );
+                    view.setAngularWidth ( min ( SSAngle::fromDegrees ( degrees ), view.maxAngularWidth() ) );
+                    view.setCenter ( SSAngle ( SSAngle::kTwoPi * uniform ( gen ) ), SSAngle ( asin ( 2.0 * uniform ( gen ) - 1.0 ) ), SSAngle ( SSAngle::kTwoPi * uniform ( gen ) ) );
+                    
+                    vector<uint32_t> kept;
+                    cache.cull ( view, kept );
+                    failed += ! is_sorted ( kept.begin(), kept.end() );
+                    culled += chunks.size() - kept.size();
+                    
+                    for ( uint32_t c = 0, k = 0; c < chunks.size(); c++ )
+                    {
+                        if ( k < kept.size() && kept[k] == c )
+                        {
+                            k++;
+                            continue;
+                        }
+                        
+                        bool visible = false;
+                        for ( uint32_t v = chunks[c].first; v < chunks[c].first + chunks[c].count; v++ )
+                        {
+                            SSVector mid = v + 1 < chunks[c].first + chunks[c].count ? vertices[v] + vertices[v + 1] : vertices[v];
+                            SSVector p0 = view.project ( vertices[v] ), p1 = view.project ( mid / mid.magnitude() );
+                            visible = visible || view.inBoundRect ( p0.x, p0.y ) || view.inBoundRect ( p1.x, p1.y );
+                        }
+                        
+                        failed += visible;
+                        tested++;
+                    }
+                }
+            }
+        }
+    }
+    
+    cout << "Geometry cache: " << failed << " of " << tested << " checks failed; " << rebuilds << " rebuilds in 10 years; "
+         << culled << " chunks culled in " << 7 * 2 * 4 * 10 << " views of " << chunks.size() << " chunks." << endl;
+}
+
+// Imports bright stars into arena-mode object arrays, on one thread and several, and checks that every
+// object exports the same CSV as when imported on the heap. Checks that objects created in the arena are
+// stored without copying, that heap objects pushed into it are copied and the copy returned, that names and
+// identifiers are deduplicated (importing the same catalog twice adds nothing to the pool), that clones of
+// arena objects outlive the arena, and that pooled objects can still be modified.
+
+void TestObjectArena ( string inputDir )
+{
+    string filename = inputDir + "/Stars/Brightest.csv";
+    SSObjectVec heap;
+    SSImportObjectsFromCSV ( filename, heap );
+
+    int failed = 0;
+    size_t pooled = 0, distinct = 0, interned = 0;
+    vector<SSObjectPtr> clones;
+    
+    {
+        SSObjectVec arena1 ( true ), arena4 ( true ), copies ( true );
+        SSImportObjectsFromCSV ( filename, arena1, 1 );
+        SSImportObjectsFromCSV ( filename, arena4, 4 );
+        failed += arena1.size() != heap.size() || arena4.size() != heap.size();
+
+        for ( size_t i = 0; i < heap.size() && i < arena1.size() && i < arena4.size(); i++ )
+        {
+            string csv = heap[i]->toCSV();
+            failed += arena1[i]->toCSV() != csv || arena4[i]->toCSV() != csv;
+            
+            // A heap clone is copied into the arena and deleted, and push_back() returns the copy.
+            
+            SSObjectPtr pStored = copies.push_back ( SSCloneObject ( heap[i] ) );
+            failed += pStored != copies[i] || pStored->toCSV() != csv;
+        }
+        
+        // Re-importing the same stars must only find duplicates of pooled data.
+        
+        SSPool &pool = arena1.getArena()->getPool();
+        distinct = pool.getCount();
+        SSImportObjectsFromCSV ( filename, arena1, 1 );
+        failed += pool.getCount() != distinct;
+        interned = pool.getInterned();
+        
+        // An object created in the arena is stored as is.
+        
+        SSObjectPtr pObj = SSNewObject ( kTypeStar, arena1.getArena() );
+        pObj->setNames ( { "A name much too long to be stored inline", "Short" } );
+        failed += arena1.push_back ( pObj ) != pObj;
+        failed += pool.getCount() != distinct + 2;
+        
+        // Modifying a pooled object copies its data to the heap; its destructor frees it with the arena.
+        
+        SSStarPtr pStar = SSGetStarPtr ( arena1[0] );
+        vector<SSIdentifier> idents = pStar->getIdentifiers();
+        string spectrum = pStar->getSpectralType();
+        pStar->addIdentifier ( SSIdentifier ( kCatHD, 999999 ) );
+        pStar->sortIdentifiers();
+        pStar->setSpectralType ( spectrum + " with a long suffix" );
+        failed += pStar->getIdentifiers().size() != idents.size() + 1 || pStar->getSpectralType() != spectrum + " with a long suffix";
+        failed += SSGetStarPtr ( arena1[heap.size()] )->getIdentifiers() != idents;
+        
+        for ( size_t i = 0; i < arena4.size(); i++ )
+            clones.push_back ( SSCloneObject ( arena4[i] ) );
+        
+        pooled = arena1.size() + arena4.size() + copies.size();
+    }
+    
+    // Clones of arena objects must be intact after the arena is freed.
+    
+    for ( size_t i = 0; i < clones.size(); i++ )
+    {
+        failed += clones[i]->toCSV() != heap[i]->toCSV();
+        delete clones[i];
+    }
+    
+    cout << "Object arena: " << failed << " of " << heap.size() * 3 + 6 << " checks failed; " << pooled << " objects share " << distinct << " distinct pooled strings and identifier lists (" << interned << " interned)." << endl;
+}
+
+void TestDeepSky ( string inputDir, string outputDir )
+{
+    SSObjectVec messier, caldwell;
+    
+    int numObjs = SSImportObjectsFromCSV ( inputDir + "/DeepSky/Messier.csv", messier );
+    cout << "Imported " << numObjs << " Messier objects" << endl;
+    
+    numObjs = SSImportObjectsFromCSV ( inputDir + "/DeepSky/Caldwell.csv", caldwell );
+    cout << "Imported " << numObjs << " Caldwell objects" << endl;
+    
+    if ( ! outputDir.empty() )
+    {
+        numObjs = SSExportObjectsToCSV ( outputDir + "/ExportedMessier.csv", messier );
+        cout << "Exported " << numObjs << " Messier objects to " << outputDir + "/ExportedMessier.csv" << endl;
+
+        numObjs = SSExportObjectsToCSV ( outputDir + "/ExportedCaldwell.csv", caldwell );
+        cout << "Exported " << numObjs << " Caldwell objects to " << outputDir + "/ExportedCaldwell.csv" << endl;
+    }
+}
+
+void TestJPLDEphemeris ( string inputDir )
+{
+    SSJPLDEphemeris jpldeph;
+    
+    string ephemFile = inputDir + "/SolarSystem/DE438/1950_2050.438";
+    if ( ! jpldeph.open ( ephemFile ) )
+    {
+        cout << "Failed to open " << ephemFile << endl;
+        return;
+    }
+    
+    cout << "Successfully opened " << ephemFile << endl;
+    cout << "JED " << jpldeph.getStartJED() << " to " << jpldeph.getStopJED() << endl;
+    
+    // for ( int i = 0; i < jpldeph.getConstantNumber(); i++ )
+    //    cout << jpldeph.getConstantName ( i ) << " = " << jpldeph.getConstantValue ( i ) << endl;
+        
+    double jed = SSTime ( SSDate ( kGregorian, 0.0, 2020, 1, 1.0, 0, 0, 0.0 ) ).getJulianEphemerisDate();
+    SSVector pos, vel;
+    
+    for ( int id = 0; id <= 10; id++ )
+    {
+        jpldeph.compute ( id, jed, true, pos, vel );
+        cout << format ( "obj %2d  ", id );
+        cout << format ( "pos %+12.8f %+12.8f %+12.8f  ", pos.x, pos.y, pos.z );
+        cout << format ( "vel %+11.8f %+11.8f %+11.8f", vel.x, vel.y, vel.z ) << endl;
+    }
+    
+    jpldeph.close();
+}
+
+// Returns true if two values are identical, counting two NaNs as identical.
+
+static bool same ( double a, double b )
+{
+    return a == b || ( isnan ( a ) && isnan ( b ) );
+}
+
+static bool same ( SSVector a, SSVector b )
+{
+    return same ( a.x, b.x ) && same ( a.y, b.y ) && same ( a.z, b.z );
+}
+
+// Returns true if two objects (a) and (b) have identical types, names, and every field
+// a binary snapshot stores for them.
+
+static bool sameSnapshotObject ( SSObjectPtr a, SSObjectPtr b )
+{
+    if ( a->getType() != b->getType() || a->getNames() != b->getNames() || ! same ( a->getDirection(), b->getDirection() )
+        || ! same ( a->getDistance(), b->getDistance() ) || ! same ( a->getMagnitude(), b->getMagnitude() ) )
+        return false;
+    
+    SSPlanetPtr pA = SSGetPlanetPtr ( a ), pB = SSGetPlanetPtr ( b );
+    if ( ( pA == nullptr ) != ( pB == nullptr ) )
+        return false;
+    
+    if ( pA )
+    {
+        SSOrbit oA = pA->getOrbit(), oB = pB->getOrbit();
+        if ( pA->getIdentifier() != pB->getIdentifier() || ! same ( oA.t, oB.t ) || ! same ( oA.q, oB.q ) || ! same ( oA.e, oB.e )
+            || ! same ( oA.i, oB.i ) || ! same ( oA.w, oB.w ) || ! same ( oA.n, oB.n ) || ! same ( oA.m, oB.m ) || ! same ( oA.mm, oB.mm )
+            || ! same ( pA->getHMagnitude(), pB->getHMagnitude() ) || ! same ( pA->getGMagnitude(), pB->getGMagnitude() )
+            || ! same ( pA->getRadius(), pB->getRadius() ) )
+            return false;
+        
+        SSSatellitePtr sA = SSGetSatellitePtr ( a ), sB = SSGetSatellitePtr ( b );
+        if ( ( sA == nullptr ) != ( sB == nullptr ) )
+            return false;
+        
+        if ( sA )
+        {
+            SSTLE tA = sA->getTLE(), tB = sB->getTLE();
+            if ( tA.name != tB.name || tA.desig != tB.desig || tA.norad != tB.norad || ! same ( tA.jdepoch, tB.jdepoch )
+                || ! same ( tA.xndt2o, tB.xndt2o ) || ! same ( tA.xndd6o, tB.xndd6o ) || ! same ( tA.bstar, tB.bstar )
+                || ! same ( tA.xincl, tB.xincl ) || ! same ( tA.xnodeo, tB.xnodeo ) || ! same ( tA.eo, tB.eo )
+                || ! same ( tA.omegao, tB.omegao ) || ! same ( tA.xmo, tB.xmo ) || ! same ( tA.xno, tB.xno ) || tA.deep != tB.deep )
+                return false;
+        }
+    }
+    
+    SSStarPtr pStarA = SSGetStarPtr ( a ), pStarB = SSGetStarPtr ( b );
+    if ( ( pStarA == nullptr ) != ( pStarB == nullptr ) )
+        return false;
+    
+    if ( pStarA )
+    {
+        if ( pStarA->getIdentifiers() != pStarB->getIdentifiers() || ! same ( pStarA->getFundamentalPosition(), pStarB->getFundamentalPosition() )
+            || ! same ( pStarA->getFundamentalVelocity(), pStarB->getFundamentalVelocity() ) || ! same ( pStarA->getParallax(), pStarB->getParallax() )
+            || ! same ( pStarA->getRadVel(), pStarB->getRadVel() ) || ! same ( pStarA->getVMagnitude(), pStarB->getVMagnitude() )
+            || ! same ( pStarA->getBMagnitude(), pStarB->getBMagnitude() ) || pStarA->getSpectralType() != pStarB->getSpectralType() )
+            return false;
+        
+        SSDoubleStarPtr dA = SSGetDoubleStarPtr ( a ), dB = SSGetDoubleStarPtr ( b );
+        if ( ( dA == nullptr ) != ( dB == nullptr ) )
+            return false;
+        
+        if ( dA && ( dA->getComponents() != dB->getComponents() || ! same ( dA->getMagnitudeDelta(), dB->getMagnitudeDelta() )
+            || ! same ( dA->getSeparation(), dB->getSeparation() ) || ! same ( dA->getPositionAngle(), dB->getPositionAngle() )
+            || ! same ( dA->getPositionAngleYear(), dB->getPositionAngleYear() ) ) )
+            return false;
+        
+        SSVariableStarPtr vA = SSGetVariableStarPtr ( a ), vB = SSGetVariableStarPtr ( b );
+        if ( ( vA == nullptr ) != ( vB == nullptr ) )
+            return false;
+        
+        if ( vA && ( vA->getVariableType() != vB->getVariableType() || ! same ( vA->getMaximumMagnitude(), vB->getMaximumMagnitude() )
+            || ! same ( vA->getMinimumMagnitude(), vB->getMinimumMagnitude() ) || ! same ( vA->getPeriod(), vB->getPeriod() )
+            || ! same ( vA->getEpoch(), vB->getEpoch() ) ) )
+            return false;
+        
+        SSDeepSkyPtr gA = SSGetDeepSkyPtr ( a ), gB = SSGetDeepSkyPtr ( b );
+        if ( ( gA == nullptr ) != ( gB == nullptr ) )
+            return false;
+        
+        if ( gA && ( ! same ( gA->getMajorAxis(), gB->getMajorAxis() ) || ! same ( gA->getMinorAxis(), gB->getMinorAxis() )
+            || ! same ( gA->getPositionAngle(), gB->getPositionAngle() ) ) )
+            return false;
+    }
+    
+    SSConstellationPtr cA = SSGetConstellationPtr ( a ), cB = SSGetConstellationPtr ( b );
+    if ( ( cA == nullptr ) != ( cB == nullptr ) )
+        return false;
+    
+    if ( cA )
+    {
+        vector<SSVector> bA = cA->getBoundary(), bB = cB->getBoundary();
+        if ( ! same ( cA->getArea(), cB->getArea() ) || cA->getRank() != cB->getRank() || cA->getFigure() != cB->getFigure() || bA.size() != bB.size() )
+            return false;
+        
+        for ( size_t i = 0; i < bA.size(); i++ )
+            if ( ! same ( bA[i], bB[i] ) )
+                return false;
+    }
+    
+    return true;
+}
+
+// Returns every normalized key SSSearchIndex indexes an object (pObj) under, with its rank:
+// 0 = primary name, 1 = other name, 2 = identifier, 3 = word within name. Written independently
+// of the index, as a reference for checking it by brute force.
+
+static vector<pair<string,int>> searchKeys ( SSObjectPtr pObj )
+{
+    vector<pair<string,int>> keys;
+    auto keep = [] ( char c ) { return ! SSSearchIndex::normalize ( string ( 1, c ) ).empty(); };
+
+    vector<string> names = pObj->getNames();
+    for ( int k = 0; k < names.size(); k++ )
+    {
+        const string &name = names[k];
+        keys.push_back ( { SSSearchIndex::normalize ( name ), k == 0 ? 0 : 1 } );
+        for ( size_t i = 1; i < name.length(); i++ )
+            if ( keep ( name[i] ) && ! keep ( name[i - 1] ) && name[i - 1] != '\'' && ! SSSearchIndex::normalize ( name.substr ( 0, i ) ).empty() )
+                keys.push_back ( { SSSearchIndex::normalize ( name.substr ( i ) ), 3 } );
+    }
+
+    SSIdentifierVec idents;
+    SSStarPtr pStar = SSGetStarPtr ( pObj );
+    SSPlanetPtr pPlanet = SSGetPlanetPtr ( pObj );
+    if ( pStar != nullptr )
+        idents = pStar->getIdentifiers();
+    else if ( pPlanet != nullptr && pPlanet->getIdentifier() )
+        idents.push_back ( pPlanet->getIdentifier() );
+
+    for ( SSIdentifier ident : idents )
+    {
+        if ( ident.catalog() == kCatJPLanet )
+            continue;
+
+        string str = ident.toString();
+        keys.push_back ( { SSSearchIndex::normalize ( str ), 2 } );
+
+        size_t len = str.find_first_not_of ( "abcdefghijklmnopqrstuvwxyz" );
+        if ( ident.catalog() == kCatBayer && len != string::npos && len > 3 )
+            keys.push_back ( { SSSearchIndex::normalize ( str.substr ( 0, 3 ) + str.substr ( len ) ), 2 } );
+    }
+
+    keys.erase ( remove_if ( keys.begin(), keys.end(), [] ( const pair<string,int> &key ) { return key.first.empty(); } ), keys.end() );
+    return keys;
+}
+
+// Returns optimal string alignment distance between (a) and (b): Levenshtein distance,
+// plus transpositions of adjacent characters.
+
+static int osaDistance ( const string &a, const string &b )
+{
+    vector<vector<int>> d ( a.length() + 1, vector<int> ( b.length() + 1 ) );
+    for ( size_t i = 0; i <= a.length(); i++ )
+        for ( size_t j = 0; j <= b.length(); j++ )
+        {
+            if ( i == 0 || j == 0 )
+            {
+                d[i][j] = (int) ( i + j );
+                continue;
+            }
+
+            d[i][j] = min ( min ( d[i - 1][j] + 1, d[i][j - 1] + 1 ), d[i - 1][j - 1] + ( a[i - 1] == b[j - 1] ? 0 : 1 ) );
+            if ( i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1] )
+                d[i][j] = min ( d[i][j], d[i - 2][j - 2] + 1 );
+        }
+
+    return d[a.length()][b.length()];
+}
+
+// Returns indices of the best (maxResults) objects for a query (query), found by brute force over every
+// object's keys: with (fuzzy) false, keys beginning with the query, whole-key matches first; with (fuzzy)
+// true, keys within (maxDist) edits of the query, closest first. Then names before identifiers before words,
+// shorter keys before longer ones, and objects in array order, as SSSearchIndex ranks them.
+
+static vector<int> bruteForceSearch ( SSObjectVec &objects, const string &query, bool fuzzy, int maxDist, size_t maxResults )
+{
+    string q = SSSearchIndex::normalize ( query );
+    vector<tuple<int,int,int,size_t,int>> best;
+
+    for ( int i = 0; i < objects.size(); i++ )
+    {
+        tuple<int,int,int,size_t,int> objBest ( INT_MAX, 0, 0, 0, i );
+        for ( auto &key : searchKeys ( objects[i] ) )
+        {
+            tuple<int,int,int,size_t,int> cand ( INT_MAX, 0, 0, 0, i );
+            if ( fuzzy )
+            {
+                int dist = osaDistance ( key.first, q );
+                if ( dist <= maxDist )
+                    cand = make_tuple ( dist, 0, key.second, key.first.length(), i );
+            }
+            else if ( key.first.compare ( 0, q.length(), q ) == 0 )
+            {
+                cand = make_tuple ( 0, key.first.length() == q.length() ? 0 : 1, key.second, key.first.length(), i );
+            }
+
+            objBest = min ( objBest, cand );
+        }
+
+        if ( get<0> ( objBest ) != INT_MAX )
+            best.push_back ( objBest );
+    }
+
+    sort ( best.begin(), best.end() );
+    vector<int> indices;
+    for ( size_t k = 0; k < best.size() && k < maxResults; k++ )
+        indices.push_back ( get<4> ( best[k] ) );
+
+    return indices;
+}
+
+// Builds a search index of the planets, moons, and bright stars. Checks prefix completion and fuzzy
+// matching for several queries against a brute-force search, then checks a few results by name:
+// an exact prefix, best-ranked completion, a transposition, two typos, and three typos (no match).
+
+// Checks indexed constellation identification against a linear scan of the boundary table, over a B1875 grid
+// which includes the poles and points one ulp either side of every band edge on it; then over J2000 unit vectors,
+// including the poles, in both single and batch forms; then checks constellation index/abbreviation conversion.
+
+// Checks SSIdentifierHashMap against multimap with random keys in several catalogs, many of them duplicated:
+// after every insertion that grows the hash table, and at the end, every key's count(), equal_range() values and
+// their order, and operator [] must match multimap, whose equal keys also keep insertion order. Missing keys must
+// be found nowhere, and never inserted. Then checks that reserve() and clear() leave the map working.
+
+void TestIdentifierHashMap ( void )
+{
+    mt19937 gen ( 20200418 );
+    SSCatalog catalogs[] = { kCatHR, kCatHD, kCatHIP, kCatNGC };
+    SSIdentifierHashMap<int> map;
+    multimap<int64_t,int> expected;
+    vector<SSIdentifier> keys;
+    int failed = 0, tested = 0;
+    
+    auto compare = [&] ( void )
+    {
+        failed += map.size() != expected.size();
+        for ( SSIdentifier key : keys )
+        {
+            auto range = map.equal_range ( key );
+            auto expect = expected.equal_range ( key );
+            size_t n = 0;
+            
+            for ( auto i = range.first; i != range.second; ++i, ++expect.first, n++ )
+                failed += expect.first == expect.second || i->second != expect.first->second || i->first != key;
+            
+            failed += expect.first != expect.second || n != map.count ( key ) || n != expected.count ( key );
+            failed += map[ key ] != ( n ? expected.find ( key )->second : 0 ) || ( map.find ( key ) == nullptr ) != ( n == 0 );
+            tested++;
+        }
+        
+        failed += map.count ( SSIdentifier ( kCatSAO, 1 ) ) != 0 || map[ SSIdentifier ( kCatSAO, 1 ) ] != 0 || map.size() != expected.size();
+    };
+    
+    size_t distinct = 0;
+    for ( int i = 0; i < 20000; i++ )
+    {
+        SSIdentifier key ( catalogs[ gen() % 4 ], 1 + gen() % 5000 );
+        keys.push_back ( key );
+        map.insert ( { key, i } );
+        expected.insert ( { key, i } );
+        
+        // Check whenever the table has just doubled: the 9th distinct key grows it from 16 to 32 slots,
+        // the 17th from 32 to 64, and so on.
+        
+        distinct += expected.count ( key ) == 1;
+        if ( ( expected.count ( key ) == 1 && distinct > 8 && ( ( distinct - 1 ) & ( distinct - 2 ) ) == 0 ) || i == 19999 )
+            compare();
+    }
+    
+    // Iteration covers all entries in insertion order.
+    
+    int index = 0;
+    for ( auto &entry : map )
+        failed += entry.second != index || entry.first != keys[ index++ ];
+    failed += index != 20000;
+    
+    map.clear();
+    expected.clear();
+    failed += ! map.empty() || map.count ( keys[0] ) != 0 || map.find ( keys[0] ) != nullptr;
+    
+    map.reserve ( 1000 );
+    for ( int i = 0; i < 3000; i++ )
+    {
+        map.insert ( { keys[i], -i } );
+        expected.insert ( { keys[i], -i } );
+    }
+    
+    keys.resize ( 3000 );
+    compare();
+    
+    cout << "Identifier hash map: " << failed << " of " << tested << " key lookups failed to match multimap." << endl;
+}
+
+// Runs a small synthetic SSPipeline on 1, 2, 4, and all threads. Every stage must start only after all of its inputs
+// have finished. Stage 4 throws, so stage 5, which depends on it, and stage 6, which depends on stage 5, must be skipped,
+// while every other stage still runs. Stage 7 also throws, but only after stage 4 has, so run() must rethrow stage 4's
+// exception. Then checks that the same pipeline without failing stages runs every stage and returns normally.
+
+void TestPipeline ( void )
+{
+    int failed = 0, tested = 0;
+    
+    for ( bool throws : { true, false } )
+    {
+        for ( int threads : { 1, 2, 4, 0 } )
+        {
+            static constexpr int kStages = 9;
+            atomic<int> clock ( 0 );
+            atomic<bool> thrown ( false );
+            vector<int> started ( kStages, -1 ), ended ( kStages, -1 );
+            SSPipeline pipeline;
+            
+            auto stage = [&] ( int i, bool fail ) -> function<int(void)>
+            {
+                return [&, i, fail] ( void )
+                {
+                    started[i] = clock++;
+                    this_thread::sleep_for ( chrono::milliseconds ( 2 ) );
+                    if ( fail && i == 7 )
+                    {
+                        while ( ! thrown )
+                            this_thread::sleep_for ( chrono::milliseconds ( 1 ) );
+                        this_thread::sleep_for ( chrono::milliseconds ( 50 ) );
+                    }
+                    ended[i] = clock++;
+                    if ( fail && i == 4 )
+                        thrown = true;
+                    if ( fail )
+                        throw runtime_error ( "stage " + to_string ( i ) );
+                    return i * 10 + 1;
+                };
+            };
+            
+            pipeline.addStage ( "A", stage ( 0, false ) );
+            pipeline.addStage ( "B", stage ( 1, false ), { 0 } );
+            pipeline.addStage ( "C", stage ( 2, false ), { 0 } );
+            pipeline.addStage ( "D", stage ( 3, false ), { 1, 2 } );
+            pipeline.addStage ( "E", stage ( 4, throws ), { 0 } );
+            pipeline.addStage ( "F", stage ( 5, false ), { 4 } );
+            pipeline.addStage ( "G", stage ( 6, false ), { 5, 3 } );
+            pipeline.addStage ( "H", stage ( 7, throws ), { 0 } );
+            pipeline.addStage ( "I", stage ( 8, false ) );
+            
+            string error;
+            try
+            {
+                pipeline.run ( threads );
+            }
+            catch ( const runtime_error &e )
+            {
+                error = e.what();
+            }
+            
+            failed += error != ( throws ? "stage 4" : "" );
+            
+            const vector<SSPipeline::Stage> &stages = pipeline.getStages();
+            for ( int i = 0; i < kStages; i++ )
+            {
+                bool skipped = throws && ( i == 5 || i == 6 );
+                bool threw = throws && ( i == 4 || i == 7 );
+                failed += skipped ? started[i] >= 0 : started[i] < 0 || ended[i] < started[i];
+                failed += pipeline.getResult ( i ) != ( skipped || threw ? 0 : i * 10 + 1 );
+                
+                for ( int input : stages[i].inputs )
+                    failed += started[i] >= 0 && ! ( ended[input] >= 0 && ended[input] < started[i] );
+                
+                tested++;
+            }
+        }
+    }
+    
+    cout << "Pipeline: " << failed << " of " << tested << " stages ran out of order, or were wrongly run or skipped." << endl;
+}
+
+void TestConstellationIndex ( void )
+{
+    int failed = 0, tested = 0;
+
+    for ( int i = -360; i <= 360; i++ )
+    {
+        double dec = i / 4.0;
+        double decs[3] = { nextafter ( dec, -INFINITY ), dec, nextafter ( dec, INFINITY ) };
+        for ( double d : decs )
+        {
+            for ( int m = 0; m < 1440; m += d == dec ? 1 : 15 )
+            {
+                double ra = m / 60.0 * SSAngle::kRadPerHour, de = d * SSAngle::kRadPerDeg;
+                int expected = SSConstellation::abbreviationToIndex ( SSConstellation::identifyByScan ( ra, de ) );
+                failed += SSConstellation::identifyIndex ( ra, de ) != expected;
+                failed += SSConstellation::abbreviationToIndex ( SSConstellation::identify ( ra, de ) ) != expected;
+                tested++;
+            }
+        }
+    }
+
+    // Points spread evenly over the sphere on a Fibonacci spiral, plus both poles.
+
+    vector<SSVector> positions;
+    int numPoints = 100000;
+    for ( int i = 0; i < numPoints; i++ )
+    {
+        double z = 1.0 - ( 2.0 * i + 1.0 ) / numPoints;
+        double r = sqrt ( 1.0 - z * z ), lon = i * SSAngle::kTwoPi * 0.6180339887498949;
+        positions.push_back ( SSVector ( r * cos ( lon ), r * sin ( lon ), z ) );
+    }
+    positions.push_back ( SSVector ( 0.0, 0.0, 1.0 ) );
+    positions.push_back ( SSVector ( 0.0, 0.0, -1.0 ) );
+
+    SSMatrix precess = SSCoordinates::getPrecessionMatrix ( SSTime::fromBesselianYear ( 1875.0 ) );
+    vector<int> indices ( positions.size() );
+    SSConstellation::identifyIndex ( positions.data(), positions.size(), indices.data() );
+    for ( size_t i = 0; i < positions.size(); i++ )
+    {
+        SSSpherical coords = precess * positions[i];
+        int expected = SSConstellation::abbreviationToIndex ( SSConstellation::identifyByScan ( coords.lon, coords.lat ) );
+        failed += expected < 1 || SSConstellation::identifyIndex ( positions[i] ) != expected || indices[i] != expected;
+        tested++;
+    }
+
+    failed += SSConstellation::indexToAbbreviation ( 1 ) != "And" || SSConstellation::indexToAbbreviation ( 88 ) != "Vul";
+    failed += SSConstellation::indexToAbbreviation ( 0 ) != "" || SSConstellation::indexToAbbreviation ( 89 ) != "";
+    for ( int i = 1; i <= 88; i++ )
+        failed += SSConstellation::abbreviationToIndex ( SSConstellation::indexToAbbreviation ( i ) ) != i;
+
+    tested += 90;
+    cout << "Constellation index: " << failed << " of " << tested << " identifications failed to match boundary table scan." << endl;
+}
+
+void TestSearchIndex ( string inputDir )
+{
+    SSObjectVec objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", objects );
+
+    SSSearchIndex index ( objects );
+    int failed = 0, tested = 0;
+
+    const char *prefixes[] = { "mar", "al", "sa", "hr 1", "alp", "betelg", "io" };
+    for ( const char *prefix : prefixes )
+    {
+        vector<int> expected = bruteForceSearch ( objects, prefix, false, 0, 20 );
+        vector<int> found;
+        for ( SSSearchMatch &match : index.completePrefix ( prefix, 20 ) )
+            found.push_back ( match.index );
+
+        failed += found != expected;
+        tested++;
+    }
+
+    const char *queries[] = { "Betelgeues", "Btelgeuxe", "Aldebaarn", "Siruis", "Btelgxuze", "Jupitre" };
+    for ( const char *query : queries )
+    {
+        vector<int> expected = bruteForceSearch ( objects, query, true, 2, 50 );
+        vector<int> found;
+        for ( SSSearchMatch &match : index.findFuzzy ( query, 2, 50 ) )
+            found.push_back ( match.index );
+
+        failed += found != expected;
+        tested++;
+    }
+
+    // Exact prefix; best ranked completion (a primary name shorter than every other);
+    // a transposition; two typos; and three typos, too many to match.
+
+    vector<SSSearchMatch> matches = index.completePrefix ( "Betelg" );
+    failed += matches.empty() || matches[0].text != "Betelgeuse" || matches[0].distance != 0 || matches[0].complete;
+
+    matches = index.completePrefix ( "Mar" );
+    failed += matches.empty() || matches[0].text != "Mars";
+
+    matches = index.findFuzzy ( "Aldebaarn", 2 );
+    failed += matches.empty() || matches[0].text != "Aldebaran" || matches[0].distance != 1;
+
+    matches = index.findFuzzy ( "Btelgeuxe", 2 );
+    failed += matches.empty() || matches[0].text != "Betelgeuse" || matches[0].distance != 2;
+
+    matches = index.findFuzzy ( "Btelgxuze", 2 );
+    for ( SSSearchMatch &match : matches )
+        failed += match.text == "Betelgeuse" || match.distance > 2;
+
+    tested += 5;
+    cout << "Search index: " << index.size() << " keys; " << failed << " of " << tested << " searches failed to match brute force or expected results." << endl;
+}
+
+// Writes a binary snapshot of solar system objects, satellites, stars, deep sky objects, and
+// constellations, reloads it, and checks every object against the original, field by field.
+// Includes a star with a name too long, and more names and identifiers, than older snapshot formats could hold.
+// Then checks that truncated snapshots, and files which aren't snapshots, are rejected.
+
+void TestSnapshot ( string inputDir, string outputDir )
+{
+    if ( outputDir.empty() )
+        return;
+    
+    SSObjectVec objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", objects );
+    SSImportSatellitesFromTLE ( inputDir + "/SolarSystem/Satellites/visual.txt", objects );
+    SSImportMPCAsteroids ( inputDir + "/SolarSystem/Asteroids.txt", objects );
+    SSImportMPCComets ( inputDir + "/SolarSystem/Comets.txt", objects );
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Nearest.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/DeepSky/Messier.csv", objects );
+    
+    SSObjectVec constellations;
+    SSImportConstellations ( inputDir + "/Constellations/Constellations.csv", constellations );
+    SSImportConstellationBoundaries ( inputDir + "/Constellations/Boundaries.csv", constellations );
+    SSImportConstellationShapes ( inputDir + "/Constellations/Shapes.csv", constellations );
+    for ( size_t i = 0; i < constellations.size(); i++ )
+        objects.push_back ( SSCloneObject ( constellations[i] ) );
+    
+    SSObjectPtr pBig = SSNewObject ( kTypeStar );
+    vector<string> names = { string ( 70000, 'x' ) };
+    vector<SSIdentifier> idents;
+    for ( int i = 1; i <= 300; i++ )
+    {
+        names.push_back ( "Name " + to_string ( i ) );
+        idents.push_back ( SSIdentifier ( kCatHD, i ) );
+    }
+    pBig->setNames ( names );
+    SSGetStarPtr ( pBig )->setIdentifiers ( idents );
+    objects.push_back ( pBig );
+    
+    string snapFile = outputDir + "/Objects.snapshot";
+    int n = SSExportObjectsToSnapshot ( snapFile, objects );
+    cout << "Exported " << n << " objects to " << snapFile << endl;
+    
+    SSObjectVec loaded;
+    int m = SSImportObjectsFromSnapshot ( snapFile, loaded );
+    
+    int failed = 0;
+    for ( size_t i = 0; i < objects.size() && i < loaded.size(); i++ )
+        if ( ! sameSnapshotObject ( objects[i], loaded[i] ) )
+            failed++;
+    
+    cout << "Imported " << m << " objects from snapshot; " << failed << " failed to match the originals." << endl;
+    
+    // Rewrite the snapshot without its last few bytes, then with a damaged magic number.
+    
+    string data;
+    FILE *file = fopen ( snapFile.c_str(), "rb" );
+    if ( file )
+    {
+        char buf[65536];
+        for ( size_t len = fread ( buf, 1, sizeof ( buf ), file ); len > 0; len = fread ( buf, 1, sizeof ( buf ), file ) )
+            data.append ( buf, len );
+        fclose ( file );
+    }
+    
+    string badFile = outputDir + "/Damaged.snapshot";
+    int rejected = 0;
+    for ( int test = 0; test < 2 && data.size() > 16; test++ )
+    {
+        string bad = test == 0 ? data.substr ( 0, data.size() - 10 ) : data;
+        if ( test == 1 )
+            bad[0] ^= 0xFF;
+        
+        file = fopen ( badFile.c_str(), "wb" );
+        if ( file )
+        {
+            fwrite ( bad.data(), 1, bad.size(), file );
+            fclose ( file );
+        }
+        
+        SSObjectVec damaged;
+        if ( SSImportObjectsFromSnapshot ( badFile, damaged ) == 0 && damaged.size() == 0 )
+            rejected++;
+    }
+    
+    cout << "Rejected " << rejected << " of 2 truncated or damaged snapshots." << endl;
+}
+
+// Integrates an unperturbed asteroid orbit for several hundred days and checks it against
+// the two-body positions from the same orbital elements. Also checks a query a fraction of
+// a nanoday past a checkpoint, which needs one very short final step.
+
+void TestNBody ( void )
+{
+    SSMatrix matrix = SSCoordinates::getEclipticMatrix ( SSCoordinates::getObliquity ( SSTime::kJ2000 ) );
+    double epoch = 2459000.5, q = 2.55, e = 0.0785, tolerance = 1.0e-8;
+    SSOrbit orbit ( epoch, q, e, 10.6 * SSAngle::kRadPerDeg, 73.6 * SSAngle::kRadPerDeg, 80.3 * SSAngle::kRadPerDeg, 77.4 * SSAngle::kRadPerDeg, SSOrbit::meanMotion ( e, q ) );
+
+    SSNBody nbody ( 100.0 );
+    nbody.setPerturbed ( false );
+    nbody.add ( orbit );
+
+    int failed = 0, tested = 0;
+    for ( double jde = epoch - 400.0; jde <= epoch + 400.0; jde += 12.5, tested++ )
+    {
+        SSVector pos, vel;
+        SSNBody::State state = nbody.computePositionVelocity ( 0, jde );
+        orbit.toPositionVelocity ( jde, pos, vel );
+        if ( ! ( ( matrix.multiply ( pos ) - state.pos ).magnitude() <= tolerance ) )
+            failed++;
+    }
+
+    SSNBody::State state = nbody.computePositionVelocity ( 0, nextafter ( epoch, INFINITY ) );
+    if ( ! isfinite ( state.pos.x ) || ! isfinite ( state.vel.x ) || ( state.pos - nbody.computePositionVelocity ( 0, epoch ).pos ).magnitude() > tolerance )
+        failed++;
+
+    state = nbody.computePositionVelocity ( 0, nextafter ( epoch + 100.0, INFINITY ) );
+    if ( ! isfinite ( state.pos.x ) || ! isfinite ( state.vel.x ) )
+        failed++;
+
+    cout << "N-body integration: " << failed << " of " << tested + 2 << " unperturbed positions failed to match two-body orbit within " << tolerance << " AU." << endl;
+}
+
+// Computes ephemerides of the solar system objects, asteroids, comets, and bright stars
+// once in a serial loop, then again on four threads with SSComputeEphemerides(),
+// and checks that every object's direction and distance come out the same.
+
+void TestParallelEphemerides ( string inputDir )
+{
+    SSObjectVec objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", objects );
+    SSImportMPCAsteroids ( inputDir + "/SolarSystem/Asteroids.txt", objects );
+    SSImportMPCComets ( inputDir + "/SolarSystem/Comets.txt", objects );
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", objects );
+
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSCoordinates coords ( SSTime ( SSDate ( kGregorian, 0.0, 2020, 4, 15.0, 0, 0, 0.0 ) ), here );
+    coords.setAberration ( true );
+    coords.setLightTime ( true );
+    
+    vector<SSVector> directions ( objects.size() );
+    vector<double> distances ( objects.size() );
+    for ( size_t i = 0; i < objects.size(); i++ )
+    {
+        objects[i]->computeEphemeris ( coords );
+        directions[i] = objects[i]->getDirection();
+        distances[i] = objects[i]->getDistance();
+    }
+
+    SSComputeEphemerides ( coords, objects, 4 );
+    
+    int failed = 0;
+    for ( size_t i = 0; i < objects.size(); i++ )
+        if ( ( objects[i]->getDirection() - directions[i] ).magnitude() > 0.0 || objects[i]->getDistance() != distances[i] )
+            failed++;
+    
+    cout << "Parallel ephemerides: " << failed << " of " << objects.size() << " objects failed to match serial computation." << endl;
+}
+
+// Computes all MPC asteroids and comets at once with SSOrbitBatch, plus a few orbits at and beyond
+// the batch eccentricity limit, and checks every result against SSOrbit::toPositionVelocity().
+// Batch and SSOrbit round times differently, by up to 5.0e-10 days, hence the tolerance.
+// The last lane's light time is NaN, so the SIMD Kepler solver can't converge there; it must
+// fall back to SSOrbit without disturbing the other lane in its register.
+
+// Event functions for the tests below: apparent angular separation of two objects, and altitude of the first.
+
+double EventSeparation ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2 )
+{
+    return pObj1->getDirection().angularSeparation ( pObj2->getDirection() );
+}
+
+double EventAltitude ( SSCoordinates &coords, SSObjectPtr pObj1, SSObjectPtr pObj2 )
+{
+    SSSpherical hor = coords.transform ( kFundamental, kHorizon, pObj1->getDirection() );
+    return hor.lat;
+}
+
+// Returns true if event lists (events1) and (events2) hold the same number of events,
+// in the same order, with times within (tolerance) days of each other.
+
+bool SameEvents ( const vector<SSEventTime> &events1, const vector<SSEventTime> &events2, double tolerance )
+{
+    if ( events1.size() != events2.size() )
+        return false;
+
+    for ( size_t i = 0; i < events1.size(); i++ )
+        if ( ! ( fabs ( events1[i].time - events2[i].time ) <= tolerance ) )
+            return false;
+
+    return true;
+}
+
+// Checks that findEventsParallel() and findEqualityEventsParallel() find the same events at identical times, in the same order,
+// as the serial searches on one, several, and the default number of threads; including searches cut short by
+// the event limit, and events which fall on chunk boundaries. Also checks caller's coordinates aren't modified.
+
+void TestParallelEvents ( string inputDir )
+{
+    SSObjectVec objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", objects );
+    SSObjectPtr pSun = objects[0], pJup = objects[5], pSat = objects[6], pMoon = objects[10];
+
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSTime start = SSTime ( SSDate ( kGregorian, 0.0, 2020, 1, 1.0, 0, 0, 0.0 ) );
+    SSCoordinates coords ( start, here );
+    coords.setAberration ( true );
+    coords.setLightTime ( true );
+
+    struct Search { bool equality; SSObjectPtr pObj1, pObj2; double days, step; bool flag; double value; int maxEvents; };
+    Search searches[] =
+    {
+        { false, pMoon, pSun, 730.0, 1.0, true, SSAngle::kPi, 100 },                                // new moons
+        { false, pMoon, pSun, 730.0, 1.0, false, 0.0, 10 },                                         // full moons, cut short
+        { false, pJup, pSat, 7300.0, 1.0, true, SSAngle::kPi, 10 },                                 // Jupiter-Saturn conjunctions
+        { true, pSun, nullptr, 60.0, 1.0 / 24.0, true, SSEvent::kSunMoonRiseSetAlt, 100 },          // sunrises
+        { true, pMoon, nullptr, 60.0, 1.0 / 24.0, false, SSEvent::kSunMoonRiseSetAlt, 100 },        // moonsets
+        { true, pSun, nullptr, 60.0, 1.0 / 24.0, false, SSEvent::kSunCivilDawnDuskAlt, 25 },        // civil dusks, cut short
+    };
+
+    int failed = 0, tested = 0;
+    for ( Search &s : searches )
+    {
+        SSEventFunc func = s.equality ? EventAltitude : EventSeparation;
+        vector<SSEventTime> serial;
+        if ( s.equality )
+            SSEvent::findEqualityEvents ( coords, s.pObj1, s.pObj2, start, start + s.days, s.step, s.flag, s.value, func, serial, s.maxEvents );
+        else
+            SSEvent::findEvents ( coords, s.pObj1, s.pObj2, start, start + s.days, s.step, s.flag, s.value, func, serial, s.maxEvents );
+
+        failed += serial.empty();
+        for ( int threads : { 1, 3, 8, 0 } )
+        {
+            vector<SSEventTime> parallel;
+            coords.setTime ( start );
+            if ( s.equality )
+                SSEvent::findEqualityEventsParallel ( coords, s.pObj1, s.pObj2, start, start + s.days, s.step, s.flag, s.value, func, parallel, s.maxEvents, threads );
+            else
+                SSEvent::findEventsParallel ( coords, s.pObj1, s.pObj2, start, start + s.days, s.step, s.flag, s.value, func, parallel, s.maxEvents, threads );
+
+            failed += ! SameEvents ( serial, parallel, 0.0 ) || coords.getTime() != start;
+            tested++;
         }
     }
+
+    cout << "Parallel events: " << failed << " of " << tested << " searches failed to match serial search." << endl;
 }
 
-void TestTime ( void )
+// Exposes the time-dependent quantities SSCoordinates::setTime() computes, so smooth time mode can be tested.
+
+class SSTestCoordinates : public SSCoordinates
 {
-    SSTime now = SSTime::fromSystem();
-    SSDate date = now;
+public:
+    
+    SSTestCoordinates ( SSTime time, SSSpherical location ) : SSCoordinates ( time, location ) { }
+    
+    double getObliquity ( void ) { return _obq; }
+    double getNutationLon ( void ) { return _dl; }
+    double getNutationObq ( void ) { return _de; }
+    SSMatrix getPrecession ( void ) { return _preMat; }
+    SSMatrix getNutation ( void ) { return _nutMat; }
+    double getSmoothJD ( void ) { return _smoothJD; }
+};
 
-    cout << "Current local date is " << format ( "%04hd-%02hd-%0hd", date.year, date.month, date.day ) << endl;
-    cout << "Current local time is " << format ( "%02hd:%02hd:%04.1f", date.hour, date.min, date.sec ) << endl;
-    cout << "Current local time is " << format ( "%+.2f", date.zone ) << " hours east of UTC" << endl;
-    cout << "Current Julian Date is " << format ( "%.6f", now.jd ) << endl;
+// Returns largest difference between elements of two matrices (a) and (b), in arcseconds.
 
-    cout << "Current working directory is " << getcwd() << endl << endl;
+static double MatrixErrorArcsec ( const SSMatrix &a, const SSMatrix &b )
+{
+    const double *p = &a.m00, *q = &b.m00;
+    double err = 0.0;
+    
+    for ( int i = 0; i < 9; i++ )
+        err = max ( err, fabs ( p[i] - q[i] ) );
+    
+    return err * SSAngle::kArcsecPerRad;
+}
 
-    cout << "Before is "
-         << format("%04hd-%02hd-%02.0f %02hd:%02hd:%04.1f",
-              date.year,
-              date.month,
-              floor(date.day),
-              date.hour,
-              date.min,
-              date.sec)
-         << endl;
-    SSTime time2 = date;
-    SSDate date2 = time2;
-    cout << "After is "
-         << format("%04hd-%02hd-%02.0f %02hd:%02hd:%04.1f",
-              date2.year,
-              date2.month,
-              floor(date2.day),
-              date2.hour,
-              date2.min,
-              date2.sec)
-         << endl;
-};
+// Steps a smooth time coordinate object and an exact one together across several smooth time fit windows,
+// checking obliquity, nutation, precession and nutation matrices, observer position, and the Sun's and Moon's
+// apparent directions against the bounds documented for SSCoordinates::setSmoothTime(): 1.0e-6 arcsec,
+// 10 meters, and 0.005 arcsec. Checks that a new fit window is started when Delta T tables are imported
+// or the JPL ephemeris is opened or closed, that setLocation() corrects the fitted observer position
+// without a new window, and that turning smooth time off again gives exactly the exact values.
 
-void TestSatellites ( string inputDir, string outputDir )
+void TestSmoothTime ( string inputDir, string outputDir )
 {
-    string filename = inputDir + "/SolarSystem/Satellites/visual.txt";
-    FILE *file = fopen ( filename.c_str(), "r" );
-    if ( ! file )
+    SSObjectVec objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", objects );
+    SSPlanet sun = *SSGetPlanetPtr ( objects[0] ), moon = *SSGetPlanetPtr ( objects[10] );
+
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSTime start = SSTime ( SSDate ( kGregorian, 0.0, 2020, 1, 1.0, 0, 0, 0.0 ) );
+    SSTestCoordinates exact ( start, here ), smooth ( start, here );
+    smooth.setSmoothTime ( true );
+    
+    double maxAngle = 0.0, maxMatrix = 0.0, maxPos = 0.0, maxSun = 0.0, maxMoon = 0.0;
+    int failed = 0, tested = 0;
+    
+    // Compares the smooth and exact coordinates at their current time, updating the largest errors seen.
+    
+    auto compare = [&] ( void )
     {
-        cout << "Failed to open " << filename << endl;
-        return;
-    }
+        double angle = max ( fabs ( smooth.getObliquity() - exact.getObliquity() ), fabs ( smooth.getNutationLon() - exact.getNutationLon() ) );
+        angle = max ( angle, fabs ( smooth.getNutationObq() - exact.getNutationObq() ) ) * SSAngle::kArcsecPerRad;
+        double matrix = max ( MatrixErrorArcsec ( smooth.getPrecession(), exact.getPrecession() ), MatrixErrorArcsec ( smooth.getNutation(), exact.getNutation() ) );
+        double pos = ( smooth.getObserverPosition() - exact.getObserverPosition() ).magnitude() * SSCoordinates::kKmPerAU * 1000.0;
+        
+        SSVector dirs[4];
+        for ( int i = 0; i < 2; i++ )
+        {
+            SSTestCoordinates &coords = i ? smooth : exact;
+            sun.computeEphemeris ( coords );
+            moon.computeEphemeris ( coords );
+            dirs[i * 2] = sun.getDirection();
+            dirs[i * 2 + 1] = moon.getDirection();
+        }
+        
+        double sunErr = ( dirs[2] - dirs[0] ).magnitude() * SSAngle::kArcsecPerRad;
+        double moonErr = ( dirs[3] - dirs[1] ).magnitude() * SSAngle::kArcsecPerRad;
+        
+        failed += angle > 1.0e-6 || matrix > 1.0e-6 || pos > 10.0 || sunErr > 0.005 || moonErr > 0.005;
+        tested++;
+        
+        maxAngle = max ( maxAngle, angle );
+        maxMatrix = max ( maxMatrix, matrix );
+        maxPos = max ( maxPos, pos );
+        maxSun = max ( maxSun, sunErr );
+        maxMoon = max ( maxMoon, moonErr );
+    };
     
-    string outfilename = outputDir + "/ExportedSatellites.tle";
-    ofstream outfile ( outfilename );
-    if ( ! outfile )
+    // Step through five days at an interval which doesn't divide the fit window evenly,
+    // so times land at all positions in the window, including a few right at its edges.
+    
+    for ( double t = 0.0; t < 5.0; t += 0.0371 )
     {
-        cout << "Failed to open " << outfilename << endl;
-        return;
+        exact.setTime ( start + t );
+        smooth.setTime ( start + t );
+        compare();
     }
     
-    SSTLE tle;
+    // Importing Delta T values starts a new window at the next setTime(), even within the current one.
     
-    while ( tle.read ( file ) == 0 )
+    SSTime t = start + 5.0;
+    string deltaTPath = outputDir + "/smooth.deltat";
+    ofstream ( deltaTPath ) << "2019.0 69.0\n2021.0 72.0\n";
+    exact.setTime ( t );
+    smooth.setTime ( t );
+    SSTime::importDeltaT ( deltaTPath );
+    t += 0.1;
+    exact.setTime ( t );
+    smooth.setTime ( t );
+    failed += smooth.getSmoothJD() != t.jd;
+    compare();
+    t += 0.1;
+    exact.setTime ( t );
+    smooth.setTime ( t );
+    compare();
+    SSTime::clearDeltaT();
+
+    // Opening and closing the JPL ephemeris changes Earth's position by far more than 10 meters,
+    // so each must also start a new window.
+    
+    for ( int open = 1; open >= 0; open-- )
     {
-        tle.write ( cout );
- 
-        SSVector pos, vel;
+        if ( open )
+            failed += ! SSJPLDEphemeris::open ( inputDir + "/SolarSystem/DE438/1950_2050.438" );
+        else
+            SSJPLDEphemeris::close();
+        
+        for ( int i = 0; i < 3; i++ )
+        {
+            t += 0.1;
+            exact.setTime ( t );
+            smooth.setTime ( t );
+            failed += i == 0 && smooth.getSmoothJD() != t.jd;
+            compare();
+        }
+    }
 
-        tle.toPositionVelocity ( tle.jdepoch + 10.0, pos, vel );
+    // Moving the observer doesn't change the fit, which is geocentric, but must move the observer position.
+    
+    double smoothJD = smooth.getSmoothJD();
+    SSSpherical there = { SSAngle::fromDegrees ( 151.2 ), SSAngle::fromDegrees ( -33.9 ), 0.1 };
+    exact.setLocation ( there );
+    smooth.setLocation ( there );
+    failed += smooth.getSmoothJD() != smoothJD;
+    compare();
+    t += 0.05;
+    exact.setTime ( t );
+    smooth.setTime ( t );
+    failed += smooth.getSmoothJD() != smoothJD;
+    compare();
+    
+    // Turning smooth time off recomputes everything exactly.
+    
+    smooth.setSmoothTime ( false );
+    failed += smooth.getObliquity() != exact.getObliquity() || MatrixErrorArcsec ( smooth.getPrecession(), exact.getPrecession() ) != 0.0 || ( smooth.getObserverPosition() - exact.getObserverPosition() ).magnitude() != 0.0;
+    tested++;
+    
+    cout << "Smooth time: " << failed << " of " << tested << " checks failed; max error " << maxAngle << "\" nutation/obliquity, " << maxMatrix << "\" matrices, "
+         << maxPos << " m observer, " << maxSun << "\" Sun, " << maxMoon << "\" Moon." << endl;
+}
 
-        cout << format ( "JD %.6f  ", tle.jdepoch + 10.0 );
-        cout << format ( "pos %+10.3f %+10.3f %+10.3f  ", pos.x, pos.y, pos.z );
-        cout << format ( "vel %+7.3f %+7.3f %+7.3f",   vel.x, vel.y, vel.z ) << endl;
+// Checks that findEventsBrent() and findEqualityEventsBrent() find the same events as findEvents() and findEqualityEvents():
+// Moon-Sun separation minima and maxima, Moon rises and sets with and without altitudeRate(), and Sun altitude crossings.
+// Both locate events to about a second, so event times must agree within two seconds; extreme values within 0.01".
 
-        SSTLE tle1 = tle;
-        tle1.fromPositionVelocity ( tle.jdepoch + 10.0, pos, vel );
-        
-        SSTLE tle2 = tle1;
-        tle1.toPositionVelocity ( tle1.jdepoch - 10.0, pos, vel );
-        tle2.fromPositionVelocity ( tle1.jdepoch - 10.0, pos, vel );
-        tle2.write ( cout );
-        tle2.write ( outfile );
-     }
+void TestBrentEvents ( string inputDir )
+{
+    SSObjectVec objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", objects );
+    SSObjectPtr pSun = objects[0], pMoon = objects[10];
+
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSTime start = SSTime ( SSDate ( kGregorian, 0.0, 2020, 1, 1.0, 0, 0, 0.0 ) );
+    SSCoordinates coords ( start, here );
+    coords.setAberration ( true );
+    coords.setLightTime ( true );
+
+    struct Search { bool equality; SSObjectPtr pObj1, pObj2; double days, step; bool flag; double value; SSEventFunc rate; };
+    Search searches[] =
+    {
+        { false, pMoon, pSun, 365.0, 1.0, true, SSAngle::kPi, nullptr },                                               // new moons
+        { false, pMoon, pSun, 365.0, 1.0, false, 0.0, nullptr },                                                        // full moons
+        { true, pMoon, nullptr, 60.0, 1.0 / 24.0, true, SSEvent::kSunMoonRiseSetAlt, nullptr },                         // moonrises
+        { true, pMoon, nullptr, 60.0, 1.0 / 24.0, false, SSEvent::kSunMoonRiseSetAlt, SSEvent::altitudeRate },          // moonsets
+        { true, pSun, nullptr, 60.0, 1.0 / 24.0, true, SSEvent::kSunAstronomicalDawnDuskAlt, nullptr },                 // astronomical dawns
+        { true, pSun, nullptr, 60.0, 1.0 / 24.0, false, SSEvent::kSunCivilDawnDuskAlt, SSEvent::altitudeRate },         // civil dusks
+    };
+
+    int failed = 0, tested = 0;
+    for ( Search &s : searches )
+    {
+        SSEventFunc func = s.equality ? EventAltitude : EventSeparation;
+        vector<SSEventTime> expected, found;
+        if ( s.equality )
+        {
+            SSEvent::findEqualityEvents ( coords, s.pObj1, s.pObj2, start, start + s.days, s.step, s.flag, s.value, func, expected, 100 );
+            SSEvent::findEqualityEventsBrent ( coords, s.pObj1, s.pObj2, start, start + s.days, s.step, s.flag, s.value, func, found, 100, s.rate );
+        }
+        else
+        {
+            SSEvent::findEvents ( coords, s.pObj1, s.pObj2, start, start + s.days, s.step, s.flag, s.value, func, expected, 100 );
+            SSEvent::findEventsBrent ( coords, s.pObj1, s.pObj2, start, start + s.days, s.step, s.flag, s.value, func, found, 100 );
+        }
+
+        failed += expected.empty() || ! SameEvents ( expected, found, 2.0 / SSTime::kSecondsPerDay );
+        for ( size_t i = 0; ! s.equality && i < expected.size() && i < found.size(); i++ )
+            failed += fabs ( expected[i].value - found[i].value ) > 0.01 / SSAngle::kArcsecPerRad;
+        tested++;
+    }
+
+    cout << "Brent events: " << failed << " of " << tested << " searches failed to match step-halving search." << endl;
 }
 
-void TestSolarSystem ( string inputDir, string outputDir )
+// Checks findAllConjunctions() against findConjunctions() run on every pair of the Sun, Moon, planets, Regulus, and Spica
+// for a year: every minimum separation within the limit found pair by pair must be found, within a minute and 0.1",
+// and anything else must be a real minimum. The Earth, which the observer stands on, is left out by findAllConjunctions() and here.
+
+void TestAllConjunctions ( string inputDir )
 {
-    SSObjectVec planets;
-    int numPlanets = SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", planets );
-    cout << "Imported " << numPlanets << " major planets" << endl;
-    numPlanets = SSExportObjectsToCSV ( "", planets );
-    
-    SSObjectVec moons;
-    int numMoons = SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", moons );
-    cout << "Imported " << numMoons << " natural satellites" << endl;
-    
-    SSObjectVec comets;
-    int numComets = SSImportMPCComets ( inputDir + "/SolarSystem/Comets.txt", comets );
-    cout << "Imported " << numComets << " MPC comets" << endl;
+    SSObjectVec solsys, stars, objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", solsys );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", solsys );
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", stars );
+    for ( int i = 0; i <= 10; i++ )
+        objects.push_back ( SSCloneObject ( solsys[i] ) );
+    for ( int i = 0; i < stars.size(); i++ )
+        if ( stars[i]->getName ( 0 ) == "Regulus" || stars[i]->getName ( 0 ) == "Spica" )
+            objects.push_back ( SSCloneObject ( stars[i] ) );
 
-    SSObjectVec asteroids;
-    int numAsteroids = SSImportMPCAsteroids ( inputDir + "/SolarSystem/Asteroids.txt", asteroids );
-    cout << "Imported " << numAsteroids << " MPC asteroids" << endl;
+    SSSpherical here = { SSAngle ( SSDegMinSec ( '-', 122, 25, 09.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 };
+    SSTime start = SSTime ( SSDate ( kGregorian, 0.0, 2020, 1, 1.0, 0, 0, 0.0 ) ), stop = start + 366.0;
+    SSCoordinates coords ( start, here );
+    coords.setAberration ( true );
+    coords.setLightTime ( true );
 
-    if ( ! outputDir.empty() )
+    SSAngle limit = 3.0 / SSAngle::kDegPerRad;
+    vector<SSConjunction> found;
+    SSEvent::findAllConjunctions ( coords, objects, start, stop, 1.0 / 24.0, limit, found, 1000 );
+
+    int failed = 0, expected = 0;
+    vector<bool> matched ( found.size(), false );
+    for ( size_t i = 0; i < objects.size(); i++ )
     {
-        numMoons = SSExportObjectsToCSV ( outputDir + "/ExportedMoons.csv", moons );
-        cout << "Exported " << numMoons << " natural satellites to " << outputDir + "/ExportedMoons.csv" << endl;
+        for ( size_t j = i + 1; j < objects.size() && i != 3; j++ )
+        {
+            vector<SSEventTime> events;
+            SSEvent::findConjunctions ( coords, objects[i], objects[j], start, stop, events, 1000 );
+            for ( SSEventTime &event : events )
+            {
+                if ( j == 3 || event.value > limit )
+                    continue;
+
+                size_t k = 0;
+                while ( k < found.size() && ! ( found[k].pObj1 == objects[i] && found[k].pObj2 == objects[j] && fabs ( found[k].time - event.time ) < 1.0 / SSTime::kMinutesPerDay ) )
+                    k++;
+
+                if ( k == found.size() || fabs ( found[k].separation - event.value ) > 0.1 / SSAngle::kArcsecPerRad )
+                    failed++;
+                else
+                    matched[k] = true;
+                expected++;
+            }
+        }
+    }
 
-        numComets = SSExportObjectsToCSV ( outputDir + "/ExportedComets.csv", comets );
-        cout << "Exported " << numComets << " MPC comets to " << outputDir + "/ExportedComets.csv" << endl;
+    // Diurnal parallax makes the separation of two planets wobble by an arcsecond or so over a day, which can add a shallow
+    // minimum near a maximum. The pairwise search's one-day step can't resolve those, so check any extras directly instead.
 
-        numAsteroids = SSExportObjectsToCSV ( outputDir + "/ExportedAsteroids.csv", asteroids );
-        cout << "Exported " << numAsteroids << " MPC asteroids to " << outputDir + "/ExportedAsteroids.csv" << endl;
+    auto separation = [&] ( SSConjunction &conj, double jd )
+    {
+        coords.setTime ( SSTime ( jd ) );
+        conj.pObj1->computeEphemeris ( coords );
+        conj.pObj2->computeEphemeris ( coords );
+        return conj.pObj1->getDirection().angularSeparation ( conj.pObj2->getDirection() );
+    };
+
+    int extra = 0;
+    for ( size_t k = 0; k < found.size(); k++ )
+    {
+        if ( matched[k] )
+            continue;
+
+        double jd = found[k].time, dt = 10.0 / SSTime::kMinutesPerDay, sep = separation ( found[k], jd );
+        failed += sep > limit || separation ( found[k], jd - dt ) <= sep || separation ( found[k], jd + dt ) <= sep;
+        extra++;
     }
-}
 
-void TestConstellations ( string inputDir, string outputDir )
-{
-    SSObjectVec constellations;
-    
-    int numCons = SSImportConstellations ( inputDir + "/Constellations/Constellations.csv", constellations );
-    cout << "Imported " << numCons << " IAU constellations" << endl;
-    
-    int numVerts = SSImportConstellationBoundaries ( inputDir + "/Constellations/Boundaries.csv", constellations );
-    cout << "Imported " << numVerts << " IAU constellation boundary vertices" << endl;
+    cout << "All conjunctions: " << failed << " of " << expected + extra << " conjunctions within 3° in 2020 failed to match pairwise search ";
+    cout << "or direct check (" << extra << " too shallow for pairwise search)." << endl;
+}
 
-    int numLines = SSImportConstellationShapes ( inputDir + "/Constellations/Shapes.csv", constellations );
-    cout << "Imported " << numLines << " IAU constellation shape lines" << endl;
+// Checks SSEclipse::findEclipses() against the solar and lunar eclipses of 2019 to 2022 in NASA's Five Millennium Canons
+// (Espenak & Meeus): each must be found, with the same type, greatest eclipse within two seconds of the canon's in dynamical time,
+// and gamma within 0.0005 Earth radii; and no others. Uses the DE438 ephemeris, which TestEphemeris() closes when done.
 
-    if ( ! outputDir.empty() )
+void TestEclipses ( string inputDir )
+{
+    struct Known { int year; short month; double day; short hour, min; double sec; SSEclipseType type; double gamma; };
+    Known known[] =
     {
-        numCons = SSExportObjectsToCSV ( outputDir + "/ExportedConstellations.csv", constellations );
-        cout << "Exported " << numCons << " constellations to " << outputDir + "/ExportedConstellations.csv" << endl;
+        { 2019,  1,  6,  1, 42, 38, kPartialSolarEclipse,    1.1417 },
+        { 2019,  1, 21,  5, 13, 27, kTotalLunarEclipse,      0.3684 },
+        { 2019,  7,  2, 19, 24,  7, kTotalSolarEclipse,     -0.6466 },
+        { 2019,  7, 16, 21, 31, 55, kPartialLunarEclipse,   -0.6430 },
+        { 2019, 12, 26,  5, 18, 53, kAnnularSolarEclipse,    0.4135 },
+        { 2020,  1, 10, 19, 11, 11, kPenumbralLunarEclipse,  1.0727 },
+        { 2020,  6,  5, 19, 26, 14, kPenumbralLunarEclipse,  1.2406 },
+        { 2020,  6, 21,  6, 41, 15, kAnnularSolarEclipse,    0.1209 },
+        { 2020,  7,  5,  4, 31, 12, kPenumbralLunarEclipse, -1.3639 },
+        { 2020, 11, 30,  9, 44,  1, kPenumbralLunarEclipse, -1.1309 },
+        { 2020, 12, 14, 16, 14, 39, kTotalSolarEclipse,     -0.2939 },
+        { 2021,  5, 26, 11, 19, 53, kTotalLunarEclipse,      0.4774 },
+        { 2021,  6, 10, 10, 43,  7, kAnnularSolarEclipse,    0.9152 },
+        { 2021, 11, 19,  9,  4,  6, kPartialLunarEclipse,   -0.4552 },
+        { 2021, 12,  4,  7, 34, 38, kTotalSolarEclipse,     -0.9526 },
+        { 2022,  4, 30, 20, 42, 36, kPartialSolarEclipse,   -1.1901 },
+        { 2022,  5, 16,  4, 12, 42, kTotalLunarEclipse,     -0.2532 },
+        { 2022, 10, 25, 11,  1, 20, kPartialSolarEclipse,    1.0701 },
+        { 2022, 11,  8, 11,  0, 22, kTotalLunarEclipse,      0.2570 },
+    };
+
+    SSObjectVec objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", objects );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", objects );
+    SSJPLDEphemeris::open ( inputDir + "/SolarSystem/DE438/1950_2050.438" );
+
+    vector<SSEclipseEvent> eclipses;
+    SSTime start = SSTime ( SSDate ( kGregorian, 0.0, 2019, 1, 1.0, 0, 0, 0.0 ) );
+    SSTime stop = SSTime ( SSDate ( kGregorian, 0.0, 2023, 1, 1.0, 0, 0, 0.0 ) );
+    SSEclipse::findEclipses ( start, stop, objects[0], objects[10], true, true, eclipses );
+
+    int failed = 0, tested = sizeof ( known ) / sizeof ( known[0] );
+    for ( int i = 0; i < tested; i++ )
+    {
+        Known &k = known[i];
+        double jed = SSTime ( SSDate ( kGregorian, 0.0, k.year, k.month, k.day, k.hour, k.min, k.sec ) ).jd;
+        if ( i >= eclipses.size() )
+            failed++;
+        else
+            failed += eclipses[i].type != k.type || fabs ( eclipses[i].greatest.getJulianEphemerisDate() - jed ) > 2.0 / SSTime::kSecondsPerDay || fabs ( eclipses[i].gamma - k.gamma ) > 0.0005;
     }
+
+    // Greatest eclipse of 2 July 2019 was at 17.4 S, 109.0 W.
+
+    failed += eclipses.size() != tested;
+    if ( eclipses.size() > 2 )
+        failed += fabs ( eclipses[2].location.lon * SSAngle::kDegPerRad + 109.0 ) > 0.1 || fabs ( eclipses[2].location.lat * SSAngle::kDegPerRad + 17.4 ) > 0.1;
+
+    SSJPLDEphemeris::close();
+    cout << "Eclipses: found " << eclipses.size() << " in 2019-2022; " << failed << " of " << tested << " failed to match NASA canon." << endl;
 }
 
-void TestStars ( string inputDir, string outputDir )
+// Returns true if rise, transit, or set circumstances (rts1) and (rts2) agree: both missing, in the same sense,
+// or times within (tolerance) days and horizon directions within (angle) radians. Directions are compared,
+// rather than azimuths, since near the zenith a tiny difference in time makes a large one in azimuth.
+
+bool SameRTS ( const SSRTS &rts1, const SSRTS &rts2, double tolerance, double angle )
 {
-    SSObjectVec nearest, brightest;
-    
-    int numStars = SSImportObjectsFromCSV ( inputDir + "/Stars/Nearest.csv", nearest );
-    cout << "Imported " << numStars << " nearby stars" << endl;
-    
-    numStars = SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", brightest );
-    cout << "Imported " << numStars << " bright stars" << endl;
-    
-    if ( ! outputDir.empty() )
+    if ( isinf ( rts1.time ) || isinf ( rts2.time ) )
+        return rts1.time.jd == rts2.time.jd;
+
+    SSVector hor1 = SSSpherical ( rts1.azm, rts1.alt ), hor2 = SSSpherical ( rts2.azm, rts2.alt );
+    return fabs ( rts1.time - rts2.time ) <= tolerance && hor1.angularSeparation ( hor2 ) <= angle;
+}
+
+// Checks riseTransitSetTable() against riseTransitSet() for each object, day, and site, for the Sun, Moon, planets,
+// and stars which are circumpolar or never rise at some sites, over a month from sites in both hemispheres and north
+// of the Arctic Circle, in June when the Sun doesn't set there. Times must agree within five seconds, and directions within
+// 0.02°, about as far as the sky turns in that time.
+
+void TestRiseTransitSetTable ( string inputDir )
+{
+    SSObjectVec solsys, stars, objects;
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Planets.csv", solsys );
+    SSImportObjectsFromCSV ( inputDir + "/SolarSystem/Moons.csv", solsys );
+    SSImportObjectsFromCSV ( inputDir + "/Stars/Brightest.csv", stars );
+    for ( int i = 0; i <= 10; i++ )
+        if ( i != 3 )
+            objects.push_back ( SSCloneObject ( solsys[i] ) );
+    for ( int i = 0; i < stars.size(); i++ )
+        if ( stars[i]->getName ( 0 ) == "Sirius" || stars[i]->getName ( 0 ) == "Polaris" || stars[i]->getName ( 0 ) == "Canopus" )
+            objects.push_back ( SSCloneObject ( stars[i] ) );
+
+    vector<SSRTSSite> sites =
     {
-        numStars = SSExportObjectsToCSV ( outputDir + "/ExportedNearbyStars.csv", nearest );
-        cout << "Exported " << numStars << " nearby stars to " << outputDir + "/ExportedNearbyStars.csv" << endl;
+        { SSSpherical ( SSAngle ( SSDegMinSec ( '-', 122, 25, 9.9 ) ), SSAngle ( SSDegMinSec ( '+', 37, 46, 29.7 ) ), 0.026 ), -7.0 },   // San Francisco
+        { SSSpherical ( SSAngle ( SSDegMinSec ( '+', 151, 12, 36.0 ) ), SSAngle ( SSDegMinSec ( '-', 33, 51, 36.0 ) ), 0.040 ), 10.0 },   // Sydney
+        { SSSpherical ( SSAngle ( SSDegMinSec ( '+', 18, 57, 0.0 ) ), SSAngle ( SSDegMinSec ( '+', 69, 39, 0.0 ) ), 0.010 ), 2.0 },        // Tromsø
+    };
+
+    SSTime start = SSTime ( SSDate ( kGregorian, 0.0, 2020, 6, 1.0, 12, 0, 0.0 ) );
+    int days = 30, nobj = (int) objects.size();
+    vector<SSPass> passes;
+    SSEvent::riseTransitSetTable ( start, days, objects, sites, passes );
+
+    int failed = 0, tested = 0, missing = 0;
+    double tolerance = 5.0 / SSTime::kSecondsPerDay, angle = 0.02 / SSAngle::kDegPerRad;
+    for ( int s = 0; s < sites.size(); s++ )
+    {
+        SSCoordinates coords ( start, sites[s].location );
+        coords.setAberration ( true );
+        coords.setLightTime ( true );
+        double midnight = SSTime ( start.jd, sites[s].zone ).getLocalMidnight();
 
-        numStars = SSExportObjectsToCSV ( outputDir + "/ExportedBrightStars.csv", brightest );
-        cout << "Exported " << numStars << " bright stars to " << outputDir + "/ExportedBrightStars.csv" << endl;
+        for ( int d = 0; d < days; d++ )
+        {
+            for ( int o = 0; o < nobj; o++ )
+            {
+                SSPlanetPtr pPlanet = SSGetPlanetPtr ( objects[o] );
+                bool sunMoon = pPlanet && ( pPlanet->getIdentifier() == SSIdentifier ( kCatJPLanet, kSun ) || pPlanet->getIdentifier() == SSIdentifier ( kCatJPLanet, kLuna ) );
+                SSPass expected = SSEvent::riseTransitSet ( SSTime ( midnight + d + 0.5, sites[s].zone ), coords, objects[o], sunMoon ? SSEvent::kSunMoonRiseSetAlt : SSEvent::kDefaultRiseSetAlt );
+                SSPass &found = passes[ ( (size_t) s * days + d ) * nobj + o ];
+                failed += ! SameRTS ( expected.rising, found.rising, tolerance, angle ) || ! SameRTS ( expected.transit, found.transit, tolerance, angle ) || ! SameRTS ( expected.setting, found.setting, tolerance, angle );
+                missing += isinf ( expected.rising.time ) + isinf ( expected.setting.time );
+                tested++;
+            }
+        }
     }
+
+    cout << "Rise/transit/set table: " << failed << " of " << tested << " passes (" << missing << " rises or sets missing) failed to match riseTransitSet()." << endl;
 }
 
-void TestDeepSky ( string inputDir, string outputDir )
+void TestOrbitBatch ( string inputDir )
 {
-    SSObjectVec messier, caldwell;
+    SSObjectVec objects;
+    SSImportMPCAsteroids ( inputDir + "/SolarSystem/Asteroids.txt", objects );
+    SSImportMPCComets ( inputDir + "/SolarSystem/Comets.txt", objects );
     
-    int numObjs = SSImportObjectsFromCSV ( inputDir + "/DeepSky/Messier.csv", messier );
-    cout << "Imported " << numObjs << " Messier objects" << endl;
+    SSOrbitBatch batch ( objects );
+    double epoch = 2459000.5;
+    double eccs[] = { 0.5, 0.9499, 0.95, 0.99, 1.0, 1.5 };
+    for ( double e : eccs )
+        batch.add ( SSOrbit ( epoch, 1.2, e, 0.3, 1.1, 2.2, 0.01, SSOrbit::meanMotion ( e, 1.2 ) ) );
     
-    numObjs = SSImportObjectsFromCSV ( inputDir + "/DeepSky/Caldwell.csv", caldwell );
-    cout << "Imported " << numObjs << " Caldwell objects" << endl;
+    if ( batch.size() % 2 )
+        batch.add ( SSOrbit ( epoch, 3.0, 0.1, 0.1, 0.1, 0.1, 0.1, SSOrbit::meanMotion ( 0.1, 3.0 ) ) );
+    batch.add ( SSOrbit ( epoch, 2.0, 0.2, 0.1, 0.2, 0.3, 0.4, SSOrbit::meanMotion ( 0.2, 2.0 ) ) );
+    batch.add ( SSOrbit ( epoch, 2.5, 0.9, 0.4, 0.5, 0.6, 0.7, SSOrbit::meanMotion ( 0.9, 2.5 ) ) );
     
-    if ( ! outputDir.empty() )
+    vector<double> lt ( batch.size(), 0.01 );
+    lt.back() = NAN;
+    
+    SSMatrix matrix = SSCoordinates::getEclipticMatrix ( SSCoordinates::getObliquity ( SSTime::kJ2000 ) );
+    double jde = epoch + 1000.0, tolerance = 1.0e-10;
+    int failed = 0;
+    
+    batch.computePositionVelocity ( jde, lt.data() );
+    for ( size_t i = 0; i < batch.size(); i++ )
     {
-        numObjs = SSExportObjectsToCSV ( outputDir + "/ExportedMessier.csv", messier );
-        cout << "Exported " << numObjs << " Messier objects to " << outputDir + "/ExportedMessier.csv" << endl;
-
-        numObjs = SSExportObjectsToCSV ( outputDir + "/ExportedCaldwell.csv", caldwell );
-        cout << "Exported " << numObjs << " Caldwell objects to " << outputDir + "/ExportedCaldwell.csv" << endl;
+        SSVector pos, vel;
+        SSOrbit orbit = batch.getOrbit ( i );
+        orbit.toPositionVelocity ( jde - lt[i], pos, vel );
+        pos = matrix.multiply ( pos );
+        vel = matrix.multiply ( vel );
+        
+        double dp = ( batch.getPosition ( i ) - pos ).magnitude(), dv = ( batch.getVelocity ( i ) - vel ).magnitude();
+        if ( isfinite ( pos.x ) != isfinite ( batch.getPosition ( i ).x ) )
+            failed++;
+        else if ( isfinite ( pos.x ) && ! ( dp <= tolerance * pos.magnitude() && dv <= tolerance * vel.magnitude() ) )
+            failed++;
     }
+    
+    cout << "Orbit batch: " << failed << " of " << batch.size() << " positions (" << batch.numSpecial() << " near-parabolic or hyperbolic) failed to match SSOrbit." << endl;
 }
 
-void TestJPLDEphemeris ( string inputDir )
+// Integrates a few asteroids' orbits over ten years, exports the integrated positions
+// to a Chebyshev ephemeris file on several threads, then reads the file back and checks
+// it against the integration.
+
+void TestChebyshevEphemeris ( string inputDir, string outputDir )
 {
-    SSJPLDEphemeris jpldeph;
+    SSObjectVec asteroids;
+    SSImportMPCAsteroids ( inputDir + "/SolarSystem/Asteroids.txt", asteroids );
+    if ( asteroids.size() == 0 || outputDir.empty() )
+        return;
     
-    string ephemFile = inputDir + "/SolarSystem/DE438/1950_2050.438";
-    if ( ! jpldeph.open ( ephemFile ) )
+    SSNBody nbody;
+    for ( int i = 0; i < asteroids.size() && i < 16; i++ )
+        nbody.add ( SSGetPlanetPtr ( asteroids[i] ) );
+    
+    double jde0 = SSTime ( SSDate ( kGregorian, 0.0, 2020, 1, 1.0, 0, 0, 0.0 ) ).getJulianEphemerisDate();
+    double jde1 = jde0 + 3652.5, accuracy = 1.0e-8;
+    string ephemFile = outputDir + "/NBody.cheb";
+    
+    int n = SSExportChebyshevEphemeris ( ephemFile, nbody, jde0, jde1, accuracy, 4 );
+    cout << "Exported " << n << " n-body asteroid ephemerides to " << ephemFile << endl;
+    
+    SSChebyshevEphemeris cheb;
+    if ( ! cheb.open ( ephemFile ) )
     {
         cout << "Failed to open " << ephemFile << endl;
         return;
     }
     
-    cout << "Successfully opened " << ephemFile << endl;
-    cout << "JED " << jpldeph.getStartJED() << " to " << jpldeph.getStopJED() << endl;
+    int failed = 0;
+    for ( int i = 0; i < nbody.size(); i++ )
+    {
+        for ( double jde = jde0; jde <= jde1; jde += 36.525 )
+        {
+            SSVector pos, vel;
+            SSNBody::State state = nbody.computePositionVelocity ( i, jde );
+            if ( ! cheb.compute ( nbody.getPlanet ( i )->getIdentifier(), jde, pos, vel ) || ( pos - state.pos ).magnitude() > 10.0 * accuracy )
+                failed++;
+        }
+    }
     
-    // for ( int i = 0; i < jpldeph.getConstantNumber(); i++ )
-    //    cout << jpldeph.getConstantName ( i ) << " = " << jpldeph.getConstantValue ( i ) << endl;
-        
-    double jed = SSTime ( SSDate ( kGregorian, 0.0, 2020, 1, 1.0, 0, 0, 0.0 ) ).getJulianEphemerisDate();
-    SSVector pos, vel;
+    cout << "Read back " << cheb.size() << " Chebyshev ephemerides; " << failed << " positions failed to match the integration." << endl;
+
+    // While the file is in use, batch positions of the same asteroids must come from it.
     
-    for ( int id = 0; id <= 10; id++ )
+    SSPlanet::useChebyshevEphemeris ( &cheb );
+    SSOrbitBatch batch;
+    for ( int i = 0; i < nbody.size(); i++ )
+        batch.add ( nbody.getPlanet ( i ) );
+    
+    failed = 0;
+    batch.computePositionVelocity ( jde0 + 100.0 );
+    for ( int i = 0; i < batch.size(); i++ )
     {
-        jpldeph.compute ( id, jed, true, pos, vel );
-        cout << format ( "obj %2d  ", id );
-        cout << format ( "pos %+12.8f %+12.8f %+12.8f  ", pos.x, pos.y, pos.z );
-        cout << format ( "vel %+11.8f %+11.8f %+11.8f", vel.x, vel.y, vel.z ) << endl;
+        SSVector pos, vel;
+        if ( ! cheb.compute ( batch.getPlanet ( i )->getIdentifier(), jde0 + 100.0, pos, vel ) || ( batch.getPosition ( i ) - pos ).magnitude() > 0.0 )
+            failed++;
     }
     
-    jpldeph.close();
+    SSPlanet::useChebyshevEphemeris ( nullptr );
+    cout << "Batch computed " << batch.size() << " asteroids; " << failed << " positions failed to match the Chebyshev ephemeris in use." << endl;
 }
 
 void TestEvents ( SSCoordinates coords, SSObjectVec &solsys )
@@ -656,17 +2688,42 @@ int main ( int argc, const char *argv[] )
     string inpath ( argv[1] );
     string outpath ( argv[2] );
     
+    TestDeltaT ( outpath );
 
     TestELPMPP02 ( "/Users/timmyd/Projects/SouthernStars/Projects/Astro Code/ELPMPP02/Chapront/" );
     TestVSOP2013 ( "/Users/timmyd/Projects/SouthernStars/Projects/Astro Code/VSOP2013/solution/" );
     TestEphemeris ( inpath, outpath );
+    TestSmoothTime ( inpath, outpath );
 //  TestPrecession();
 //  TestSatellites ( inpath, outpath );
 //  TestJPLDEphemeris ( inpath );
 //  TestSolarSystem ( inpath, outpath );
 //  TestConstellations ( inpath, outpath );
+    TestCSVImport ( inpath );
+    TestMPCImport ( inpath );
     TestStars ( inpath, outpath );
+    TestStarField ( inpath );
+    TestStarFieldSpeed ( inpath, 100 );
+    TestViewProject();
+    TestViewHTMRegions();
+    TestGeometryCache ( inpath );
+    TestBatchTransforms();
+    TestObjectArena ( inpath );
     TestDeepSky ( inpath, outpath );
+    TestIdentifierHashMap();
+    TestPipeline();
+    TestConstellationIndex();
+    TestSearchIndex ( inpath );
+    TestSnapshot ( inpath, outpath );
+    TestParallelEphemerides ( inpath );
+    TestParallelEvents ( inpath );
+    TestBrentEvents ( inpath );
+    TestAllConjunctions ( inpath );
+    TestEclipses ( inpath );
+    TestRiseTransitSetTable ( inpath );
+    TestOrbitBatch ( inpath );
+    TestNBody();
+    TestChebyshevEphemeris ( inpath, outpath );
 /*
     SSObjectVec comets;
     int numcom = importMPCComets ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Comets/MPC/CometEls.txt", comets );
@@ -704,58 +2761,32 @@ int main ( int argc, const char *argv[] )
     exportCatalog ( objects, kCatMessier, 1, 110 );
     exportCatalog ( objects, kCatCaldwell, 1, 110 );
 */
-    SSIdentifierMap hipHRMap;
-    int n = SSImportHIPHRIdentifiers ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/TABLES/IDENT3.DOC", hipHRMap );
-    cout << "Imported " << n << " Hipparcos HR identifiers." << endl;
-
-    SSIdentifierMap hipBayMap;
-    n = SSImportHIPBayerIdentifiers ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/TABLES/IDENT4.DOC", hipBayMap );
-    cout << "Imported " << n << " Hipparcos Bayer/Flamsteed identifiers." << endl;
-
-    SSIdentifierMap hipGCVSMap;
-    n = SSImportHIPGCVSIdentifiers ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/TABLES/IDENT5.DOC", hipGCVSMap );
-    cout << "Imported " << n << " Hipparcos GCVS identifiers." << endl;
-
-    SSIdentifierNameMap hipNames;
-    n = SSImportHIPNames ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/TABLES/IDENT6.DOC", hipNames );
-    cout << "Imported " << n << " Hipparcos star names." << endl;
+    // Import Hipparcos, Gliese-Jahreiss, and SKY2000 catalogs and cross-match them.
+    // Independent files are read in parallel; HIP2 is currently left out.
     
-    SSObjectVec hicStars;
-    n = SSImportHIC ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos Input Catalog/main.dat", hicStars );
-    cout << "Imported " << n << " Hipparcos Input Catalog stars." << endl;
-
-    SSObjectVec hip2Stars;
-//  n = SSImportHIP2 ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos New Reduction 2007/hip2.dat", hip2Stars );
-//  cout << "Imported " << n << " Hipparcos New Reduction stars." << endl;
-
-    SSObjectVec hipStars;
-    n = SSImportHIP ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/CATS/HIP_MAIN.DAT", hipHRMap, hipBayMap, hipGCVSMap, hipNames, hicStars, hip2Stars, hipStars );
-    cout << "Imported " << n << " Hipparcos stars." << endl;
-
-    SSIdentifierNameMap iauNames;
-    n = SSImportIAUStarNames ( "/Users/timmyd/Projects/SouthernStars/Projects/Star Names/IAU-CSN.txt", iauNames );
-    cout << "Imported " << n << " IAU star names." << endl;
-
-    SSIdentifierNameMap starNames;
-    n = SSImportIdentifierNameMap ( "/Users/timmyd/Projects/SouthernStars/Projects/SSCore/SSData/Stars/Names.csv", starNames );
-    cout << "Imported " << n << " star names." << endl;
-
-    SSObjectVec gjACStars;
-    n = SSImportGJAC ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Nearby Stars/Accurate Coordinates/table1.dat", hipStars, gjACStars );
-    cout << "Imported " << n << " GJ accurate coordinate nearby stars." << endl;
-//    exportCatalog ( gjACStars );
-
-    SSObjectVec gjStars;
-    n = SSImportGJCNS3 ( "/Users/timmyd/Projects/SouthernStars/Catalogs/Nearby Stars/CNS3/catalog.dat", starNames, gjACStars, gjStars );
-    cout << "Imported " << n << " GJ nearby stars." << endl;
-//    exportCatalog ( gjStars );
-
-    SSObjectVec skyStars;
-    n = SSImportSKY2000 ( "/Users/timmyd/Projects/SouthernStars/Catalogs/SKY2000 Master Star Catalog/ATT_sky2kv5.cat", iauNames, hipStars, gjStars, skyStars );
-    cout << "Imported " << n << " SKY2000 stars." << endl;
-    // exportCatalog ( skyStars, kCatHR, 1, 9110 );
-    // SSExportObjectsToCSV ( "/Users/timmyd/Desktop/SKY2000.csv", skyStars );
-    ExportObjectsToHTM ( "/Users/timmyd/Desktop/SKY2000/", skyStars );
+    SSStarCatalogFiles files;
+    files.hipHRIdents = "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/TABLES/IDENT3.DOC";
+    files.hipBayerIdents = "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/TABLES/IDENT4.DOC";
+    files.hipGCVSIdents = "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/TABLES/IDENT5.DOC";
+    files.hipNames = "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/TABLES/IDENT6.DOC";
+    files.hic = "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos Input Catalog/main.dat";
+//  files.hip2 = "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos New Reduction 2007/hip2.dat";
+    files.hip = "/Users/timmyd/Projects/SouthernStars/Catalogs/Hipparcos/CATS/HIP_MAIN.DAT";
+    files.iauNames = "/Users/timmyd/Projects/SouthernStars/Projects/Star Names/IAU-CSN.txt";
+    files.starNames = "/Users/timmyd/Projects/SouthernStars/Projects/SSCore/SSData/Stars/Names.csv";
+    files.gjAC = "/Users/timmyd/Projects/SouthernStars/Catalogs/Nearby Stars/Accurate Coordinates/table1.dat";
+    files.gjCNS3 = "/Users/timmyd/Projects/SouthernStars/Catalogs/Nearby Stars/CNS3/catalog.dat";
+    files.sky2000 = "/Users/timmyd/Projects/SouthernStars/Catalogs/SKY2000 Master Star Catalog/ATT_sky2kv5.cat";
+
+    SSStarCatalogs catalogs;
+    SSPipeline pipeline;
+    SSMakeStarCatalogPipeline ( files, catalogs, pipeline );
+    pipeline.run();
+    cout << pipeline.report();
+    // exportCatalog ( catalogs.gjStars );
+    // exportCatalog ( catalogs.skyStars, kCatHR, 1, 9110 );
+    // SSExportObjectsToCSV ( "/Users/timmyd/Desktop/SKY2000.csv", catalogs.skyStars );
+    ExportObjectsToHTM ( "/Users/timmyd/Desktop/SKY2000/", catalogs.skyStars );
 
 
 #ifdef _WIN32
@@ -765,8 +2796,6 @@ int main ( int argc, const char *argv[] )
     return 0;
 }
 
-#include "SSHTM.hpp"
-
 void ExportObjectsToHTM ( const string htmdir, SSObjectVec &objects )
 {
     vector<float> maglevels = { 6.0, 7.2, 8.4, INFINITY };